@@ -4,11 +4,12 @@ import os
 import shutil
 import subprocess
 import sys
+import tempfile
 
 from distutils import log
 from distutils.command.build_ext import build_ext
 from distutils.command.sdist import sdist
-from distutils.errors import DistutilsError
+from distutils.errors import CompileError, DistutilsError
 
 
 def makedirs(path):
@@ -72,8 +73,45 @@ class libuv_build_ext(build_ext):
             self.compiler.dll_libraries = [lib for lib in self.compiler.dll_libraries if not lib.startswith('msvcr')]
         self.force = self.libuv_force_fetch or self.libuv_clean_compile
         self.get_libuv()
+        self.check_optional_deps()
         build_ext.build_extensions(self)
 
+    def check_optional_deps(self):
+        # Features which depend on external libraries are only compiled in if the library is found
+        ext = self.extensions[0]
+        if self.compiler.has_function('SSL_CTX_new', includes=['openssl/ssl.h'], libraries=['ssl', 'crypto']):
+            log.info('OpenSSL found, TLS support enabled.')
+            ext.define_macros.append(('PYUV_HAVE_OPENSSL', 1))
+            ext.libraries.extend(['ssl', 'crypto'])
+        else:
+            log.info('OpenSSL not found, TLS support disabled.')
+        if self.compiler.has_function('deflateInit_', includes=['zlib.h'], libraries=['z']):
+            log.info('zlib found, deflate stream compression enabled.')
+            ext.define_macros.append(('PYUV_HAVE_ZLIB', 1))
+            ext.libraries.append('z')
+        if self.compiler.has_function('ZSTD_createCStream', includes=['zstd.h'], libraries=['zstd']):
+            log.info('zstd found, zstd stream compression enabled.')
+            ext.define_macros.append(('PYUV_HAVE_ZSTD', 1))
+            ext.libraries.append('zstd')
+        if sys.platform.startswith('linux') and self.has_header('sys/sdt.h'):
+            log.info('sys/sdt.h found, USDT probes enabled.')
+            ext.define_macros.append(('PYUV_HAVE_SDT', 1))
+
+    def has_header(self, header):
+        # Probes are macros, so has_function can't be used to check for them
+        tmpdir = tempfile.mkdtemp()
+        try:
+            src = os.path.join(tmpdir, 'check_header.c')
+            with open(src, 'w') as f:
+                f.write('#include <%s>\nint main(void) { return 0; }\n' % header)
+            try:
+                self.compiler.compile([src], output_dir=tmpdir)
+            except CompileError:
+                return False
+            return True
+        finally:
+            shutil.rmtree(tmpdir)
+
     def finalize_options(self):
         build_ext.finalize_options(self)
         self.include_dirs.append(os.path.join(self.libuv_dir, 'include'))
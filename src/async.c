@@ -4,7 +4,10 @@ on_async_callback(uv_async_t *async, int status)
 {
     PyGILState_STATE gstate = PyGILState_Ensure();
     Async *self;
-    PyObject *result;
+    async_payload_t *payload;
+    pyuv_mpsc_node_t *node;
+    PyObject *result, *payloads;
+    Py_ssize_t i, count;
 
     ASSERT(async);
     ASSERT(status == 0);
@@ -14,7 +17,34 @@ on_async_callback(uv_async_t *async, int status)
     /* Object could go out of scope in the callback, increase refcount to avoid it */
     Py_INCREF(self);
 
-    result = PyObject_CallFunctionObjArgs(self->callback, self, NULL);
+    /* everything sent since the last wakeup is delivered at once, in the order it was sent. The
+     * list is passed even if it's empty: a wakeup may race with the send which queued a payload */
+    if (self->with_payloads) {
+        node = pyuv_mpsc_take(&self->payloads);
+        count = 0;
+        for (payload = (async_payload_t *)node; payload; payload = (async_payload_t *)payload->node.next) {
+            count++;
+        }
+        payloads = PyList_New(count);
+        for (i = 0; i < count; i++) {
+            payload = (async_payload_t *)node;
+            node = node->next;
+            if (payloads) {
+                PyList_SET_ITEM(payloads, i, payload->obj);
+            } else {
+                Py_DECREF(payload->obj);
+            }
+            PyMem_Free(payload);
+        }
+        if (payloads) {
+            result = pyuv_callback("async", self->callback, self, payloads, NULL);
+            Py_DECREF(payloads);
+        } else {
+            result = NULL;
+        }
+    } else {
+        result = pyuv_callback("async", self->callback, self, NULL);
+    }
     if (result == NULL) {
         PyErr_WriteUnraisable(self->callback);
     }
@@ -25,13 +55,53 @@ on_async_callback(uv_async_t *async, int status)
 }
 
 
+static void
+async_payloads_clear(Async *self)
+{
+    async_payload_t *payload;
+    pyuv_mpsc_node_t *node;
+
+    node = pyuv_mpsc_take(&self->payloads);
+    while (node) {
+        payload = (async_payload_t *)node;
+        node = node->next;
+        Py_DECREF(payload->obj);
+        PyMem_Free(payload);
+    }
+}
+
+
 static PyObject *
-Async_func_send(Async *self)
+Async_func_send(Async *self, PyObject *args)
 {
     int r;
+    async_payload_t *payload;
+    PyObject *obj = NULL;
 
     RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
 
+    if (!PyArg_ParseTuple(args, "|O:send", &obj)) {
+        return NULL;
+    }
+
+    if (obj && !self->with_payloads) {
+        PyErr_SetString(PyExc_AsyncError, "payloads were not enabled for this handle");
+        return NULL;
+    }
+
+    if (obj) {
+        payload = PyMem_Malloc(sizeof(async_payload_t));
+        if (!payload) {
+            return PyErr_NoMemory();
+        }
+        Py_INCREF(obj);
+        payload->obj = obj;
+        /* if the queue wasn't empty a wakeup is already on its way */
+        if (!pyuv_mpsc_push(&self->payloads, &payload->node)) {
+            Py_RETURN_NONE;
+        }
+    }
+
     r = uv_async_send((uv_async_t *)UV_HANDLE(self));
     if (r != 0) {
         RAISE_UV_EXCEPTION(UV_LOOP((Handle *)self), PyExc_AsyncError);
@@ -49,16 +119,17 @@ Async_tp_init(Async *self, PyObject *args, PyObject *kwargs)
     uv_async_t *uv_async = NULL;
     Loop *loop;
     PyObject *callback;
+    PyObject *with_payloads = Py_False;
     PyObject *tmp = NULL;
 
-    UNUSED_ARG(kwargs);
+    static char *kwlist[] = {"loop", "callback", "payloads", NULL};
 
     if (UV_HANDLE(self)) {
         PyErr_SetString(PyExc_AsyncError, "Object already initialized");
         return -1;
     }
 
-    if (!PyArg_ParseTuple(args, "O!O:__init__", &LoopType, &loop, &callback)) {
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!O|O:__init__", kwlist, &LoopType, &loop, &callback, &with_payloads)) {
         return -1;
     }
 
@@ -91,8 +162,11 @@ Async_tp_init(Async *self, PyObject *args, PyObject *kwargs)
     self->callback = callback;
     Py_XDECREF(tmp);
 
+    self->with_payloads = PyObject_IsTrue(with_payloads) ? True : False;
+
     uv_async->data = (void *)self;
     UV_HANDLE(self) = (uv_handle_t *)uv_async;
+    PYUV_PROBE2(handle__init, self, Py_TYPE(self)->tp_name);
 
     return 0;
 }
@@ -112,7 +186,12 @@ Async_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 static int
 Async_tp_traverse(Async *self, visitproc visit, void *arg)
 {
+    pyuv_mpsc_node_t *node;
     Py_VISIT(self->callback);
+    /* senders push with the GIL held, the list can't change under us */
+    for (node = self->payloads; node; node = node->next) {
+        Py_VISIT(((async_payload_t *)node)->obj);
+    }
     HandleType.tp_traverse((PyObject *)self, visit, arg);
     return 0;
 }
@@ -122,6 +201,7 @@ static int
 Async_tp_clear(Async *self)
 {
     Py_CLEAR(self->callback);
+    async_payloads_clear(self);
     HandleType.tp_clear((PyObject *)self);
     return 0;
 }
@@ -129,7 +209,7 @@ Async_tp_clear(Async *self)
 
 static PyMethodDef
 Async_tp_methods[] = {
-    { "send", (PyCFunction)Async_func_send, METH_NOARGS, "Send the Async signal." },
+    { "send", (PyCFunction)Async_func_send, METH_VARARGS, "Send the Async signal, optionally with a payload." },
     { NULL }
 };
 
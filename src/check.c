@@ -14,7 +14,7 @@ on_check_callback(uv_check_t *handle, int status)
     /* Object could go out of scope in the callback, increase refcount to avoid it */
     Py_INCREF(self);
 
-    result = PyObject_CallFunctionObjArgs(self->callback, self, NULL);
+    result = pyuv_callback("check", self->callback, self, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(self->callback);
     }
@@ -118,6 +118,7 @@ Check_tp_init(Check *self, PyObject *args, PyObject *kwargs)
     }
     uv_check->data = (void *)self;
     UV_HANDLE(self) = (uv_handle_t *)uv_check;
+    PYUV_PROBE2(handle__init, self, Py_TYPE(self)->tp_name);
 
     return 0;
 }
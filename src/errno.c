@@ -1,4 +1,65 @@
 
+/* Preallocated objects handed to callbacks, so the error and event paths don't allocate */
+static PyObject *PyUV_ErrorCodes[UV_MAX_ERRORS];
+static PyObject *PyUV_ErrorStrings[UV_MAX_ERRORS];
+static PyObject *PyUV_EventMasks[4];
+
+
+/* Returns a new reference to the int object for the given error code */
+static INLINE PyObject *
+pyuv_error_code(int code)
+{
+    PyObject *obj;
+    if (code >= 0 && code < UV_MAX_ERRORS && PyUV_ErrorCodes[code]) {
+        obj = PyUV_ErrorCodes[code];
+        Py_INCREF(obj);
+        return obj;
+    }
+    return PyInt_FromLong((long)code);
+}
+
+
+/* Returns a new reference to the int object for a mask of UV_READABLE / UV_WRITABLE or
+ * UV_RENAME / UV_CHANGE events */
+static INLINE PyObject *
+pyuv_event_mask(int events)
+{
+    PyObject *obj;
+    if (events >= 0 && events < (int)(sizeof(PyUV_EventMasks) / sizeof(PyUV_EventMasks[0])) && PyUV_EventMasks[events]) {
+        obj = PyUV_EventMasks[events];
+        Py_INCREF(obj);
+        return obj;
+    }
+    return PyInt_FromLong((long)events);
+}
+
+
+/* Set a (code, message) exception for the given libuv error, used by RAISE_UV_EXCEPTION */
+static void
+pyuv_set_uv_exception(uv_err_t err, PyObject *exc_type)
+{
+    PyObject *exc_data, *code, *message;
+
+    code = pyuv_error_code(err.code);
+    if (err.code >= 0 && err.code < UV_MAX_ERRORS && PyUV_ErrorStrings[err.code]) {
+        message = PyUV_ErrorStrings[err.code];
+        Py_INCREF(message);
+    } else {
+        message = PYUVString_FromString(uv_strerror(err));
+    }
+
+    if (code && message) {
+        exc_data = PyTuple_Pack(2, code, message);
+        if (exc_data != NULL) {
+            PyErr_SetObject(exc_type, exc_data);
+            Py_DECREF(exc_data);
+        }
+    }
+    Py_XDECREF(code);
+    Py_XDECREF(message);
+}
+
+
 /* Borrowed code from Python (Modules/errnomodule.c) */
 
 static void
@@ -20,7 +81,17 @@ inscode(PyObject *module_dict, PyObject *other_dict, const char *name, int code)
         PyDict_SetItem(other_dict, error_code, error_name);
     }
     Py_XDECREF(error_name);
-    Py_XDECREF(error_code);
+
+    if (code >= 0 && code < UV_MAX_ERRORS && error_code) {
+        uv_err_t err;
+        err.code = code;
+        err.sys_errno_ = 0;
+        /* the module keeps these references for its whole life */
+        PyUV_ErrorCodes[code] = error_code;
+        PyUV_ErrorStrings[code] = PYUVString_FromString(uv_strerror(err));
+    } else {
+        Py_XDECREF(error_code);
+    }
 }
 
 
@@ -61,6 +132,7 @@ static PyModuleDef pyuv_errorno_module = {
 PyObject *
 init_errno(void)
 {
+    int i;
     PyObject *module;
     PyObject *module_dict;
     PyObject *errorcode_dict;
@@ -83,6 +155,10 @@ init_errno(void)
     UV_ERRNO_MAP(XX)
 #undef XX
 
+    for (i = 0; i < (int)(sizeof(PyUV_EventMasks) / sizeof(PyUV_EventMasks[0])); i++) {
+        PyUV_EventMasks[i] = PyInt_FromLong((long)i);
+    }
+
     Py_DECREF(errorcode_dict);
 
     return module;
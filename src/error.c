@@ -42,6 +42,9 @@ init_error(void)
     PyExc_FSEventError = PyErr_NewException("pyuv.error.FSEventError", PyExc_HandleError, NULL);
     PyExc_FSPollError = PyErr_NewException("pyuv.error.FSPollError", PyExc_HandleError, NULL);
     PyExc_ProcessError = PyErr_NewException("pyuv.error.ProcessError", PyExc_HandleError, NULL);
+    PyExc_TLSError = PyErr_NewException("pyuv.error.TLSError", PyExc_UVError, NULL);
+    PyExc_RESPError = PyErr_NewException("pyuv.error.RESPError", PyExc_UVError, NULL);
+    PyExc_SharedRingError = PyErr_NewException("pyuv.error.SharedRingError", PyExc_HandleError, NULL);
 
     PyUVModule_AddType(module, "UVError", (PyTypeObject *)PyExc_UVError);
     PyUVModule_AddType(module, "HandleError", (PyTypeObject *)PyExc_HandleError);
@@ -62,6 +65,9 @@ init_error(void)
     PyUVModule_AddType(module, "FSEventError", (PyTypeObject *)PyExc_FSEventError);
     PyUVModule_AddType(module, "FSPollError", (PyTypeObject *)PyExc_FSPollError);
     PyUVModule_AddType(module, "ProcessError", (PyTypeObject *)PyExc_ProcessError);
+    PyUVModule_AddType(module, "TLSError", (PyTypeObject *)PyExc_TLSError);
+    PyUVModule_AddType(module, "RESPError", (PyTypeObject *)PyExc_RESPError);
+    PyUVModule_AddType(module, "SharedRingError", (PyTypeObject *)PyExc_SharedRingError);
 
     return module;
 }
@@ -130,7 +130,7 @@ process_stat(uv_fs_t* req, PyObject **path, PyObject **stat_data, PyObject **err
     }
 
     if (req->result < 0) {
-        *errorno = PyInt_FromLong((long)req->errorno);
+        *errorno = pyuv_error_code(req->errorno);
         *stat_data = Py_None;
         Py_INCREF(Py_None);
         return;
@@ -160,12 +160,14 @@ stat_cb(uv_fs_t* req) {
     Loop *loop;
     PyObject *callback, *result, *errorno, *stat_data, *path;
 
+    PYUV_PROBE3(fs__complete, req, req->fs_type, req->result);
+
     process_stat(req, &path, &stat_data, &errorno);
     callback = (PyObject *)req->data;
     loop = (Loop *)req->loop->data;
 
     if (path && stat_data && errorno) {
-        result = PyObject_CallFunctionObjArgs(callback, loop, path, stat_data, errorno, NULL);
+        result = pyuv_callback("fs.stat", callback, loop, path, stat_data, errorno, NULL);
         if (result == NULL) {
             PyErr_WriteUnraisable(callback);
         }
@@ -193,6 +195,8 @@ unlink_cb(uv_fs_t* req) {
     ASSERT(req);
     ASSERT(req->fs_type == UV_FS_UNLINK);
 
+    PYUV_PROBE3(fs__complete, req, req->fs_type, req->result);
+
     callback = (PyObject *)req->data;
     loop = (Loop *)req->loop->data;
 
@@ -204,13 +208,13 @@ unlink_cb(uv_fs_t* req) {
     }
 
     if (req->result < 0) {
-        errorno = PyInt_FromLong((long)req->errorno);
+        errorno = pyuv_error_code(req->errorno);
     } else {
         errorno = Py_None;
         Py_INCREF(Py_None);
     }
 
-    result = PyObject_CallFunctionObjArgs(callback, loop, path, errorno, NULL);
+    result = pyuv_callback("fs.unlink", callback, loop, path, errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(callback);
     }
@@ -236,6 +240,8 @@ mkdir_cb(uv_fs_t* req) {
     ASSERT(req);
     ASSERT(req->fs_type == UV_FS_MKDIR);
 
+    PYUV_PROBE3(fs__complete, req, req->fs_type, req->result);
+
     callback = (PyObject *)req->data;
     loop = (Loop *)req->loop->data;
 
@@ -247,13 +253,13 @@ mkdir_cb(uv_fs_t* req) {
     }
 
     if (req->result < 0) {
-        errorno = PyInt_FromLong((long)req->errorno);
+        errorno = pyuv_error_code(req->errorno);
     } else {
         errorno = Py_None;
         Py_INCREF(Py_None);
     }
 
-    result = PyObject_CallFunctionObjArgs(callback, loop, path, errorno, NULL);
+    result = pyuv_callback("fs.mkdir", callback, loop, path, errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(callback);
     }
@@ -279,6 +285,8 @@ rmdir_cb(uv_fs_t* req) {
     ASSERT(req);
     ASSERT(req->fs_type == UV_FS_RMDIR);
 
+    PYUV_PROBE3(fs__complete, req, req->fs_type, req->result);
+
     callback = (PyObject *)req->data;
     loop = (Loop *)req->loop->data;
 
@@ -290,13 +298,13 @@ rmdir_cb(uv_fs_t* req) {
     }
 
     if (req->result < 0) {
-        errorno = PyInt_FromLong((long)req->errorno);
+        errorno = pyuv_error_code(req->errorno);
     } else {
         errorno = Py_None;
         Py_INCREF(Py_None);
     }
 
-    result = PyObject_CallFunctionObjArgs(callback, loop, path, errorno, NULL);
+    result = pyuv_callback("fs.rmdir", callback, loop, path, errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(callback);
     }
@@ -322,6 +330,8 @@ rename_cb(uv_fs_t* req) {
     ASSERT(req);
     ASSERT(req->fs_type == UV_FS_RENAME);
 
+    PYUV_PROBE3(fs__complete, req, req->fs_type, req->result);
+
     callback = (PyObject *)req->data;
     loop = (Loop *)req->loop->data;
 
@@ -333,13 +343,13 @@ rename_cb(uv_fs_t* req) {
     }
 
     if (req->result < 0) {
-        errorno = PyInt_FromLong((long)req->errorno);
+        errorno = pyuv_error_code(req->errorno);
     } else {
         errorno = Py_None;
         Py_INCREF(Py_None);
     }
 
-    result = PyObject_CallFunctionObjArgs(callback, loop, path, errorno, NULL);
+    result = pyuv_callback("fs.rename", callback, loop, path, errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(callback);
     }
@@ -365,6 +375,8 @@ chmod_cb(uv_fs_t* req) {
     ASSERT(req);
     ASSERT(req->fs_type == UV_FS_CHMOD || req->fs_type == UV_FS_FCHMOD);
 
+    PYUV_PROBE3(fs__complete, req, req->fs_type, req->result);
+
     callback = (PyObject *)req->data;
     loop = (Loop *)req->loop->data;
 
@@ -376,13 +388,13 @@ chmod_cb(uv_fs_t* req) {
     }
 
     if (req->result < 0) {
-        errorno = PyInt_FromLong((long)req->errorno);
+        errorno = pyuv_error_code(req->errorno);
     } else {
         errorno = Py_None;
         Py_INCREF(Py_None);
     }
 
-    result = PyObject_CallFunctionObjArgs(callback, loop, path, errorno, NULL);
+    result = pyuv_callback("fs.chmod", callback, loop, path, errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(callback);
     }
@@ -408,6 +420,8 @@ link_cb(uv_fs_t* req) {
     ASSERT(req);
     ASSERT(req->fs_type == UV_FS_LINK);
 
+    PYUV_PROBE3(fs__complete, req, req->fs_type, req->result);
+
     callback = (PyObject *)req->data;
     loop = (Loop *)req->loop->data;
 
@@ -419,13 +433,13 @@ link_cb(uv_fs_t* req) {
     }
 
     if (req->result < 0) {
-        errorno = PyInt_FromLong((long)req->errorno);
+        errorno = pyuv_error_code(req->errorno);
     } else {
         errorno = Py_None;
         Py_INCREF(Py_None);
     }
 
-    result = PyObject_CallFunctionObjArgs(callback, loop, path, errorno, NULL);
+    result = pyuv_callback("fs.link", callback, loop, path, errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(callback);
     }
@@ -451,6 +465,8 @@ symlink_cb(uv_fs_t* req) {
     ASSERT(req);
     ASSERT(req->fs_type == UV_FS_SYMLINK);
 
+    PYUV_PROBE3(fs__complete, req, req->fs_type, req->result);
+
     callback = (PyObject *)req->data;
     loop = (Loop *)req->loop->data;
 
@@ -462,13 +478,13 @@ symlink_cb(uv_fs_t* req) {
     }
 
     if (req->result < 0) {
-        errorno = PyInt_FromLong((long)req->errorno);
+        errorno = pyuv_error_code(req->errorno);
     } else {
         errorno = Py_None;
         Py_INCREF(Py_None);
     }
 
-    result = PyObject_CallFunctionObjArgs(callback, loop, path, errorno, NULL);
+    result = pyuv_callback("fs.symlink", callback, loop, path, errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(callback);
     }
@@ -492,7 +508,7 @@ process_readlink(uv_fs_t* req, PyObject **path, PyObject **errorno)
     ASSERT(req->fs_type == UV_FS_READLINK);
 
     if (req->result < 0) {
-        *errorno = PyInt_FromLong((long)req->errorno);
+        *errorno = pyuv_error_code(req->errorno);
         *path = Py_None;
         Py_INCREF(Py_None);
     } else {
@@ -508,11 +524,13 @@ readlink_cb(uv_fs_t* req) {
     Loop *loop;
     PyObject *callback, *result, *errorno, *path;
 
+    PYUV_PROBE3(fs__complete, req, req->fs_type, req->result);
+
     process_readlink(req, &path, &errorno);
     callback = (PyObject *)req->data;
     loop = (Loop *)req->loop->data;
 
-    result = PyObject_CallFunctionObjArgs(callback, loop, path, errorno, NULL);
+    result = pyuv_callback("fs.readlink", callback, loop, path, errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(callback);
     }
@@ -538,6 +556,8 @@ chown_cb(uv_fs_t* req) {
     ASSERT(req);
     ASSERT(req->fs_type == UV_FS_CHOWN || req->fs_type == UV_FS_FCHOWN);
 
+    PYUV_PROBE3(fs__complete, req, req->fs_type, req->result);
+
     callback = (PyObject *)req->data;
     loop = (Loop *)req->loop->data;
 
@@ -549,13 +569,13 @@ chown_cb(uv_fs_t* req) {
     }
 
     if (req->result < 0) {
-        errorno = PyInt_FromLong((long)req->errorno);
+        errorno = pyuv_error_code(req->errorno);
     } else {
         errorno = Py_None;
         Py_INCREF(Py_None);
     }
 
-    result = PyObject_CallFunctionObjArgs(callback, loop, path, errorno, NULL);
+    result = pyuv_callback("fs.chown", callback, loop, path, errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(callback);
     }
@@ -586,7 +606,7 @@ process_open(uv_fs_t* req, PyObject **path, PyObject **fd, PyObject **errorno)
     }
 
     if (req->result < 0) {
-        *errorno = PyInt_FromLong((long)req->errorno);
+        *errorno = pyuv_error_code(req->errorno);
         *fd = Py_None;
         Py_INCREF(Py_None);
     } else {
@@ -602,11 +622,13 @@ open_cb(uv_fs_t* req) {
     Loop *loop;
     PyObject *callback, *result, *fd, *errorno, *path;
 
+    PYUV_PROBE3(fs__complete, req, req->fs_type, req->result);
+
     process_open(req, &path, &fd, &errorno);
     callback = (PyObject *)req->data;
     loop = (Loop *)req->loop->data;
 
-    result = PyObject_CallFunctionObjArgs(callback, loop, path, fd, errorno, NULL);
+    result = pyuv_callback("fs.open", callback, loop, path, fd, errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(callback);
     }
@@ -633,6 +655,8 @@ close_cb(uv_fs_t* req) {
     ASSERT(req);
     ASSERT(req->fs_type == UV_FS_CLOSE);
 
+    PYUV_PROBE3(fs__complete, req, req->fs_type, req->result);
+
     callback = (PyObject *)req->data;
     loop = (Loop *)req->loop->data;
 
@@ -644,13 +668,13 @@ close_cb(uv_fs_t* req) {
     }
 
     if (req->result < 0) {
-        errorno = PyInt_FromLong((long)req->errorno);
+        errorno = pyuv_error_code(req->errorno);
     } else {
         errorno = Py_None;
         Py_INCREF(Py_None);
     }
 
-    result = PyObject_CallFunctionObjArgs(callback, loop, path, errorno, NULL);
+    result = pyuv_callback("fs.close", callback, loop, path, errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(callback);
     }
@@ -685,7 +709,7 @@ process_read(uv_fs_t* req, PyObject **path, PyObject **read_data, PyObject **err
     }
 
     if (req->result < 0) {
-        *errorno = PyInt_FromLong((long)req->errorno);
+        *errorno = pyuv_error_code(req->errorno);
         *read_data = Py_None;
         Py_INCREF(Py_None);
     } else {
@@ -702,11 +726,13 @@ read_cb(uv_fs_t* req) {
     Loop *loop;
     PyObject *result, *errorno, *read_data, *path;
 
+    PYUV_PROBE3(fs__complete, req, req->fs_type, req->result);
+
     process_read(req, &path, &read_data, &errorno);
     req_data = (fs_rwreq_data_t*)(req->data);
     loop = (Loop *)req->loop->data;
 
-    result = PyObject_CallFunctionObjArgs(req_data->callback, loop, path, read_data, errorno, NULL);
+    result = pyuv_callback("fs.read", req_data->callback, loop, path, read_data, errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(req_data->callback);
     }
@@ -741,7 +767,7 @@ process_write(uv_fs_t* req, PyObject **path, PyObject **bytes_written, PyObject
     }
 
     if (req->result < 0) {
-        *errorno = PyInt_FromLong((long)req->errorno);
+        *errorno = pyuv_error_code(req->errorno);
     } else {
         *errorno = Py_None;
         Py_INCREF(Py_None);
@@ -758,11 +784,13 @@ write_cb(uv_fs_t* req) {
     ASSERT(req);
     ASSERT(req->fs_type == UV_FS_WRITE);
 
+    PYUV_PROBE3(fs__complete, req, req->fs_type, req->result);
+
     process_write(req, &path, &bytes_written, &errorno);
     req_data = (fs_rwreq_data_t*)(req->data);
     loop = (Loop *)req->loop->data;
 
-    result = PyObject_CallFunctionObjArgs(req_data->callback, loop, path, bytes_written, errorno, NULL);
+    result = pyuv_callback("fs.write", req_data->callback, loop, path, bytes_written, errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(req_data->callback);
     }
@@ -791,6 +819,8 @@ fsync_cb(uv_fs_t* req) {
     ASSERT(req);
     ASSERT(req->fs_type == UV_FS_FSYNC || req->fs_type == UV_FS_FDATASYNC);
 
+    PYUV_PROBE3(fs__complete, req, req->fs_type, req->result);
+
     callback = (PyObject *)req->data;
     loop = (Loop *)req->loop->data;
 
@@ -802,13 +832,13 @@ fsync_cb(uv_fs_t* req) {
     }
 
     if (req->result < 0) {
-        errorno = PyInt_FromLong((long)req->errorno);
+        errorno = pyuv_error_code(req->errorno);
     } else {
         errorno = Py_None;
         Py_INCREF(Py_None);
     }
 
-    result = PyObject_CallFunctionObjArgs(callback, loop, path, errorno, NULL);
+    result = pyuv_callback("fs.fsync", callback, loop, path, errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(callback);
     }
@@ -834,6 +864,8 @@ ftruncate_cb(uv_fs_t* req) {
     ASSERT(req);
     ASSERT(req->fs_type == UV_FS_FTRUNCATE);
 
+    PYUV_PROBE3(fs__complete, req, req->fs_type, req->result);
+
     callback = (PyObject *)req->data;
     loop = (Loop *)req->loop->data;
 
@@ -845,13 +877,13 @@ ftruncate_cb(uv_fs_t* req) {
     }
 
     if (req->result < 0) {
-        errorno = PyInt_FromLong((long)req->errorno);
+        errorno = pyuv_error_code(req->errorno);
     } else {
         errorno = Py_None;
         Py_INCREF(Py_None);
     }
 
-    result = PyObject_CallFunctionObjArgs(callback, loop, path, errorno, NULL);
+    result = pyuv_callback("fs.ftruncate", callback, loop, path, errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(callback);
     }
@@ -886,7 +918,7 @@ process_readdir(uv_fs_t* req, PyObject **path, PyObject **files, PyObject **erro
     }
 
     if (req->result < 0) {
-        *errorno = PyInt_FromLong((long)req->errorno);
+        *errorno = pyuv_error_code(req->errorno);
         *files = Py_None;
         Py_INCREF(Py_None);
     } else {
@@ -918,11 +950,13 @@ readdir_cb(uv_fs_t* req) {
     Loop *loop;
     PyObject *callback, *result, *errorno, *files, *path;
 
+    PYUV_PROBE3(fs__complete, req, req->fs_type, req->result);
+
     process_readdir(req, &path, &files, &errorno);
     callback = (PyObject *)req->data;
     loop = (Loop *)req->loop->data;
 
-    result = PyObject_CallFunctionObjArgs(callback, loop, path, files, errorno, NULL);
+    result = pyuv_callback("fs.readdir", callback, loop, path, files, errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(callback);
     }
@@ -956,7 +990,7 @@ process_sendfile(uv_fs_t* req, PyObject **path, PyObject **bytes_written, PyObje
     }
 
     if (req->result < 0) {
-        *errorno = PyInt_FromLong((long)req->errorno);
+        *errorno = pyuv_error_code(req->errorno);
     } else {
         *errorno = Py_None;
         Py_INCREF(Py_None);
@@ -969,11 +1003,13 @@ sendfile_cb(uv_fs_t* req) {
     Loop *loop;
     PyObject *callback, *result, *errorno, *bytes_written, *path;
 
+    PYUV_PROBE3(fs__complete, req, req->fs_type, req->result);
+
     process_sendfile(req, &path, &bytes_written, &errorno);
     callback = (PyObject *)req->data;
     loop = (Loop *)req->loop->data;
 
-    result = PyObject_CallFunctionObjArgs(callback, loop, path, bytes_written, errorno, NULL);
+    result = pyuv_callback("fs.sendfile", callback, loop, path, bytes_written, errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(callback);
     }
@@ -999,6 +1035,8 @@ utime_cb(uv_fs_t* req) {
     ASSERT(req);
     ASSERT(req->fs_type == UV_FS_UTIME || req->fs_type == UV_FS_FUTIME);
 
+    PYUV_PROBE3(fs__complete, req, req->fs_type, req->result);
+
     callback = (PyObject *)req->data;
     loop = (Loop *)req->loop->data;
 
@@ -1010,13 +1048,13 @@ utime_cb(uv_fs_t* req) {
     }
 
     if (req->result < 0) {
-        errorno = PyInt_FromLong((long)req->errorno);
+        errorno = pyuv_error_code(req->errorno);
     } else {
         errorno = Py_None;
         Py_INCREF(Py_None);
     }
 
-    result = PyObject_CallFunctionObjArgs(callback, loop, path, errorno, NULL);
+    result = pyuv_callback("fs.utime", callback, loop, path, errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(callback);
     }
@@ -1066,11 +1104,16 @@ stat_func(PyObject *args, PyObject *kwargs, int type)
     Py_XINCREF(callback);
 
     fs_req->data = (void *)callback;
+    PYUV_PROBE2(fs__submit, fs_req, type);
     if (type == UV_FS_STAT) {
         r = uv_fs_stat(loop->uv_loop, fs_req, path, (callback != NULL) ? stat_cb : NULL);
     } else {
         r = uv_fs_lstat(loop->uv_loop, fs_req, path, (callback != NULL) ? stat_cb : NULL);
     }
+    /* synchronous requests (and failed submissions) are complete once the call returns */
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, type, r);
+    }
     if (r < 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         ret = NULL;
@@ -1146,7 +1189,11 @@ FS_func_fstat(PyObject *obj, PyObject *args, PyObject *kwargs)
     Py_XINCREF(callback);
 
     fs_req->data = (void *)callback;
+    PYUV_PROBE2(fs__submit, fs_req, UV_FS_FSTAT);
     r = uv_fs_fstat(loop->uv_loop, fs_req, fd, (callback != NULL) ? stat_cb : NULL);
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, UV_FS_FSTAT, r);
+    }
     if (r < 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         ret = NULL;
@@ -1206,7 +1253,11 @@ FS_func_unlink(PyObject *obj, PyObject *args, PyObject *kwargs)
     Py_XINCREF(callback);
 
     fs_req->data = (void *)callback;
+    PYUV_PROBE2(fs__submit, fs_req, UV_FS_UNLINK);
     r = uv_fs_unlink(loop->uv_loop, fs_req, path, (callback != NULL) ? unlink_cb : NULL);
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, UV_FS_UNLINK, r);
+    }
     if (r < 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         goto end;
@@ -1257,7 +1308,11 @@ FS_func_mkdir(PyObject *obj, PyObject *args, PyObject *kwargs)
     Py_XINCREF(callback);
 
     fs_req->data = (void *)callback;
+    PYUV_PROBE2(fs__submit, fs_req, UV_FS_MKDIR);
     r = uv_fs_mkdir(loop->uv_loop, fs_req, path, mode, (callback != NULL) ? mkdir_cb : NULL);
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, UV_FS_MKDIR, r);
+    }
     if (r < 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         goto end;
@@ -1308,7 +1363,11 @@ FS_func_rmdir(PyObject *obj, PyObject *args, PyObject *kwargs)
     Py_XINCREF(callback);
 
     fs_req->data = (void *)callback;
+    PYUV_PROBE2(fs__submit, fs_req, UV_FS_RMDIR);
     r = uv_fs_rmdir(loop->uv_loop, fs_req, path, (callback != NULL) ? rmdir_cb : NULL);
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, UV_FS_RMDIR, r);
+    }
     if (r < 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         goto end;
@@ -1359,7 +1418,11 @@ FS_func_rename(PyObject *obj, PyObject *args, PyObject *kwargs)
     Py_XINCREF(callback);
 
     fs_req->data = (void *)callback;
+    PYUV_PROBE2(fs__submit, fs_req, UV_FS_RENAME);
     r = uv_fs_rename(loop->uv_loop, fs_req, path, new_path, (callback != NULL) ? rename_cb : NULL);
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, UV_FS_RENAME, r);
+    }
     if (r < 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         goto end;
@@ -1410,7 +1473,11 @@ FS_func_chmod(PyObject *obj, PyObject *args, PyObject *kwargs)
     Py_XINCREF(callback);
 
     fs_req->data = (void *)callback;
+    PYUV_PROBE2(fs__submit, fs_req, UV_FS_CHMOD);
     r = uv_fs_chmod(loop->uv_loop, fs_req, path, mode, (callback != NULL) ? chmod_cb : NULL);
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, UV_FS_CHMOD, r);
+    }
     if (r < 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         goto end;
@@ -1460,7 +1527,11 @@ FS_func_fchmod(PyObject *obj, PyObject *args, PyObject *kwargs)
     Py_XINCREF(callback);
 
     fs_req->data = (void *)callback;
+    PYUV_PROBE2(fs__submit, fs_req, UV_FS_FCHMOD);
     r = uv_fs_fchmod(loop->uv_loop, fs_req, fd, mode, (callback != NULL) ? chmod_cb : NULL);
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, UV_FS_FCHMOD, r);
+    }
     if (r < 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         goto end;
@@ -1511,7 +1582,11 @@ FS_func_link(PyObject *obj, PyObject *args, PyObject *kwargs)
     Py_XINCREF(callback);
 
     fs_req->data = (void *)callback;
+    PYUV_PROBE2(fs__submit, fs_req, UV_FS_LINK);
     r = uv_fs_link(loop->uv_loop, fs_req, path, new_path, (callback != NULL) ? link_cb : NULL);
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, UV_FS_LINK, r);
+    }
     if (r < 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         goto end;
@@ -1562,7 +1637,11 @@ FS_func_symlink(PyObject *obj, PyObject *args, PyObject *kwargs)
     Py_XINCREF(callback);
 
     fs_req->data = (void *)callback;
+    PYUV_PROBE2(fs__submit, fs_req, UV_FS_SYMLINK);
     r = uv_fs_symlink(loop->uv_loop, fs_req, path, new_path, flags, (callback != NULL) ? symlink_cb : NULL);
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, UV_FS_SYMLINK, r);
+    }
     if (r < 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         goto end;
@@ -1614,7 +1693,11 @@ FS_func_readlink(PyObject *obj, PyObject *args, PyObject *kwargs)
     Py_XINCREF(callback);
 
     fs_req->data = (void *)callback;
+    PYUV_PROBE2(fs__submit, fs_req, UV_FS_READLINK);
     r = uv_fs_readlink(loop->uv_loop, fs_req, path, (callback != NULL) ? readlink_cb : NULL);
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, UV_FS_READLINK, r);
+    }
     if (r < 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         ret = NULL;
@@ -1673,7 +1756,11 @@ FS_func_chown(PyObject *obj, PyObject *args, PyObject *kwargs)
     Py_XINCREF(callback);
 
     fs_req->data = (void *)callback;
+    PYUV_PROBE2(fs__submit, fs_req, UV_FS_CHOWN);
     r = uv_fs_chown(loop->uv_loop, fs_req, path, uid, gid, (callback != NULL) ? chown_cb : NULL);
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, UV_FS_CHOWN, r);
+    }
     if (r < 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         goto end;
@@ -1723,7 +1810,11 @@ FS_func_fchown(PyObject *obj, PyObject *args, PyObject *kwargs)
     Py_XINCREF(callback);
 
     fs_req->data = (void *)callback;
+    PYUV_PROBE2(fs__submit, fs_req, UV_FS_FCHOWN);
     r = uv_fs_fchown(loop->uv_loop, fs_req, fd, uid, gid, (callback != NULL) ? chown_cb : NULL);
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, UV_FS_FCHOWN, r);
+    }
     if (r != 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         goto end;
@@ -1775,7 +1866,11 @@ FS_func_open(PyObject *obj, PyObject *args, PyObject *kwargs)
     Py_XINCREF(callback);
 
     fs_req->data = (void *)callback;
+    PYUV_PROBE2(fs__submit, fs_req, UV_FS_OPEN);
     r = uv_fs_open(loop->uv_loop, fs_req, path, flags, mode, (callback != NULL) ? open_cb : NULL);
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, UV_FS_OPEN, r);
+    }
     if (r < 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         ret = NULL;
@@ -1834,7 +1929,11 @@ FS_func_close(PyObject *obj, PyObject *args, PyObject *kwargs)
     Py_XINCREF(callback);
 
     fs_req->data = (void *)callback;
+    PYUV_PROBE2(fs__submit, fs_req, UV_FS_CLOSE);
     r = uv_fs_close(loop->uv_loop, fs_req, fd, (callback != NULL) ? close_cb : NULL);
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, UV_FS_CLOSE, r);
+    }
     if (r < 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         goto end;
@@ -1905,7 +2004,11 @@ FS_func_read(PyObject *obj, PyObject *args, PyObject *kwargs)
     req_data->buf = buf;
 
     fs_req->data = (void *)req_data;
+    PYUV_PROBE2(fs__submit, fs_req, UV_FS_READ);
     r = uv_fs_read(loop->uv_loop, fs_req, fd, buf, length, offset, (callback != NULL) ? read_cb : NULL);
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, UV_FS_READ, r);
+    }
     if (r < 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         ret = NULL;
@@ -1984,7 +2087,11 @@ FS_func_write(PyObject *obj, PyObject *args, PyObject *kwargs)
     req_data->view = pbuf;
 
     fs_req->data = (void *)req_data;
+    PYUV_PROBE2(fs__submit, fs_req, UV_FS_WRITE);
     r = uv_fs_write(loop->uv_loop, fs_req, fd, pbuf.buf, pbuf.len, offset, (callback != NULL) ? write_cb : NULL);
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, UV_FS_WRITE, r);
+    }
     if (r < 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         ret = NULL;
@@ -2047,7 +2154,11 @@ FS_func_fsync(PyObject *obj, PyObject *args, PyObject *kwargs)
     Py_XINCREF(callback);
 
     fs_req->data = (void *)callback;
+    PYUV_PROBE2(fs__submit, fs_req, UV_FS_FSYNC);
     r = uv_fs_fsync(loop->uv_loop, fs_req, fd, (callback != NULL) ? fsync_cb : NULL);
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, UV_FS_FSYNC, r);
+    }
     if (r < 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         goto end;
@@ -2097,7 +2208,11 @@ FS_func_fdatasync(PyObject *obj, PyObject *args, PyObject *kwargs)
     Py_XINCREF(callback);
 
     fs_req->data = (void *)callback;
+    PYUV_PROBE2(fs__submit, fs_req, UV_FS_FDATASYNC);
     r = uv_fs_fdatasync(loop->uv_loop, fs_req, fd, (callback != NULL) ? fsync_cb : NULL);
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, UV_FS_FDATASYNC, r);
+    }
     if (r != 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         goto end;
@@ -2147,7 +2262,11 @@ FS_func_ftruncate(PyObject *obj, PyObject *args, PyObject *kwargs)
     Py_XINCREF(callback);
 
     fs_req->data = (void *)callback;
+    PYUV_PROBE2(fs__submit, fs_req, UV_FS_FTRUNCATE);
     r = uv_fs_ftruncate(loop->uv_loop, fs_req, fd, offset, (callback != NULL) ? ftruncate_cb : NULL);
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, UV_FS_FTRUNCATE, r);
+    }
     if (r < 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         goto end;
@@ -2200,7 +2319,11 @@ FS_func_readdir(PyObject *obj, PyObject *args, PyObject *kwargs)
     Py_XINCREF(callback);
 
     fs_req->data = (void *)callback;
+    PYUV_PROBE2(fs__submit, fs_req, UV_FS_READDIR);
     r = uv_fs_readdir(loop->uv_loop, fs_req, path, flags, (callback != NULL) ? readdir_cb : NULL);
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, UV_FS_READDIR, r);
+    }
     if (r < 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         ret = NULL;
@@ -2260,7 +2383,11 @@ FS_func_sendfile(PyObject *obj, PyObject *args, PyObject *kwargs)
     Py_XINCREF(callback);
 
     fs_req->data = (void *)callback;
+    PYUV_PROBE2(fs__submit, fs_req, UV_FS_SENDFILE);
     r = uv_fs_sendfile(loop->uv_loop, fs_req, out_fd, in_fd, in_offset, length, (callback != NULL) ? sendfile_cb : NULL);
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, UV_FS_SENDFILE, r);
+    }
     if (r < 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         ret = NULL;
@@ -2321,7 +2448,11 @@ FS_func_utime(PyObject *obj, PyObject *args, PyObject *kwargs)
     Py_XINCREF(callback);
 
     fs_req->data = (void *)callback;
+    PYUV_PROBE2(fs__submit, fs_req, UV_FS_UTIME);
     r = uv_fs_utime(loop->uv_loop, fs_req, path, atime, mtime, (callback != NULL) ? utime_cb : NULL);
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, UV_FS_UTIME, r);
+    }
     if (r < 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         goto end;
@@ -2372,7 +2503,11 @@ FS_func_futime(PyObject *obj, PyObject *args, PyObject *kwargs)
     Py_XINCREF(callback);
 
     fs_req->data = (void *)callback;
+    PYUV_PROBE2(fs__submit, fs_req, UV_FS_FUTIME);
     r = uv_fs_futime(loop->uv_loop, fs_req, fd, atime, mtime, (callback != NULL) ? utime_cb : NULL);
+    if (callback == NULL || r < 0) {
+        PYUV_PROBE3(fs__complete, fs_req, UV_FS_FUTIME, r);
+    }
     if (r < 0) {
         RAISE_UV_EXCEPTION(loop->uv_loop, PyExc_FSError);
         goto end;
@@ -2446,15 +2581,15 @@ on_fsevent_callback(uv_fs_event_t *handle, const char *filename, int events, int
 
     if (status < 0) {
         uv_err_t err = uv_last_error(UV_HANDLE_LOOP(self));
-        errorno = PyInt_FromLong((long)err.code);
+        errorno = pyuv_error_code(err.code);
     } else {
         errorno = Py_None;
         Py_INCREF(Py_None);
     }
 
-    py_events = PyInt_FromLong((long)events);
+    py_events = pyuv_event_mask(events);
 
-    result = PyObject_CallFunctionObjArgs(self->callback, self, py_filename, py_events, errorno, NULL);
+    result = pyuv_callback("fs_event", self->callback, self, py_filename, py_events, errorno, NULL);
     if (result == NULL) {
 	PyErr_WriteUnraisable(self->callback);
     }
@@ -2501,6 +2636,7 @@ FSEvent_func_start(FSEvent *self, PyObject *args, PyObject *kwargs)
     }
     fs_event->data = (void *)self;
     UV_HANDLE(self) = (uv_handle_t *)fs_event;
+    PYUV_PROBE2(handle__init, self, Py_TYPE(self)->tp_name);
 
     r = uv_fs_event_init(UV_HANDLE_LOOP(self), fs_event, path, on_fsevent_callback, flags);
     if (r != 0) {
@@ -2659,7 +2795,7 @@ on_fspoll_callback(uv_fs_poll_t *handle, int status, const uv_statbuf_t *prev, c
 
     if (status < 0) {
         uv_err_t err = uv_last_error(UV_HANDLE_LOOP(self));
-        errorno = PyInt_FromLong((long)err.code);
+        errorno = pyuv_error_code(err.code);
         prev_stat_data = Py_None;
         curr_stat_data = Py_None;
         Py_INCREF(Py_None);
@@ -2687,7 +2823,7 @@ on_fspoll_callback(uv_fs_poll_t *handle, int status, const uv_statbuf_t *prev, c
         }
     }
 
-    result = PyObject_CallFunctionObjArgs(self->callback, self, prev_stat_data, curr_stat_data, errorno, NULL);
+    result = pyuv_callback("fs_poll", self->callback, self, prev_stat_data, curr_stat_data, errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(self->callback);
     }
@@ -2800,6 +2936,7 @@ FSPoll_tp_init(FSPoll *self, PyObject *args, PyObject *kwargs)
     }
     uv_fspoll->data = (void *)self;
     UV_HANDLE(self) = (uv_handle_t *)uv_fspoll;
+    PYUV_PROBE2(handle__init, self, Py_TYPE(self)->tp_name);
 
     return 0;
 }
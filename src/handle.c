@@ -1,3 +1,50 @@
+/* Traffic counters, every update is also applied to the loop totals */
+static INLINE void
+handle_stats_read(Handle *handle, handle_stats_t *stats, size_t nbytes)
+{
+    handle_stats_t *loop_stats = &handle->loop->handle_stats;
+    stats->reads++;
+    stats->bytes_read += nbytes;
+    loop_stats->reads++;
+    loop_stats->bytes_read += nbytes;
+    PYUV_PROBE2(handle__read, handle, nbytes);
+}
+
+
+static INLINE void
+handle_stats_write(Handle *handle, handle_stats_t *stats, size_t nbytes)
+{
+    handle_stats_t *loop_stats = &handle->loop->handle_stats;
+    stats->writes++;
+    stats->bytes_written += nbytes;
+    loop_stats->writes++;
+    loop_stats->bytes_written += nbytes;
+    PYUV_PROBE2(handle__write, handle, nbytes);
+}
+
+
+static INLINE void
+handle_stats_error(Handle *handle, handle_stats_t *stats)
+{
+    stats->errors++;
+    handle->loop->handle_stats.errors++;
+    PYUV_PROBE1(handle__error, handle);
+}
+
+
+static INLINE void
+handle_stats_queued(Handle *handle, handle_stats_t *stats, size_t queue_size)
+{
+    handle_stats_t *loop_stats = &handle->loop->handle_stats;
+    if (queue_size > stats->write_queue_high) {
+        stats->write_queue_high = queue_size;
+    }
+    if (queue_size > loop_stats->write_queue_high) {
+        loop_stats->write_queue_high = queue_size;
+    }
+}
+
+
 
 static void
 on_handle_close(uv_handle_t *handle)
@@ -11,7 +58,7 @@ on_handle_close(uv_handle_t *handle)
     ASSERT(self);
 
     if (self->on_close_cb) {
-        result = PyObject_CallFunctionObjArgs(self->on_close_cb, self, NULL);
+        result = pyuv_callback("close", self->on_close_cb, self, NULL);
         if (result == NULL) {
             PyErr_WriteUnraisable(self->on_close_cb);
         }
@@ -43,6 +90,39 @@ on_handle_dealloc_close(uv_handle_t *handle)
 }
 
 
+#if defined(PYUV_HAVE_SHARED_RING) || defined(PYUV_HAVE_HRTIMER)
+static void
+pyuv_fd_poll_close_fds(uv_handle_t *handle)
+{
+    int i;
+    pyuv_fd_poll_t *fd_poll = (pyuv_fd_poll_t *)handle;
+
+    for (i = 0; i < 2; i++) {
+        if (fd_poll->fds[i] != -1) {
+            close(fd_poll->fds[i]);
+            fd_poll->fds[i] = -1;
+        }
+    }
+}
+
+
+static void
+on_fd_poll_close(uv_handle_t *handle)
+{
+    pyuv_fd_poll_close_fds(handle);
+    on_handle_close(handle);
+}
+
+
+static void
+on_fd_poll_dealloc_close(uv_handle_t *handle)
+{
+    pyuv_fd_poll_close_fds(handle);
+    on_handle_dealloc_close(handle);
+}
+#endif
+
+
 static PyObject *
 Handle_func_ref(Handle *self)
 {
@@ -62,7 +142,7 @@ Handle_func_unref(Handle *self)
 
 
 static PyObject *
-Handle_func_close(Handle *self, PyObject *args)
+handle_close(Handle *self, PyObject *args, uv_close_cb close_cb)
 {
     PyObject *callback = NULL;
 
@@ -83,12 +163,44 @@ Handle_func_close(Handle *self, PyObject *args)
     /* Increase refcount so that object is not removed before the callback is called */
     Py_INCREF(self);
 
-    uv_close(self->uv_handle, on_handle_close);
+    PYUV_PROBE2(handle__close, self, Py_TYPE(self)->tp_name);
+    uv_close(self->uv_handle, close_cb);
 
     Py_RETURN_NONE;
 }
 
 
+static PyObject *
+Handle_func_close(Handle *self, PyObject *args)
+{
+    return handle_close(self, args, on_handle_close);
+}
+
+
+#if defined(PYUV_HAVE_SHARED_RING) || defined(PYUV_HAVE_HRTIMER)
+/* close() for handles using a pyuv_fd_poll_t */
+static PyObject *
+Handle_func_fd_poll_close(Handle *self, PyObject *args)
+{
+    return handle_close(self, args, on_fd_poll_close);
+}
+
+
+/* To be called from tp_dealloc before HandleType.tp_dealloc, which then has nothing to close */
+static void
+handle_fd_poll_dealloc(Handle *self)
+{
+    if (self->uv_handle) {
+        uv_poll_stop((uv_poll_t *)self->uv_handle);
+        self->uv_handle->data = NULL;
+        PYUV_PROBE2(handle__close, self, Py_TYPE(self)->tp_name);
+        uv_close(self->uv_handle, on_fd_poll_dealloc_close);
+        self->uv_handle = NULL;
+    }
+}
+#endif
+
+
 static PyObject *
 Handle_active_get(Handle *self, void *closure)
 {
@@ -151,6 +263,7 @@ Handle_tp_dealloc(Handle *self)
 {
     if (self->uv_handle) {
         self->uv_handle->data = NULL;
+        PYUV_PROBE2(handle__close, self, Py_TYPE(self)->tp_name);
         uv_close(self->uv_handle, on_handle_dealloc_close);
     }
     if (self->weakreflist != NULL) {
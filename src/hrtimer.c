@@ -0,0 +1,330 @@
+
+#ifdef PYUV_HAVE_HRTIMER
+
+/* Timer with nanosecond resolution. libuv timers work in milliseconds, so this one is a
+ * timerfd on CLOCK_MONOTONIC (the clock behind uv_hrtime) watched by a uv_poll_t. Deadlines
+ * are absolute, so a periodic sender can compute the next one from the previous deadline
+ * instead of accumulating the callback latency. */
+
+static INLINE void
+hrtimer_timespec(struct timespec *ts, uint64_t ns)
+{
+    ts->tv_sec = (time_t)(ns / 1000000000);
+    ts->tv_nsec = (long)(ns % 1000000000);
+}
+
+
+static void
+on_hrtimer_poll(uv_poll_t *handle, int status, int events)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    uv_err_t err;
+    HRTimer *self;
+    PyObject *result, *py_expirations, *py_errorno;
+    uint64_t expirations;
+    ssize_t n;
+
+    ASSERT(handle);
+    UNUSED_ARG(events);
+
+    self = (HRTimer *)handle->data;
+    ASSERT(self);
+
+    if (status == 0) {
+        /* number of expirations since the last read, more than 1 if the loop was late */
+        n = read(self->timerfd, &expirations, sizeof(expirations));
+        if (n != sizeof(expirations)) {
+            /* spurious wakeup, or the timer was disarmed meanwhile */
+            PyGILState_Release(gstate);
+            return;
+        }
+    }
+
+    /* Object could go out of scope in the callback, increase refcount to avoid it */
+    Py_INCREF(self);
+
+    if (status == 0) {
+        /* a one shot timer is done, let the loop exit unless the callback starts it again */
+        if (self->interval == 0) {
+            uv_poll_stop(handle);
+        }
+        py_expirations = PyLong_FromUnsignedLongLong((unsigned PY_LONG_LONG)expirations);
+        py_errorno = Py_None;
+        Py_INCREF(Py_None);
+    } else {
+        py_expirations = Py_None;
+        Py_INCREF(Py_None);
+        err = uv_last_error(UV_HANDLE_LOOP(self));
+        py_errorno = pyuv_error_code(err.code);
+    }
+
+    result = pyuv_callback("hrtimer", self->callback, self, py_expirations, py_errorno, NULL);
+    if (result == NULL) {
+        PyErr_WriteUnraisable(self->callback);
+    }
+    Py_XDECREF(result);
+    Py_XDECREF(py_expirations);
+    Py_XDECREF(py_errorno);
+
+    Py_DECREF(self);
+    PyGILState_Release(gstate);
+}
+
+
+static PyObject *
+HRTimer_func_start(HRTimer *self, PyObject *args, PyObject *kwargs)
+{
+    int r;
+    unsigned PY_LONG_LONG deadline, interval;
+    struct itimerspec its;
+    PyObject *tmp, *callback;
+
+    static char *kwlist[] = {"callback", "deadline", "interval", NULL};
+
+    tmp = NULL;
+    interval = 0;
+
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OK|K:start", kwlist, &callback, &deadline, &interval)) {
+        return NULL;
+    }
+
+    if (!PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+
+    /* an all zero it_value disarms the timer, a deadline in the past fires right away */
+    hrtimer_timespec(&its.it_value, deadline ? (uint64_t)deadline : 1);
+    hrtimer_timespec(&its.it_interval, (uint64_t)interval);
+    if (timerfd_settime(self->timerfd, TFD_TIMER_ABSTIME, &its, NULL) != 0) {
+        PyErr_SetFromErrno(PyExc_TimerError);
+        return NULL;
+    }
+
+    r = uv_poll_start((uv_poll_t *)UV_HANDLE(self), UV_READABLE, on_hrtimer_poll);
+    if (r != 0) {
+        RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self), PyExc_TimerError);
+        return NULL;
+    }
+
+    self->interval = (uint64_t)interval;
+
+    tmp = self->callback;
+    Py_INCREF(callback);
+    self->callback = callback;
+    Py_XDECREF(tmp);
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+HRTimer_func_stop(HRTimer *self)
+{
+    int r;
+    struct itimerspec its;
+
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    memset(&its, 0, sizeof(its));
+    if (timerfd_settime(self->timerfd, 0, &its, NULL) != 0) {
+        PyErr_SetFromErrno(PyExc_TimerError);
+        return NULL;
+    }
+
+    r = uv_poll_stop((uv_poll_t *)UV_HANDLE(self));
+    if (r != 0) {
+        RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self), PyExc_TimerError);
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+HRTimer_deadline_get(HRTimer *self, void *closure)
+{
+    struct itimerspec its;
+    uint64_t remaining;
+
+    UNUSED_ARG(closure);
+
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    if (timerfd_gettime(self->timerfd, &its) != 0) {
+        PyErr_SetFromErrno(PyExc_TimerError);
+        return NULL;
+    }
+
+    remaining = (uint64_t)its.it_value.tv_sec * 1000000000 + (uint64_t)its.it_value.tv_nsec;
+    if (remaining == 0) {
+        Py_RETURN_NONE;
+    }
+    return PyLong_FromUnsignedLongLong((unsigned PY_LONG_LONG)(uv_hrtime() + remaining));
+}
+
+
+static PyObject *
+HRTimer_interval_get(HRTimer *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    return PyLong_FromUnsignedLongLong((unsigned PY_LONG_LONG)self->interval);
+}
+
+
+static int
+HRTimer_tp_init(HRTimer *self, PyObject *args, PyObject *kwargs)
+{
+    int r, fd;
+    pyuv_fd_poll_t *uv_poll = NULL;
+    Loop *loop;
+    PyObject *tmp = NULL;
+
+    UNUSED_ARG(kwargs);
+
+    if (UV_HANDLE(self)) {
+        PyErr_SetString(PyExc_TimerError, "Object already initialized");
+        return -1;
+    }
+
+    if (!PyArg_ParseTuple(args, "O!:__init__", &LoopType, &loop)) {
+        return -1;
+    }
+
+    fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd == -1) {
+        PyErr_SetFromErrno(PyExc_TimerError);
+        return -1;
+    }
+
+    tmp = (PyObject *)((Handle *)self)->loop;
+    Py_INCREF(loop);
+    ((Handle *)self)->loop = loop;
+    Py_XDECREF(tmp);
+
+    uv_poll = PyMem_Malloc(sizeof(pyuv_fd_poll_t));
+    if (!uv_poll) {
+        PyErr_NoMemory();
+        close(fd);
+        return -1;
+    }
+
+    r = uv_poll_init(UV_HANDLE_LOOP(self), &uv_poll->poll, fd);
+    if (r != 0) {
+        RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self), PyExc_TimerError);
+        PyMem_Free(uv_poll);
+        close(fd);
+        return -1;
+    }
+    /* the timerfd is closed with the handle, once the poll handle is closed */
+    uv_poll->fds[0] = fd;
+    uv_poll->fds[1] = -1;
+    uv_poll->poll.data = (void *)self;
+    UV_HANDLE(self) = (uv_handle_t *)uv_poll;
+    PYUV_PROBE2(handle__init, self, Py_TYPE(self)->tp_name);
+    self->timerfd = fd;
+
+    return 0;
+}
+
+
+static PyObject *
+HRTimer_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    HRTimer *self = (HRTimer *)HandleType.tp_new(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+    self->timerfd = -1;
+    return (PyObject *)self;
+}
+
+
+static int
+HRTimer_tp_traverse(HRTimer *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->callback);
+    HandleType.tp_traverse((PyObject *)self, visit, arg);
+    return 0;
+}
+
+
+static int
+HRTimer_tp_clear(HRTimer *self)
+{
+    Py_CLEAR(self->callback);
+    HandleType.tp_clear((PyObject *)self);
+    return 0;
+}
+
+
+static void
+HRTimer_tp_dealloc(HRTimer *self)
+{
+    handle_fd_poll_dealloc((Handle *)self);
+    HandleType.tp_dealloc((PyObject *)self);
+}
+
+
+static PyMethodDef
+HRTimer_tp_methods[] = {
+    { "start", (PyCFunction)HRTimer_func_start, METH_VARARGS|METH_KEYWORDS, "Start the HRTimer." },
+    { "stop", (PyCFunction)HRTimer_func_stop, METH_NOARGS, "Stop the HRTimer." },
+    { "close", (PyCFunction)Handle_func_fd_poll_close, METH_VARARGS, "Close handle." },
+    { NULL }
+};
+
+
+static PyGetSetDef HRTimer_tp_getsets[] = {
+    {"deadline", (getter)HRTimer_deadline_get, NULL, "Next expiration, in nanoseconds on the util.hrtime clock.", NULL},
+    {"interval", (getter)HRTimer_interval_get, NULL, "Interval between expirations, in nanoseconds.", NULL},
+    {NULL}
+};
+
+
+static PyTypeObject HRTimerType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv.HRTimer",                                                 /*tp_name*/
+    sizeof(HRTimer),                                                /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    (destructor)HRTimer_tp_dealloc,                                 /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    0,                                                              /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,                        /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)HRTimer_tp_traverse,                              /*tp_traverse*/
+    (inquiry)HRTimer_tp_clear,                                      /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    0,                                                              /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    HRTimer_tp_methods,                                             /*tp_methods*/
+    0,                                                              /*tp_members*/
+    HRTimer_tp_getsets,                                             /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    (initproc)HRTimer_tp_init,                                      /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    HRTimer_tp_new,                                                 /*tp_new*/
+};
+
+#endif
+
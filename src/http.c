@@ -0,0 +1,775 @@
+
+#include <ctype.h>
+#include <limits.h>
+
+/* Incremental HTTP/1.1 request parser, can be attached to a stream with Stream.start_read */
+
+#define HTTP_MAX_HEADER_SIZE    (80 * 1024)
+#define HTTP_MAX_LINE_SIZE      1024
+
+enum {
+    HTTP_STATE_HEADERS = 0,
+    HTTP_STATE_BODY_IDENTITY,
+    HTTP_STATE_CHUNK_SIZE,
+    HTTP_STATE_CHUNK_DATA,
+    HTTP_STATE_CHUNK_DATA_END,
+    HTTP_STATE_TRAILERS,
+    HTTP_STATE_ERROR
+};
+
+
+/* Header data is latin-1, which never fails to decode */
+static INLINE PyObject *
+http_str(const char *data, Py_ssize_t len)
+{
+#ifdef PYUV_PYTHON3
+    return PyUnicode_DecodeLatin1(data, len, NULL);
+#else
+    return PyString_FromStringAndSize(data, len);
+#endif
+}
+
+
+static INLINE Bool
+http_token_eq(const char *data, Py_ssize_t len, const char *token)
+{
+    Py_ssize_t i;
+    for (i = 0; i < len; i++) {
+        if (token[i] == '\0' || tolower((unsigned char)data[i]) != token[i]) {
+            return False;
+        }
+    }
+    return token[len] == '\0';
+}
+
+
+/* Check if the comma separated header value contains the given token (lowercase) */
+static Bool
+http_value_has_token(const char *data, Py_ssize_t len, const char *token)
+{
+    Py_ssize_t start, end;
+
+    start = 0;
+    while (start < len) {
+        end = start;
+        while (end < len && data[end] != ',') {
+            end++;
+        }
+        while (start < end && (data[start] == ' ' || data[start] == '\t')) {
+            start++;
+        }
+        while (end > start && (data[end-1] == ' ' || data[end-1] == '\t')) {
+            end--;
+        }
+        if (http_token_eq(data + start, end - start, token)) {
+            return True;
+        }
+        while (start < len && data[start] != ',') {
+            start++;
+        }
+        start++;
+    }
+    return False;
+}
+
+
+/* A Transfer-Encoding value can only be framed if chunked is the final coding and it's only
+ * applied once */
+static Bool
+http_value_is_chunked(const char *data, Py_ssize_t len)
+{
+    Py_ssize_t start, end;
+
+    end = len;
+    while (end > 0 && (data[end-1] == ' ' || data[end-1] == '\t')) {
+        end--;
+    }
+    start = end;
+    while (start > 0 && data[start-1] != ',') {
+        start--;
+    }
+    /* the codings before the last one */
+    if (start > 0 && http_value_has_token(data, start - 1, "chunked")) {
+        return False;
+    }
+    while (start < end && (data[start] == ' ' || data[start] == '\t')) {
+        start++;
+    }
+    return http_token_eq(data + start, end - start, "chunked");
+}
+
+
+static void
+http_parser_call(HTTPParser *self, PyObject *callback, PyObject *arg1, PyObject *arg2, PyObject *arg3, PyObject *arg4, PyObject *arg5)
+{
+    PyObject *result;
+
+    if (!callback) {
+        return;
+    }
+    result = pyuv_callback("http", callback, self->handle, arg1, arg2, arg3, arg4, arg5, NULL);
+    if (result == NULL) {
+        PyErr_WriteUnraisable(callback);
+    }
+    Py_XDECREF(result);
+}
+
+
+static void
+http_parser_body(HTTPParser *self, const char *data, Py_ssize_t len)
+{
+    PyObject *body;
+
+    if (!self->on_body_cb || len == 0) {
+        return;
+    }
+    body = PyString_FromStringAndSize(data, len);
+    if (!body) {
+        PyErr_WriteUnraisable(self->on_body_cb);
+        return;
+    }
+    http_parser_call(self, self->on_body_cb, body, NULL, NULL, NULL, NULL);
+    Py_DECREF(body);
+}
+
+
+static void
+http_parser_complete(HTTPParser *self)
+{
+    self->state = HTTP_STATE_HEADERS;
+    http_parser_call(self, self->on_complete_cb, NULL, NULL, NULL, NULL, NULL);
+}
+
+
+/* Parse a complete header block (request line and headers, without the final empty line) */
+static int
+http_parse_headers(HTTPParser *self, const char *data, Py_ssize_t len)
+{
+    int major, minor;
+    long long content_length;
+    Bool has_content_length, chunked, keep_alive, conn_close, conn_keep_alive;
+    Py_ssize_t pos, eol, line_len, i, sp1, sp2, colon, vstart, vend;
+    const char *line;
+    PyObject *method, *path, *version, *headers, *header, *name, *value;
+
+    method = path = version = headers = NULL;
+    has_content_length = chunked = conn_close = conn_keep_alive = False;
+    content_length = 0;
+
+    /* Request line */
+    eol = 0;
+    while (eol < len && data[eol] != '\n') {
+        eol++;
+    }
+    line = data;
+    line_len = eol;
+    if (line_len > 0 && line[line_len-1] == '\r') {
+        line_len--;
+    }
+
+    sp1 = sp2 = -1;
+    for (i = 0; i < line_len; i++) {
+        if (line[i] == ' ') {
+            if (sp1 == -1) {
+                sp1 = i;
+            } else if (sp2 == -1) {
+                sp2 = i;
+            } else {
+                return -1;
+            }
+        }
+    }
+    if (sp1 <= 0 || sp2 <= sp1 + 1 || line_len - sp2 - 1 != 8) {
+        return -1;
+    }
+    if (strncmp(line + sp2 + 1, "HTTP/", 5) != 0 || !isdigit((unsigned char)line[sp2+6]) || line[sp2+7] != '.' || !isdigit((unsigned char)line[sp2+8])) {
+        return -1;
+    }
+    major = line[sp2+6] - '0';
+    minor = line[sp2+8] - '0';
+    if (major != 1) {
+        return -1;
+    }
+
+    headers = PyList_New(0);
+    if (!headers) {
+        goto error;
+    }
+
+    /* Headers */
+    pos = eol + 1;
+    while (pos < len) {
+        eol = pos;
+        while (eol < len && data[eol] != '\n') {
+            eol++;
+        }
+        line = data + pos;
+        line_len = eol - pos;
+        if (line_len > 0 && line[line_len-1] == '\r') {
+            line_len--;
+        }
+        pos = eol + 1;
+        if (line_len == 0) {
+            continue;
+        }
+        /* obsolete line folding is not supported */
+        if (line[0] == ' ' || line[0] == '\t') {
+            goto invalid;
+        }
+        colon = 0;
+        while (colon < line_len && line[colon] != ':') {
+            if (line[colon] == ' ' || line[colon] == '\t') {
+                goto invalid;
+            }
+            colon++;
+        }
+        if (colon == 0 || colon == line_len) {
+            goto invalid;
+        }
+        vstart = colon + 1;
+        vend = line_len;
+        while (vstart < vend && (line[vstart] == ' ' || line[vstart] == '\t')) {
+            vstart++;
+        }
+        while (vend > vstart && (line[vend-1] == ' ' || line[vend-1] == '\t')) {
+            vend--;
+        }
+
+        if (http_token_eq(line, colon, "content-length")) {
+            long long value_cl = 0;
+            if (vend == vstart) {
+                goto invalid;
+            }
+            for (i = vstart; i < vend; i++) {
+                if (!isdigit((unsigned char)line[i]) || value_cl > (LLONG_MAX - 9) / 10) {
+                    goto invalid;
+                }
+                value_cl = value_cl * 10 + (line[i] - '0');
+            }
+            if (has_content_length && value_cl != content_length) {
+                goto invalid;
+            }
+            has_content_length = True;
+            content_length = value_cl;
+        } else if (http_token_eq(line, colon, "transfer-encoding")) {
+            /* a previous Transfer-Encoding header already ended with chunked */
+            if (chunked || !http_value_is_chunked(line + vstart, vend - vstart)) {
+                goto invalid;
+            }
+            chunked = True;
+        } else if (http_token_eq(line, colon, "connection")) {
+            if (http_value_has_token(line + vstart, vend - vstart, "close")) {
+                conn_close = True;
+            }
+            if (http_value_has_token(line + vstart, vend - vstart, "keep-alive")) {
+                conn_keep_alive = True;
+            }
+        }
+
+        name = http_str(line, colon);
+        value = http_str(line + vstart, vend - vstart);
+        if (!name || !value) {
+            Py_XDECREF(name);
+            Py_XDECREF(value);
+            goto error;
+        }
+        header = PyTuple_Pack(2, name, value);
+        Py_DECREF(name);
+        Py_DECREF(value);
+        if (!header || PyList_Append(headers, header) != 0) {
+            Py_XDECREF(header);
+            goto error;
+        }
+        Py_DECREF(header);
+    }
+
+    /* A message with both is a request smuggling attempt, refuse it */
+    if (chunked && has_content_length) {
+        goto invalid;
+    }
+
+    if (minor >= 1) {
+        keep_alive = !conn_close;
+    } else {
+        keep_alive = conn_keep_alive && !conn_close;
+    }
+
+    method = http_str(data, sp1);
+    path = http_str(data + sp1 + 1, sp2 - sp1 - 1);
+    version = Py_BuildValue("(ii)", major, minor);
+    if (!method || !path || !version) {
+        goto error;
+    }
+
+    if (chunked) {
+        self->state = HTTP_STATE_CHUNK_SIZE;
+    } else if (content_length > 0) {
+        self->state = HTTP_STATE_BODY_IDENTITY;
+        self->remaining = content_length;
+    } else {
+        self->state = HTTP_STATE_HEADERS;
+    }
+    self->keep_alive = keep_alive;
+
+    http_parser_call(self, self->on_headers_cb, method, path, version, headers, keep_alive ? Py_True : Py_False);
+
+    Py_DECREF(method);
+    Py_DECREF(path);
+    Py_DECREF(version);
+    Py_DECREF(headers);
+
+    if (!chunked && content_length == 0) {
+        http_parser_complete(self);
+    }
+    return 0;
+
+invalid:
+    Py_XDECREF(headers);
+    return -1;
+
+error:
+    PyErr_WriteUnraisable((PyObject *)self);
+    Py_XDECREF(method);
+    Py_XDECREF(path);
+    Py_XDECREF(version);
+    Py_XDECREF(headers);
+    return -1;
+}
+
+
+/* A callback stopped reading from (or closed) the stream the data comes from, pipelined
+ * requests are kept in the buffer until the parser is fed again */
+static INLINE Bool
+http_parser_stopped(HTTPParser *self)
+{
+    if (self->handle == Py_None) {
+        return False;
+    }
+    return ((Stream *)self->handle)->on_read_cb == NULL || UV_HANDLE_CLOSED(self->handle);
+}
+
+
+/* Run the state machine over the given data. Returns the amount of data consumed or -1 if the
+ * request is invalid. Data which isn't consumed has to be fed again, along with more data. */
+static Py_ssize_t
+http_parser_execute(HTTPParser *self, const char *data, Py_ssize_t len)
+{
+    Py_ssize_t pos, i, n, end;
+    long long size;
+    int digit;
+
+    pos = 0;
+    while (pos < len) {
+        if (http_parser_stopped(self)) {
+            return pos;
+        }
+        switch (self->state) {
+            case HTTP_STATE_HEADERS:
+                /* Empty lines before a request are ignored */
+                while (pos < len && (data[pos] == '\r' || data[pos] == '\n')) {
+                    pos++;
+                }
+                end = -1;
+                for (i = pos; i < len; i++) {
+                    if (data[i] != '\n') {
+                        continue;
+                    }
+                    if (i + 1 < len && data[i+1] == '\n') {
+                        end = i + 2;
+                        break;
+                    }
+                    if (i + 2 < len && data[i+1] == '\r' && data[i+2] == '\n') {
+                        end = i + 3;
+                        break;
+                    }
+                }
+                if (end == -1) {
+                    if (len - pos > HTTP_MAX_HEADER_SIZE) {
+                        goto error;
+                    }
+                    return pos;
+                }
+                if (http_parse_headers(self, data + pos, end - pos) != 0) {
+                    goto error;
+                }
+                pos = end;
+                break;
+            case HTTP_STATE_BODY_IDENTITY:
+            case HTTP_STATE_CHUNK_DATA:
+                n = len - pos;
+                if ((long long)n > self->remaining) {
+                    n = (Py_ssize_t)self->remaining;
+                }
+                self->remaining -= n;
+                if (self->remaining == 0) {
+                    self->state = self->state == HTTP_STATE_CHUNK_DATA ? HTTP_STATE_CHUNK_DATA_END : HTTP_STATE_HEADERS;
+                }
+                http_parser_body(self, data + pos, n);
+                pos += n;
+                if (self->remaining == 0 && self->state == HTTP_STATE_HEADERS) {
+                    http_parser_complete(self);
+                }
+                break;
+            case HTTP_STATE_CHUNK_SIZE:
+                end = pos;
+                while (end < len && data[end] != '\n') {
+                    end++;
+                }
+                if (end == len) {
+                    if (len - pos > HTTP_MAX_LINE_SIZE) {
+                        goto error;
+                    }
+                    return pos;
+                }
+                size = 0;
+                for (i = pos; i < end && data[i] != ';' && data[i] != '\r'; i++) {
+                    if (isdigit((unsigned char)data[i])) {
+                        digit = data[i] - '0';
+                    } else if (data[i] >= 'a' && data[i] <= 'f') {
+                        digit = data[i] - 'a' + 10;
+                    } else if (data[i] >= 'A' && data[i] <= 'F') {
+                        digit = data[i] - 'A' + 10;
+                    } else {
+                        goto error;
+                    }
+                    if (size > (LLONG_MAX >> 4)) {
+                        goto error;
+                    }
+                    size = (size << 4) | digit;
+                }
+                if (i == pos) {
+                    goto error;
+                }
+                pos = end + 1;
+                if (size == 0) {
+                    self->state = HTTP_STATE_TRAILERS;
+                } else {
+                    self->state = HTTP_STATE_CHUNK_DATA;
+                    self->remaining = size;
+                }
+                break;
+            case HTTP_STATE_CHUNK_DATA_END:
+                if (data[pos] == '\r') {
+                    if (pos + 1 == len) {
+                        return pos;
+                    }
+                    pos++;
+                }
+                if (data[pos] != '\n') {
+                    goto error;
+                }
+                pos++;
+                self->state = HTTP_STATE_CHUNK_SIZE;
+                break;
+            case HTTP_STATE_TRAILERS:
+                /* Trailers are ignored */
+                end = pos;
+                while (end < len && data[end] != '\n') {
+                    end++;
+                }
+                if (end == len) {
+                    if (len - pos > HTTP_MAX_HEADER_SIZE) {
+                        goto error;
+                    }
+                    return pos;
+                }
+                n = end - pos;
+                pos = end + 1;
+                if (n == 0 || (n == 1 && data[end-1] == '\r')) {
+                    http_parser_complete(self);
+                }
+                break;
+            default:
+                goto error;
+        }
+    }
+
+    return pos;
+
+error:
+    self->state = HTTP_STATE_ERROR;
+    return -1;
+}
+
+
+/* Feed data to the parser, buffering what can't be consumed yet */
+static int
+http_parser_feed(HTTPParser *self, PyObject *handle, const char *data, Py_ssize_t len)
+{
+    char *tmp;
+    Py_ssize_t consumed, size;
+
+    if (self->feeding) {
+        /* the outer call is still parsing from the buffer */
+        PyErr_SetString(PyExc_RuntimeError, "HTTPParser can't be fed from its own callbacks");
+        return -1;
+    }
+
+    if (self->state == HTTP_STATE_ERROR) {
+        return -1;
+    }
+
+    /* Object could go out of scope in the callbacks, increase refcount to avoid it */
+    Py_INCREF(self);
+    self->handle = handle;
+    self->feeding = True;
+
+    if (self->buf_len > 0) {
+        /* Some data is pending, append the new data to it */
+        if (self->buf_len + len > self->buf_size) {
+            size = self->buf_len + len;
+            tmp = (char *) PyMem_Realloc(self->buf, size);
+            if (!tmp) {
+                goto error;
+            }
+            self->buf = tmp;
+            self->buf_size = size;
+        }
+        memcpy(self->buf + self->buf_len, data, len);
+        self->buf_len += len;
+        data = self->buf;
+        len = self->buf_len;
+    }
+
+    consumed = http_parser_execute(self, data, len);
+    if (consumed < 0) {
+        goto error;
+    }
+
+    /* Keep whatever wasn't consumed for the next time */
+    if (consumed < len) {
+        if (data != self->buf) {
+            if (len - consumed > self->buf_size) {
+                tmp = (char *) PyMem_Realloc(self->buf, len - consumed);
+                if (!tmp) {
+                    goto error;
+                }
+                self->buf = tmp;
+                self->buf_size = len - consumed;
+            }
+            memcpy(self->buf, data + consumed, len - consumed);
+        } else {
+            memmove(self->buf, self->buf + consumed, len - consumed);
+        }
+    }
+    self->buf_len = len - consumed;
+
+    self->handle = Py_None;
+    self->feeding = False;
+    Py_DECREF(self);
+    return 0;
+
+error:
+    self->state = HTTP_STATE_ERROR;
+    self->buf_len = 0;
+    self->handle = Py_None;
+    self->feeding = False;
+    Py_DECREF(self);
+    return -1;
+}
+
+
+static PyObject *
+HTTPParser_func_feed(HTTPParser *self, PyObject *args)
+{
+    int r;
+    Py_buffer pbuf;
+
+    if (!PyArg_ParseTuple(args, "s*:feed", &pbuf)) {
+        return NULL;
+    }
+
+    r = http_parser_feed(self, Py_None, pbuf.buf, pbuf.len);
+    PyBuffer_Release(&pbuf);
+    if (r != 0) {
+        if (!PyErr_Occurred()) {
+            PyErr_SetString(PyExc_ValueError, "invalid HTTP request");
+        }
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+HTTPParser_func_reset(HTTPParser *self)
+{
+    if (self->feeding) {
+        PyErr_SetString(PyExc_RuntimeError, "HTTPParser can't be reset from its own callbacks");
+        return NULL;
+    }
+
+    self->state = HTTP_STATE_HEADERS;
+    self->buf_len = 0;
+    self->remaining = 0;
+    self->keep_alive = False;
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+HTTPParser_keep_alive_get(HTTPParser *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    return PyBool_FromLong((long)self->keep_alive);
+}
+
+
+static int
+HTTPParser_tp_init(HTTPParser *self, PyObject *args, PyObject *kwargs)
+{
+    PyObject *on_headers_cb, *on_body_cb, *on_complete_cb, *tmp;
+
+    static char *kwlist[] = {"on_headers", "on_body", "on_complete", NULL};
+
+    if (self->feeding) {
+        PyErr_SetString(PyExc_RuntimeError, "HTTPParser can't be initialized from its own callbacks");
+        return -1;
+    }
+
+    on_body_cb = on_complete_cb = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|OO:__init__", kwlist, &on_headers_cb, &on_body_cb, &on_complete_cb)) {
+        return -1;
+    }
+
+    if (!PyCallable_Check(on_headers_cb)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return -1;
+    }
+
+    if ((on_body_cb != Py_None && !PyCallable_Check(on_body_cb)) || (on_complete_cb != Py_None && !PyCallable_Check(on_complete_cb))) {
+        PyErr_SetString(PyExc_TypeError, "a callable or None is required");
+        return -1;
+    }
+
+    tmp = self->on_headers_cb;
+    Py_INCREF(on_headers_cb);
+    self->on_headers_cb = on_headers_cb;
+    Py_XDECREF(tmp);
+
+    tmp = self->on_body_cb;
+    if (on_body_cb != Py_None) {
+        Py_INCREF(on_body_cb);
+        self->on_body_cb = on_body_cb;
+    } else {
+        self->on_body_cb = NULL;
+    }
+    Py_XDECREF(tmp);
+
+    tmp = self->on_complete_cb;
+    if (on_complete_cb != Py_None) {
+        Py_INCREF(on_complete_cb);
+        self->on_complete_cb = on_complete_cb;
+    } else {
+        self->on_complete_cb = NULL;
+    }
+    Py_XDECREF(tmp);
+
+    self->state = HTTP_STATE_HEADERS;
+    self->buf_len = 0;
+
+    return 0;
+}
+
+
+static PyObject *
+HTTPParser_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    HTTPParser *self = (HTTPParser *)PyType_GenericNew(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+    self->handle = Py_None;
+    self->buf = NULL;
+    self->buf_len = self->buf_size = 0;
+    self->feeding = False;
+    return (PyObject *)self;
+}
+
+
+static int
+HTTPParser_tp_traverse(HTTPParser *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->on_headers_cb);
+    Py_VISIT(self->on_body_cb);
+    Py_VISIT(self->on_complete_cb);
+    return 0;
+}
+
+
+static int
+HTTPParser_tp_clear(HTTPParser *self)
+{
+    Py_CLEAR(self->on_headers_cb);
+    Py_CLEAR(self->on_body_cb);
+    Py_CLEAR(self->on_complete_cb);
+    return 0;
+}
+
+
+static void
+HTTPParser_tp_dealloc(HTTPParser *self)
+{
+    HTTPParser_tp_clear(self);
+    PyMem_Free(self->buf);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+
+static PyMethodDef
+HTTPParser_tp_methods[] = {
+    { "feed", (PyCFunction)HTTPParser_func_feed, METH_VARARGS, "Feed data to the parser." },
+    { "reset", (PyCFunction)HTTPParser_func_reset, METH_NOARGS, "Reset the parser state, discarding any buffered data." },
+    { NULL }
+};
+
+
+static PyGetSetDef HTTPParser_tp_getsets[] = {
+    {"keep_alive", (getter)HTTPParser_keep_alive_get, NULL, "Indicates if the connection should be kept alive after the current request.", NULL},
+    {NULL}
+};
+
+
+static PyTypeObject HTTPParserType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv.HTTPParser",                                              /*tp_name*/
+    sizeof(HTTPParser),                                             /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    (destructor)HTTPParser_tp_dealloc,                              /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    0,                                                              /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,                        /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)HTTPParser_tp_traverse,                           /*tp_traverse*/
+    (inquiry)HTTPParser_tp_clear,                                   /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    0,                                                              /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    HTTPParser_tp_methods,                                          /*tp_methods*/
+    0,                                                              /*tp_members*/
+    HTTPParser_tp_getsets,                                          /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    (initproc)HTTPParser_tp_init,                                   /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    HTTPParser_tp_new,                                              /*tp_new*/
+};
+
@@ -14,7 +14,7 @@ on_idle_callback(uv_idle_t *handle, int status)
     /* Object could go out of scope in the callback, increase refcount to avoid it */
     Py_INCREF(self);
 
-    result = PyObject_CallFunctionObjArgs(self->callback, self, NULL);
+    result = pyuv_callback("idle", self->callback, self, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(self->callback);
     }
@@ -118,6 +118,7 @@ Idle_tp_init(Idle *self, PyObject *args, PyObject *kwargs)
     }
     uv_idle->data = (void *)self;
     UV_HANDLE(self) = (uv_handle_t *)uv_idle;
+    PYUV_PROBE2(handle__init, self, Py_TYPE(self)->tp_name);
 
     return 0;
 }
@@ -0,0 +1,351 @@
+
+/* Native work kernels run by the ThreadPool without the GIL: they only see plain memory and
+ * never touch Python objects or the Python allocator. The SHA and CRC-32 implementations
+ * are only used when OpenSSL and zlib (respectively) were not found at build time */
+
+#define KERNEL_SHA1_SIZE    20
+#define KERNEL_SHA256_SIZE  32
+
+#ifndef PYUV_HAVE_OPENSSL
+#define KERNEL_ROTL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define KERNEL_ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;        /* bytes */
+    unsigned char block[64];
+    size_t used;
+} kernel_sha_t;
+
+typedef void (*kernel_sha_compress_t)(uint32_t *state, const unsigned char *block);
+
+
+static INLINE uint32_t
+kernel_load_be32(const unsigned char *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+
+static INLINE void
+kernel_store_be32(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+
+static void
+kernel_sha1_compress(uint32_t *state, const unsigned char *block)
+{
+    uint32_t w[80], a, b, c, d, e, f, k, t;
+    int i;
+
+    for (i = 0; i < 16; i++) {
+        w[i] = kernel_load_be32(block + i * 4);
+    }
+    for (i = 16; i < 80; i++) {
+        w[i] = KERNEL_ROTL(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+
+    for (i = 0; i < 80; i++) {
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5a827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ed9eba1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8f1bbcdc;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xca62c1d6;
+        }
+        t = KERNEL_ROTL(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = KERNEL_ROTL(b, 30);
+        b = a;
+        a = t;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+}
+
+
+static const uint32_t kernel_sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+
+static void
+kernel_sha256_compress(uint32_t *state, const unsigned char *block)
+{
+    uint32_t w[64], s[8], s0, s1, ch, maj, t1, t2;
+    int i;
+
+    for (i = 0; i < 16; i++) {
+        w[i] = kernel_load_be32(block + i * 4);
+    }
+    for (i = 16; i < 64; i++) {
+        s0 = KERNEL_ROTR(w[i - 15], 7) ^ KERNEL_ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        s1 = KERNEL_ROTR(w[i - 2], 17) ^ KERNEL_ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    for (i = 0; i < 8; i++) {
+        s[i] = state[i];
+    }
+
+    for (i = 0; i < 64; i++) {
+        s1 = KERNEL_ROTR(s[4], 6) ^ KERNEL_ROTR(s[4], 11) ^ KERNEL_ROTR(s[4], 25);
+        ch = (s[4] & s[5]) ^ (~s[4] & s[6]);
+        t1 = s[7] + s1 + ch + kernel_sha256_k[i] + w[i];
+        s0 = KERNEL_ROTR(s[0], 2) ^ KERNEL_ROTR(s[0], 13) ^ KERNEL_ROTR(s[0], 22);
+        maj = (s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]);
+        t2 = s0 + maj;
+        s[7] = s[6];
+        s[6] = s[5];
+        s[5] = s[4];
+        s[4] = s[3] + t1;
+        s[3] = s[2];
+        s[2] = s[1];
+        s[1] = s[0];
+        s[0] = t1 + t2;
+    }
+
+    for (i = 0; i < 8; i++) {
+        state[i] += s[i];
+    }
+}
+
+
+/* SHA-1 and SHA-256 share the padding, only the compression function and the size differ */
+static void
+kernel_sha(kernel_sha_compress_t compress, uint32_t *state, int words, const unsigned char *data, size_t len, unsigned char *digest)
+{
+    unsigned char block[64];
+    uint64_t bits = (uint64_t)len * 8;
+    size_t rest;
+    int i;
+
+    for (; len >= 64; data += 64, len -= 64) {
+        compress(state, data);
+    }
+
+    rest = len;
+    memcpy(block, data, rest);
+    block[rest++] = 0x80;
+    if (rest > 56) {
+        memset(block + rest, 0, 64 - rest);
+        compress(state, block);
+        rest = 0;
+    }
+    memset(block + rest, 0, 56 - rest);
+    kernel_store_be32(block + 56, (uint32_t)(bits >> 32));
+    kernel_store_be32(block + 60, (uint32_t)bits);
+    compress(state, block);
+
+    for (i = 0; i < words; i++) {
+        kernel_store_be32(digest + i * 4, state[i]);
+    }
+}
+
+
+static void
+kernel_sha1(const unsigned char *data, size_t len, unsigned char *digest)
+{
+    uint32_t state[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+    kernel_sha(kernel_sha1_compress, state, 5, data, len, digest);
+}
+
+
+static void
+kernel_sha256(const unsigned char *data, size_t len, unsigned char *digest)
+{
+    uint32_t state[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    kernel_sha(kernel_sha256_compress, state, 8, data, len, digest);
+}
+#endif
+
+
+#ifndef PYUV_HAVE_ZLIB
+/* CRC-32 (IEEE 802.3, as zlib.crc32 and binascii.crc32), sliced by 4 */
+static uint32_t kernel_crc32_table[4][256];
+static int kernel_crc32_ready = 0;
+
+static void
+kernel_crc32_init(void)
+{
+    uint32_t c;
+    int i, j;
+
+    for (i = 0; i < 256; i++) {
+        c = (uint32_t)i;
+        for (j = 0; j < 8; j++) {
+            c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+        }
+        kernel_crc32_table[0][i] = c;
+    }
+    for (i = 0; i < 256; i++) {
+        c = kernel_crc32_table[0][i];
+        for (j = 1; j < 4; j++) {
+            c = kernel_crc32_table[0][c & 0xff] ^ (c >> 8);
+            kernel_crc32_table[j][i] = c;
+        }
+    }
+    kernel_crc32_ready = 1;
+}
+
+
+static uint32_t
+kernel_crc32(uint32_t crc, const unsigned char *data, size_t len)
+{
+    crc = ~crc;
+    for (; len >= 4; data += 4, len -= 4) {
+        crc ^= (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+        crc = kernel_crc32_table[3][crc & 0xff] ^ kernel_crc32_table[2][(crc >> 8) & 0xff] ^
+              kernel_crc32_table[1][(crc >> 16) & 0xff] ^ kernel_crc32_table[0][crc >> 24];
+    }
+    while (len--) {
+        crc = kernel_crc32_table[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+#endif
+
+
+/* Base64, standard alphabet with padding. Decoding is strict: no whitespace is skipped */
+static const char kernel_b64_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static size_t
+kernel_b64encode(const unsigned char *data, size_t len, char *out)
+{
+    char *p = out;
+    uint32_t v;
+
+    for (; len >= 3; data += 3, len -= 3) {
+        v = ((uint32_t)data[0] << 16) | ((uint32_t)data[1] << 8) | data[2];
+        *p++ = kernel_b64_alphabet[(v >> 18) & 0x3f];
+        *p++ = kernel_b64_alphabet[(v >> 12) & 0x3f];
+        *p++ = kernel_b64_alphabet[(v >> 6) & 0x3f];
+        *p++ = kernel_b64_alphabet[v & 0x3f];
+    }
+    if (len) {
+        v = (uint32_t)data[0] << 16;
+        if (len == 2) {
+            v |= (uint32_t)data[1] << 8;
+        }
+        *p++ = kernel_b64_alphabet[(v >> 18) & 0x3f];
+        *p++ = kernel_b64_alphabet[(v >> 12) & 0x3f];
+        *p++ = len == 2 ? kernel_b64_alphabet[(v >> 6) & 0x3f] : '=';
+        *p++ = '=';
+    }
+    return p - out;
+}
+
+
+static INLINE int
+kernel_b64_value(unsigned char c)
+{
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A';
+    } else if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 26;
+    } else if (c >= '0' && c <= '9') {
+        return c - '0' + 52;
+    } else if (c == '+') {
+        return 62;
+    } else if (c == '/') {
+        return 63;
+    }
+    return -1;
+}
+
+
+/* Returns the decoded size, or -1 if the input is not valid base64 */
+static Py_ssize_t
+kernel_b64decode(const unsigned char *data, size_t len, unsigned char *out)
+{
+    unsigned char *p = out;
+    size_t i, pad;
+    int a, b, c, d;
+
+    if (len % 4 != 0) {
+        return -1;
+    }
+    pad = 0;
+    if (len && data[len - 1] == '=') {
+        pad = (len >= 2 && data[len - 2] == '=') ? 2 : 1;
+    }
+
+    for (i = 0; i < len; i += 4) {
+        a = kernel_b64_value(data[i]);
+        b = kernel_b64_value(data[i + 1]);
+        if (i + 4 == len && pad) {
+            c = pad == 2 ? 0 : kernel_b64_value(data[i + 2]);
+            d = 0;
+        } else {
+            c = kernel_b64_value(data[i + 2]);
+            d = kernel_b64_value(data[i + 3]);
+        }
+        if (a < 0 || b < 0 || c < 0 || d < 0) {
+            return -1;
+        }
+        *p++ = (unsigned char)((a << 2) | (b >> 4));
+        if (i + 4 < len || pad < 2) {
+            *p++ = (unsigned char)((b << 4) | (c >> 2));
+        }
+        if (i + 4 < len || pad < 1) {
+            *p++ = (unsigned char)((c << 6) | d);
+        }
+    }
+    return p - out;
+}
+
+
+/* Index of the first occurrence of needle in haystack, or -1 */
+static Py_ssize_t
+kernel_find(const unsigned char *haystack, size_t len, const unsigned char *needle, size_t nlen)
+{
+    const unsigned char *p, *end;
+
+    if (nlen == 0) {
+        return 0;
+    }
+    if (nlen > len) {
+        return -1;
+    }
+    end = haystack + len - nlen + 1;
+    for (p = haystack; p < end; p++) {
+        p = memchr(p, needle[0], end - p);
+        if (!p) {
+            break;
+        }
+        if (memcmp(p, needle, nlen) == 0) {
+            return p - haystack;
+        }
+    }
+    return -1;
+}
+
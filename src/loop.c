@@ -9,6 +9,121 @@ _loop_cleanup(void)
 }
 
 
+#ifdef PYUV_HAVE_SDT
+static void
+on_loop_probe_prepare(uv_prepare_t *handle, int status)
+{
+    Loop *self = (Loop *)handle->loop->data;
+    UNUSED_ARG(status);
+    self->probe_poll_start = PYUV_PROBE_ENABLED(loop__poll__end) ? uv_hrtime() : 0;
+    PYUV_PROBE1(loop__poll__start, self);
+}
+
+
+static void
+on_loop_probe_check(uv_check_t *handle, int status)
+{
+    Loop *self = (Loop *)handle->loop->data;
+    UNUSED_ARG(status);
+    if (PYUV_PROBE_ENABLED(loop__poll__end)) {
+        PYUV_PROBE2(loop__poll__end, self, self->probe_poll_start ? uv_hrtime() - self->probe_poll_start : 0);
+    } else if (!PYUV_PROBE_ENABLED(loop__poll__start)) {
+        uv_prepare_stop(&self->probe_prepare);
+        uv_check_stop(&self->probe_check);
+    }
+}
+
+
+static void
+loop_probes_init(Loop *self)
+{
+    uv_prepare_init(self->uv_loop, &self->probe_prepare);
+    uv_check_init(self->uv_loop, &self->probe_check);
+    self->probe_prepare.data = self->probe_check.data = NULL;
+    uv_unref((uv_handle_t *)&self->probe_prepare);
+    uv_unref((uv_handle_t *)&self->probe_check);
+}
+#endif
+
+
+/* The probe handles only run while a tracer has the poll probes enabled. They are started
+ * when the loop starts running, and stop themselves once the probes are disabled */
+static INLINE void
+loop_probes_update(Loop *self)
+{
+#ifdef PYUV_HAVE_SDT
+    if (PYUV_PROBE_ENABLED(loop__poll__start) || PYUV_PROBE_ENABLED(loop__poll__end)) {
+        if (!uv_is_active((uv_handle_t *)&self->probe_prepare)) {
+            uv_prepare_start(&self->probe_prepare, on_loop_probe_prepare);
+            uv_check_start(&self->probe_check, on_loop_probe_check);
+        }
+    } else if (uv_is_active((uv_handle_t *)&self->probe_prepare)) {
+        uv_prepare_stop(&self->probe_prepare);
+        uv_check_stop(&self->probe_check);
+    }
+#else
+    UNUSED_ARG(self);
+#endif
+}
+
+
+static void
+on_loop_threadsafe_async(uv_async_t *handle, int status)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    Loop *self = (Loop *)handle->loop->data;
+    loop_threadsafe_call_t *call;
+    pyuv_mpsc_node_t *node;
+    PyObject *result;
+
+    UNUSED_ARG(status);
+
+    node = pyuv_mpsc_take(&self->threadsafe_calls);
+    while (node) {
+        call = (loop_threadsafe_call_t *)node;
+        node = node->next;
+
+        result = pyuv_callback_array("call_soon_threadsafe", call->callable, ((PyTupleObject *)call->args)->ob_item, PyTuple_GET_SIZE(call->args));
+        if (result == NULL) {
+            PyErr_WriteUnraisable(call->callable);
+        }
+        Py_XDECREF(result);
+        Py_DECREF(call->callable);
+        Py_DECREF(call->args);
+        PyMem_Free(call);
+    }
+
+    PyGILState_Release(gstate);
+}
+
+
+static void
+loop_threadsafe_init(Loop *self)
+{
+    uv_async_init(self->uv_loop, &self->threadsafe_async, on_loop_threadsafe_async);
+    self->threadsafe_async.data = NULL;
+    uv_unref((uv_handle_t *)&self->threadsafe_async);
+    self->threadsafe_calls = NULL;
+}
+
+
+static void
+loop_threadsafe_clear(Loop *self)
+{
+    loop_threadsafe_call_t *call;
+    pyuv_mpsc_node_t *node;
+
+    node = pyuv_mpsc_take(&self->threadsafe_calls);
+    while (node) {
+        call = (loop_threadsafe_call_t *)node;
+        node = node->next;
+        Py_DECREF(call->callable);
+        Py_DECREF(call->args);
+        PyMem_Free(call);
+    }
+}
+
+
 static PyObject *
 new_loop(PyTypeObject *type, PyObject *args, PyObject *kwargs, int is_default)
 {
@@ -27,6 +142,10 @@ new_loop(PyTypeObject *type, PyObject *args, PyObject *kwargs, int is_default)
             default_loop->uv_loop->data = (void *)default_loop;
             default_loop->is_default = 1;
             default_loop->weakreflist = NULL;
+            loop_threadsafe_init(default_loop);
+#ifdef PYUV_HAVE_SDT
+            loop_probes_init(default_loop);
+#endif
             Py_AtExit(_loop_cleanup);
         }
         Py_INCREF(default_loop);
@@ -40,21 +159,118 @@ new_loop(PyTypeObject *type, PyObject *args, PyObject *kwargs, int is_default)
         self->uv_loop->data = (void *)self;
         self->is_default = 0;
         self->weakreflist = NULL;
+        loop_threadsafe_init(self);
+#ifdef PYUV_HAVE_SDT
+        loop_probes_init(self);
+#endif
         return (PyObject *)self;
     }
 }
 
 
+/* The internal handles have no Python object, they find the Loop through the uv loop */
+
+static void
+on_loop_run_idle(uv_idle_t *handle, int status)
+{
+    /* Nothing to do, an active idle handle is enough to make the poll phase non blocking */
+    UNUSED_ARG(handle);
+    UNUSED_ARG(status);
+}
+
+
+static void
+on_loop_run_check(uv_check_t *handle, int status)
+{
+    Loop *self = (Loop *)handle->loop->data;
+    UNUSED_ARG(status);
+    uv_idle_stop(&self->run_idle);
+    uv_check_stop(&self->run_check);
+}
+
+
+/* Make the current (or next) loop iteration poll for I/O without blocking */
+static void
+loop_run_nowait(Loop *self)
+{
+    uv_idle_start(&self->run_idle, on_loop_run_idle);
+    uv_check_start(&self->run_check, on_loop_run_check);
+}
+
+
+static void
+on_loop_run_timer(uv_timer_t *handle, int status)
+{
+    Loop *self = (Loop *)handle->loop->data;
+    UNUSED_ARG(status);
+    self->run_timed_out = True;
+    /* other timers could make the rest of this iteration block past the deadline */
+    loop_run_nowait(self);
+}
+
+
+static void
+loop_run_handles_init(Loop *self)
+{
+    if (self->run_handles_init) {
+        return;
+    }
+    uv_idle_init(self->uv_loop, &self->run_idle);
+    uv_check_init(self->uv_loop, &self->run_check);
+    uv_timer_init(self->uv_loop, &self->run_timer);
+    self->run_idle.data = self->run_check.data = self->run_timer.data = NULL;
+    /* they must never keep the loop alive */
+    uv_unref((uv_handle_t *)&self->run_idle);
+    uv_unref((uv_handle_t *)&self->run_check);
+    uv_unref((uv_handle_t *)&self->run_timer);
+    self->run_handles_init = True;
+}
+
+
 static PyObject *
-Loop_func_run(Loop *self)
+Loop_func_run(Loop *self, PyObject *args, PyObject *kwargs)
 {
+    int r, mode;
+    Loop *prev_loop;
+
+    static char *kwlist[] = {"mode", NULL};
+
+    mode = PYUV_RUN_DEFAULT;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|i:run", kwlist, &mode)) {
+        return NULL;
+    }
+
+    if (mode != PYUV_RUN_DEFAULT && mode != PYUV_RUN_ONCE && mode != PYUV_RUN_NOWAIT) {
+        PyErr_SetString(PyExc_ValueError, "invalid run mode");
+        return NULL;
+    }
+
+    if (mode == PYUV_RUN_NOWAIT) {
+        loop_run_handles_init(self);
+        loop_run_nowait(self);
+    }
+
+    prev_loop = pyuv_current_loop;
+    pyuv_current_loop = self;
+    loop_probes_update(self);
+    PYUV_PROBE2(loop__run__start, self, mode);
     Py_BEGIN_ALLOW_THREADS
-    uv_run(self->uv_loop);
+    if (mode == PYUV_RUN_DEFAULT) {
+        r = uv_run(self->uv_loop);
+    } else {
+        r = uv_run_once(self->uv_loop);
+    }
     Py_END_ALLOW_THREADS
+    PYUV_PROBE1(loop__run__end, self);
+    pyuv_current_loop = prev_loop;
     if (PyErr_Occurred()) {
         PyErr_WriteUnraisable(Py_None);
     }
-    Py_RETURN_NONE;
+    if (mode == PYUV_RUN_DEFAULT) {
+        Py_RETURN_NONE;
+    }
+    return PyBool_FromLong((long)r);
 }
 
 
@@ -62,10 +278,17 @@ static PyObject *
 Loop_func_run_once(Loop *self)
 {
     int r;
+    Loop *prev_loop;
 
+    prev_loop = pyuv_current_loop;
+    pyuv_current_loop = self;
+    loop_probes_update(self);
+    PYUV_PROBE2(loop__run__start, self, PYUV_RUN_ONCE);
     Py_BEGIN_ALLOW_THREADS
     r = uv_run_once(self->uv_loop);
     Py_END_ALLOW_THREADS
+    PYUV_PROBE1(loop__run__end, self);
+    pyuv_current_loop = prev_loop;
     if (PyErr_Occurred()) {
         PyErr_WriteUnraisable(Py_None);
     }
@@ -73,6 +296,719 @@ Loop_func_run_once(Loop *self)
 }
 
 
+static PyObject *
+Loop_func_run_for(Loop *self, PyObject *args)
+{
+    int r;
+    double timeout;
+    Loop *prev_loop;
+
+    if (!PyArg_ParseTuple(args, "d:run_for", &timeout)) {
+        return NULL;
+    }
+
+    if (timeout < 0.0) {
+        PyErr_SetString(PyExc_ValueError, "a positive value or zero is required");
+        return NULL;
+    }
+
+    loop_run_handles_init(self);
+    self->run_timed_out = False;
+    /* the deadline is relative to the current time, not to the start of the last iteration */
+    uv_update_time(self->uv_loop);
+    uv_timer_start(&self->run_timer, on_loop_run_timer, (int64_t)(timeout * 1000), 0);
+
+    prev_loop = pyuv_current_loop;
+    pyuv_current_loop = self;
+    loop_probes_update(self);
+    PYUV_PROBE2(loop__run__start, self, PYUV_RUN_DEFAULT);
+    Py_BEGIN_ALLOW_THREADS
+    do {
+        r = uv_run_once(self->uv_loop);
+    } while (r && !self->run_timed_out);
+    Py_END_ALLOW_THREADS
+    PYUV_PROBE1(loop__run__end, self);
+    pyuv_current_loop = prev_loop;
+
+    uv_timer_stop(&self->run_timer);
+    if (PyErr_Occurred()) {
+        PyErr_WriteUnraisable(Py_None);
+    }
+    return PyBool_FromLong((long)r);
+}
+
+
+/* Loop monitor: the prepare and check handles surround the poll phase, so prepare to prepare
+ * is a whole iteration. Time spent in Python callbacks is accounted by pyuv_callback. */
+
+static INLINE int
+loop_histogram_index(uint64_t value)
+{
+    int msb, shift;
+
+    if (value < (2 << LOOP_HISTOGRAM_SUB_BITS)) {
+        return (int)value;
+    }
+#if defined(__GNUC__)
+    msb = 63 - __builtin_clzll(value);
+#else
+    msb = 0;
+    while (value >> (msb + 1)) {
+        msb++;
+    }
+#endif
+    shift = msb - LOOP_HISTOGRAM_SUB_BITS;
+    return (shift << LOOP_HISTOGRAM_SUB_BITS) + (int)(value >> shift);
+}
+
+
+/* Highest value which falls in the given bucket */
+static INLINE uint64_t
+loop_histogram_value(int index)
+{
+    int shift;
+    uint64_t mantissa;
+
+    if (index < (2 << LOOP_HISTOGRAM_SUB_BITS)) {
+        return (uint64_t)index;
+    }
+    shift = (index >> LOOP_HISTOGRAM_SUB_BITS) - 1;
+    mantissa = (uint64_t)((index & ((1 << LOOP_HISTOGRAM_SUB_BITS) - 1)) + (1 << LOOP_HISTOGRAM_SUB_BITS));
+    return (mantissa << shift) + ((uint64_t)1 << shift) - 1;
+}
+
+
+static void
+loop_histogram_record(loop_histogram_t *h, uint64_t value)
+{
+    if (h->count == 0 || value < h->min) {
+        h->min = value;
+    }
+    if (value > h->max) {
+        h->max = value;
+    }
+    h->count++;
+    h->sum += value;
+    h->buckets[loop_histogram_index(value)]++;
+}
+
+
+static uint64_t
+loop_histogram_percentile(loop_histogram_t *h, double percentile)
+{
+    int i;
+    uint64_t target, seen, value;
+
+    target = (uint64_t)(percentile * h->count + 0.5);
+    if (target == 0) {
+        target = 1;
+    }
+    seen = 0;
+    for (i = 0; i < LOOP_HISTOGRAM_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen >= target) {
+            value = loop_histogram_value(i);
+            return value < h->max ? value : h->max;
+        }
+    }
+    return h->max;
+}
+
+
+static PyObject *
+loop_histogram_result(loop_histogram_t *h)
+{
+    PyObject *result;
+
+    result = PyStructSequence_New(&LoopMonitorResultType);
+    if (!result) {
+        return NULL;
+    }
+
+    PyStructSequence_SET_ITEM(result, 0, PyLong_FromUnsignedLongLong(h->count));
+    PyStructSequence_SET_ITEM(result, 1, PyFloat_FromDouble(h->min / 1e9));
+    PyStructSequence_SET_ITEM(result, 2, PyFloat_FromDouble(h->count ? (double)h->sum / h->count / 1e9 : 0.0));
+    PyStructSequence_SET_ITEM(result, 3, PyFloat_FromDouble(h->count ? loop_histogram_percentile(h, 0.50) / 1e9 : 0.0));
+    PyStructSequence_SET_ITEM(result, 4, PyFloat_FromDouble(h->count ? loop_histogram_percentile(h, 0.90) / 1e9 : 0.0));
+    PyStructSequence_SET_ITEM(result, 5, PyFloat_FromDouble(h->count ? loop_histogram_percentile(h, 0.99) / 1e9 : 0.0));
+    PyStructSequence_SET_ITEM(result, 6, PyFloat_FromDouble(h->max / 1e9));
+
+    return result;
+}
+
+
+static void
+loop_monitor_reset(loop_monitor_t *monitor)
+{
+    monitor->last_prepare = 0;
+    monitor->last_timer = uv_hrtime();
+    memset(&monitor->iteration, 0, sizeof(loop_histogram_t));
+    memset(&monitor->callbacks, 0, sizeof(loop_histogram_t));
+    memset(&monitor->poll, 0, sizeof(loop_histogram_t));
+    memset(&monitor->timer_delay, 0, sizeof(loop_histogram_t));
+}
+
+
+static void
+on_loop_monitor_prepare(uv_prepare_t *handle, int status)
+{
+    uint64_t now;
+    loop_monitor_t *monitor = ((Loop *)handle->loop->data)->monitor;
+
+    UNUSED_ARG(status);
+
+    now = uv_hrtime();
+    if (monitor->last_prepare) {
+        loop_histogram_record(&monitor->iteration, now - monitor->last_prepare);
+        loop_histogram_record(&monitor->callbacks, monitor->callback_time - monitor->callback_time_iteration);
+    }
+    monitor->last_prepare = monitor->poll_start = now;
+    monitor->callback_time_iteration = monitor->callback_time_poll = monitor->callback_time;
+}
+
+
+static void
+on_loop_monitor_check(uv_check_t *handle, int status)
+{
+    uint64_t elapsed, in_callbacks;
+    loop_monitor_t *monitor = ((Loop *)handle->loop->data)->monitor;
+
+    UNUSED_ARG(status);
+
+    if (!monitor->last_prepare) {
+        return;
+    }
+    /* I/O callbacks run inside the poll phase, they don't count as polling */
+    elapsed = uv_hrtime() - monitor->poll_start;
+    in_callbacks = monitor->callback_time - monitor->callback_time_poll;
+    loop_histogram_record(&monitor->poll, elapsed > in_callbacks ? elapsed - in_callbacks : 0);
+}
+
+
+static void
+on_loop_monitor_timer(uv_timer_t *handle, int status)
+{
+    uint64_t now, elapsed;
+    loop_monitor_t *monitor = ((Loop *)handle->loop->data)->monitor;
+
+    UNUSED_ARG(status);
+
+    now = uv_hrtime();
+    elapsed = now - monitor->last_timer;
+    loop_histogram_record(&monitor->timer_delay, elapsed > monitor->timer_interval ? elapsed - monitor->timer_interval : 0);
+    monitor->last_timer = now;
+}
+
+
+static PyObject *
+Loop_func_start_monitor(Loop *self, PyObject *args)
+{
+    double resolution;
+    loop_monitor_t *monitor;
+
+    resolution = 0.01;
+
+    if (!PyArg_ParseTuple(args, "|d:start_monitor", &resolution)) {
+        return NULL;
+    }
+
+    if (resolution < 0.001) {
+        PyErr_SetString(PyExc_ValueError, "resolution must be at least 1ms");
+        return NULL;
+    }
+
+    monitor = self->monitor;
+    if (!monitor) {
+        monitor = PyMem_Malloc(sizeof(loop_monitor_t));
+        if (!monitor) {
+            return PyErr_NoMemory();
+        }
+        memset(monitor, 0, sizeof(loop_monitor_t));
+        uv_prepare_init(self->uv_loop, &monitor->prepare);
+        uv_check_init(self->uv_loop, &monitor->check);
+        uv_timer_init(self->uv_loop, &monitor->timer);
+        monitor->prepare.data = monitor->check.data = monitor->timer.data = NULL;
+        /* monitoring must not keep the loop alive */
+        uv_unref((uv_handle_t *)&monitor->prepare);
+        uv_unref((uv_handle_t *)&monitor->check);
+        uv_unref((uv_handle_t *)&monitor->timer);
+        self->monitor = monitor;
+    }
+
+    loop_monitor_reset(monitor);
+    monitor->timer_interval = (uint64_t)(resolution * 1000) * 1000000;
+    uv_prepare_start(&monitor->prepare, on_loop_monitor_prepare);
+    uv_check_start(&monitor->check, on_loop_monitor_check);
+    uv_timer_start(&monitor->timer, on_loop_monitor_timer, (int64_t)(resolution * 1000), (int64_t)(resolution * 1000));
+    monitor->active = True;
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+Loop_func_stop_monitor(Loop *self)
+{
+    loop_monitor_t *monitor = self->monitor;
+
+    if (monitor && monitor->active) {
+        uv_prepare_stop(&monitor->prepare);
+        uv_check_stop(&monitor->check);
+        uv_timer_stop(&monitor->timer);
+        monitor->active = False;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+Loop_func_monitor_stats(Loop *self, PyObject *args, PyObject *kwargs)
+{
+    PyObject *reset, *stats, *item;
+    loop_monitor_t *monitor = self->monitor;
+
+    static char *kwlist[] = {"reset", NULL};
+
+    reset = Py_False;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|O:monitor_stats", kwlist, &reset)) {
+        return NULL;
+    }
+
+    if (!monitor) {
+        Py_RETURN_NONE;
+    }
+
+    stats = PyDict_New();
+    if (!stats) {
+        return NULL;
+    }
+
+#define XX(name)                                                                \
+    item = loop_histogram_result(&monitor->name);                               \
+    if (!item || PyDict_SetItemString(stats, #name, item) != 0) {               \
+        Py_XDECREF(item);                                                       \
+        Py_DECREF(stats);                                                       \
+        return NULL;                                                            \
+    }                                                                           \
+    Py_DECREF(item);
+    XX(iteration)
+    XX(callbacks)
+    XX(poll)
+    XX(timer_delay)
+#undef XX
+
+    if (PyObject_IsTrue(reset)) {
+        loop_monitor_reset(monitor);
+    }
+
+    return stats;
+}
+
+
+/* Loop profiler */
+
+#define LOOP_PROFILER_INITIAL_SIZE 64
+#define LOOP_PROFILER_MAX_ENTRIES  1024
+
+/* Functions and methods are accounted by their code, so closures and lambdas created for
+ * every call share an entry (and aren't kept alive). Other callables are used as they are */
+static INLINE PyObject *
+loop_profiler_key(PyObject *callable)
+{
+    if (PyMethod_Check(callable)) {
+        callable = PyMethod_GET_FUNCTION(callable);
+    }
+    if (PyFunction_Check(callable)) {
+        return PyFunction_GET_CODE(callable);
+    }
+    return callable;
+}
+
+static INLINE size_t
+loop_profiler_hash(PyTypeObject *type, const char *site, PyObject *key)
+{
+    size_t h = (size_t)key >> 4;
+    h = h * 31 + ((size_t)site >> 3);
+    h = h * 31 + ((size_t)type >> 4);
+    return h ^ (h >> 16);
+}
+
+
+static loop_profiler_entry_t *
+loop_profiler_lookup(loop_profiler_entry_t *entries, size_t size, PyTypeObject *type, const char *site, PyObject *key)
+{
+    size_t i;
+    loop_profiler_entry_t *entry;
+
+    i = loop_profiler_hash(type, site, key) & (size - 1);
+    for (;;) {
+        entry = &entries[i];
+        if (!entry->key || (entry->key == key && entry->site == site && entry->type == type)) {
+            return entry;
+        }
+        i = (i + 1) & (size - 1);
+    }
+}
+
+
+static int
+loop_profiler_grow(loop_profiler_t *profiler)
+{
+    size_t i, new_size;
+    loop_profiler_entry_t *entries, *entry;
+
+    new_size = profiler->size ? profiler->size * 2 : LOOP_PROFILER_INITIAL_SIZE;
+    entries = PyMem_Malloc(new_size * sizeof(loop_profiler_entry_t));
+    if (!entries) {
+        return -1;
+    }
+    memset(entries, 0, new_size * sizeof(loop_profiler_entry_t));
+
+    for (i = 0; i < profiler->size; i++) {
+        entry = &profiler->entries[i];
+        if (entry->key) {
+            *loop_profiler_lookup(entries, new_size, entry->type, entry->site, entry->key) = *entry;
+        }
+    }
+
+    PyMem_Free(profiler->entries);
+    profiler->entries = entries;
+    profiler->size = new_size;
+    return 0;
+}
+
+
+static void
+loop_profiler_record(Loop *loop, const char *site, PyObject *callable, PyObject *first_arg, uint64_t elapsed)
+{
+    PyObject *key;
+    PyTypeObject *type;
+    loop_profiler_t *profiler;
+    loop_profiler_entry_t *entry;
+
+    profiler = loop->profiler;
+    if (first_arg && (PyObject_TypeCheck(first_arg, &HandleType) || PyObject_TypeCheck(first_arg, &LoopType))) {
+        type = Py_TYPE(first_arg);
+    } else {
+        type = NULL;
+    }
+
+    /* keep the table at most half full */
+    if ((profiler->used + 1) * 2 > profiler->size && loop_profiler_grow(profiler) != 0) {
+        return;
+    }
+
+    key = loop_profiler_key(callable);
+    entry = loop_profiler_lookup(profiler->entries, profiler->size, type, site, key);
+    if (!entry->key && profiler->used >= LOOP_PROFILER_MAX_ENTRIES) {
+        /* too many distinct callables, account new ones per type and site only */
+        key = Py_None;
+        entry = loop_profiler_lookup(profiler->entries, profiler->size, type, site, key);
+    }
+    if (!entry->key) {
+        Py_INCREF(key);
+        Py_XINCREF(type);
+        entry->key = key;
+        entry->type = type;
+        entry->site = site;
+        profiler->used++;
+    }
+    entry->count++;
+    entry->total += elapsed;
+    if (elapsed > entry->max) {
+        entry->max = elapsed;
+    }
+}
+
+
+static void
+loop_profiler_clear(loop_profiler_t *profiler)
+{
+    size_t i;
+    loop_profiler_entry_t *entries;
+
+    /* DECREF can run arbitrary code, detach the table first */
+    entries = profiler->entries;
+    profiler->entries = NULL;
+    for (i = 0; i < profiler->size; i++) {
+        if (entries[i].key) {
+            Py_DECREF(entries[i].key);
+            Py_XDECREF(entries[i].type);
+        }
+    }
+    profiler->size = profiler->used = 0;
+    PyMem_Free(entries);
+}
+
+
+static PyObject *
+Loop_func_start_profiler(Loop *self)
+{
+    if (!self->profiler) {
+        self->profiler = PyMem_Malloc(sizeof(loop_profiler_t));
+        if (!self->profiler) {
+            return PyErr_NoMemory();
+        }
+        memset(self->profiler, 0, sizeof(loop_profiler_t));
+    }
+    self->profiler->active = True;
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+Loop_func_stop_profiler(Loop *self)
+{
+    if (self->profiler) {
+        self->profiler->active = False;
+    }
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+Loop_func_profile_stats(Loop *self, PyObject *args, PyObject *kwargs)
+{
+    size_t i;
+    loop_profiler_entry_t *entry;
+    PyObject *reset, *stats, *key, *value;
+
+    static char *kwlist[] = {"reset", NULL};
+
+    reset = Py_False;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|O:profile_stats", kwlist, &reset)) {
+        return NULL;
+    }
+
+    stats = PyDict_New();
+    if (!stats || !self->profiler) {
+        return stats;
+    }
+
+    for (i = 0; i < self->profiler->size; i++) {
+        entry = &self->profiler->entries[i];
+        if (!entry->key) {
+            continue;
+        }
+        key = Py_BuildValue("(OsO)", entry->type ? (PyObject *)entry->type : Py_None, entry->site, entry->key);
+        value = PyStructSequence_New(&LoopProfileResultType);
+        if (!key || !value) {
+            goto error;
+        }
+        PyStructSequence_SET_ITEM(value, 0, PyLong_FromUnsignedLongLong(entry->count));
+        PyStructSequence_SET_ITEM(value, 1, PyFloat_FromDouble(entry->total / 1e9));
+        PyStructSequence_SET_ITEM(value, 2, PyFloat_FromDouble(entry->max / 1e9));
+        if (PyDict_SetItem(stats, key, value) != 0) {
+            goto error;
+        }
+        Py_DECREF(key);
+        Py_DECREF(value);
+    }
+
+    if (PyObject_IsTrue(reset)) {
+        loop_profiler_clear(self->profiler);
+    }
+
+    return stats;
+
+error:
+    Py_XDECREF(key);
+    Py_XDECREF(value);
+    Py_DECREF(stats);
+    return NULL;
+}
+
+
+/* call_soon: the idle handle is active (and referenced) while there are queued calls, which
+ * also keeps the poll phase from blocking. Only the calls queued before the idle phase of an
+ * iteration run in it, calls queued by them wait for the next one so I/O isn't starved */
+static void
+on_loop_calls_idle(uv_idle_t *handle, int status)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    Loop *self = (Loop *)handle->loop->data;
+    loop_calls_t *calls = self->calls;
+    loop_call_t item;
+    size_t n;
+    PyObject *result;
+
+    UNUSED_ARG(status);
+
+    for (n = calls->count; n > 0 && calls->count > 0; n--) {
+        item = calls->items[calls->head];
+        calls->head = (calls->head + 1) & (calls->size - 1);
+        calls->count--;
+
+        result = pyuv_callback_array("call_soon", item.callable, ((PyTupleObject *)item.args)->ob_item, PyTuple_GET_SIZE(item.args));
+        if (result == NULL) {
+            PyErr_WriteUnraisable(item.callable);
+        }
+        Py_XDECREF(result);
+        Py_DECREF(item.callable);
+        Py_DECREF(item.args);
+    }
+
+    if (calls->count == 0) {
+        uv_idle_stop(&calls->idle);
+    }
+
+    PyGILState_Release(gstate);
+}
+
+
+static int
+loop_calls_grow(loop_calls_t *calls)
+{
+    size_t i, size;
+    loop_call_t *items;
+
+    size = calls->size ? calls->size * 2 : 16;
+    items = PyMem_Malloc(size * sizeof(loop_call_t));
+    if (!items) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    for (i = 0; i < calls->count; i++) {
+        items[i] = calls->items[(calls->head + i) & (calls->size - 1)];
+    }
+    PyMem_Free(calls->items);
+    calls->items = items;
+    calls->size = size;
+    calls->head = 0;
+    return 0;
+}
+
+
+static void
+loop_calls_clear(loop_calls_t *calls)
+{
+    loop_call_t item;
+
+    while (calls->count > 0) {
+        item = calls->items[calls->head];
+        calls->head = (calls->head + 1) & (calls->size - 1);
+        calls->count--;
+        Py_DECREF(item.callable);
+        Py_DECREF(item.args);
+    }
+    uv_idle_stop(&calls->idle);
+}
+
+
+/* Queue callable(*args) for the next iteration, also used by other objects which must not
+ * call back into Python right away */
+static int
+loop_call_soon(Loop *self, PyObject *callable, PyObject *args)
+{
+    loop_calls_t *calls;
+    loop_call_t *item;
+
+    calls = self->calls;
+    if (!calls) {
+        calls = PyMem_Malloc(sizeof(loop_calls_t));
+        if (!calls) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        memset(calls, 0, sizeof(loop_calls_t));
+        uv_idle_init(self->uv_loop, &calls->idle);
+        calls->idle.data = NULL;
+        self->calls = calls;
+    }
+
+    if (calls->count == calls->size && loop_calls_grow(calls) != 0) {
+        return -1;
+    }
+
+    item = &calls->items[(calls->head + calls->count) & (calls->size - 1)];
+    Py_INCREF(callable);
+    Py_INCREF(args);
+    item->callable = callable;
+    item->args = args;
+    if (calls->count++ == 0) {
+        uv_idle_start(&calls->idle, on_loop_calls_idle);
+    }
+
+    return 0;
+}
+
+
+static PyObject *
+Loop_func_call_soon(Loop *self, PyObject *args)
+{
+    int r;
+    PyObject *callable, *call_args;
+
+    if (PyTuple_GET_SIZE(args) < 1) {
+        PyErr_SetString(PyExc_TypeError, "call_soon expected at least 1 argument");
+        return NULL;
+    }
+
+    callable = PyTuple_GET_ITEM(args, 0);
+    if (!PyCallable_Check(callable)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+
+    call_args = PyTuple_GetSlice(args, 1, PyTuple_GET_SIZE(args));
+    if (!call_args) {
+        return NULL;
+    }
+
+    r = loop_call_soon(self, callable, call_args);
+    Py_DECREF(call_args);
+    if (r != 0) {
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+/* Can be called from any thread, the calls are run by the loop thread on its next iteration */
+static PyObject *
+Loop_func_call_soon_threadsafe(Loop *self, PyObject *args)
+{
+    loop_threadsafe_call_t *call;
+    PyObject *callable, *call_args;
+
+    if (PyTuple_GET_SIZE(args) < 1) {
+        PyErr_SetString(PyExc_TypeError, "call_soon_threadsafe expected at least 1 argument");
+        return NULL;
+    }
+
+    callable = PyTuple_GET_ITEM(args, 0);
+    if (!PyCallable_Check(callable)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+
+    call_args = PyTuple_GetSlice(args, 1, PyTuple_GET_SIZE(args));
+    if (!call_args) {
+        return NULL;
+    }
+
+    call = PyMem_Malloc(sizeof(loop_threadsafe_call_t));
+    if (!call) {
+        Py_DECREF(call_args);
+        return PyErr_NoMemory();
+    }
+    Py_INCREF(callable);
+    call->callable = callable;
+    call->args = call_args;
+
+    /* if the queue wasn't empty a wakeup is already on its way */
+    if (pyuv_mpsc_push(&self->threadsafe_calls, &call->node)) {
+        uv_async_send(&self->threadsafe_async);
+    }
+
+    Py_RETURN_NONE;
+}
+
+
 static PyObject *
 Loop_func_now(Loop *self)
 {
@@ -96,7 +1032,7 @@ walk_cb(uv_handle_t* handle, void* arg)
     if (handle->data != NULL) {
         obj = (PyObject *)handle->data;
         Py_INCREF(obj);
-        result = PyObject_CallFunctionObjArgs(callback, obj, NULL);
+        result = pyuv_callback("walk", callback, obj, NULL);
         if (result == NULL) {
             PyErr_WriteUnraisable(callback);
         }
@@ -127,6 +1063,141 @@ Loop_func_walk(Loop *self, PyObject *args)
 }
 
 
+typedef struct {
+    PyObject *result;
+    PyObject *type;     /* type or tuple of types to filter by, NULL for all handles */
+    PyTypeObject *last_type;
+    PyObject *last_count;
+    int error;
+} loop_handles_walk_t;
+
+
+static void
+handles_walk_cb(uv_handle_t* handle, void* arg)
+{
+    int r;
+    loop_handles_walk_t *walk = (loop_handles_walk_t *)arg;
+    PyObject *obj = (PyObject *)handle->data;
+
+    /* internal handles have no Python object */
+    if (obj == NULL || walk->error) {
+        return;
+    }
+
+    if (walk->type) {
+        if (PyType_Check(walk->type)) {
+            r = PyObject_TypeCheck(obj, (PyTypeObject *)walk->type);
+        } else {
+            r = PyObject_IsInstance(obj, walk->type);
+        }
+        if (r < 0) {
+            walk->error = 1;
+            return;
+        }
+        if (r == 0) {
+            return;
+        }
+    }
+
+    if (PyList_Append(walk->result, obj) != 0) {
+        walk->error = 1;
+    }
+}
+
+
+static PyObject *
+Loop_func_handles(Loop *self, PyObject *args, PyObject *kwargs)
+{
+    loop_handles_walk_t walk;
+    PyObject *type;
+
+    static char *kwlist[] = {"type", NULL};
+
+    type = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|O:handles", kwlist, &type)) {
+        return NULL;
+    }
+
+    if (type != Py_None && !PyType_Check(type) && !PyTuple_Check(type)) {
+        PyErr_SetString(PyExc_TypeError, "type must be a type, a tuple of types or None");
+        return NULL;
+    }
+
+    walk.result = PyList_New(0);
+    if (!walk.result) {
+        return NULL;
+    }
+    walk.type = type != Py_None ? type : NULL;
+    walk.error = 0;
+
+    uv_walk(self->uv_loop, (uv_walk_cb)handles_walk_cb, (void*)&walk);
+
+    if (walk.error) {
+        Py_DECREF(walk.result);
+        return NULL;
+    }
+    return walk.result;
+}
+
+
+static void
+handle_counts_walk_cb(uv_handle_t* handle, void* arg)
+{
+    long count;
+    loop_handles_walk_t *walk = (loop_handles_walk_t *)arg;
+    PyObject *obj = (PyObject *)handle->data;
+    PyObject *value;
+
+    if (obj == NULL || walk->error) {
+        return;
+    }
+
+    /* handles of the same type are usually created together, avoid a lookup for each one */
+    if (Py_TYPE(obj) == walk->last_type) {
+        count = PyLong_AsLong(walk->last_count) + 1;
+    } else {
+        walk->last_type = Py_TYPE(obj);
+        value = PyDict_GetItem(walk->result, (PyObject *)walk->last_type);
+        count = value ? PyLong_AsLong(value) + 1 : 1;
+    }
+
+    value = PyInt_FromLong(count);
+    if (!value || PyDict_SetItem(walk->result, (PyObject *)walk->last_type, value) != 0) {
+        Py_XDECREF(value);
+        walk->error = 1;
+        return;
+    }
+    /* borrowed, the dict holds a reference */
+    walk->last_count = value;
+    Py_DECREF(value);
+}
+
+
+static PyObject *
+Loop_func_handle_counts(Loop *self)
+{
+    loop_handles_walk_t walk;
+
+    walk.result = PyDict_New();
+    if (!walk.result) {
+        return NULL;
+    }
+    walk.type = NULL;
+    walk.last_type = NULL;
+    walk.last_count = NULL;
+    walk.error = 0;
+
+    uv_walk(self->uv_loop, (uv_walk_cb)handle_counts_walk_cb, (void*)&walk);
+
+    if (walk.error) {
+        Py_DECREF(walk.result);
+        return NULL;
+    }
+    return walk.result;
+}
+
+
 static PyObject *
 Loop_func_default_loop(PyObject *cls)
 {
@@ -167,6 +1238,33 @@ get_counter_value(uint64_t value)
     return val;
 }
 
+static PyObject *
+pyuv_handle_stats_result(handle_stats_t *stats)
+{
+    PyObject *result;
+
+    result = PyStructSequence_New(&HandleStatsResultType);
+    if (!result) {
+        return NULL;
+    }
+    PyStructSequence_SET_ITEM(result, 0, PyLong_FromUnsignedLongLong(stats->bytes_read));
+    PyStructSequence_SET_ITEM(result, 1, PyLong_FromUnsignedLongLong(stats->bytes_written));
+    PyStructSequence_SET_ITEM(result, 2, PyLong_FromUnsignedLongLong(stats->reads));
+    PyStructSequence_SET_ITEM(result, 3, PyLong_FromUnsignedLongLong(stats->writes));
+    PyStructSequence_SET_ITEM(result, 4, PyLong_FromUnsignedLongLong(stats->write_queue_high));
+    PyStructSequence_SET_ITEM(result, 5, PyLong_FromUnsignedLongLong(stats->errors));
+    return result;
+}
+
+
+static PyObject *
+Loop_handle_stats_get(Loop *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    return pyuv_handle_stats_result(&self->handle_stats);
+}
+
+
 static PyObject *
 Loop_counters_get(Loop *self, void *closure)
 {
@@ -220,7 +1318,26 @@ Loop_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 static int
 Loop_tp_traverse(Loop *self, visitproc visit, void *arg)
 {
+    size_t i;
+    pyuv_mpsc_node_t *node;
     Py_VISIT(self->dict);
+    if (self->profiler) {
+        for (i = 0; i < self->profiler->size; i++) {
+            Py_VISIT(self->profiler->entries[i].key);
+            Py_VISIT((PyObject *)self->profiler->entries[i].type);
+        }
+    }
+    if (self->calls) {
+        for (i = 0; i < self->calls->count; i++) {
+            Py_VISIT(self->calls->items[(self->calls->head + i) & (self->calls->size - 1)].callable);
+            Py_VISIT(self->calls->items[(self->calls->head + i) & (self->calls->size - 1)].args);
+        }
+    }
+    /* producers push with the GIL held, the list can't change under us */
+    for (node = self->threadsafe_calls; node; node = node->next) {
+        Py_VISIT(((loop_threadsafe_call_t *)node)->callable);
+        Py_VISIT(((loop_threadsafe_call_t *)node)->args);
+    }
     return 0;
 }
 
@@ -229,21 +1346,74 @@ static int
 Loop_tp_clear(Loop *self)
 {
     Py_CLEAR(self->dict);
+    if (self->profiler) {
+        loop_profiler_clear(self->profiler);
+    }
+    if (self->calls) {
+        loop_calls_clear(self->calls);
+    }
+    loop_threadsafe_clear(self);
     return 0;
 }
 
 
+/* Close the internal handles, which are embedded in the Loop structures and have no close callback */
+static void
+loop_internal_handles_close(Loop *self)
+{
+    if (self->calls) {
+        uv_close((uv_handle_t *)&self->calls->idle, NULL);
+    }
+    if (self->run_handles_init) {
+        uv_close((uv_handle_t *)&self->run_idle, NULL);
+        uv_close((uv_handle_t *)&self->run_check, NULL);
+        uv_close((uv_handle_t *)&self->run_timer, NULL);
+        self->run_handles_init = False;
+    }
+    if (self->monitor) {
+        uv_close((uv_handle_t *)&self->monitor->prepare, NULL);
+        uv_close((uv_handle_t *)&self->monitor->check, NULL);
+        uv_close((uv_handle_t *)&self->monitor->timer, NULL);
+    }
+    uv_close((uv_handle_t *)&self->threadsafe_async, NULL);
+#ifdef PYUV_HAVE_SDT
+    uv_close((uv_handle_t *)&self->probe_prepare, NULL);
+    uv_close((uv_handle_t *)&self->probe_check, NULL);
+#endif
+}
+
+
 static void
 Loop_tp_dealloc(Loop *self)
 {
+    if (self->calls) {
+        loop_calls_clear(self->calls);
+    }
     if (self->uv_loop) {
+        /* the internal handles must be closed, and their close processed by running the loop once,
+         * before the uv loop is deleted and the memory they live in is freed */
+        loop_internal_handles_close(self);
+        uv_run_once(self->uv_loop);
         self->uv_loop->data = NULL;
         uv_loop_delete(self->uv_loop);
     }
+    if (self->monitor) {
+        PyMem_Free(self->monitor);
+        self->monitor = NULL;
+    }
     if (self->weakreflist != NULL) {
         PyObject_ClearWeakRefs((PyObject *)self);
     }
     Loop_tp_clear(self);
+    if (self->profiler) {
+        PyMem_Free(self->profiler);
+        self->profiler = NULL;
+    }
+    if (self->calls) {
+        PyMem_Free(self->calls->items);
+        PyMem_Free(self->calls);
+        self->calls = NULL;
+    }
     Py_TYPE(self)->tp_free((PyObject *)self);
 }
 
@@ -289,11 +1459,22 @@ Loop_dict_set(Loop *self, PyObject* val, void* c)
 
 static PyMethodDef
 Loop_tp_methods[] = {
-    { "run", (PyCFunction)Loop_func_run, METH_NOARGS, "Run the event loop." },
+    { "run", (PyCFunction)Loop_func_run, METH_VARARGS|METH_KEYWORDS, "Run the event loop." },
     { "run_once", (PyCFunction)Loop_func_run_once, METH_NOARGS, "Run a single event loop iteration, waiting for events if necessary." },
+    { "run_for", (PyCFunction)Loop_func_run_for, METH_VARARGS, "Run the event loop until the given time has passed." },
     { "now", (PyCFunction)Loop_func_now, METH_NOARGS, "Return event loop time, expressed in nanoseconds." },
     { "update_time", (PyCFunction)Loop_func_update_time, METH_NOARGS, "Update event loop's notion of time by querying the kernel." },
+    { "call_soon", (PyCFunction)Loop_func_call_soon, METH_VARARGS, "Call the given function with the given arguments on the next loop iteration." },
+    { "call_soon_threadsafe", (PyCFunction)Loop_func_call_soon_threadsafe, METH_VARARGS, "Like call_soon, but it can be called from any thread." },
     { "walk", (PyCFunction)Loop_func_walk, METH_VARARGS, "Walk all handles in the loop." },
+    { "handles", (PyCFunction)Loop_func_handles, METH_VARARGS|METH_KEYWORDS, "Get a list with the handles in the loop, optionally of the given type." },
+    { "handle_counts", (PyCFunction)Loop_func_handle_counts, METH_NOARGS, "Get the number of handles in the loop by type." },
+    { "start_monitor", (PyCFunction)Loop_func_start_monitor, METH_VARARGS, "Start measuring loop iterations, callbacks and timer delays." },
+    { "stop_monitor", (PyCFunction)Loop_func_stop_monitor, METH_NOARGS, "Stop the loop monitor." },
+    { "monitor_stats", (PyCFunction)Loop_func_monitor_stats, METH_VARARGS|METH_KEYWORDS, "Get the loop monitor statistics." },
+    { "start_profiler", (PyCFunction)Loop_func_start_profiler, METH_NOARGS, "Start accounting time spent in every callback." },
+    { "stop_profiler", (PyCFunction)Loop_func_stop_profiler, METH_NOARGS, "Stop the callback profiler." },
+    { "profile_stats", (PyCFunction)Loop_func_profile_stats, METH_VARARGS|METH_KEYWORDS, "Get the callback profiler statistics." },
     { "default_loop", (PyCFunction)Loop_func_default_loop, METH_CLASS|METH_NOARGS, "Instantiate the default loop." },
     { NULL }
 };
@@ -304,6 +1485,7 @@ static PyGetSetDef Loop_tp_getsets[] = {
     {"active_handles", (getter)Loop_active_handles_get, NULL, "Number of active handles in this loop", NULL},
     {"default", (getter)Loop_default_get, NULL, "Is this the default loop?", NULL},
     {"counters", (getter)Loop_counters_get, NULL, "Loop counters", NULL},
+    {"handle_stats", (getter)Loop_handle_stats_get, NULL, "Traffic counters of all stream and UDP handles", NULL},
     {NULL}
 };
 
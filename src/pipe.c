@@ -14,13 +14,13 @@ on_pipe_connection(uv_stream_t* server, int status)
 
     if (status != 0) {
         uv_err_t err = uv_last_error(UV_HANDLE_LOOP(self));
-        py_errorno = PyInt_FromLong((long)err.code);
+        py_errorno = pyuv_error_code(err.code);
     } else {
         py_errorno = Py_None;
         Py_INCREF(Py_None);
     }
 
-    result = PyObject_CallFunctionObjArgs(self->on_new_connection_cb, self, py_errorno, NULL);
+    result = pyuv_callback("connection", self->on_new_connection_cb, self, py_errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(self->on_new_connection_cb);
     }
@@ -49,13 +49,13 @@ on_pipe_client_connection(uv_connect_t *req, int status)
 
     if (status != 0) {
         uv_err_t err = uv_last_error(UV_HANDLE_LOOP(self));
-        py_errorno = PyInt_FromLong(err.code);
+        py_errorno = pyuv_error_code(err.code);
     } else {
         py_errorno = Py_None;
         Py_INCREF(Py_None);
     }
 
-    result = PyObject_CallFunctionObjArgs(callback, self, py_errorno, NULL);
+    result = pyuv_callback("connect", callback, self, py_errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(callback);
     }
@@ -84,6 +84,8 @@ on_pipe_read2(uv_pipe_t* handle, int nread, uv_buf_t buf, uv_handle_type pending
     /* Object could go out of scope in the callback, increase refcount to avoid it */
     Py_INCREF(self);
 
+    stream_stats_read(self, nread);
+
     py_pending = PyInt_FromLong((long)pending);
 
     if (nread >= 0) {
@@ -94,10 +96,10 @@ on_pipe_read2(uv_pipe_t* handle, int nread, uv_buf_t buf, uv_handle_type pending
         data = Py_None;
         Py_INCREF(Py_None);
         err = uv_last_error(UV_HANDLE_LOOP(self));
-        py_errorno = PyInt_FromLong((long)err.code);
+        py_errorno = pyuv_error_code(err.code);
     }
 
-    result = PyObject_CallFunctionObjArgs(self->on_read_cb, self, data, py_pending, py_errorno, NULL);
+    result = pyuv_callback("read2", self->on_read_cb, self, data, py_pending, py_errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(self->on_read_cb);
     }
@@ -116,6 +118,437 @@ on_pipe_read2(uv_pipe_t* handle, int nread, uv_buf_t buf, uv_handle_type pending
 }
 
 
+
+/* IPC message channel: every message is framed with its length and a flags byte, which tells
+ * if a handle was sent along with it. Handles are received ahead of (or with) the first bytes
+ * of their message, so they are queued until the message is complete. */
+
+#define PIPE_MSG_HEADER_SIZE    5
+#define PIPE_MSG_FLAG_HANDLE    0x01
+#define PIPE_MSG_MAX_SIZE       (64 * 1024 * 1024)
+#define PIPE_MSG_BATCH_SIZE     (64 * 1024)
+
+typedef struct {
+    uv_write_t req;
+    uv_buf_t buf;
+    PyObject *callbacks;    /* callbacks of the messages contained in this write */
+    uv_pipe_t *fd_pipe;     /* temporary handle wrapping a raw file descriptor being sent */
+} pipe_message_write_t;
+
+
+static int
+pipe_buf_reserve(char **buf, Py_ssize_t *size, Py_ssize_t needed)
+{
+    char *tmp;
+    Py_ssize_t new_size;
+
+    if (needed <= *size) {
+        return 0;
+    }
+    new_size = *size ? *size : 4096;
+    while (new_size < needed) {
+        new_size *= 2;
+    }
+    tmp = (char *) PyMem_Realloc(*buf, new_size);
+    if (!tmp) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    *buf = tmp;
+    *size = new_size;
+    return 0;
+}
+
+
+static void
+pipe_message_callback(Pipe *self, PyObject *data, PyObject *handle, PyObject *py_errorno)
+{
+    PyObject *callback, *result;
+
+    callback = ((Stream *)self)->on_read_cb;
+    if (!callback) {
+        return;
+    }
+    /* The callback could be replaced while it runs */
+    Py_INCREF(callback);
+    result = pyuv_callback("message", callback, self, data, handle, py_errorno, NULL);
+    if (result == NULL) {
+        PyErr_WriteUnraisable(callback);
+    }
+    Py_XDECREF(result);
+    Py_DECREF(callback);
+}
+
+
+/* Accept a handle received over the pipe into a new TCP or Pipe object */
+static int
+pipe_accept_pending(Pipe *self, uv_handle_type pending)
+{
+    int r;
+    PyTypeObject *type;
+    PyObject *client;
+
+    if (pending == UV_TCP) {
+        type = &TCPType;
+    } else if (pending == UV_NAMED_PIPE) {
+        type = &PipeType;
+    } else {
+        PyErr_SetString(PyExc_PipeError, "received an unsupported handle type");
+        return -1;
+    }
+
+    client = PyObject_CallFunctionObjArgs((PyObject *)type, ((Handle *)self)->loop, NULL);
+    if (!client) {
+        return -1;
+    }
+
+    r = uv_accept((uv_stream_t *)UV_HANDLE(self), (uv_stream_t *)UV_HANDLE(client));
+    if (r != 0) {
+        RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self), PyExc_PipeError);
+        Py_DECREF(client);
+        return -1;
+    }
+
+    r = PyList_Append(self->pending_handles, client);
+    Py_DECREF(client);
+    return r;
+}
+
+
+#ifndef PYUV_WINDOWS
+/* This libuv revision has no uv_fileno() */
+#define PIPE_HANDLE_FD(handle) (((uv_stream_t *)(handle))->fd)
+
+/* Take a file descriptor which is not a socket (memfd, eventfd, regular file...) received
+ * over the pipe, it's delivered as an int and the receiver owns it. libuv reports those as
+ * UV_UNKNOWN_HANDLE, so this is only done for messages which say they carry a handle */
+static int
+pipe_accept_fd(Pipe *self)
+{
+    int r, fd;
+    uv_pipe_t *fd_pipe;
+    PyObject *py_fd;
+
+    fd_pipe = PyMem_Malloc(sizeof(uv_pipe_t));
+    if (!fd_pipe) {
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    r = uv_pipe_init(UV_HANDLE_LOOP(self), fd_pipe, 0);
+    if (r != 0) {
+        RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self), PyExc_PipeError);
+        PyMem_Free(fd_pipe);
+        return -1;
+    }
+    fd_pipe->data = NULL;
+
+    /* The handle takes the received descriptor, the receiver gets a copy */
+    r = uv_accept((uv_stream_t *)UV_HANDLE(self), (uv_stream_t *)fd_pipe);
+    if (r != 0) {
+        RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self), PyExc_PipeError);
+        fd = -1;
+    } else {
+        fd = fcntl(PIPE_HANDLE_FD(fd_pipe), F_DUPFD_CLOEXEC, 0);
+        if (fd == -1) {
+            PyErr_SetFromErrno(PyExc_PipeError);
+        }
+    }
+    uv_close((uv_handle_t *)fd_pipe, on_handle_dealloc_close);
+    if (fd == -1) {
+        return -1;
+    }
+
+    py_fd = PyInt_FromLong((long)fd);
+    if (!py_fd || PyList_Append(self->pending_handles, py_fd) != 0) {
+        Py_XDECREF(py_fd);
+        close(fd);
+        return -1;
+    }
+    Py_DECREF(py_fd);
+    return 0;
+}
+#endif
+
+
+/* Deliver the complete messages contained in data, returns the amount of data consumed */
+static Py_ssize_t
+pipe_messages_parse(Pipe *self, const char *data, Py_ssize_t len)
+{
+    Py_ssize_t pos, msg_len;
+    const unsigned char *hdr;
+    PyObject *msg, *handle;
+
+    pos = 0;
+    while (len - pos >= PIPE_MSG_HEADER_SIZE) {
+        hdr = (const unsigned char *)data + pos;
+        msg_len = ((Py_ssize_t)hdr[0] << 24) | ((Py_ssize_t)hdr[1] << 16) | ((Py_ssize_t)hdr[2] << 8) | hdr[3];
+        if (msg_len > PIPE_MSG_MAX_SIZE || (hdr[4] & ~PIPE_MSG_FLAG_HANDLE)) {
+            return -1;
+        }
+        if (len - pos - PIPE_MSG_HEADER_SIZE < msg_len) {
+            break;
+        }
+
+        if (hdr[4] & PIPE_MSG_FLAG_HANDLE) {
+#ifndef PYUV_WINDOWS
+            if (PyList_GET_SIZE(self->pending_handles) == 0 && pipe_accept_fd(self) != 0) {
+                return -1;
+            }
+#endif
+            if (PyList_GET_SIZE(self->pending_handles) == 0) {
+                /* the handle was lost, most likely due to an accept error */
+                return -1;
+            }
+            handle = PyList_GET_ITEM(self->pending_handles, 0);
+            Py_INCREF(handle);
+            PyList_SetSlice(self->pending_handles, 0, 1, NULL);
+        } else {
+            handle = Py_None;
+            Py_INCREF(Py_None);
+        }
+
+        msg = PyString_FromStringAndSize(data + pos + PIPE_MSG_HEADER_SIZE, msg_len);
+        if (!msg) {
+            Py_DECREF(handle);
+            return -1;
+        }
+        pos += PIPE_MSG_HEADER_SIZE + msg_len;
+
+        pipe_message_callback(self, msg, handle, Py_None);
+        Py_DECREF(msg);
+        Py_DECREF(handle);
+    }
+
+    return pos;
+}
+
+
+static int
+pipe_messages_feed(Pipe *self, const char *data, Py_ssize_t len)
+{
+    Py_ssize_t consumed;
+
+    if (self->in_len > 0) {
+        if (pipe_buf_reserve(&self->in_buf, &self->in_size, self->in_len + len) != 0) {
+            return -1;
+        }
+        memcpy(self->in_buf + self->in_len, data, len);
+        self->in_len += len;
+        consumed = pipe_messages_parse(self, self->in_buf, self->in_len);
+        if (consumed < 0) {
+            return -1;
+        }
+        memmove(self->in_buf, self->in_buf + consumed, self->in_len - consumed);
+        self->in_len -= consumed;
+        return 0;
+    }
+
+    /* Nothing is buffered, parse straight from the read buffer and keep the rest */
+    consumed = pipe_messages_parse(self, data, len);
+    if (consumed < 0) {
+        return -1;
+    }
+    if (consumed < len) {
+        if (pipe_buf_reserve(&self->in_buf, &self->in_size, len - consumed) != 0) {
+            return -1;
+        }
+        memcpy(self->in_buf, data + consumed, len - consumed);
+        self->in_len = len - consumed;
+    }
+    return 0;
+}
+
+
+static void
+on_pipe_read_message(uv_pipe_t* handle, int nread, uv_buf_t buf, uv_handle_type pending)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    uv_err_t err;
+    Pipe *self;
+    PyObject *py_errorno;
+    ASSERT(handle);
+
+    self = (Pipe *)handle->data;
+    ASSERT(self);
+    /* Object could go out of scope in the callback, increase refcount to avoid it */
+    Py_INCREF(self);
+
+    stream_stats_read((Stream *)self, nread);
+
+    if (pending != UV_UNKNOWN_HANDLE && pipe_accept_pending(self, pending) != 0) {
+        PyErr_WriteUnraisable((PyObject *)self);
+    }
+
+    if (nread < 0) {
+        err = uv_last_error(UV_HANDLE_LOOP(self));
+        py_errorno = pyuv_error_code(err.code);
+        pipe_message_callback(self, Py_None, Py_None, py_errorno);
+        Py_DECREF(py_errorno);
+    } else if (nread > 0 && pipe_messages_feed(self, buf.base, nread) != 0) {
+        /* the data can't be framed anymore, report it as a protocol error */
+        PyErr_Clear();
+        self->in_len = 0;
+        py_errorno = pyuv_error_code(UV_EPROTO);
+        pipe_message_callback(self, Py_None, Py_None, py_errorno);
+        Py_DECREF(py_errorno);
+    }
+
+    /* In case of error libuv may not call alloc_cb */
+    if (buf.base != NULL) {
+        PyMem_Free(buf.base);
+    }
+
+    Py_DECREF(self);
+    PyGILState_Release(gstate);
+}
+
+
+static int pipe_messages_flush(Pipe *self, uv_stream_t *send_handle, uv_pipe_t *fd_pipe);
+
+
+static void
+on_pipe_message_write(uv_write_t* req, int status)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    Py_ssize_t i;
+    pipe_message_write_t *wr;
+    Pipe *self;
+    PyObject *callback, *result, *py_errorno;
+    uv_err_t err;
+
+    ASSERT(req);
+
+    wr = (pipe_message_write_t *)req;
+    self = (Pipe *)req->data;
+    ASSERT(self);
+
+    if (status < 0) {
+        handle_stats_error((Handle *)self, &((Stream *)self)->stats);
+        err = uv_last_error(UV_HANDLE_LOOP(self));
+        py_errorno = pyuv_error_code(err.code);
+    } else {
+        handle_stats_write((Handle *)self, &((Stream *)self)->stats, wr->buf.len);
+        py_errorno = Py_None;
+        Py_INCREF(Py_None);
+    }
+
+    for (i = 0; i < PyList_GET_SIZE(wr->callbacks); i++) {
+        callback = PyList_GET_ITEM(wr->callbacks, i);
+        if (callback == Py_None) {
+            continue;
+        }
+        result = pyuv_callback("write", callback, self, py_errorno, NULL);
+        if (result == NULL) {
+            PyErr_WriteUnraisable(callback);
+        }
+        Py_XDECREF(result);
+    }
+    Py_DECREF(py_errorno);
+
+    Py_DECREF(wr->callbacks);
+    PyMem_Free(wr->buf.base);
+    if (wr->fd_pipe) {
+        uv_close((uv_handle_t *)wr->fd_pipe, on_handle_dealloc_close);
+    }
+    PyMem_Free(wr);
+
+    /* Send the messages which were batched while this write was in flight */
+    self->writes_in_flight--;
+    if (self->writes_in_flight == 0 && self->out_len > 0 && !UV_HANDLE_CLOSED(self)) {
+        if (pipe_messages_flush(self, NULL, NULL) != 0) {
+            PyErr_WriteUnraisable((PyObject *)self);
+        }
+    }
+
+    /* Refcount was increased when the write was started */
+    Py_DECREF(self);
+    PyGILState_Release(gstate);
+}
+
+
+/* Write all batched messages in a single request, sending a handle along if given. The
+ * request takes ownership of fd_pipe, if any. */
+static int
+pipe_messages_flush(Pipe *self, uv_stream_t *send_handle, uv_pipe_t *fd_pipe)
+{
+    int r;
+    pipe_message_write_t *wr;
+
+    wr = (pipe_message_write_t *) PyMem_Malloc(sizeof(pipe_message_write_t));
+    if (!wr) {
+        PyErr_NoMemory();
+        if (fd_pipe) {
+            uv_close((uv_handle_t *)fd_pipe, on_handle_dealloc_close);
+        }
+        return -1;
+    }
+
+    /* Ownership of the buffer and the callbacks goes to the request */
+    wr->buf = uv_buf_init(self->out_buf, self->out_len);
+    wr->callbacks = self->out_callbacks;
+    wr->fd_pipe = fd_pipe;
+    wr->req.data = (void *)self;
+    self->out_buf = NULL;
+    self->out_len = self->out_size = 0;
+    self->out_callbacks = NULL;
+
+    if (send_handle) {
+        r = uv_write2(&wr->req, (uv_stream_t *)UV_HANDLE(self), &wr->buf, 1, send_handle, on_pipe_message_write);
+    } else {
+        r = uv_write(&wr->req, (uv_stream_t *)UV_HANDLE(self), &wr->buf, 1, on_pipe_message_write);
+    }
+    if (r != 0) {
+        RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self), PyExc_PipeError);
+        Py_DECREF(wr->callbacks);
+        PyMem_Free(wr->buf.base);
+        if (fd_pipe) {
+            uv_close((uv_handle_t *)fd_pipe, on_handle_dealloc_close);
+        }
+        PyMem_Free(wr);
+        return -1;
+    }
+
+    handle_stats_queued((Handle *)self, &((Stream *)self)->stats, ((uv_stream_t *)UV_HANDLE(self))->write_queue_size);
+    self->writes_in_flight++;
+    Py_INCREF(self);
+    return 0;
+}
+
+
+/* Add a framed message to the outgoing batch */
+static int
+pipe_messages_append(Pipe *self, const char *data, Py_ssize_t len, Bool with_handle, PyObject *callback)
+{
+    unsigned char *hdr;
+
+    if (!self->out_callbacks) {
+        self->out_callbacks = PyList_New(0);
+        if (!self->out_callbacks) {
+            return -1;
+        }
+    }
+
+    if (pipe_buf_reserve(&self->out_buf, &self->out_size, self->out_len + PIPE_MSG_HEADER_SIZE + len) != 0) {
+        return -1;
+    }
+    if (PyList_Append(self->out_callbacks, callback) != 0) {
+        return -1;
+    }
+
+    hdr = (unsigned char *)self->out_buf + self->out_len;
+    hdr[0] = (unsigned char)(len >> 24);
+    hdr[1] = (unsigned char)(len >> 16);
+    hdr[2] = (unsigned char)(len >> 8);
+    hdr[3] = (unsigned char)len;
+    hdr[4] = with_handle ? PIPE_MSG_FLAG_HANDLE : 0;
+    memcpy(self->out_buf + self->out_len + PIPE_MSG_HEADER_SIZE, data, len);
+    self->out_len += PIPE_MSG_HEADER_SIZE + len;
+
+    return 0;
+}
+
+
 static PyObject *
 Pipe_func_bind(Pipe *self, PyObject *args)
 {
@@ -257,7 +690,10 @@ Pipe_func_open(Pipe *self, PyObject *args)
         return NULL;
     }
 
-    uv_pipe_open((uv_pipe_t *)UV_HANDLE(self), fd);
+    if (uv_pipe_open((uv_pipe_t *)UV_HANDLE(self), fd) != 0) {
+        RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self), PyExc_PipeError);
+        return NULL;
+    }
 
     Py_RETURN_NONE;
 }
@@ -311,6 +747,9 @@ Pipe_func_start_read2(Pipe *self, PyObject *args)
     ((Stream *)self)->on_read_cb = callback;
     Py_XDECREF(tmp);
 
+    /* parsers are not supported with handle passing */
+    Py_CLEAR(((Stream *)self)->parser);
+
     Py_RETURN_NONE;
 }
 
@@ -344,6 +783,188 @@ Pipe_func_write2(Pipe *self, PyObject *args)
 }
 
 
+static PyObject *
+Pipe_func_start_read_messages(Pipe *self, PyObject *args)
+{
+    int r;
+    PyObject *tmp, *callback;
+
+    tmp = NULL;
+
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTuple(args, "O:start_read_messages", &callback)) {
+        return NULL;
+    }
+
+    if (!PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+
+    if (!self->pending_handles) {
+        self->pending_handles = PyList_New(0);
+        if (!self->pending_handles) {
+            return NULL;
+        }
+    }
+
+    r = uv_read2_start((uv_stream_t *)UV_HANDLE(self), (uv_alloc_cb)on_stream_alloc, (uv_read2_cb)on_pipe_read_message);
+    if (r != 0) {
+        RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self), PyExc_PipeError);
+        return NULL;
+    }
+
+    tmp = ((Stream *)self)->on_read_cb;
+    Py_INCREF(callback);
+    ((Stream *)self)->on_read_cb = callback;
+    Py_XDECREF(tmp);
+
+    Py_CLEAR(((Stream *)self)->parser);
+
+    Py_RETURN_NONE;
+}
+
+
+#ifndef PYUV_WINDOWS
+static uv_pipe_t *
+pipe_wrap_fd(Pipe *self, PyObject *py_fd)
+{
+    int r, fd;
+    uv_pipe_t *fd_pipe;
+
+    fd = PyObject_AsFileDescriptor(py_fd);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    fd_pipe = (uv_pipe_t *) PyMem_Malloc(sizeof(uv_pipe_t));
+    if (!fd_pipe) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+
+    /* The caller keeps its descriptor, the copy is closed together with the handle */
+    fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (fd == -1) {
+        PyErr_SetFromErrno(PyExc_PipeError);
+        PyMem_Free(fd_pipe);
+        return NULL;
+    }
+
+    r = uv_pipe_init(UV_HANDLE_LOOP(self), fd_pipe, 0);
+    if (r != 0) {
+        RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self), PyExc_PipeError);
+        close(fd);
+        PyMem_Free(fd_pipe);
+        return NULL;
+    }
+    fd_pipe->data = NULL;
+
+    r = uv_pipe_open(fd_pipe, fd);
+    if (r != 0) {
+        RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self), PyExc_PipeError);
+        close(fd);
+        uv_close((uv_handle_t *)fd_pipe, on_handle_dealloc_close);
+        return NULL;
+    }
+    return fd_pipe;
+}
+#endif
+
+
+static PyObject *
+Pipe_func_write_message(Pipe *self, PyObject *args)
+{
+    int r;
+    Py_buffer pbuf;
+    uv_pipe_t *fd_pipe;
+    uv_stream_t *send_stream;
+    PyObject *callback, *send_handle;
+
+    callback = send_handle = Py_None;
+    send_stream = NULL;
+    fd_pipe = NULL;
+
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTuple(args, "s*|OO:write_message", &pbuf, &send_handle, &callback)) {
+        return NULL;
+    }
+
+    if (PyObject_TypeCheck(send_handle, &TCPType) || PyObject_TypeCheck(send_handle, &PipeType)) {
+        send_stream = (uv_stream_t *)UV_HANDLE(send_handle);
+    }
+#ifdef PYUV_WINDOWS
+    else if (send_handle != Py_None) {
+        PyBuffer_Release(&pbuf);
+        PyErr_SetString(PyExc_TypeError, "Only TCP and Pipe objects are supported for write_message");
+        return NULL;
+    }
+#endif
+
+    if (callback != Py_None && !PyCallable_Check(callback)) {
+        PyBuffer_Release(&pbuf);
+        PyErr_SetString(PyExc_TypeError, "a callable or None is required");
+        return NULL;
+    }
+
+    if (pbuf.len > PIPE_MSG_MAX_SIZE) {
+        PyBuffer_Release(&pbuf);
+        PyErr_SetString(PyExc_ValueError, "message is too big");
+        return NULL;
+    }
+
+    if (send_handle != Py_None) {
+#ifndef PYUV_WINDOWS
+        if (!send_stream) {
+            /* a file descriptor, it's duplicated into a temporary pipe handle so libuv can send it */
+            fd_pipe = pipe_wrap_fd(self, send_handle);
+            if (!fd_pipe) {
+                PyBuffer_Release(&pbuf);
+                return NULL;
+            }
+            send_stream = (uv_stream_t *)fd_pipe;
+        }
+#endif
+        /* The handle is attached to a write, so its message must be the first one in it */
+        if (self->out_len > 0 && pipe_messages_flush(self, NULL, NULL) != 0) {
+            goto error;
+        }
+        if (pipe_messages_append(self, pbuf.buf, pbuf.len, True, callback) != 0) {
+            goto error;
+        }
+        PyBuffer_Release(&pbuf);
+        if (pipe_messages_flush(self, send_stream, fd_pipe) != 0) {
+            return NULL;
+        }
+        Py_RETURN_NONE;
+    }
+
+    r = pipe_messages_append(self, pbuf.buf, pbuf.len, False, callback);
+    PyBuffer_Release(&pbuf);
+    if (r != 0) {
+        return NULL;
+    }
+
+    /* Small messages are batched while a write is in flight, they are sent when it completes */
+    if (self->writes_in_flight == 0 || self->out_len >= PIPE_MSG_BATCH_SIZE) {
+        if (pipe_messages_flush(self, NULL, NULL) != 0) {
+            return NULL;
+        }
+    }
+
+    Py_RETURN_NONE;
+
+error:
+    PyBuffer_Release(&pbuf);
+    if (fd_pipe) {
+        uv_close((uv_handle_t *)fd_pipe, on_handle_dealloc_close);
+    }
+    return NULL;
+}
+
+
 static int
 Pipe_tp_init(Pipe *self, PyObject *args, PyObject *kwargs)
 {
@@ -384,6 +1005,7 @@ Pipe_tp_init(Pipe *self, PyObject *args, PyObject *kwargs)
     }
     uv_pipe->data = (void *)self;
     UV_HANDLE(self) = (uv_handle_t *)uv_pipe;
+    PYUV_PROBE2(handle__init, self, Py_TYPE(self)->tp_name);
 
     return 0;
 }
@@ -404,6 +1026,8 @@ static int
 Pipe_tp_traverse(Pipe *self, visitproc visit, void *arg)
 {
     Py_VISIT(self->on_new_connection_cb);
+    Py_VISIT(self->pending_handles);
+    Py_VISIT(self->out_callbacks);
     StreamType.tp_traverse((PyObject *)self, visit, arg);
     return 0;
 }
@@ -413,6 +1037,14 @@ static int
 Pipe_tp_clear(Pipe *self)
 {
     Py_CLEAR(self->on_new_connection_cb);
+    Py_CLEAR(self->pending_handles);
+    Py_CLEAR(self->out_callbacks);
+    PyMem_Free(self->in_buf);
+    self->in_buf = NULL;
+    self->in_len = self->in_size = 0;
+    PyMem_Free(self->out_buf);
+    self->out_buf = NULL;
+    self->out_len = self->out_size = 0;
     StreamType.tp_clear((PyObject *)self);
     return 0;
 }
@@ -428,6 +1060,8 @@ Pipe_tp_methods[] = {
     { "pending_instances", (PyCFunction)Pipe_func_pending_instances, METH_VARARGS, "Set the number of pending pipe instance handles when the pipe server is waiting for connections." },
     { "start_read2", (PyCFunction)Pipe_func_start_read2, METH_VARARGS, "Extended read methods for receiving handles over a pipe. The pipe must be initialized with ipc set to True." },
     { "write2", (PyCFunction)Pipe_func_write2, METH_VARARGS, "Write data and send handle over a pipe." },
+    { "start_read_messages", (PyCFunction)Pipe_func_start_read_messages, METH_VARARGS, "Start reading framed messages, along with the handles sent with them. The pipe must be initialized with ipc set to True." },
+    { "write_message", (PyCFunction)Pipe_func_write_message, METH_VARARGS, "Write a framed message, optionally sending a handle along with it." },
     { NULL }
 };
 
@@ -15,17 +15,17 @@ on_poll_callback(uv_poll_t *handle, int status, int events)
     Py_INCREF(self);
 
     if (status == 0) {
-        py_events = PyInt_FromLong((long)events);
+        py_events = pyuv_event_mask(events);
         py_errorno = Py_None;
         Py_INCREF(Py_None);
     } else  {
         py_events = Py_None;
         Py_INCREF(Py_None);
         err = uv_last_error(UV_HANDLE_LOOP(self));
-        py_errorno = PyInt_FromLong((long)err.code);
+        py_errorno = pyuv_error_code(err.code);
     }
 
-    result = PyObject_CallFunctionObjArgs(self->callback, self, py_events, py_errorno,NULL);
+    result = pyuv_callback("poll", self->callback, self, py_events, py_errorno,NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(self->callback);
     }
@@ -132,6 +132,7 @@ Poll_tp_init(Poll *self, PyObject *args, PyObject *kwargs)
     }
     uv_poll->data = (void *)self;
     UV_HANDLE(self) = (uv_handle_t *)uv_poll;
+    PYUV_PROBE2(handle__init, self, Py_TYPE(self)->tp_name);
 
     return 0;
 }
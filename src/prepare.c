@@ -14,7 +14,7 @@ on_prepare_callback(uv_prepare_t *handle, int status)
     /* Object could go out of scope in the callback, increase refcount to avoid it */
     Py_INCREF(self);
 
-    result = PyObject_CallFunctionObjArgs(self->callback, self, NULL);
+    result = pyuv_callback("prepare", self->callback, self, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(self->callback);
     }
@@ -118,6 +118,7 @@ Prepare_tp_init(Prepare *self, PyObject *args, PyObject *kwargs)
     }
     uv_prepare->data = (void *)self;
     UV_HANDLE(self) = (uv_handle_t *)uv_prepare;
+    PYUV_PROBE2(handle__init, self, Py_TYPE(self)->tp_name);
 
     return 0;
 }
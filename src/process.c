@@ -196,7 +196,7 @@ on_process_exit(uv_process_t *process, int exit_status, int term_signal)
     py_term_signal = PyInt_FromLong(term_signal);
 
     if (self->on_exit_cb != Py_None) {
-        result = PyObject_CallFunctionObjArgs(self->on_exit_cb, self, py_exit_status, py_term_signal, NULL);
+        result = pyuv_callback("exit", self->on_exit_cb, self, py_exit_status, py_term_signal, NULL);
         if (result == NULL) {
             PyErr_WriteUnraisable(self->on_exit_cb);
         }
@@ -386,6 +386,7 @@ Process_func_spawn(Process *self, PyObject *args, PyObject *kwargs)
     }
     uv_process->data = (void *)self;
     UV_HANDLE(self) = (uv_handle_t *)uv_process;
+    PYUV_PROBE2(handle__init, self, Py_TYPE(self)->tp_name);
 
     r = uv_spawn(UV_HANDLE_LOOP(self), uv_process, options);
 
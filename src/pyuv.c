@@ -7,20 +7,28 @@
 #include "handle.c"
 #include "async.c"
 #include "timer.c"
+#include "timerwheel.c"
+#include "hrtimer.c"
 #include "prepare.c"
 #include "idle.c"
 #include "check.c"
 #include "signal.c"
+#include "http.c"
+#include "websocket.c"
+#include "resp.c"
 #include "stream.c"
 #include "pipe.c"
 #include "tcp.c"
 #include "tty.c"
 #include "udp.c"
 #include "poll.c"
+#include "sharedring.c"
 #include "fs.c"
+#include "kernels.c"
 #include "threadpool.c"
 #include "process.c"
 #include "util.c"
+#include "tls.c"
 
 #define LIBUV_VERSION UV_VERSION_MAJOR.UV_VERSION_MINOR-LIBUV_REVISION
 
@@ -67,6 +75,12 @@ init_pyuv(void)
     /* Initialize GIL */
     PyEval_InitThreads();
 
+#ifdef PYUV_HAVE_OPENSSL
+    /* Initialize OpenSSL */
+    SSL_library_init();
+    SSL_load_error_strings();
+#endif
+
 #ifdef PYUV_WINDOWS
     if (pyuv_setmaxstdio()) {
         return NULL;
@@ -111,6 +125,10 @@ init_pyuv(void)
     /* Types */
     AsyncType.tp_base = &HandleType;
     TimerType.tp_base = &HandleType;
+    TimerWheelType.tp_base = &HandleType;
+#ifdef PYUV_HAVE_HRTIMER
+    HRTimerType.tp_base = &HandleType;
+#endif
     PrepareType.tp_base = &HandleType;
     IdleType.tp_base = &HandleType;
     CheckType.tp_base = &HandleType;
@@ -123,10 +141,18 @@ init_pyuv(void)
     TCPType.tp_base = &StreamType;
     PipeType.tp_base = &StreamType;
     TTYType.tp_base = &StreamType;
+#ifdef PYUV_HAVE_SHARED_RING
+    SharedRingType.tp_base = &HandleType;
+#endif
 
     PyUVModule_AddType(pyuv, "Loop", &LoopType);
     PyUVModule_AddType(pyuv, "Async", &AsyncType);
     PyUVModule_AddType(pyuv, "Timer", &TimerType);
+    PyUVModule_AddType(pyuv, "TimerWheel", &TimerWheelType);
+    PyUVModule_AddType(pyuv, "TimerWheelEntry", &TimerWheelEntryType);
+#ifdef PYUV_HAVE_HRTIMER
+    PyUVModule_AddType(pyuv, "HRTimer", &HRTimerType);
+#endif
     PyUVModule_AddType(pyuv, "Prepare", &PrepareType);
     PyUVModule_AddType(pyuv, "Idle", &IdleType);
     PyUVModule_AddType(pyuv, "Check", &CheckType);
@@ -139,12 +165,29 @@ init_pyuv(void)
     PyUVModule_AddType(pyuv, "StdIO", &StdIOType);
     PyUVModule_AddType(pyuv, "Process", &ProcessType);
     PyUVModule_AddType(pyuv, "ThreadPool", &ThreadPoolType);
+    PyUVModule_AddType(pyuv, "Future", &FutureType);
+    PyUVModule_AddType(pyuv, "HTTPParser", &HTTPParserType);
+    PyUVModule_AddType(pyuv, "WebSocketParser", &WebSocketParserType);
+    PyUVModule_AddType(pyuv, "RESPParser", &RESPParserType);
+#ifdef PYUV_HAVE_OPENSSL
+    PyUVModule_AddType(pyuv, "TLSContext", &TLSContextType);
+    PyUVModule_AddType(pyuv, "TLSStream", &TLSStreamType);
+#endif
+#ifdef PYUV_HAVE_SHARED_RING
+    PyUVModule_AddType(pyuv, "SharedRing", &SharedRingType);
+#endif
 
     /* PyStructSequence types */
     if (AddrinfoResultType.tp_name == 0)
         PyStructSequence_InitType(&AddrinfoResultType, &addrinfo_result_desc);
+    if (HandleStatsResultType.tp_name == 0)
+        PyStructSequence_InitType(&HandleStatsResultType, &handle_stats_result_desc);
     if (LoopCountersResultType.tp_name == 0)
         PyStructSequence_InitType(&LoopCountersResultType, &loop_counters_result_desc);
+    if (LoopMonitorResultType.tp_name == 0)
+        PyStructSequence_InitType(&LoopMonitorResultType, &loop_monitor_result_desc);
+    if (LoopProfileResultType.tp_name == 0)
+        PyStructSequence_InitType(&LoopProfileResultType, &loop_profile_result_desc);
     if (StatResultType.tp_name == 0)
         PyStructSequence_InitType(&StatResultType, &stat_result_desc);
 
@@ -162,6 +205,25 @@ init_pyuv(void)
     PyModule_AddIntMacro(pyuv, UV_WRITABLE_PIPE);
     PyModule_AddIntMacro(pyuv, UV_INHERIT_FD);
     PyModule_AddIntMacro(pyuv, UV_INHERIT_STREAM);
+    /* Stream compression constants */
+    PyModule_AddIntConstant(pyuv, "COMPRESS_NONE", PYUV_COMPRESS_NONE);
+#ifdef PYUV_HAVE_ZLIB
+    PyModule_AddIntConstant(pyuv, "COMPRESS_DEFLATE", PYUV_COMPRESS_DEFLATE);
+#endif
+#ifdef PYUV_HAVE_ZSTD
+    PyModule_AddIntConstant(pyuv, "COMPRESS_ZSTD", PYUV_COMPRESS_ZSTD);
+#endif
+    /* WebSocket opcodes */
+    PyModule_AddIntConstant(pyuv, "WS_OPCODE_CONTINUATION", PYUV_WS_OPCODE_CONTINUATION);
+    PyModule_AddIntConstant(pyuv, "WS_OPCODE_TEXT", PYUV_WS_OPCODE_TEXT);
+    PyModule_AddIntConstant(pyuv, "WS_OPCODE_BINARY", PYUV_WS_OPCODE_BINARY);
+    PyModule_AddIntConstant(pyuv, "WS_OPCODE_CLOSE", PYUV_WS_OPCODE_CLOSE);
+    PyModule_AddIntConstant(pyuv, "WS_OPCODE_PING", PYUV_WS_OPCODE_PING);
+    PyModule_AddIntConstant(pyuv, "WS_OPCODE_PONG", PYUV_WS_OPCODE_PONG);
+    /* Loop run modes */
+    PyModule_AddIntConstant(pyuv, "UV_RUN_DEFAULT", PYUV_RUN_DEFAULT);
+    PyModule_AddIntConstant(pyuv, "UV_RUN_ONCE", PYUV_RUN_ONCE);
+    PyModule_AddIntConstant(pyuv, "UV_RUN_NOWAIT", PYUV_RUN_NOWAIT);
     /* Poll constants */
     PyModule_AddIntMacro(pyuv, UV_READABLE);
     PyModule_AddIntMacro(pyuv, UV_WRITABLE);
@@ -31,6 +31,69 @@
 /* libuv */
 #include "uv.h"
 
+/* Compression libraries, only if found at build time */
+#ifdef PYUV_HAVE_ZLIB
+    #include <zlib.h>
+#endif
+#ifdef PYUV_HAVE_ZSTD
+    #include <zstd.h>
+#endif
+
+/* OpenSSL, only if found at build time */
+#ifdef PYUV_HAVE_OPENSSL
+    #include <openssl/ssl.h>
+    #include <openssl/err.h>
+    #include <openssl/x509v3.h>
+#endif
+
+/* Shared memory rings need memfd/eventfd and high resolution timers need timerfd, only
+ * available on Linux */
+#ifdef __linux__
+    #define PYUV_HAVE_SHARED_RING
+    #define PYUV_HAVE_HRTIMER
+    #include <sys/mman.h>
+    #include <sys/eventfd.h>
+    #include <sys/timerfd.h>
+    #include <sys/stat.h>
+    #include <sys/syscall.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+/* Static tracepoints (USDT) for bpftrace, perf or SystemTap, provider "pyuv". Only compiled
+ * in if sys/sdt.h was found at build time. Every probe has a semaphore, which the tracer
+ * increments while attached, so arguments which are costly to compute (latencies) are
+ * only computed when someone is listening. */
+#ifdef PYUV_HAVE_SDT
+    #define _SDT_HAS_SEMAPHORES 1
+    #include <sys/sdt.h>
+    #define PYUV_PROBE_SEMAPHORE(name) \
+        static unsigned short pyuv_##name##_semaphore __attribute__((used, section(".probes")))
+    PYUV_PROBE_SEMAPHORE(loop__run__start);     /* (loop, mode) */
+    PYUV_PROBE_SEMAPHORE(loop__run__end);       /* (loop) */
+    PYUV_PROBE_SEMAPHORE(loop__poll__start);    /* (loop) */
+    PYUV_PROBE_SEMAPHORE(loop__poll__end);      /* (loop, ns spent polling and in I/O callbacks) */
+    PYUV_PROBE_SEMAPHORE(handle__init);         /* (handle, type name) */
+    PYUV_PROBE_SEMAPHORE(handle__close);        /* (handle, type name) */
+    PYUV_PROBE_SEMAPHORE(handle__read);         /* (handle, bytes) */
+    PYUV_PROBE_SEMAPHORE(handle__write);        /* (handle, bytes) */
+    PYUV_PROBE_SEMAPHORE(handle__error);        /* (handle) */
+    PYUV_PROBE_SEMAPHORE(timer__fire);          /* (timer, repeat ms) */
+    PYUV_PROBE_SEMAPHORE(fs__submit);           /* (req, fs type) */
+    PYUV_PROBE_SEMAPHORE(fs__complete);         /* (req, fs type, result) */
+    PYUV_PROBE_SEMAPHORE(work__start);          /* (req, ns spent in the queue) */
+    PYUV_PROBE_SEMAPHORE(work__end);            /* (req, ns spent running) */
+    #define PYUV_PROBE_ENABLED(name) __builtin_expect(pyuv_##name##_semaphore != 0, 0)
+    #define PYUV_PROBE1(name, a) DTRACE_PROBE1(pyuv, name, a)
+    #define PYUV_PROBE2(name, a, b) DTRACE_PROBE2(pyuv, name, a, b)
+    #define PYUV_PROBE3(name, a, b, c) DTRACE_PROBE3(pyuv, name, a, b, c)
+#else
+    #define PYUV_PROBE_ENABLED(name) 0
+    #define PYUV_PROBE1(name, a)
+    #define PYUV_PROBE2(name, a, b)
+    #define PYUV_PROBE3(name, a, b, c)
+#endif
+
 
 /* Custom types */
 typedef int Bool;
@@ -53,8 +116,10 @@ typedef int Bool;
 
 #ifdef _MSC_VER
     #define INLINE __inline
+    #define PYUV_THREAD_LOCAL __declspec(thread)
 #else
     #define INLINE inline
+    #define PYUV_THREAD_LOCAL __thread
 #endif
 
 /* borrowed from pyev */
@@ -78,15 +143,10 @@ typedef int Bool;
         }                                                                   \
     } while(0)                                                              \
 
-#define RAISE_UV_EXCEPTION(loop, exc_type)                                          \
-    do {                                                                            \
-        uv_err_t err = uv_last_error(loop);                                         \
-        PyObject *exc_data = Py_BuildValue("(is)", err.code, uv_strerror(err));     \
-        if (exc_data != NULL) {                                                     \
-            PyErr_SetObject(exc_type, exc_data);                                    \
-            Py_DECREF(exc_data);                                                    \
-        }                                                                           \
-    } while(0)                                                                      \
+#define RAISE_UV_EXCEPTION(loop, exc_type)                                  \
+    do {                                                                    \
+        pyuv_set_uv_exception(uv_last_error(loop), exc_type);               \
+    } while(0)                                                              \
 
 #if defined(_MSC_VER)
 #define __func__ __FUNCTION__
@@ -101,8 +161,132 @@ typedef int Bool;
         }                                                                   \
     } while(0)                                                              \
 
+/* Lock-free multi-producer single-consumer queue: producers push on a stack with a CAS, the
+ * consumer takes the whole stack at once and reverses it, so items come out in FIFO order */
+typedef struct pyuv_mpsc_node_s {
+    struct pyuv_mpsc_node_s *next;
+} pyuv_mpsc_node_t;
+
+#ifdef _MSC_VER
+    #define PYUV_ATOMIC_LOAD_PTR(p) InterlockedCompareExchangePointer((PVOID volatile *)(p), NULL, NULL)
+    #define PYUV_ATOMIC_CAS_PTR(p, expected, desired) \
+        (InterlockedCompareExchangePointer((PVOID volatile *)(p), (desired), *(expected)) == *(expected))
+    #define PYUV_ATOMIC_XCHG_PTR(p, value) InterlockedExchangePointer((PVOID volatile *)(p), (value))
+#else
+    #define PYUV_ATOMIC_LOAD_PTR(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+    #define PYUV_ATOMIC_CAS_PTR(p, expected, desired) \
+        __atomic_compare_exchange_n((p), (expected), (desired), False, __ATOMIC_RELEASE, __ATOMIC_RELAXED)
+    #define PYUV_ATOMIC_XCHG_PTR(p, value) __atomic_exchange_n((p), (value), __ATOMIC_ACQ_REL)
+#endif
+
+/* Returns True if the queue was empty, only then the consumer needs to be woken up */
+static INLINE Bool
+pyuv_mpsc_push(pyuv_mpsc_node_t **head, pyuv_mpsc_node_t *node)
+{
+    pyuv_mpsc_node_t *old;
+    do {
+        old = PYUV_ATOMIC_LOAD_PTR(head);
+        node->next = old;
+    } while (!PYUV_ATOMIC_CAS_PTR(head, &old, node));
+    return old == NULL;
+}
+
+static INLINE pyuv_mpsc_node_t *
+pyuv_mpsc_take(pyuv_mpsc_node_t **head)
+{
+    pyuv_mpsc_node_t *node, *next, *list;
+
+    node = PYUV_ATOMIC_XCHG_PTR(head, NULL);
+    list = NULL;
+    while (node) {
+        next = node->next;
+        node->next = list;
+        list = node;
+        node = next;
+    }
+    return list;
+}
+
 /* Python types definitions */
 
+/* Loop monitor: log-linear histograms with 2^LOOP_HISTOGRAM_SUB_BITS buckets per power of 2 */
+#define LOOP_HISTOGRAM_SUB_BITS 4
+#define LOOP_HISTOGRAM_BUCKETS  ((64 - LOOP_HISTOGRAM_SUB_BITS + 1) << LOOP_HISTOGRAM_SUB_BITS)
+
+typedef struct {
+    uint64_t count;
+    uint64_t min;
+    uint64_t max;
+    uint64_t sum;
+    uint64_t buckets[LOOP_HISTOGRAM_BUCKETS];
+} loop_histogram_t;
+
+typedef struct {
+    Bool active;
+    uv_prepare_t prepare;
+    uv_check_t check;
+    uv_timer_t timer;
+    uint64_t timer_interval;        /* ns */
+    uint64_t last_timer;
+    uint64_t last_prepare;
+    uint64_t poll_start;
+    uint64_t callback_time;         /* time spent in Python callbacks, updated by pyuv_callback */
+    uint64_t callback_time_iteration;
+    uint64_t callback_time_poll;
+    loop_histogram_t iteration;
+    loop_histogram_t callbacks;
+    loop_histogram_t poll;
+    loop_histogram_t timer_delay;
+} loop_monitor_t;
+
+/* Loop profiler: hash table keyed by (handle type, callback site, code of the callable) */
+typedef struct {
+    PyTypeObject *type;     /* handle or Loop type, NULL for other callbacks */
+    const char *site;
+    PyObject *key;          /* code object or callable, None for overflow, NULL for an empty slot */
+    uint64_t count;
+    uint64_t total;         /* ns */
+    uint64_t max;           /* ns */
+} loop_profiler_entry_t;
+
+typedef struct {
+    Bool active;
+    size_t size;            /* power of 2 */
+    size_t used;
+    loop_profiler_entry_t *entries;
+} loop_profiler_t;
+
+/* Traffic counters kept by TCP, Pipe, TTY and UDP handles, and summed per loop */
+typedef struct {
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t write_queue_high;  /* bytes */
+    uint64_t errors;
+} handle_stats_t;
+
+/* Callbacks queued with Loop.call_soon, a FIFO kept in a ring which grows as needed */
+typedef struct {
+    PyObject *callable;
+    PyObject *args;         /* tuple */
+} loop_call_t;
+
+typedef struct {
+    uv_idle_t idle;
+    loop_call_t *items;
+    size_t size;            /* power of 2 */
+    size_t head;
+    size_t count;
+} loop_calls_t;
+
+/* Calls queued with Loop.call_soon_threadsafe */
+typedef struct {
+    pyuv_mpsc_node_t node;
+    PyObject *callable;
+    PyObject *args;         /* tuple */
+} loop_threadsafe_call_t;
+
 /* Loop */
 typedef struct {
     PyObject_HEAD
@@ -110,8 +294,120 @@ typedef struct {
     PyObject *dict;
     uv_loop_t *uv_loop;
     int is_default;
+    /* unreferenced handles used by the non blocking and bounded run modes, set up on first use */
+    Bool run_handles_init;
+    Bool run_timed_out;
+    uv_idle_t run_idle;
+    uv_check_t run_check;
+    uv_timer_t run_timer;
+    loop_monitor_t *monitor;
+    loop_profiler_t *profiler;
+    loop_calls_t *calls;
+    /* unreferenced async handle, created with the loop because it can't be initialized from
+     * another thread, which wakes the loop for call_soon_threadsafe */
+    uv_async_t threadsafe_async;
+    pyuv_mpsc_node_t *threadsafe_calls;
+    handle_stats_t handle_stats;
+#ifdef PYUV_HAVE_SDT
+    /* unreferenced handles surrounding the poll phase, for the loop__poll__* probes */
+    uv_prepare_t probe_prepare;
+    uv_check_t probe_check;
+    uint64_t probe_poll_start;
+#endif
 } Loop;
 
+/* Loop run modes */
+#define PYUV_RUN_DEFAULT    0
+#define PYUV_RUN_ONCE       1
+#define PYUV_RUN_NOWAIT     2
+
+/* Loop being run by the current thread, if any */
+static PYUV_THREAD_LOCAL Loop *pyuv_current_loop = NULL;
+
+static void loop_profiler_record(Loop *loop, const char *site, PyObject *callable, PyObject *first_arg, uint64_t elapsed);
+
+/* Callback dispatch: same calling convention as PyObject_CallFunctionObjArgs (NULL terminated
+ * arguments) but the arguments are passed on the C stack through vectorcall / fastcall when the
+ * interpreter has it, instead of being packed in a new tuple on every call */
+#define PYUV_MAX_CALLBACK_ARGS 8
+
+static INLINE PyObject *
+pyuv__call(PyObject *callable, PyObject **args, Py_ssize_t nargs)
+{
+#if PY_VERSION_HEX < 0x03060000
+    Py_ssize_t i;
+    PyObject *tuple, *result;
+#endif
+
+#if PY_VERSION_HEX >= 0x03090000
+    return PyObject_Vectorcall(callable, args, nargs, NULL);
+#elif PY_VERSION_HEX >= 0x03080000
+    return _PyObject_Vectorcall(callable, args, nargs, NULL);
+#elif PY_VERSION_HEX >= 0x03060000
+    return _PyObject_FastCall(callable, args, nargs);
+#else
+    tuple = PyTuple_New(nargs);
+    if (!tuple) {
+        return NULL;
+    }
+    for (i = 0; i < nargs; i++) {
+        Py_INCREF(args[i]);
+        PyTuple_SET_ITEM(tuple, i, args[i]);
+    }
+    result = PyObject_Call(callable, tuple, NULL);
+    Py_DECREF(tuple);
+    return result;
+#endif
+}
+
+/* Time spent in Python is accounted while the running loop is being monitored or profiled,
+ * site names the kind of callback for the profiler */
+static INLINE PyObject *
+pyuv_callback_array(const char *site, PyObject *callable, PyObject **args, Py_ssize_t nargs)
+{
+    uint64_t t0, elapsed;
+    Loop *loop;
+    PyObject *result;
+
+    loop = pyuv_current_loop;
+    if (loop == NULL || !((loop->monitor && loop->monitor->active) || (loop->profiler && loop->profiler->active))) {
+        return pyuv__call(callable, args, nargs);
+    }
+
+    /* the callable could be replaced (and freed) while it runs */
+    Py_INCREF(callable);
+    t0 = uv_hrtime();
+    result = pyuv__call(callable, args, nargs);
+    elapsed = uv_hrtime() - t0;
+    if (loop->monitor && loop->monitor->active) {
+        loop->monitor->callback_time += elapsed;
+    }
+    if (loop->profiler && loop->profiler->active) {
+        loop_profiler_record(loop, site, callable, nargs > 0 ? args[0] : NULL, elapsed);
+    }
+    Py_DECREF(callable);
+    return result;
+}
+
+static INLINE PyObject *
+pyuv_callback(const char *site, PyObject *callable, ...)
+{
+    va_list va;
+    Py_ssize_t nargs;
+    PyObject *arg, *args[PYUV_MAX_CALLBACK_ARGS];
+
+    nargs = 0;
+    va_start(va, callable);
+    while ((arg = va_arg(va, PyObject *)) != NULL) {
+        ASSERT(nargs < PYUV_MAX_CALLBACK_ARGS);
+        args[nargs++] = arg;
+    }
+    va_end(va);
+
+    return pyuv_callback_array(site, callable, args, nargs);
+}
+
+
 static PyTypeObject LoopType;
 
 /* Handle */
@@ -126,10 +422,23 @@ typedef struct {
 
 static PyTypeObject HandleType;
 
+/* uv_poll_t which owns the descriptors it watches, they are closed after the handle */
+typedef struct {
+    uv_poll_t poll;
+    int fds[2];
+} pyuv_fd_poll_t;
+
 /* Async */
+typedef struct {
+    pyuv_mpsc_node_t node;
+    PyObject *obj;
+} async_payload_t;
+
 typedef struct {
     Handle handle;
     PyObject *callback;
+    pyuv_mpsc_node_t *payloads;     /* sent from any thread, taken by the loop thread */
+    Bool with_payloads;
 } Async;
 
 static PyTypeObject AsyncType;
@@ -138,10 +447,64 @@ static PyTypeObject AsyncType;
 typedef struct {
     Handle handle;
     PyObject *callback;
+    int64_t slack;          /* ms, deadlines are rounded up to a multiple of it */
+    int64_t deadline;       /* ms in loop time, last rounded deadline, repeats are scheduled from it */
+    unsigned int restarts;  /* bumped by start/stop/again, tells if the callback re-armed the timer */
 } Timer;
 
 static PyTypeObject TimerType;
 
+/* HRTimer */
+#ifdef PYUV_HAVE_HRTIMER
+typedef struct {
+    Handle handle;
+    PyObject *callback;
+    uint64_t interval;      /* ns */
+    int timerfd;
+} HRTimer;
+
+static PyTypeObject HRTimerType;
+#endif
+
+/* TimerWheel: hashed hierarchical timing wheel driven by a single uv timer. The root wheel
+ * has one slot per tick, every upper level covers TIMER_WHEEL_LEVEL_SIZE slots of the one below */
+#define TIMER_WHEEL_ROOT_BITS   8
+#define TIMER_WHEEL_ROOT_SIZE   (1 << TIMER_WHEEL_ROOT_BITS)
+#define TIMER_WHEEL_LEVEL_BITS  6
+#define TIMER_WHEEL_LEVEL_SIZE  (1 << TIMER_WHEEL_LEVEL_BITS)
+#define TIMER_WHEEL_LEVELS      4
+#define TIMER_WHEEL_MAX_TICKS   ((uint64_t)1 << (TIMER_WHEEL_ROOT_BITS + TIMER_WHEEL_LEVELS * TIMER_WHEEL_LEVEL_BITS))
+
+typedef struct timer_wheel_link_s {
+    struct timer_wheel_link_s *prev;
+    struct timer_wheel_link_s *next;
+} timer_wheel_link_t;
+
+typedef struct TimerWheel TimerWheel;
+
+typedef struct {
+    PyObject_HEAD
+    timer_wheel_link_t link;
+    TimerWheel *wheel;      /* borrowed, only set while scheduled */
+    uint64_t expires;       /* tick */
+    PyObject *data;
+} TimerWheelEntry;
+
+static PyTypeObject TimerWheelEntryType;
+
+struct TimerWheel {
+    Handle handle;
+    PyObject *callback;
+    uint64_t resolution;    /* ms per tick */
+    uint64_t base;          /* loop time of tick 0 */
+    uint64_t current;       /* next tick to expire */
+    Py_ssize_t pending;
+    timer_wheel_link_t root[TIMER_WHEEL_ROOT_SIZE];
+    timer_wheel_link_t levels[TIMER_WHEEL_LEVELS][TIMER_WHEEL_LEVEL_SIZE];
+};
+
+static PyTypeObject TimerWheelType;
+
 /* Prepare */
 typedef struct {
     Handle handle;
@@ -173,10 +536,96 @@ typedef struct {
 
 static PyTypeObject SignalType;
 
+/* HTTPParser */
+typedef struct {
+    PyObject_HEAD
+    PyObject *on_headers_cb;
+    PyObject *on_body_cb;
+    PyObject *on_complete_cb;
+    PyObject *handle;   /* borrowed, only valid while feeding data */
+    int state;
+    Bool feeding;
+    Bool keep_alive;
+    long long remaining;
+    char *buf;
+    Py_ssize_t buf_len;
+    Py_ssize_t buf_size;
+} HTTPParser;
+
+static PyTypeObject HTTPParserType;
+
+/* WebSocketParser */
+typedef struct {
+    PyObject_HEAD
+    PyObject *on_message_cb;
+    PyObject *handle;   /* borrowed, only valid while feeding data */
+    Bool server_side;
+    Py_ssize_t max_message_size;
+    int state;
+    Bool feeding;
+    /* current frame */
+    unsigned char hdr[14];
+    size_t hdr_len;
+    int opcode;
+    Bool fin;
+    Bool masked;
+    unsigned char key[4];
+    size_t key_offset;
+    uint64_t remaining;
+    /* message being reassembled */
+    int msg_opcode;
+    char *msg;
+    size_t msg_len;
+    size_t msg_size;
+    /* control frames */
+    char ctrl[125];
+    size_t ctrl_len;
+    char pong[125];
+    size_t pong_len;
+    Bool pong_pending;
+    /* masking keys, read from os.urandom in batches */
+    unsigned char mask_pool[256];
+    size_t mask_pool_offset;
+} WebSocketParser;
+
+static PyTypeObject WebSocketParserType;
+
+/* RESPParser */
+#define RESP_MAX_DEPTH 32
+
+typedef struct {
+    PyObject *list;     /* grows as the elements arrive */
+    Py_ssize_t count;   /* declared number of elements */
+} resp_frame_t;
+
+typedef struct {
+    PyObject_HEAD
+    PyObject *on_replies_cb;
+    PyObject *handle;   /* borrowed, only valid while feeding data */
+    int state;
+    char *line;
+    Py_ssize_t line_len;
+    Py_ssize_t line_size;
+    PyObject *bulk;
+    Py_ssize_t bulk_pos;
+    Py_ssize_t bulk_len;
+    resp_frame_t stack[RESP_MAX_DEPTH];
+    int depth;
+    PyObject *replies;
+} RESPParser;
+
+static PyTypeObject RESPParserType;
+
 /* Stream */
+typedef struct stream_compression_s stream_compression_t;
+
 typedef struct {
     Handle handle;
     PyObject *on_read_cb;
+    PyObject *layer;    /* object layered on top of this stream, which owns the read callbacks */
+    PyObject *parser;   /* protocol parser fed with the data read from this stream */
+    stream_compression_t *compression;
+    handle_stats_t stats;
 } Stream;
 
 static PyTypeObject StreamType;
@@ -193,6 +642,16 @@ static PyTypeObject TCPType;
 typedef struct {
     Stream stream;
     PyObject *on_new_connection_cb;
+    /* IPC message channel */
+    PyObject *pending_handles;      /* received handles not yet claimed by their message */
+    char *in_buf;                   /* incomplete incoming message */
+    Py_ssize_t in_len;
+    Py_ssize_t in_size;
+    char *out_buf;                  /* outgoing messages batched while a write is in flight */
+    Py_ssize_t out_len;
+    Py_ssize_t out_size;
+    PyObject *out_callbacks;
+    int writes_in_flight;
 } Pipe;
 
 static PyTypeObject PipeType;
@@ -208,6 +667,8 @@ static PyTypeObject TTYType;
 typedef struct {
     Handle handle;
     PyObject *on_read_cb;
+    size_t send_queue_size;     /* bytes */
+    handle_stats_t stats;
 } UDP;
 
 static PyTypeObject UDPType;
@@ -246,6 +707,23 @@ typedef struct {
 
 static PyTypeObject FSEventType;
 
+/* SharedRing */
+#ifdef PYUV_HAVE_SHARED_RING
+typedef struct shared_ring_header_s shared_ring_header_t;
+
+typedef struct {
+    Handle handle;
+    PyObject *callback;
+    shared_ring_header_t *header;
+    char *data;
+    size_t map_size;
+    int memfd;
+    int eventfd;
+} SharedRing;
+
+static PyTypeObject SharedRingType;
+#endif
+
 /* FSPoll */
 typedef struct {
     Handle handle;
@@ -258,10 +736,59 @@ static PyTypeObject FSPollType;
 typedef struct {
     PyObject_HEAD
     Loop *loop;
+    /* queue_work requests which haven't started yet, a binary heap ordered by priority */
+    struct tpool_req_data_s **pending;
+    Py_ssize_t pending_count;
+    Py_ssize_t pending_size;
+    uint64_t pending_seq;
 } ThreadPool;
 
 static PyTypeObject ThreadPoolType;
 
+/* Future, returned by ThreadPool.queue_work */
+typedef struct {
+    PyObject_HEAD
+    Loop *loop;
+    Bool done;
+    PyObject *result;
+    PyObject *error;        /* (type, value, traceback) tuple, or None */
+    PyObject *callbacks;    /* list, created on demand */
+    Bool cancelled;
+    struct tpool_req_data_s *work;  /* queue_work request, only set while it can be cancelled */
+} Future;
+
+static PyTypeObject FutureType;
+
+#ifdef PYUV_HAVE_OPENSSL
+/* TLSContext */
+typedef struct {
+    PyObject_HEAD
+    SSL_CTX *ctx;
+    PyObject *sessions;
+    int server_side;
+} TLSContext;
+
+static PyTypeObject TLSContextType;
+
+/* TLSStream */
+typedef struct {
+    PyObject_HEAD
+    PyObject *weakreflist;
+    Stream *stream;
+    TLSContext *context;
+    PyObject *server_hostname;
+    PyObject *on_handshake_cb;
+    PyObject *on_read_cb;
+    PyObject *pending_writes;
+    SSL *ssl;
+    BIO *rbio;
+    BIO *wbio;
+    Bool handshake_done;
+} TLSStream;
+
+static PyTypeObject TLSStreamType;
+#endif
+
 
 /* Exceptions */
 static PyObject* PyExc_AsyncError;
@@ -276,10 +803,13 @@ static PyObject* PyExc_PipeError;
 static PyObject* PyExc_PollError;
 static PyObject* PyExc_PrepareError;
 static PyObject* PyExc_ProcessError;
+static PyObject* PyExc_RESPError;
+static PyObject* PyExc_SharedRingError;
 static PyObject* PyExc_SignalError;
 static PyObject* PyExc_StreamError;
 static PyObject* PyExc_TCPError;
 static PyObject* PyExc_ThreadPoolError;
+static PyObject* PyExc_TLSError;
 static PyObject* PyExc_TimerError;
 static PyObject* PyExc_TTYError;
 static PyObject* PyExc_UDPError;
@@ -338,6 +868,64 @@ static PyStructSequence_Desc loop_counters_result_desc = {
     16
 };
 
+/* used by Loop.monitor_stats */
+static PyTypeObject LoopMonitorResultType;
+
+static PyStructSequence_Field loop_monitor_result_fields[] = {
+    {"count", "number of samples"},
+    {"min", "minimum, in seconds"},
+    {"mean", "mean, in seconds"},
+    {"p50", "median, in seconds"},
+    {"p90", "90th percentile, in seconds"},
+    {"p99", "99th percentile, in seconds"},
+    {"max", "maximum, in seconds"},
+    {NULL}
+};
+
+static PyStructSequence_Desc loop_monitor_result_desc = {
+    "loop_monitor_result",
+    NULL,
+    loop_monitor_result_fields,
+    7
+};
+
+/* used by Loop.profile_stats */
+static PyTypeObject LoopProfileResultType;
+
+static PyStructSequence_Field loop_profile_result_fields[] = {
+    {"count", "number of calls"},
+    {"total", "total time, in seconds"},
+    {"max", "longest call, in seconds"},
+    {NULL}
+};
+
+static PyStructSequence_Desc loop_profile_result_desc = {
+    "loop_profile_result",
+    NULL,
+    loop_profile_result_fields,
+    3
+};
+
+/* used by the stats attribute of TCP, Pipe, TTY and UDP and Loop.handle_stats */
+static PyTypeObject HandleStatsResultType;
+
+static PyStructSequence_Field handle_stats_result_fields[] = {
+    {"bytes_read", "number of bytes read"},
+    {"bytes_written", "number of bytes written"},
+    {"reads", "number of successful reads"},
+    {"writes", "number of successful writes"},
+    {"write_queue_high", "largest number of bytes waiting to be written"},
+    {"errors", "number of failed reads and writes"},
+    {NULL}
+};
+
+static PyStructSequence_Desc handle_stats_result_desc = {
+    "handle_stats_result",
+    NULL,
+    handle_stats_result_fields,
+    6
+};
+
 /* used by fs stat functions */
 static PyTypeObject StatResultType;
 
@@ -0,0 +1,621 @@
+
+/* Redis protocol (RESP) reply parser, can be attached to a stream with Stream.start_read */
+
+#define RESP_MAX_LINE_SIZE      (64 * 1024)
+/* Declared lengths are only trusted this far, like Redis proto-max-bulk-len. The containers
+ * grow as the data arrives, so a short header can't make us allocate the whole thing */
+#define RESP_MAX_BULK_LEN       (512 * 1024 * 1024)
+#define RESP_MAX_ARRAY_LEN      (1024 * 1024 * 128)
+#define RESP_BULK_PREALLOC      (64 * 1024)
+
+enum {
+    RESP_STATE_LINE = 0,
+    RESP_STATE_BULK,
+    RESP_STATE_ERROR
+};
+
+typedef struct {
+    char *base;
+    size_t len;
+    size_t size;
+} resp_buf_t;
+
+
+static int
+resp_buf_append(resp_buf_t *buf, const char *data, size_t len)
+{
+    char *tmp;
+    size_t size;
+
+    if (buf->len + len > buf->size) {
+        size = buf->size ? buf->size : 1024;
+        while (size < buf->len + len) {
+            size *= 2;
+        }
+        tmp = (char *) PyMem_Realloc(buf->base, size);
+        if (!tmp) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        buf->base = tmp;
+        buf->size = size;
+    }
+    memcpy(buf->base + buf->len, data, len);
+    buf->len += len;
+    return 0;
+}
+
+
+static void
+resp_parser_clear_partial(RESPParser *self)
+{
+    int i;
+
+    for (i = 0; i < self->depth; i++) {
+        Py_CLEAR(self->stack[i].list);
+    }
+    self->depth = 0;
+    Py_CLEAR(self->bulk);
+    self->line_len = 0;
+}
+
+
+/* Add a complete value to the array being built, or to the batch of replies. Steals the reference. */
+static int
+resp_push_value(RESPParser *self, PyObject *value)
+{
+    resp_frame_t *frame;
+
+    if (!value) {
+        return -1;
+    }
+
+    while (self->depth > 0) {
+        frame = &self->stack[self->depth-1];
+        if (PyList_Append(frame->list, value) != 0) {
+            Py_DECREF(value);
+            return -1;
+        }
+        Py_DECREF(value);
+        if (PyList_GET_SIZE(frame->list) < frame->count) {
+            return 0;
+        }
+        /* The array is complete, it becomes a value of its parent */
+        value = frame->list;
+        frame->list = NULL;
+        self->depth--;
+    }
+
+    if (PyList_Append(self->replies, value) != 0) {
+        Py_DECREF(value);
+        return -1;
+    }
+    Py_DECREF(value);
+    return 0;
+}
+
+
+static int
+resp_parse_length(const char *data, Py_ssize_t len, long long *result)
+{
+    Py_ssize_t i;
+    long long value;
+    Bool negative;
+
+    i = 0;
+    negative = False;
+    if (len > 0 && data[0] == '-') {
+        negative = True;
+        i++;
+    }
+    if (i == len) {
+        return -1;
+    }
+    value = 0;
+    for (; i < len; i++) {
+        if (data[i] < '0' || data[i] > '9' || value > (LLONG_MAX - 9) / 10) {
+            return -1;
+        }
+        value = value * 10 + (data[i] - '0');
+    }
+    *result = negative ? -value : value;
+    return 0;
+}
+
+
+/* Process a complete line (without the CRLF) */
+static int
+resp_process_line(RESPParser *self, const char *line, Py_ssize_t len)
+{
+    long long n;
+    PyObject *value, *tmp;
+
+    if (len == 0) {
+        return -1;
+    }
+
+    switch (line[0]) {
+        case '+':
+            return resp_push_value(self, PyString_FromStringAndSize(line + 1, len - 1));
+        case '-':
+            tmp = PYUVString_FromStringAndSize(line + 1, len - 1);
+            if (!tmp) {
+                return -1;
+            }
+            value = PyObject_CallFunctionObjArgs(PyExc_RESPError, tmp, NULL);
+            Py_DECREF(tmp);
+            return resp_push_value(self, value);
+        case ':':
+            if (resp_parse_length(line + 1, len - 1, &n) != 0) {
+                return -1;
+            }
+            if (n >= LONG_MIN && n <= LONG_MAX) {
+                return resp_push_value(self, PyInt_FromLong((long)n));
+            }
+            return resp_push_value(self, PyLong_FromLongLong(n));
+        case '$':
+            if (resp_parse_length(line + 1, len - 1, &n) != 0 || n < -1 || n > RESP_MAX_BULK_LEN) {
+                return -1;
+            }
+            if (n == -1) {
+                Py_INCREF(Py_None);
+                return resp_push_value(self, Py_None);
+            }
+            self->bulk = PyString_FromStringAndSize(NULL, (Py_ssize_t)(n < RESP_BULK_PREALLOC ? n : RESP_BULK_PREALLOC));
+            if (!self->bulk) {
+                return -1;
+            }
+            /* the trailing CRLF is checked after the data */
+            self->bulk_pos = 0;
+            self->bulk_len = (Py_ssize_t)n;
+            self->state = RESP_STATE_BULK;
+            return 0;
+        case '*':
+            if (resp_parse_length(line + 1, len - 1, &n) != 0 || n < -1 || n > RESP_MAX_ARRAY_LEN) {
+                return -1;
+            }
+            if (n == -1) {
+                Py_INCREF(Py_None);
+                return resp_push_value(self, Py_None);
+            }
+            value = PyList_New(0);
+            if (!value) {
+                return -1;
+            }
+            if (n == 0) {
+                return resp_push_value(self, value);
+            }
+            if (self->depth == RESP_MAX_DEPTH) {
+                Py_DECREF(value);
+                return -1;
+            }
+            self->stack[self->depth].list = value;
+            self->stack[self->depth].count = (Py_ssize_t)n;
+            self->depth++;
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+
+/* Keep the start of a line which didn't arrive completely */
+static int
+resp_line_append(RESPParser *self, const char *data, Py_ssize_t len)
+{
+    char *tmp;
+
+    if (self->line_len + len > RESP_MAX_LINE_SIZE) {
+        return -1;
+    }
+    if (self->line_len + len > self->line_size) {
+        tmp = (char *) PyMem_Realloc(self->line, self->line_len + len);
+        if (!tmp) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        self->line = tmp;
+        self->line_size = self->line_len + len;
+    }
+    memcpy(self->line + self->line_len, data, len);
+    self->line_len += len;
+    return 0;
+}
+
+
+static Py_ssize_t
+resp_parser_execute(RESPParser *self, const char *data, Py_ssize_t len)
+{
+    Py_ssize_t pos, n, eol, size;
+    const char *line;
+
+    pos = 0;
+    while (pos < len) {
+        if (self->state == RESP_STATE_BULK) {
+            /* Copy the payload straight into the result object */
+            n = len - pos;
+            if (self->bulk_pos < self->bulk_len) {
+                size = PyString_GET_SIZE(self->bulk);
+                if (self->bulk_pos == size) {
+                    size = size * 2 < self->bulk_len ? size * 2 : self->bulk_len;
+                    if (_PyBytes_Resize(&self->bulk, size) != 0) {
+                        return -1;
+                    }
+                }
+                if (n > size - self->bulk_pos) {
+                    n = size - self->bulk_pos;
+                }
+                memcpy(PyString_AS_STRING(self->bulk) + self->bulk_pos, data + pos, n);
+            } else {
+                /* CRLF after the payload */
+                n = 1;
+                if (data[pos] != "\r\n"[self->bulk_pos - self->bulk_len]) {
+                    return -1;
+                }
+            }
+            self->bulk_pos += n;
+            pos += n;
+            if (self->bulk_pos == self->bulk_len + 2) {
+                self->state = RESP_STATE_LINE;
+                n = resp_push_value(self, self->bulk);
+                self->bulk = NULL;
+                if (n != 0) {
+                    return -1;
+                }
+            }
+            continue;
+        }
+
+        line = memchr(data + pos, '\n', len - pos);
+        if (!line) {
+            if (resp_line_append(self, data + pos, len - pos) != 0) {
+                return -1;
+            }
+            return len;
+        }
+
+        eol = line - data;
+        if (self->line_len > 0) {
+            /* Complete the line started in a previous read */
+            if (resp_line_append(self, data + pos, eol - pos) != 0) {
+                return -1;
+            }
+            line = self->line;
+            n = self->line_len;
+            self->line_len = 0;
+        } else {
+            line = data + pos;
+            n = eol - pos;
+        }
+        pos = eol + 1;
+
+        if (n == 0 || line[n-1] != '\r') {
+            return -1;
+        }
+        if (resp_process_line(self, line, n - 1) != 0) {
+            return -1;
+        }
+    }
+
+    return pos;
+}
+
+
+static int
+resp_parser_feed(RESPParser *self, PyObject *handle, const char *data, Py_ssize_t len)
+{
+    Py_ssize_t r;
+    PyObject *replies, *result;
+
+    if (self->state == RESP_STATE_ERROR) {
+        return -1;
+    }
+
+    ASSERT(self->replies == NULL);
+    self->replies = PyList_New(0);
+    if (!self->replies) {
+        PyErr_WriteUnraisable(self->on_replies_cb);
+        return -1;
+    }
+
+    r = resp_parser_execute(self, data, len);
+
+    /* Replies parsed before an error are still delivered */
+    replies = self->replies;
+    self->replies = NULL;
+
+    if (r < 0) {
+        if (PyErr_Occurred()) {
+            PyErr_WriteUnraisable(self->on_replies_cb);
+        }
+        self->state = RESP_STATE_ERROR;
+        resp_parser_clear_partial(self);
+    }
+
+    if (PyList_GET_SIZE(replies) > 0) {
+        /* Object could go out of scope in the callback, increase refcount to avoid it */
+        Py_INCREF(self);
+        result = pyuv_callback("resp", self->on_replies_cb, handle, replies, NULL);
+        if (result == NULL) {
+            PyErr_WriteUnraisable(self->on_replies_cb);
+        }
+        Py_XDECREF(result);
+        Py_DECREF(self);
+    }
+    Py_DECREF(replies);
+
+    return r < 0 ? -1 : 0;
+}
+
+
+/* Append the RESP encoding of a command (a sequence of arguments) to the buffer */
+static int
+resp_encode_command(resp_buf_t *buf, PyObject *command)
+{
+    Py_ssize_t i, count, len;
+    PyObject *seq, *item, *tmp;
+    char header[32];
+    const char *ptr;
+    int header_len;
+
+    seq = PySequence_Fast(command, "a command must be a sequence of arguments");
+    if (!seq) {
+        return -1;
+    }
+    count = PySequence_Fast_GET_SIZE(seq);
+    if (count == 0) {
+        PyErr_SetString(PyExc_ValueError, "a command needs at least one argument");
+        goto error;
+    }
+
+    header_len = PyOS_snprintf(header, sizeof(header), "*%" PY_FORMAT_SIZE_T "d\r\n", count);
+    if (resp_buf_append(buf, header, header_len) != 0) {
+        goto error;
+    }
+
+    for (i = 0; i < count; i++) {
+        item = PySequence_Fast_GET_ITEM(seq, i);
+        tmp = NULL;
+        if (PyString_Check(item)) {
+            ptr = PyString_AS_STRING(item);
+            len = PyString_GET_SIZE(item);
+        } else if (PyUnicode_Check(item)) {
+            tmp = PyUnicode_AsUTF8String(item);
+            if (!tmp) {
+                goto error;
+            }
+            ptr = PyString_AS_STRING(tmp);
+            len = PyString_GET_SIZE(tmp);
+#ifdef PYUV_PYTHON3
+        } else if (PyLong_Check(item) || PyFloat_Check(item)) {
+            PyObject *str = PyObject_Str(item);
+            if (!str) {
+                goto error;
+            }
+            tmp = PyUnicode_AsUTF8String(str);
+            Py_DECREF(str);
+#else
+        } else if (PyInt_Check(item) || PyLong_Check(item) || PyFloat_Check(item)) {
+            tmp = PyObject_Str(item);
+#endif
+            if (!tmp) {
+                goto error;
+            }
+            ptr = PyString_AS_STRING(tmp);
+            len = PyString_GET_SIZE(tmp);
+        } else {
+            PyErr_SetString(PyExc_TypeError, "command arguments must be bytes, strings or numbers");
+            goto error;
+        }
+
+        header_len = PyOS_snprintf(header, sizeof(header), "$%" PY_FORMAT_SIZE_T "d\r\n", len);
+        if (resp_buf_append(buf, header, header_len) != 0 || resp_buf_append(buf, ptr, len) != 0 || resp_buf_append(buf, "\r\n", 2) != 0) {
+            Py_XDECREF(tmp);
+            goto error;
+        }
+        Py_XDECREF(tmp);
+    }
+
+    Py_DECREF(seq);
+    return 0;
+
+error:
+    Py_DECREF(seq);
+    return -1;
+}
+
+
+static PyObject *
+RESPParser_func_feed(RESPParser *self, PyObject *args)
+{
+    int r;
+    Py_buffer pbuf;
+
+    if (!PyArg_ParseTuple(args, "s*:feed", &pbuf)) {
+        return NULL;
+    }
+
+    r = resp_parser_feed(self, Py_None, pbuf.buf, pbuf.len);
+    PyBuffer_Release(&pbuf);
+    if (r != 0) {
+        PyErr_SetString(PyExc_ValueError, "invalid RESP data");
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+RESPParser_func_reset(RESPParser *self)
+{
+    resp_parser_clear_partial(self);
+    self->state = RESP_STATE_LINE;
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+RESPParser_func_encode_commands(PyObject *cls, PyObject *args)
+{
+    PyObject *commands, *iter, *command, *result;
+    resp_buf_t buf;
+
+    UNUSED_ARG(cls);
+
+    if (!PyArg_ParseTuple(args, "O:encode_commands", &commands)) {
+        return NULL;
+    }
+
+    iter = PyObject_GetIter(commands);
+    if (!iter) {
+        return NULL;
+    }
+
+    buf.base = NULL;
+    buf.len = buf.size = 0;
+    result = NULL;
+
+    while ((command = PyIter_Next(iter)) != NULL) {
+        if (resp_encode_command(&buf, command) != 0) {
+            Py_DECREF(command);
+            goto done;
+        }
+        Py_DECREF(command);
+    }
+    if (PyErr_Occurred()) {
+        goto done;
+    }
+
+    result = PyString_FromStringAndSize(buf.base, buf.len);
+
+done:
+    Py_DECREF(iter);
+    PyMem_Free(buf.base);
+    return result;
+}
+
+
+static int
+RESPParser_tp_init(RESPParser *self, PyObject *args, PyObject *kwargs)
+{
+    PyObject *on_replies_cb, *tmp;
+
+    if (!PyArg_ParseTuple(args, "O:__init__", &on_replies_cb)) {
+        return -1;
+    }
+
+    if (!PyCallable_Check(on_replies_cb)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return -1;
+    }
+
+    tmp = self->on_replies_cb;
+    Py_INCREF(on_replies_cb);
+    self->on_replies_cb = on_replies_cb;
+    Py_XDECREF(tmp);
+
+    resp_parser_clear_partial(self);
+    self->state = RESP_STATE_LINE;
+
+    return 0;
+}
+
+
+static PyObject *
+RESPParser_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    RESPParser *self = (RESPParser *)PyType_GenericNew(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+    self->line = NULL;
+    self->line_len = self->line_size = 0;
+    self->depth = 0;
+    return (PyObject *)self;
+}
+
+
+static int
+RESPParser_tp_traverse(RESPParser *self, visitproc visit, void *arg)
+{
+    int i;
+
+    Py_VISIT(self->on_replies_cb);
+    Py_VISIT(self->replies);
+    for (i = 0; i < self->depth; i++) {
+        Py_VISIT(self->stack[i].list);
+    }
+    return 0;
+}
+
+
+static int
+RESPParser_tp_clear(RESPParser *self)
+{
+    Py_CLEAR(self->on_replies_cb);
+    Py_CLEAR(self->replies);
+    resp_parser_clear_partial(self);
+    return 0;
+}
+
+
+static void
+RESPParser_tp_dealloc(RESPParser *self)
+{
+    RESPParser_tp_clear(self);
+    PyMem_Free(self->line);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+
+static PyMethodDef
+RESPParser_tp_methods[] = {
+    { "feed", (PyCFunction)RESPParser_func_feed, METH_VARARGS, "Feed data to the parser." },
+    { "reset", (PyCFunction)RESPParser_func_reset, METH_NOARGS, "Reset the parser state, discarding any partial reply." },
+    { "encode_commands", (PyCFunction)RESPParser_func_encode_commands, METH_VARARGS|METH_STATIC, "Encode a sequence of commands into a single buffer." },
+    { NULL }
+};
+
+
+static PyTypeObject RESPParserType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv.RESPParser",                                              /*tp_name*/
+    sizeof(RESPParser),                                             /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    (destructor)RESPParser_tp_dealloc,                              /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    0,                                                              /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,                        /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)RESPParser_tp_traverse,                           /*tp_traverse*/
+    (inquiry)RESPParser_tp_clear,                                   /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    0,                                                              /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    RESPParser_tp_methods,                                          /*tp_methods*/
+    0,                                                              /*tp_members*/
+    0,                                                              /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    (initproc)RESPParser_tp_init,                                   /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    RESPParser_tp_new,                                              /*tp_new*/
+};
+
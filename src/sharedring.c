@@ -0,0 +1,601 @@
+
+#ifdef PYUV_HAVE_SHARED_RING
+
+/* Lock-free ring of variable sized messages living in a shared memory file (memfd). Any
+ * number of producers (threads or processes which have the file descriptors) reserve space
+ * by advancing 'head' atomically and commit each record by publishing its sequence number.
+ * The single consumer reads committed records in order and advances 'tail'. An eventfd
+ * wakes up the consumer, but only when it announced it's about to sleep. */
+
+#define SHARED_RING_MAGIC           0x52425550  /* "PUBR" */
+#define SHARED_RING_MIN_SIZE        4096
+#define SHARED_RING_DEFAULT_SIZE    (1024 * 1024)
+#define SHARED_RING_RECORD_HEADER   16
+#define SHARED_RING_PADDING         0x80000000U
+
+struct shared_ring_header_s {
+    uint32_t magic;
+    uint32_t reserved;
+    uint64_t capacity;
+    char pad0[48];
+    uint64_t head;                  /* written by producers */
+    char pad1[56];
+    uint64_t tail;                  /* written by the consumer */
+    char pad2[56];
+    uint32_t consumer_sleeping;
+    char pad3[60];
+};
+
+typedef struct {
+    uint32_t len;                   /* payload length, or SHARED_RING_PADDING */
+    uint32_t unused;
+    uint64_t seq;                   /* position of the record + 1, written last */
+} shared_ring_record_t;
+
+
+#define SHARED_RING_ALIGN(n) (((n) + 15) & ~((uint64_t)15))
+
+
+static int
+shared_ring_create_memfd(void)
+{
+    int fd;
+#ifdef SYS_memfd_create
+    fd = syscall(SYS_memfd_create, "pyuv-shared-ring", 1 /* MFD_CLOEXEC */);
+    if (fd != -1 || errno != ENOSYS) {
+        return fd;
+    }
+#endif
+    /* Older kernels: use an unlinked file on the shared memory filesystem */
+    {
+        char path[] = "/dev/shm/pyuv-ring-XXXXXX";
+        fd = mkstemp(path);
+        if (fd != -1) {
+            unlink(path);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+    }
+    return fd;
+}
+
+
+static int
+shared_ring_map(SharedRing *self, Bool init, uint64_t capacity)
+{
+    void *ptr;
+    struct stat st;
+    size_t map_size;
+
+    if (init) {
+        map_size = sizeof(shared_ring_header_t) + capacity;
+        if (ftruncate(self->memfd, map_size) != 0) {
+            PyErr_SetFromErrno(PyExc_SharedRingError);
+            return -1;
+        }
+    } else {
+        if (fstat(self->memfd, &st) != 0) {
+            PyErr_SetFromErrno(PyExc_SharedRingError);
+            return -1;
+        }
+        map_size = st.st_size;
+        if (map_size < sizeof(shared_ring_header_t) + SHARED_RING_MIN_SIZE) {
+            PyErr_SetString(PyExc_SharedRingError, "file is not a shared ring");
+            return -1;
+        }
+    }
+
+    ptr = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, self->memfd, 0);
+    if (ptr == MAP_FAILED) {
+        PyErr_SetFromErrno(PyExc_SharedRingError);
+        return -1;
+    }
+    self->header = (shared_ring_header_t *)ptr;
+    self->data = (char *)ptr + sizeof(shared_ring_header_t);
+    self->map_size = map_size;
+
+    if (init) {
+        self->header->capacity = capacity;
+        /* nobody is consuming yet, the first message must signal */
+        self->header->consumer_sleeping = 1;
+        __atomic_store_n(&self->header->magic, SHARED_RING_MAGIC, __ATOMIC_RELEASE);
+    } else if (__atomic_load_n(&self->header->magic, __ATOMIC_ACQUIRE) != SHARED_RING_MAGIC ||
+               self->header->capacity + sizeof(shared_ring_header_t) != map_size ||
+               (self->header->capacity & (self->header->capacity - 1)) != 0) {
+        PyErr_SetString(PyExc_SharedRingError, "file is not a shared ring");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/* Returns 1 if the message was added, 0 if there is no room for it */
+static int
+shared_ring_put(SharedRing *self, const char *data, uint32_t len)
+{
+    shared_ring_header_t *hdr = self->header;
+    shared_ring_record_t *rec;
+    uint64_t capacity, head, tail, pos, need, pad;
+
+    capacity = hdr->capacity;
+    need = SHARED_RING_ALIGN(SHARED_RING_RECORD_HEADER + (uint64_t)len);
+
+    head = __atomic_load_n(&hdr->head, __ATOMIC_RELAXED);
+    do {
+        tail = __atomic_load_n(&hdr->tail, __ATOMIC_ACQUIRE);
+        pos = head & (capacity - 1);
+        /* records never wrap around, skip the end of the buffer if it doesn't fit there */
+        pad = (capacity - pos < need) ? capacity - pos : 0;
+        if (head + pad + need - tail > capacity) {
+            return 0;
+        }
+    } while (!__atomic_compare_exchange_n(&hdr->head, &head, head + pad + need, True, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+    if (pad) {
+        rec = (shared_ring_record_t *)(self->data + pos);
+        rec->len = SHARED_RING_PADDING;
+        __atomic_store_n(&rec->seq, head + 1, __ATOMIC_RELEASE);
+        head += pad;
+        pos = 0;
+    }
+
+    rec = (shared_ring_record_t *)(self->data + pos);
+    rec->len = len;
+    memcpy((char *)rec + SHARED_RING_RECORD_HEADER, data, len);
+    __atomic_store_n(&rec->seq, head + 1, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&hdr->consumer_sleeping, __ATOMIC_SEQ_CST) && __atomic_exchange_n(&hdr->consumer_sleeping, 0, __ATOMIC_SEQ_CST)) {
+        uint64_t one = 1;
+        /* EAGAIN means the counter is already signaled, which is all we need */
+        while (write(self->eventfd, &one, sizeof(one)) == -1 && errno == EINTR);
+    }
+
+    return 1;
+}
+
+
+/* Next committed record, or NULL */
+static INLINE shared_ring_record_t *
+shared_ring_peek(SharedRing *self, uint64_t tail)
+{
+    shared_ring_record_t *rec = (shared_ring_record_t *)(self->data + (tail & (self->header->capacity - 1)));
+    if (__atomic_load_n(&rec->seq, __ATOMIC_SEQ_CST) != tail + 1) {
+        return NULL;
+    }
+    return rec;
+}
+
+
+/* Clear the seq word of every record position in the consumed span [start, end), which doesn't
+ * wrap. Payload bytes from an earlier lap could otherwise look like the commit of a record which
+ * a producer reserved but didn't write yet. */
+static INLINE void
+shared_ring_clear(SharedRing *self, uint64_t start, uint64_t end)
+{
+    char *ptr = self->data + (start & (self->header->capacity - 1));
+    char *limit = ptr + (end - start);
+
+    for (; ptr < limit; ptr += 16) {
+        __atomic_store_n(&((shared_ring_record_t *)ptr)->seq, 0, __ATOMIC_RELAXED);
+    }
+}
+
+
+/* Collect all committed messages */
+static PyObject *
+shared_ring_drain(SharedRing *self)
+{
+    shared_ring_header_t *hdr = self->header;
+    shared_ring_record_t *rec;
+    uint64_t tail, next, capacity;
+    PyObject *messages, *msg;
+
+    messages = PyList_New(0);
+    if (!messages) {
+        return NULL;
+    }
+
+    capacity = hdr->capacity;
+    tail = hdr->tail;
+
+    for (;;) {
+        while ((rec = shared_ring_peek(self, tail)) != NULL) {
+            if (rec->len == SHARED_RING_PADDING) {
+                next = tail + capacity - (tail & (capacity - 1));
+            } else {
+                /* the record comes from another process, never trust it */
+                if ((uint64_t)rec->len > capacity - (tail & (capacity - 1)) - SHARED_RING_RECORD_HEADER) {
+                    PyErr_SetString(PyExc_SharedRingError, "corrupted record in the ring");
+                    Py_DECREF(messages);
+                    return NULL;
+                }
+                msg = PyString_FromStringAndSize((char *)rec + SHARED_RING_RECORD_HEADER, rec->len);
+                if (!msg || PyList_Append(messages, msg) != 0) {
+                    Py_XDECREF(msg);
+                    Py_DECREF(messages);
+                    return NULL;
+                }
+                Py_DECREF(msg);
+                next = tail + SHARED_RING_ALIGN(SHARED_RING_RECORD_HEADER + (uint64_t)rec->len);
+            }
+            shared_ring_clear(self, tail, next);
+            tail = next;
+            /* the space can be reused by producers from now on, the release orders the clearing before it */
+            __atomic_store_n(&hdr->tail, tail, __ATOMIC_RELEASE);
+        }
+
+        /* Announce we are going to sleep, then check again to avoid missing a wakeup */
+        __atomic_store_n(&hdr->consumer_sleeping, 1, __ATOMIC_SEQ_CST);
+        if (!shared_ring_peek(self, tail)) {
+            break;
+        }
+        __atomic_store_n(&hdr->consumer_sleeping, 0, __ATOMIC_SEQ_CST);
+    }
+
+    return messages;
+}
+
+
+static void
+on_shared_ring_poll(uv_poll_t *handle, int status, int events)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    uint64_t count;
+    uv_err_t err;
+    SharedRing *self;
+    PyObject *result, *messages, *py_errorno;
+
+    ASSERT(handle);
+    UNUSED_ARG(events);
+
+    self = (SharedRing *)handle->data;
+    ASSERT(self);
+    /* Object could go out of scope in the callback, increase refcount to avoid it */
+    Py_INCREF(self);
+
+    if (status == 0) {
+        /* reset the counter, then look at the ring */
+        while (read(self->eventfd, &count, sizeof(count)) == -1 && errno == EINTR);
+        messages = shared_ring_drain(self);
+        if (!messages) {
+            PyErr_WriteUnraisable(self->callback);
+            goto done;
+        }
+        if (PyList_GET_SIZE(messages) == 0) {
+            Py_DECREF(messages);
+            goto done;
+        }
+        py_errorno = Py_None;
+        Py_INCREF(Py_None);
+    } else {
+        messages = Py_None;
+        Py_INCREF(Py_None);
+        err = uv_last_error(UV_HANDLE_LOOP(self));
+        py_errorno = pyuv_error_code(err.code);
+    }
+
+    result = pyuv_callback("messages", self->callback, self, messages, py_errorno, NULL);
+    if (result == NULL) {
+        PyErr_WriteUnraisable(self->callback);
+    }
+    Py_XDECREF(result);
+    Py_DECREF(messages);
+    Py_DECREF(py_errorno);
+
+done:
+    Py_DECREF(self);
+    PyGILState_Release(gstate);
+}
+
+
+static PyObject *
+SharedRing_func_put(SharedRing *self, PyObject *args)
+{
+    int r;
+    Py_buffer pbuf;
+
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTuple(args, "s*:put", &pbuf)) {
+        return NULL;
+    }
+
+    if ((uint64_t)pbuf.len > self->header->capacity / 2 - SHARED_RING_RECORD_HEADER) {
+        PyBuffer_Release(&pbuf);
+        PyErr_SetString(PyExc_ValueError, "message is too big for the ring");
+        return NULL;
+    }
+
+    r = shared_ring_put(self, pbuf.buf, (uint32_t)pbuf.len);
+    PyBuffer_Release(&pbuf);
+
+    return PyBool_FromLong((long)r);
+}
+
+
+static PyObject *
+SharedRing_func_start(SharedRing *self, PyObject *args)
+{
+    int r;
+    PyObject *tmp, *callback;
+
+    tmp = NULL;
+
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTuple(args, "O:start", &callback)) {
+        return NULL;
+    }
+
+    if (!PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+
+    r = uv_poll_start((uv_poll_t *)UV_HANDLE(self), UV_READABLE, on_shared_ring_poll);
+    if (r != 0) {
+        RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self), PyExc_SharedRingError);
+        return NULL;
+    }
+
+    tmp = self->callback;
+    Py_INCREF(callback);
+    self->callback = callback;
+    Py_XDECREF(tmp);
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+SharedRing_func_stop(SharedRing *self)
+{
+    int r;
+
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    r = uv_poll_stop((uv_poll_t *)UV_HANDLE(self));
+    if (r != 0) {
+        RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self), PyExc_SharedRingError);
+        return NULL;
+    }
+
+    Py_CLEAR(self->callback);
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+SharedRing_fds_get(SharedRing *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+    return Py_BuildValue("(ii)", self->memfd, self->eventfd);
+}
+
+
+static PyObject *
+SharedRing_size_get(SharedRing *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    if (!self->header) {
+        return PyInt_FromLong(0);
+    }
+    return PyLong_FromUnsignedLongLong(self->header->capacity);
+}
+
+
+static int
+SharedRing_tp_init(SharedRing *self, PyObject *args, PyObject *kwargs)
+{
+    int r, memfd, efd;
+    Py_ssize_t size;
+    uint64_t capacity;
+    pyuv_fd_poll_t *uv_poll = NULL;
+    Loop *loop;
+    PyObject *tmp, *fds;
+
+    static char *kwlist[] = {"loop", "size", "fds", NULL};
+
+    tmp = NULL;
+    fds = Py_None;
+    size = SHARED_RING_DEFAULT_SIZE;
+
+    if (UV_HANDLE(self)) {
+        PyErr_SetString(PyExc_SharedRingError, "Object already initialized");
+        return -1;
+    }
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!|nO:__init__", kwlist, &LoopType, &loop, &size, &fds)) {
+        return -1;
+    }
+
+    if (fds == Py_None) {
+        if (size < SHARED_RING_MIN_SIZE) {
+            PyErr_SetString(PyExc_ValueError, "size is too small");
+            return -1;
+        }
+        /* round the capacity up to a power of 2, positions are masked */
+        capacity = SHARED_RING_MIN_SIZE;
+        while (capacity < (uint64_t)size) {
+            capacity <<= 1;
+        }
+        memfd = shared_ring_create_memfd();
+        if (memfd == -1) {
+            PyErr_SetFromErrno(PyExc_SharedRingError);
+            return -1;
+        }
+        efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (efd == -1) {
+            PyErr_SetFromErrno(PyExc_SharedRingError);
+            close(memfd);
+            return -1;
+        }
+    } else {
+        if (!PyArg_ParseTuple(fds, "ii:fds", &memfd, &efd)) {
+            return -1;
+        }
+        /* the given descriptors keep belonging to the caller */
+        memfd = fcntl(memfd, F_DUPFD_CLOEXEC, 0);
+        if (memfd == -1) {
+            PyErr_SetFromErrno(PyExc_SharedRingError);
+            return -1;
+        }
+        efd = fcntl(efd, F_DUPFD_CLOEXEC, 0);
+        if (efd == -1) {
+            PyErr_SetFromErrno(PyExc_SharedRingError);
+            close(memfd);
+            return -1;
+        }
+        capacity = 0;
+    }
+
+    self->memfd = memfd;
+    self->eventfd = efd;
+    if (shared_ring_map(self, fds == Py_None, capacity) != 0) {
+        goto error;
+    }
+
+    tmp = (PyObject *)((Handle *)self)->loop;
+    Py_INCREF(loop);
+    ((Handle *)self)->loop = loop;
+    Py_XDECREF(tmp);
+
+    uv_poll = PyMem_Malloc(sizeof(pyuv_fd_poll_t));
+    if (!uv_poll) {
+        PyErr_NoMemory();
+        goto error;
+    }
+
+    r = uv_poll_init(UV_HANDLE_LOOP(self), &uv_poll->poll, efd);
+    if (r != 0) {
+        RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self), PyExc_SharedRingError);
+        PyMem_Free(uv_poll);
+        goto error;
+    }
+    /* from now on the descriptors are closed together with the handle */
+    uv_poll->fds[0] = memfd;
+    uv_poll->fds[1] = efd;
+    uv_poll->poll.data = (void *)self;
+    UV_HANDLE(self) = (uv_handle_t *)uv_poll;
+    PYUV_PROBE2(handle__init, self, Py_TYPE(self)->tp_name);
+
+    return 0;
+
+error:
+    if (self->header) {
+        munmap(self->header, self->map_size);
+        self->header = NULL;
+    }
+    close(self->memfd);
+    close(self->eventfd);
+    self->memfd = self->eventfd = -1;
+    return -1;
+}
+
+
+static PyObject *
+SharedRing_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    SharedRing *self = (SharedRing *)HandleType.tp_new(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+    self->header = NULL;
+    self->memfd = self->eventfd = -1;
+    return (PyObject *)self;
+}
+
+
+static int
+SharedRing_tp_traverse(SharedRing *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->callback);
+    HandleType.tp_traverse((PyObject *)self, visit, arg);
+    return 0;
+}
+
+
+static int
+SharedRing_tp_clear(SharedRing *self)
+{
+    Py_CLEAR(self->callback);
+    HandleType.tp_clear((PyObject *)self);
+    return 0;
+}
+
+
+static void
+SharedRing_tp_dealloc(SharedRing *self)
+{
+    /* the descriptors are closed once the poll handle is */
+    handle_fd_poll_dealloc((Handle *)self);
+    if (self->header) {
+        munmap(self->header, self->map_size);
+        self->header = NULL;
+    }
+    HandleType.tp_dealloc((PyObject *)self);
+}
+
+
+static PyMethodDef
+SharedRing_tp_methods[] = {
+    { "put", (PyCFunction)SharedRing_func_put, METH_VARARGS, "Add a message to the ring, returns False if it's full." },
+    { "start", (PyCFunction)SharedRing_func_start, METH_VARARGS, "Start consuming messages from the ring." },
+    { "stop", (PyCFunction)SharedRing_func_stop, METH_NOARGS, "Stop consuming messages from the ring." },
+    { "close", (PyCFunction)Handle_func_fd_poll_close, METH_VARARGS, "Close handle." },
+    { NULL }
+};
+
+
+static PyGetSetDef SharedRing_tp_getsets[] = {
+    {"fds", (getter)SharedRing_fds_get, NULL, "Shared memory and eventfd file descriptors, to be passed to other processes.", NULL},
+    {"size", (getter)SharedRing_size_get, NULL, "Capacity of the ring in bytes.", NULL},
+    {NULL}
+};
+
+
+static PyTypeObject SharedRingType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv.SharedRing",                                              /*tp_name*/
+    sizeof(SharedRing),                                             /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    (destructor)SharedRing_tp_dealloc,                              /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    0,                                                              /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,                        /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)SharedRing_tp_traverse,                           /*tp_traverse*/
+    (inquiry)SharedRing_tp_clear,                                   /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    0,                                                              /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    SharedRing_tp_methods,                                          /*tp_methods*/
+    0,                                                              /*tp_members*/
+    SharedRing_tp_getsets,                                          /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    (initproc)SharedRing_tp_init,                                   /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    SharedRing_tp_new,                                              /*tp_new*/
+};
+
+#endif
+
@@ -98,6 +98,7 @@ Signal_tp_init(Signal *self, PyObject *args, PyObject *kwargs)
     }
     uv_prepare->data = (void *)self;
     UV_HANDLE(self) = (uv_handle_t *)uv_prepare;
+    PYUV_PROBE2(handle__init, self, Py_TYPE(self)->tp_name);
 
     return 0;
 }
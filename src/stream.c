@@ -1,11 +1,349 @@
 
 typedef struct {
     PyObject *callback;
+    PyObject *held;     /* list of callbacks of earlier writes held by the compressor, or NULL */
     uv_buf_t *bufs;
     int buf_count;
     Py_buffer view;
+    Bool owns_bufs;
+    size_t nbytes;
+    char prefix[16];    /* small header written in front of the view, such as a WebSocket frame header */
+    uv_buf_t prefixed_bufs[2];  /* prefix and view, used when the request doesn't own its buffers */
 } stream_write_data_t;
 
+/* Transparent compression */
+
+#define PYUV_COMPRESS_NONE      0
+#define PYUV_COMPRESS_DEFLATE   1
+#define PYUV_COMPRESS_ZSTD      2
+
+#define STREAM_DECOMPRESS_MAX_SIZE  (4 * 1024 * 1024)
+
+/* zlib takes uInt lengths, larger buffers are given to it in chunks of this size */
+#define STREAM_ZLIB_CHUNK           ((size_t)(uInt)-1)
+
+struct stream_compression_s {
+    int method;
+    size_t flush_threshold;     /* 0 means every write is flushed */
+    size_t pending;             /* uncompressed bytes accepted since the last flush */
+    size_t max_size;            /* maximum decompressed size of the data delivered by a single read */
+    PyObject *held;             /* list of write callbacks waiting for their data to be flushed, or NULL */
+#ifdef PYUV_HAVE_ZLIB
+    z_stream deflate;
+    z_stream inflate;
+#endif
+#ifdef PYUV_HAVE_ZSTD
+    ZSTD_CStream *zcs;
+    ZSTD_DStream *zds;
+#endif
+};
+
+typedef struct {
+    char *base;
+    size_t len;
+    size_t size;
+} compression_buf_t;
+
+
+/* Make sure there is some free space at the end of the buffer */
+static INLINE int
+compression_buf_reserve(compression_buf_t *buf)
+{
+    char *tmp;
+    size_t size;
+
+    if (buf->len < buf->size) {
+        return 0;
+    }
+    size = buf->size ? buf->size * 2 : 16384;
+    tmp = (char *) PyMem_Realloc(buf->base, size);
+    if (!tmp) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    buf->base = tmp;
+    buf->size = size;
+    return 0;
+}
+
+
+static void
+stream_compression_free(stream_compression_t *c)
+{
+    if (!c) {
+        return;
+    }
+    /* the data of these writes is discarded along with the compressor */
+    Py_XDECREF(c->held);
+#ifdef PYUV_HAVE_ZLIB
+    if (c->method == PYUV_COMPRESS_DEFLATE) {
+        deflateEnd(&c->deflate);
+        inflateEnd(&c->inflate);
+    }
+#endif
+#ifdef PYUV_HAVE_ZSTD
+    if (c->method == PYUV_COMPRESS_ZSTD) {
+        ZSTD_freeCStream(c->zcs);
+        ZSTD_freeDStream(c->zds);
+    }
+#endif
+    PyMem_Free(c);
+}
+
+
+static stream_compression_t *
+stream_compression_new(int method, int level, size_t flush_threshold, size_t max_size)
+{
+    stream_compression_t *c;
+
+    c = (stream_compression_t *) PyMem_Malloc(sizeof(stream_compression_t));
+    if (!c) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    memset(c, 0, sizeof(stream_compression_t));
+    c->flush_threshold = flush_threshold;
+    c->max_size = max_size;
+
+    switch (method) {
+#ifdef PYUV_HAVE_ZLIB
+        case PYUV_COMPRESS_DEFLATE:
+            if (deflateInit(&c->deflate, level) != Z_OK) {
+                PyMem_Free(c);
+                PyErr_SetString(PyExc_StreamError, "error initializing deflate compressor");
+                return NULL;
+            }
+            if (inflateInit(&c->inflate) != Z_OK) {
+                deflateEnd(&c->deflate);
+                PyMem_Free(c);
+                PyErr_SetString(PyExc_StreamError, "error initializing deflate decompressor");
+                return NULL;
+            }
+            break;
+#endif
+#ifdef PYUV_HAVE_ZSTD
+        case PYUV_COMPRESS_ZSTD:
+            c->zcs = ZSTD_createCStream();
+            c->zds = ZSTD_createDStream();
+            if (!c->zcs || !c->zds || ZSTD_isError(ZSTD_initCStream(c->zcs, level < 0 ? 3 : level)) || ZSTD_isError(ZSTD_initDStream(c->zds))) {
+                ZSTD_freeCStream(c->zcs);
+                ZSTD_freeDStream(c->zds);
+                PyMem_Free(c);
+                PyErr_SetString(PyExc_StreamError, "error initializing zstd stream");
+                return NULL;
+            }
+            break;
+#endif
+        default:
+            PyMem_Free(c);
+            PyErr_SetString(PyExc_ValueError, "unsupported compression method");
+            return NULL;
+    }
+
+    c->method = method;
+    return c;
+}
+
+
+/* Compress the given buffers into a single newly allocated one. Data is flushed according to the
+ * flush policy, unless force_flush is set. The result may be empty. */
+static int
+stream_compress(stream_compression_t *c, uv_buf_t *bufs, int buf_count, Bool force_flush, uv_buf_t *result)
+{
+    int i;
+    Bool flush;
+    size_t total;
+    compression_buf_t out = {NULL, 0, 0};
+
+    total = 0;
+    for (i = 0; i < buf_count; i++) {
+        total += bufs[i].len;
+    }
+    c->pending += total;
+    flush = force_flush || c->pending >= c->flush_threshold;
+
+    if (compression_buf_reserve(&out) != 0) {
+        goto error;
+    }
+
+#ifdef PYUV_HAVE_ZLIB
+    if (c->method == PYUV_COMPRESS_DEFLATE) {
+        const char *data;
+        size_t len, chunk;
+        z_stream *z = &c->deflate;
+        for (i = 0; i < buf_count; i++) {
+            data = bufs[i].base;
+            len = bufs[i].len;
+            z->avail_in = 0;
+            while (len > 0 || z->avail_in > 0) {
+                if (z->avail_in == 0) {
+                    chunk = len < STREAM_ZLIB_CHUNK ? len : STREAM_ZLIB_CHUNK;
+                    z->next_in = (Bytef *)data;
+                    z->avail_in = (uInt)chunk;
+                    data += chunk;
+                    len -= chunk;
+                }
+                if (compression_buf_reserve(&out) != 0) {
+                    goto error;
+                }
+                chunk = out.size - out.len;
+                z->next_out = (Bytef *)(out.base + out.len);
+                z->avail_out = (uInt)(chunk < STREAM_ZLIB_CHUNK ? chunk : STREAM_ZLIB_CHUNK);
+                if (deflate(z, Z_NO_FLUSH) == Z_STREAM_ERROR) {
+                    PyErr_SetString(PyExc_StreamError, "deflate compression failed");
+                    goto error;
+                }
+                out.len = (size_t)((char *)z->next_out - out.base);
+            }
+        }
+        if (flush) {
+            do {
+                if (compression_buf_reserve(&out) != 0) {
+                    goto error;
+                }
+                chunk = out.size - out.len;
+                z->next_out = (Bytef *)(out.base + out.len);
+                z->avail_out = (uInt)(chunk < STREAM_ZLIB_CHUNK ? chunk : STREAM_ZLIB_CHUNK);
+                if (deflate(z, Z_SYNC_FLUSH) == Z_STREAM_ERROR) {
+                    PyErr_SetString(PyExc_StreamError, "deflate compression failed");
+                    goto error;
+                }
+                out.len = (size_t)((char *)z->next_out - out.base);
+            } while (z->avail_out == 0);
+        }
+    }
+#endif
+#ifdef PYUV_HAVE_ZSTD
+    if (c->method == PYUV_COMPRESS_ZSTD) {
+        size_t r;
+        ZSTD_inBuffer in;
+        ZSTD_outBuffer zout;
+        for (i = 0; i < buf_count; i++) {
+            in.src = bufs[i].base;
+            in.size = bufs[i].len;
+            in.pos = 0;
+            while (in.pos < in.size) {
+                if (compression_buf_reserve(&out) != 0) {
+                    goto error;
+                }
+                zout.dst = out.base;
+                zout.size = out.size;
+                zout.pos = out.len;
+                r = ZSTD_compressStream(c->zcs, &zout, &in);
+                out.len = zout.pos;
+                if (ZSTD_isError(r)) {
+                    PyErr_SetString(PyExc_StreamError, ZSTD_getErrorName(r));
+                    goto error;
+                }
+            }
+        }
+        if (flush) {
+            do {
+                if (compression_buf_reserve(&out) != 0) {
+                    goto error;
+                }
+                zout.dst = out.base;
+                zout.size = out.size;
+                zout.pos = out.len;
+                r = ZSTD_flushStream(c->zcs, &zout);
+                out.len = zout.pos;
+                if (ZSTD_isError(r)) {
+                    PyErr_SetString(PyExc_StreamError, ZSTD_getErrorName(r));
+                    goto error;
+                }
+            } while (r != 0);
+        }
+    }
+#endif
+
+    if (flush) {
+        c->pending = 0;
+    }
+
+    /* the result may be empty, but it's always a valid pointer */
+    *result = uv_buf_init(out.base, out.len);
+    return 0;
+
+error:
+    PyMem_Free(out.base);
+    return -1;
+}
+
+
+/* Decompress the given data, returns a new bytes object or NULL if the stream is corrupt, the output
+ * would be larger than max_size or memory is exhausted. Output is capped at max_size + 1 bytes so that
+ * exceeding the limit can be detected without decompressing any further. */
+static PyObject *
+stream_decompress(stream_compression_t *c, const char *data, size_t len)
+{
+    PyObject *result;
+    compression_buf_t out = {NULL, 0, 0};
+
+    if (compression_buf_reserve(&out) != 0) {
+        goto error;
+    }
+
+#ifdef PYUV_HAVE_ZLIB
+    if (c->method == PYUV_COMPRESS_DEFLATE) {
+        int r;
+        size_t limit = c->max_size + 1;
+        z_stream *z = &c->inflate;
+        z->next_in = (Bytef *)data;
+        z->avail_in = (uInt)len;
+        do {
+            if (compression_buf_reserve(&out) != 0) {
+                goto error;
+            }
+            z->next_out = (Bytef *)(out.base + out.len);
+            z->avail_out = (uInt)((out.size < limit ? out.size : limit) - out.len);
+            r = inflate(z, Z_SYNC_FLUSH);
+            out.len = (size_t)((char *)z->next_out - out.base);
+            if (out.len > c->max_size) {
+                goto error;
+            }
+            if (r == Z_STREAM_END) {
+                inflateReset(z);
+            } else if (r != Z_OK && r != Z_BUF_ERROR) {
+                goto error;
+            }
+        } while (z->avail_in > 0 || z->avail_out == 0);
+    }
+#endif
+#ifdef PYUV_HAVE_ZSTD
+    if (c->method == PYUV_COMPRESS_ZSTD) {
+        size_t r;
+        size_t limit = c->max_size + 1;
+        ZSTD_inBuffer in;
+        ZSTD_outBuffer zout;
+        in.src = data;
+        in.size = len;
+        in.pos = 0;
+        do {
+            if (compression_buf_reserve(&out) != 0) {
+                goto error;
+            }
+            zout.dst = out.base;
+            zout.size = out.size < limit ? out.size : limit;
+            zout.pos = out.len;
+            r = ZSTD_decompressStream(c->zds, &zout, &in);
+            out.len = zout.pos;
+            if (ZSTD_isError(r) || out.len > c->max_size) {
+                goto error;
+            }
+        } while (in.pos < in.size || zout.pos == zout.size);
+    }
+#endif
+
+    result = PyString_FromStringAndSize(out.base, out.len);
+    PyMem_Free(out.base);
+    return result;
+
+error:
+    PyMem_Free(out.base);
+    return NULL;
+}
+
+
 
 static uv_buf_t
 on_stream_alloc(uv_stream_t* handle, size_t suggested_size)
@@ -36,12 +374,12 @@ on_stream_shutdown(uv_shutdown_t* req, int status)
     if (callback != Py_None) {
         if (status < 0) {
             err = uv_last_error(UV_HANDLE_LOOP(self));
-            py_errorno = PyInt_FromLong((long)err.code);
+            py_errorno = pyuv_error_code(err.code);
         } else {
             py_errorno = Py_None;
             Py_INCREF(Py_None);
         }
-        result = PyObject_CallFunctionObjArgs(callback, self, py_errorno, NULL);
+        result = pyuv_callback("shutdown", callback, self, py_errorno, NULL);
         if (result == NULL) {
             PyErr_WriteUnraisable(callback);
         }
@@ -57,13 +395,65 @@ on_stream_shutdown(uv_shutdown_t* req, int status)
 }
 
 
+static PyObject *pyuv_stream_send_frame_copy(Stream *self, WebSocketParser *ws, int opcode, const char *data, Py_ssize_t len, PyObject *callback);
+
+
+/* Feed data to the protocol parser attached to the stream */
+static int
+stream_parser_feed(Stream *self, const char *data, Py_ssize_t len)
+{
+    int r;
+    WebSocketParser *ws;
+    PyObject *result;
+
+    if (PyObject_TypeCheck(self->parser, &HTTPParserType)) {
+        return http_parser_feed((HTTPParser *)self->parser, (PyObject *)self, data, len);
+    }
+
+    if (PyObject_TypeCheck(self->parser, &RESPParserType)) {
+        return resp_parser_feed((RESPParser *)self->parser, (PyObject *)self, data, len);
+    }
+
+    ASSERT(PyObject_TypeCheck(self->parser, &WebSocketParserType));
+    ws = (WebSocketParser *)self->parser;
+    Py_INCREF(ws);
+    r = websocket_parser_feed(ws, (PyObject *)self, data, len);
+    if (ws->pong_pending) {
+        /* Only the last ping needs to be answered */
+        ws->pong_pending = False;
+        if (!UV_HANDLE_CLOSED(self)) {
+            result = pyuv_stream_send_frame_copy(self, ws, PYUV_WS_OPCODE_PONG, ws->pong, ws->pong_len, Py_None);
+            if (result == NULL) {
+                /* the write error will be reported by the read callback */
+                PyErr_Clear();
+            }
+            Py_XDECREF(result);
+        }
+    }
+    Py_DECREF(ws);
+    return r;
+}
+
+
+/* Account a read callback in the traffic counters, EOF is not an error */
+static INLINE void
+stream_stats_read(Stream *self, int nread)
+{
+    if (nread > 0) {
+        handle_stats_read((Handle *)self, &self->stats, nread);
+    } else if (nread < 0 && uv_last_error(UV_HANDLE_LOOP(self)).code != UV_EOF) {
+        handle_stats_error((Handle *)self, &self->stats);
+    }
+}
+
+
 static void
 on_stream_read(uv_stream_t* handle, int nread, uv_buf_t buf)
 {
     PyGILState_STATE gstate = PyGILState_Ensure();
     uv_err_t err;
     Stream *self;
-    PyObject *result, *data, *py_errorno;
+    PyObject *callback, *result, *data, *py_errorno;
     ASSERT(handle);
 
     self = (Stream *)handle->data;
@@ -71,25 +461,73 @@ on_stream_read(uv_stream_t* handle, int nread, uv_buf_t buf)
     /* Object could go out of scope in the callback, increase refcount to avoid it */
     Py_INCREF(self);
 
-    if (nread >= 0) {
+    stream_stats_read(self, nread);
+
+    if (nread >= 0 && self->compression) {
+        data = stream_decompress(self->compression, buf.base, nread);
+        if (data == NULL) {
+            PyErr_Clear();
+            data = Py_None;
+            Py_INCREF(Py_None);
+            py_errorno = pyuv_error_code(UV_EPROTO);
+        } else if (PyString_GET_SIZE(data) == 0 && nread > 0) {
+            /* all input was buffered by the decompressor, nothing to deliver yet */
+            Py_DECREF(data);
+            goto done;
+        } else {
+            py_errorno = Py_None;
+            Py_INCREF(Py_None);
+        }
+    } else if (nread >= 0 && self->parser) {
+        /* avoid copying the data, the parser consumes it directly from the read buffer */
+        data = NULL;
+        py_errorno = Py_None;
+        Py_INCREF(Py_None);
+    } else if (nread >= 0) {
         data = PyString_FromStringAndSize(buf.base, nread);
         py_errorno = Py_None;
         Py_INCREF(Py_None);
-    } else if (nread < 0) {
+    } else {
         data = Py_None;
         Py_INCREF(Py_None);
         err = uv_last_error(UV_HANDLE_LOOP(self));
-        py_errorno = PyInt_FromLong((long)err.code);
+        py_errorno = pyuv_error_code(err.code);
     }
 
-    result = PyObject_CallFunctionObjArgs(self->on_read_cb, self, data, py_errorno, NULL);
-    if (result == NULL) {
-        PyErr_WriteUnraisable(self->on_read_cb);
+    if (self->parser && py_errorno == Py_None) {
+        if (data) {
+            nread = stream_parser_feed(self, PyString_AS_STRING(data), PyString_GET_SIZE(data));
+            Py_DECREF(data);
+        } else {
+            nread = stream_parser_feed(self, buf.base, nread);
+        }
+        Py_DECREF(py_errorno);
+        if (nread == 0) {
+            goto done;
+        }
+        /* the data couldn't be parsed, report it as a protocol error */
+        PyErr_Clear();
+        data = Py_None;
+        Py_INCREF(Py_None);
+        py_errorno = pyuv_error_code(UV_EPROTO);
+    }
+
+    /* A parser callback could have stopped reading, which clears the read callback, and the
+     * callback could be replaced while it runs */
+    callback = self->on_read_cb;
+    if (callback) {
+        Py_INCREF(callback);
+        result = pyuv_callback("read", callback, self, data, py_errorno, NULL);
+        if (result == NULL) {
+            PyErr_WriteUnraisable(callback);
+        }
+        Py_XDECREF(result);
+        Py_DECREF(callback);
     }
-    Py_XDECREF(result);
     Py_DECREF(data);
     Py_DECREF(py_errorno);
 
+done:
     /* In case of error libuv may not call alloc_cb */
     if (buf.base != NULL) {
         PyMem_Free(buf.base);
@@ -107,7 +545,7 @@ on_stream_write(uv_write_t* req, int status)
     int i;
     stream_write_data_t* req_data;
     Stream *self;
-    PyObject *callback, *result, *py_errorno;
+    PyObject *callback, *held_callback, *result, *py_errorno;
     uv_err_t err;
 
     ASSERT(req);
@@ -120,23 +558,42 @@ on_stream_write(uv_write_t* req, int status)
     /* Object could go out of scope in the callback, increase refcount to avoid it */
     Py_INCREF(self);
 
-    if (callback != Py_None) {
+    if (status < 0) {
+        handle_stats_error((Handle *)self, &self->stats);
+    } else {
+        handle_stats_write((Handle *)self, &self->stats, req_data->nbytes);
+    }
+
+    if (callback != Py_None || req_data->held) {
         if (status < 0) {
             err = uv_last_error(UV_HANDLE_LOOP(self));
-            py_errorno = PyInt_FromLong((long)err.code);
+            py_errorno = pyuv_error_code(err.code);
         } else {
             py_errorno = Py_None;
             Py_INCREF(Py_None);
         }
-        result = PyObject_CallFunctionObjArgs(callback, self, py_errorno, NULL);
-        if (result == NULL) {
-            PyErr_WriteUnraisable(callback);
+        /* earlier writes whose data was only flushed by this one come first */
+        if (req_data->held) {
+            for (i = 0; i < PyList_GET_SIZE(req_data->held); i++) {
+                held_callback = PyList_GET_ITEM(req_data->held, i);
+                result = pyuv_callback("write", held_callback, self, py_errorno, NULL);
+                if (result == NULL) {
+                    PyErr_WriteUnraisable(held_callback);
+                }
+                Py_XDECREF(result);
+            }
+        }
+        if (callback != Py_None) {
+            result = pyuv_callback("write", callback, self, py_errorno, NULL);
+            if (result == NULL) {
+                PyErr_WriteUnraisable(callback);
+            }
+            Py_XDECREF(result);
         }
-        Py_XDECREF(result);
         Py_DECREF(py_errorno);
     }
 
-    if (req_data->buf_count == 1) {
+    if (!req_data->owns_bufs) {
         PyBuffer_Release(&req_data->view);
     } else {
         for (i = 0; i < req_data->buf_count; i++) {
@@ -145,6 +602,7 @@ on_stream_write(uv_write_t* req, int status)
         PyMem_Free(req_data->bufs);
     }
     Py_DECREF(callback);
+    Py_XDECREF(req_data->held);
     PyMem_Free(req_data);
     PyMem_Free(req);
 
@@ -197,13 +655,14 @@ static PyObject *
 Stream_func_start_read(Stream *self, PyObject *args)
 {
     int r;
-    PyObject *tmp, *callback;
+    PyObject *tmp, *callback, *parser;
 
     tmp = NULL;
+    parser = Py_None;
 
     RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
 
-    if (!PyArg_ParseTuple(args, "O:start_read", &callback)) {
+    if (!PyArg_ParseTuple(args, "O|O:start_read", &callback, &parser)) {
         return NULL;
     }
 
@@ -212,6 +671,16 @@ Stream_func_start_read(Stream *self, PyObject *args)
         return NULL;
     }
 
+    if (parser != Py_None && !PyObject_TypeCheck(parser, &HTTPParserType) && !PyObject_TypeCheck(parser, &WebSocketParserType) && !PyObject_TypeCheck(parser, &RESPParserType)) {
+        PyErr_SetString(PyExc_TypeError, "parser must be a HTTPParser, a WebSocketParser, a RESPParser or None");
+        return NULL;
+    }
+
+    if (self->layer) {
+        PyErr_SetString(PyExc_StreamError, "stream is being read by another layer");
+        return NULL;
+    }
+
     r = uv_read_start((uv_stream_t *)UV_HANDLE(self), (uv_alloc_cb)on_stream_alloc, (uv_read_cb)on_stream_read);
     if (r != 0) {
         RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self), PyExc_StreamError);
@@ -223,6 +692,15 @@ Stream_func_start_read(Stream *self, PyObject *args)
     self->on_read_cb = callback;
     Py_XDECREF(tmp);
 
+    tmp = self->parser;
+    if (parser != Py_None) {
+        Py_INCREF(parser);
+        self->parser = parser;
+    } else {
+        self->parser = NULL;
+    }
+    Py_XDECREF(tmp);
+
     Py_RETURN_NONE;
 }
 
@@ -242,16 +720,18 @@ Stream_func_stop_read(Stream *self)
 
     Py_XDECREF(self->on_read_cb);
     self->on_read_cb = NULL;
+    Py_CLEAR(self->parser);
 
     Py_RETURN_NONE;
 }
 
 
+/* Write buffers allocated with PyMem_Malloc, ownership is transferred to the write request, along
+ * with the reference to the list of held callbacks (if any) called before the given one */
 static INLINE PyObject *
-pyuv_stream_write(Stream *self, Py_buffer pbuf, PyObject *callback, PyObject *send_handle)
+pyuv_stream_write_bufs(Stream *self, uv_buf_t *bufs, int buf_count, PyObject *callback, PyObject *held, PyObject *send_handle)
 {
-    int r;
-    uv_buf_t buf;
+    int i, r;
     uv_write_t *wr = NULL;
     stream_write_data_t *req_data = NULL;
 
@@ -269,25 +749,162 @@ pyuv_stream_write(Stream *self, Py_buffer pbuf, PyObject *callback, PyObject *se
         goto error;
     }
 
-    buf = uv_buf_init(pbuf.buf, pbuf.len);
+    req_data->callback = callback;
+    req_data->held = held;
+    req_data->bufs = bufs;
+    req_data->buf_count = buf_count;
+    req_data->owns_bufs = True;
+    req_data->nbytes = 0;
+    for (i = 0; i < buf_count; i++) {
+        req_data->nbytes += bufs[i].len;
+    }
+    wr->data = (void *)req_data;
+
+    if (send_handle) {
+        r = uv_write2(wr, (uv_stream_t *)UV_HANDLE(self), bufs, buf_count, (uv_stream_t *)UV_HANDLE(send_handle), on_stream_write);
+    } else {
+        r = uv_write(wr, (uv_stream_t *)UV_HANDLE(self), bufs, buf_count, on_stream_write);
+    }
+    if (r != 0) {
+        RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self), PyExc_StreamError);
+        goto error;
+    }
+
+    handle_stats_queued((Handle *)self, &self->stats, ((uv_stream_t *)UV_HANDLE(self))->write_queue_size);
+
+    Py_RETURN_NONE;
+
+error:
+    Py_DECREF(callback);
+    Py_XDECREF(held);
+    for (i = 0; i < buf_count; i++) {
+        PyMem_Free(bufs[i].base);
+    }
+    PyMem_Free(bufs);
+    if (req_data) {
+        PyMem_Free(req_data);
+    }
+    if (wr) {
+        PyMem_Free(wr);
+    }
+    return NULL;
+}
+
+
+/* Compress the given buffers and write the result, the input buffers are not touched. While the
+ * compressor holds some of the data back, the callback is kept until a write flushes it. */
+static INLINE PyObject *
+pyuv_stream_write_compressed(Stream *self, uv_buf_t *bufs, int buf_count, Bool force_flush, PyObject *callback, PyObject *send_handle)
+{
+    uv_buf_t *out;
+    PyObject *held;
+    stream_compression_t *c = self->compression;
+
+    out = (uv_buf_t *) PyMem_Malloc(sizeof(uv_buf_t));
+    if (!out) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+
+    if (stream_compress(c, bufs, buf_count, force_flush, out) != 0) {
+        PyMem_Free(out);
+        return NULL;
+    }
+
+    if (c->pending == 0) {
+        /* everything was flushed, the held callbacks go with this write */
+        held = c->held;
+        c->held = NULL;
+        return pyuv_stream_write_bufs(self, out, 1, callback, held, send_handle);
+    }
+
+    if (callback != Py_None) {
+        if (!c->held) {
+            c->held = PyList_New(0);
+        }
+        if (!c->held || PyList_Append(c->held, callback) != 0) {
+            PyMem_Free(out->base);
+            PyMem_Free(out);
+            return NULL;
+        }
+    }
+    if (out->len == 0 && !send_handle) {
+        PyMem_Free(out->base);
+        PyMem_Free(out);
+        Py_RETURN_NONE;
+    }
+    return pyuv_stream_write_bufs(self, out, 1, Py_None, NULL, send_handle);
+}
+
+
+/* Write the given buffer, optionally preceded by a small prefix. The payload is not copied. */
+static INLINE PyObject *
+pyuv_stream_write_prefixed(Stream *self, const char *prefix, size_t prefix_len, Py_buffer pbuf, PyObject *callback, PyObject *send_handle)
+{
+    int r, buf_count;
+    uv_buf_t tmp_bufs[2];
+    uv_write_t *wr = NULL;
+    stream_write_data_t *req_data = NULL;
+    PyObject *result;
+
+    ASSERT(prefix_len <= sizeof(req_data->prefix));
+
+    if (self->compression) {
+        /* the compressor copies the data into a new buffer, a temporary array is enough */
+        buf_count = 0;
+        if (prefix_len > 0) {
+            tmp_bufs[buf_count++] = uv_buf_init((char *)prefix, prefix_len);
+        }
+        tmp_bufs[buf_count++] = uv_buf_init(pbuf.buf, pbuf.len);
+        result = pyuv_stream_write_compressed(self, tmp_bufs, buf_count, False, callback, send_handle);
+        PyBuffer_Release(&pbuf);
+        return result;
+    }
+
+    Py_INCREF(callback);
+
+    wr = (uv_write_t *)PyMem_Malloc(sizeof(uv_write_t));
+    if (!wr) {
+        PyErr_NoMemory();
+        goto error;
+    }
+
+    req_data = (stream_write_data_t*) PyMem_Malloc(sizeof(stream_write_data_t));
+    if (!req_data) {
+        PyErr_NoMemory();
+        goto error;
+    }
+
+    /* the buffers live in the request data, so they stay valid until the write completes */
+    buf_count = 0;
+    if (prefix_len > 0) {
+        memcpy(req_data->prefix, prefix, prefix_len);
+        req_data->prefixed_bufs[buf_count++] = uv_buf_init(req_data->prefix, prefix_len);
+    }
+    req_data->prefixed_bufs[buf_count++] = uv_buf_init(pbuf.buf, pbuf.len);
 
     req_data->callback = callback;
-    req_data->bufs = &buf;
-    req_data->buf_count = 1;
+    req_data->held = NULL;
+    req_data->bufs = req_data->prefixed_bufs;
+    req_data->buf_count = buf_count;
     req_data->view = pbuf;
+    req_data->owns_bufs = False;
+    req_data->nbytes = prefix_len + pbuf.len;
 
     wr->data = (void *)req_data;
 
     if (send_handle) {
-        r = uv_write2(wr, (uv_stream_t *)UV_HANDLE(self), &buf, 1, (uv_stream_t *)UV_HANDLE(send_handle), on_stream_write);
+        r = uv_write2(wr, (uv_stream_t *)UV_HANDLE(self), req_data->bufs, buf_count, (uv_stream_t *)UV_HANDLE(send_handle), on_stream_write);
     } else {
-        r = uv_write(wr, (uv_stream_t *)UV_HANDLE(self), &buf, 1, on_stream_write);
+        r = uv_write(wr, (uv_stream_t *)UV_HANDLE(self), req_data->bufs, buf_count, on_stream_write);
     }
     if (r != 0) {
         RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self), PyExc_StreamError);
         goto error;
     }
 
+    handle_stats_queued((Handle *)self, &self->stats, ((uv_stream_t *)UV_HANDLE(self))->write_queue_size);
+
     Py_RETURN_NONE;
 
 error:
@@ -303,6 +920,57 @@ error:
 }
 
 
+static INLINE PyObject *
+pyuv_stream_write(Stream *self, Py_buffer pbuf, PyObject *callback, PyObject *send_handle)
+{
+    return pyuv_stream_write_prefixed(self, NULL, 0, pbuf, callback, send_handle);
+}
+
+
+/* Write a WebSocket frame, copying the payload. Needed when it has to be masked. */
+static PyObject *
+pyuv_stream_send_frame_copy(Stream *self, WebSocketParser *ws, int opcode, const char *data, Py_ssize_t len, PyObject *callback)
+{
+    size_t hdr_len;
+    unsigned char key[4];
+    uv_buf_t *bufs;
+    char *ptr;
+    PyObject *result;
+
+    bufs = (uv_buf_t *) PyMem_Malloc(sizeof(uv_buf_t));
+    ptr = (char *) PyMem_Malloc(WS_MAX_HEADER_SIZE + len);
+    if (!bufs || !ptr) {
+        PyMem_Free(bufs);
+        PyMem_Free(ptr);
+        PyErr_NoMemory();
+        return NULL;
+    }
+
+    if (ws->server_side) {
+        hdr_len = websocket_frame_header(ptr, opcode, len, NULL);
+        memcpy(ptr + hdr_len, data, len);
+    } else {
+        if (websocket_mask_key(ws, key) != 0) {
+            PyMem_Free(ptr);
+            PyMem_Free(bufs);
+            return NULL;
+        }
+        hdr_len = websocket_frame_header(ptr, opcode, len, key);
+        websocket_mask(ptr + hdr_len, data, len, key, 0);
+    }
+    bufs[0] = uv_buf_init(ptr, hdr_len + len);
+
+    if (self->compression) {
+        result = pyuv_stream_write_compressed(self, bufs, 1, False, callback, NULL);
+        PyMem_Free(ptr);
+        PyMem_Free(bufs);
+        return result;
+    }
+
+    return pyuv_stream_write_bufs(self, bufs, 1, callback, NULL, NULL);
+}
+
+
 static PyObject *
 Stream_func_write(Stream *self, PyObject *args)
 {
@@ -329,10 +997,8 @@ static PyObject *
 Stream_func_writelines(Stream *self, PyObject *args)
 {
     int i, r, buf_count;
-    PyObject *callback, *seq;
+    PyObject *callback, *seq, *result;
     uv_buf_t *bufs;
-    uv_write_t *wr = NULL;
-    stream_write_data_t *req_data = NULL;
 
     callback = Py_None;
 
@@ -347,54 +1013,144 @@ Stream_func_writelines(Stream *self, PyObject *args)
         return NULL;
     }
 
-    Py_INCREF(callback);
-
     r = pyseq2uvbuf(seq, &bufs, &buf_count);
     if (r != 0) {
         /* error is already set */
-        goto error;
+        return NULL;
     }
 
-    wr = (uv_write_t *)PyMem_Malloc(sizeof(uv_write_t));
-    if (!wr) {
-        PyErr_NoMemory();
-        goto error;
+    if (self->compression) {
+        result = pyuv_stream_write_compressed(self, bufs, buf_count, False, callback, NULL);
+        for (i = 0; i < buf_count; i++) {
+            PyMem_Free(bufs[i].base);
+        }
+        PyMem_Free(bufs);
+        return result;
     }
 
-    req_data = (stream_write_data_t*) PyMem_Malloc(sizeof(stream_write_data_t));
-    if (!req_data) {
-        PyErr_NoMemory();
+    return pyuv_stream_write_bufs(self, bufs, buf_count, callback, NULL, NULL);
+}
+
+
+static PyObject *
+Stream_func_send_message(Stream *self, PyObject *args)
+{
+    int opcode;
+    size_t hdr_len;
+    char hdr[WS_MAX_HEADER_SIZE];
+    Py_buffer pbuf;
+    PyObject *callback, *result;
+    WebSocketParser *ws;
+
+    callback = Py_None;
+
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTuple(args, "s*i|O:send_message", &pbuf, &opcode, &callback)) {
+        return NULL;
+    }
+
+    if (callback != Py_None && !PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable or None is required");
         goto error;
     }
 
-    req_data->callback = callback;
-    req_data->bufs = bufs;
-    req_data->buf_count = buf_count;
-    wr->data = (void *)req_data;
+    if (!self->parser || !PyObject_TypeCheck(self->parser, &WebSocketParserType)) {
+        PyErr_SetString(PyExc_StreamError, "stream is not reading with a WebSocketParser");
+        goto error;
+    }
+    ws = (WebSocketParser *)self->parser;
 
-    r = uv_write(wr, (uv_stream_t *)UV_HANDLE(self), bufs, buf_count, on_stream_write);
-    if (r != 0) {
-        RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self), PyExc_StreamError);
+    if (websocket_check_frame(opcode, pbuf.len) != 0) {
         goto error;
     }
 
-    Py_RETURN_NONE;
+    if (!ws->server_side) {
+        result = pyuv_stream_send_frame_copy(self, ws, opcode, pbuf.buf, pbuf.len, callback);
+        PyBuffer_Release(&pbuf);
+        return result;
+    }
+
+    /* Server frames are not masked, the payload is written as is after the header */
+    hdr_len = websocket_frame_header(hdr, opcode, pbuf.len, NULL);
+    return pyuv_stream_write_prefixed(self, hdr, hdr_len, pbuf, callback, NULL);
 
 error:
-    Py_DECREF(callback);
-    if (bufs) {
-        for (i = 0; i < buf_count; i++) {
-            PyMem_Free(bufs[i].base);
+    PyBuffer_Release(&pbuf);
+    return NULL;
+}
+
+
+static PyObject *
+Stream_func_set_compression(Stream *self, PyObject *args, PyObject *kwargs)
+{
+    int method, level;
+    Py_ssize_t flush_threshold, max_size;
+    stream_compression_t *compression;
+
+    static char *kwlist[] = {"method", "level", "flush_threshold", "max_size", NULL};
+
+    level = -1;
+    flush_threshold = 0;
+    max_size = STREAM_DECOMPRESS_MAX_SIZE;
+    compression = NULL;
+
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "i|inn:set_compression", kwlist, &method, &level, &flush_threshold, &max_size)) {
+        return NULL;
+    }
+
+    if (flush_threshold < 0 || max_size < 0) {
+        PyErr_SetString(PyExc_ValueError, "a positive value or zero is required");
+        return NULL;
+    }
+
+    if (method != PYUV_COMPRESS_NONE) {
+        compression = stream_compression_new(method, level, (size_t)flush_threshold, (size_t)max_size);
+        if (!compression) {
+            return NULL;
         }
-        PyMem_Free(bufs);
     }
-    if (req_data) {
-        PyMem_Free(req_data);
+
+    /* Any data buffered in the previous compressor is discarded */
+    stream_compression_free(self->compression);
+    self->compression = compression;
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+Stream_func_flush(Stream *self, PyObject *args)
+{
+    PyObject *callback = Py_None;
+
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTuple(args, "|O:flush", &callback)) {
+        return NULL;
     }
-    if (wr) {
-        PyMem_Free(wr);
+
+    if (callback != Py_None && !PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable or None is required");
+        return NULL;
     }
-    return NULL;
+
+    if (!self->compression) {
+        PyErr_SetString(PyExc_StreamError, "compression is not enabled");
+        return NULL;
+    }
+
+    return pyuv_stream_write_compressed(self, NULL, 0, True, callback, NULL);
+}
+
+
+static PyObject *
+Stream_compression_get(Stream *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    return PyInt_FromLong(self->compression ? (long)self->compression->method : PYUV_COMPRESS_NONE);
 }
 
 
@@ -437,6 +1193,11 @@ static int
 Stream_tp_traverse(Stream *self, visitproc visit, void *arg)
 {
     Py_VISIT(self->on_read_cb);
+    Py_VISIT(self->layer);
+    Py_VISIT(self->parser);
+    if (self->compression) {
+        Py_VISIT(self->compression->held);
+    }
     HandleType.tp_traverse((PyObject *)self, visit, arg);
     return 0;
 }
@@ -446,6 +1207,10 @@ static int
 Stream_tp_clear(Stream *self)
 {
     Py_CLEAR(self->on_read_cb);
+    Py_CLEAR(self->layer);
+    Py_CLEAR(self->parser);
+    stream_compression_free(self->compression);
+    self->compression = NULL;
     HandleType.tp_clear((PyObject *)self);
     return 0;
 }
@@ -456,15 +1221,28 @@ Stream_tp_methods[] = {
     { "shutdown", (PyCFunction)Stream_func_shutdown, METH_VARARGS, "Shutdown the write side of this Stream." },
     { "write", (PyCFunction)Stream_func_write, METH_VARARGS, "Write data on the stream." },
     { "writelines", (PyCFunction)Stream_func_writelines, METH_VARARGS, "Write a sequence of data on the stream." },
+    { "send_message", (PyCFunction)Stream_func_send_message, METH_VARARGS, "Send a WebSocket message on the stream." },
     { "start_read", (PyCFunction)Stream_func_start_read, METH_VARARGS, "Start read data from the connected endpoint." },
     { "stop_read", (PyCFunction)Stream_func_stop_read, METH_NOARGS, "Stop read data from the connected endpoint." },
+    { "set_compression", (PyCFunction)Stream_func_set_compression, METH_VARARGS|METH_KEYWORDS, "Enable or disable transparent compression of the data sent and received." },
+    { "flush", (PyCFunction)Stream_func_flush, METH_VARARGS, "Write any data buffered by the compressor." },
     { NULL }
 };
 
 
+static PyObject *
+Stream_stats_get(Stream *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    return pyuv_handle_stats_result(&self->stats);
+}
+
+
 static PyGetSetDef Stream_tp_getsets[] = {
     {"readable", (getter)Stream_readable_get, 0, "Indicates if stream is readable.", NULL},
     {"writable", (getter)Stream_writable_get, 0, "Indicates if stream is writable.", NULL},
+    {"compression", (getter)Stream_compression_get, 0, "Compression method in use.", NULL},
+    {"stats", (getter)Stream_stats_get, 0, "Traffic counters.", NULL},
     {NULL}
 };
 
@@ -15,13 +15,13 @@ on_tcp_connection(uv_stream_t* server, int status)
 
     if (status != 0) {
         uv_err_t err = uv_last_error(UV_HANDLE_LOOP(self));
-        py_errorno = PyInt_FromLong((long)err.code);
+        py_errorno = pyuv_error_code(err.code);
     } else {
         py_errorno = Py_None;
         Py_INCREF(Py_None);
     }
 
-    result = PyObject_CallFunctionObjArgs(self->on_new_connection_cb, self, py_errorno, NULL);
+    result = pyuv_callback("connection", self->on_new_connection_cb, self, py_errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(self->on_new_connection_cb);
     }
@@ -50,13 +50,13 @@ on_tcp_client_connection(uv_connect_t *req, int status)
 
     if (status != 0) {
         uv_err_t err = uv_last_error(UV_HANDLE_LOOP(self));
-        py_errorno = PyInt_FromLong(err.code);
+        py_errorno = pyuv_error_code(err.code);
     } else {
         py_errorno = Py_None;
         Py_INCREF(Py_None);
     }
 
-    result = PyObject_CallFunctionObjArgs(callback, self, py_errorno, NULL);
+    result = pyuv_callback("connect", callback, self, py_errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(callback);
     }
@@ -433,6 +433,7 @@ TCP_tp_init(TCP *self, PyObject *args, PyObject *kwargs)
     }
     uv_tcp->data = (void *)self;
     UV_HANDLE(self) = (uv_handle_t *)uv_tcp;
+    PYUV_PROBE2(handle__init, self, Py_TYPE(self)->tp_name);
 
     return 0;
 }
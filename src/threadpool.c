@@ -1,160 +1,1599 @@
 
+/* queue_work items wait in the ThreadPool pending heap, every uv_work_t queued runs the most
+ * urgent item pending when it starts. Items are only touched with the GIL held */
+typedef struct tpool_req_data_s {
+    PyObject *work_cb;
+    PyObject *after_work_cb;
+    Future *future;
+    PyObject *result;
+    PyObject *error;
+    ThreadPool *pool;   /* kept alive by the requests */
+    int priority;
+    uint64_t seq;
+    Py_ssize_t index;   /* position in the pending heap */
+    uint64_t queued;    /* only set while the work__* probes are enabled */
+    uint64_t started;
+} tpool_req_data_t;
+
+typedef struct {
+    uv_work_t req;
+    ThreadPool *pool;
+    tpool_req_data_t *data;     /* picked when the work starts, NULL if there was none left */
+} tpool_req_t;
+
+
+/* Higher priority first, then in the order they were queued */
+static INLINE Bool
+threadpool_pending_before(tpool_req_data_t *a, tpool_req_data_t *b)
+{
+    return a->priority > b->priority || (a->priority == b->priority && a->seq < b->seq);
+}
+
+
+static INLINE void
+threadpool_pending_set(ThreadPool *pool, Py_ssize_t i, tpool_req_data_t *data)
+{
+    pool->pending[i] = data;
+    data->index = i;
+}
+
+
+static void
+threadpool_pending_sift(ThreadPool *pool, Py_ssize_t i)
+{
+    Py_ssize_t parent, child;
+    tpool_req_data_t *data = pool->pending[i];
+
+    while (i > 0) {
+        parent = (i - 1) / 2;
+        if (!threadpool_pending_before(data, pool->pending[parent])) {
+            break;
+        }
+        threadpool_pending_set(pool, i, pool->pending[parent]);
+        i = parent;
+    }
+
+    for (;;) {
+        child = 2 * i + 1;
+        if (child >= pool->pending_count) {
+            break;
+        }
+        if (child + 1 < pool->pending_count && threadpool_pending_before(pool->pending[child + 1], pool->pending[child])) {
+            child++;
+        }
+        if (!threadpool_pending_before(pool->pending[child], data)) {
+            break;
+        }
+        threadpool_pending_set(pool, i, pool->pending[child]);
+        i = child;
+    }
+
+    threadpool_pending_set(pool, i, data);
+}
+
+
+static int
+threadpool_pending_push(ThreadPool *pool, tpool_req_data_t *data)
+{
+    Py_ssize_t size;
+    tpool_req_data_t **pending;
+
+    if (pool->pending_count == pool->pending_size) {
+        size = pool->pending_size ? pool->pending_size * 2 : 16;
+        pending = PyMem_Realloc(pool->pending, size * sizeof(tpool_req_data_t *));
+        if (!pending) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        pool->pending = pending;
+        pool->pending_size = size;
+    }
+
+    data->seq = pool->pending_seq++;
+    threadpool_pending_set(pool, pool->pending_count++, data);
+    threadpool_pending_sift(pool, data->index);
+    return 0;
+}
+
+
+static void
+threadpool_pending_remove(ThreadPool *pool, tpool_req_data_t *data)
+{
+    Py_ssize_t i = data->index;
+    tpool_req_data_t *last;
+
+    ASSERT(i < pool->pending_count && pool->pending[i] == data);
+
+    last = pool->pending[--pool->pending_count];
+    if (last != data) {
+        threadpool_pending_set(pool, i, last);
+        threadpool_pending_sift(pool, i);
+    }
+    data->index = -1;
+}
+
+
+/* Release what the item holds, result and error are only set once it ran */
+static void
+threadpool_req_data_free(tpool_req_data_t *data)
+{
+    Py_DECREF(data->future);
+    Py_DECREF(data->work_cb);
+    Py_XDECREF(data->after_work_cb);
+    Py_XDECREF(data->result);
+    Py_XDECREF(data->error);
+    PyMem_Free(data);
+}
+
+
+static Future *
+future_new(Loop *loop)
+{
+    Future *future = PyObject_GC_New(Future, &FutureType);
+    if (!future) {
+        return NULL;
+    }
+    Py_INCREF(loop);
+    future->loop = loop;
+    future->done = False;
+    future->result = NULL;
+    future->error = NULL;
+    future->callbacks = NULL;
+    future->cancelled = False;
+    future->work = NULL;
+    PyObject_GC_Track(future);
+    return future;
+}
+
+
+/* Called on the loop thread, done callbacks run right away */
+static void
+future_set_result(Future *self, PyObject *result, PyObject *error)
+{
+    Py_ssize_t i;
+    PyObject *callbacks, *callback, *ret;
+
+    ASSERT(!self->done);
+
+    Py_INCREF(result);
+    Py_INCREF(error);
+    self->result = result;
+    self->error = error;
+    self->done = True;
+
+    callbacks = self->callbacks;
+    self->callbacks = NULL;
+    if (!callbacks) {
+        return;
+    }
+
+    Py_INCREF(self);
+    for (i = 0; i < PyList_GET_SIZE(callbacks); i++) {
+        callback = PyList_GET_ITEM(callbacks, i);
+        ret = pyuv_callback("future", callback, self, NULL);
+        if (ret == NULL) {
+            PyErr_WriteUnraisable(callback);
+        }
+        Py_XDECREF(ret);
+    }
+    Py_DECREF(callbacks);
+    Py_DECREF(self);
+}
+
+
+/* Set the error of a done future as the current exception */
+static void
+future_raise(Future *self)
+{
+    PyObject *type, *value, *tb;
+
+    type = PyTuple_GET_ITEM(self->error, 0);
+    value = PyTuple_GET_ITEM(self->error, 1);
+    tb = PyTuple_GET_ITEM(self->error, 2);
+    Py_INCREF(type);
+    Py_INCREF(value);
+    Py_INCREF(tb);
+    PyErr_Restore(type, value, tb != Py_None ? tb : NULL);
+    if (tb == Py_None) {
+        Py_DECREF(tb);
+    }
+}
+
+
+static PyObject *
+Future_func_done(Future *self)
+{
+    return PyBool_FromLong((long)self->done);
+}
+
+
+static PyObject *
+Future_func_result(Future *self)
+{
+    if (!self->done) {
+        PyErr_SetString(PyExc_ThreadPoolError, "work is not done yet");
+        return NULL;
+    }
+
+    if (self->error != Py_None) {
+        future_raise(self);
+        return NULL;
+    }
+
+    Py_INCREF(self->result);
+    return self->result;
+}
+
+
+static PyObject *
+Future_func_exception(Future *self)
+{
+    PyObject *value;
+
+    if (!self->done) {
+        PyErr_SetString(PyExc_ThreadPoolError, "work is not done yet");
+        return NULL;
+    }
+
+    value = self->error != Py_None ? PyTuple_GET_ITEM(self->error, 1) : Py_None;
+    Py_INCREF(value);
+    return value;
+}
+
+
+static PyObject *
+Future_func_cancelled(Future *self)
+{
+    return PyBool_FromLong((long)self->cancelled);
+}
+
+
+/* The work is taken out of the pending heap, the orphaned uv_work_t will find nothing to
+ * run (or run the next item). Like concurrent.futures, callbacks are called right away */
+static PyObject *
+Future_func_cancel(Future *self)
+{
+    tpool_req_data_t *data;
+    PyObject *exc, *error, *ret;
+
+    data = self->work;
+    if (!data) {
+        Py_RETURN_FALSE;
+    }
+
+    exc = PyObject_CallFunction(PyExc_ThreadPoolError, "s", "work was cancelled");
+    if (!exc) {
+        return NULL;
+    }
+    error = Py_BuildValue("(OOO)", PyExc_ThreadPoolError, exc, Py_None);
+    Py_DECREF(exc);
+    if (!error) {
+        return NULL;
+    }
+
+    threadpool_pending_remove(data->pool, data);
+    self->work = NULL;
+    self->cancelled = True;
+
+    Py_INCREF(self);
+    if (data->after_work_cb) {
+        ret = pyuv_callback("after_work", data->after_work_cb, Py_None, error, NULL);
+        if (ret == NULL) {
+            PyErr_WriteUnraisable(data->after_work_cb);
+        }
+        Py_XDECREF(ret);
+    }
+    future_set_result(self, Py_None, error);
+    Py_DECREF(error);
+    threadpool_req_data_free(data);
+    Py_DECREF(self);
+
+    Py_RETURN_TRUE;
+}
+
+
+static PyObject *
+Future_func_add_done_callback(Future *self, PyObject *args)
+{
+    int r;
+    PyObject *callback, *call_args;
+
+    if (!PyArg_ParseTuple(args, "O:add_done_callback", &callback)) {
+        return NULL;
+    }
+
+    if (!PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+
+    /* like asyncio, the callback is never called from here */
+    if (self->done) {
+        call_args = PyTuple_Pack(1, (PyObject *)self);
+        if (!call_args) {
+            return NULL;
+        }
+        r = loop_call_soon(self->loop, callback, call_args);
+        Py_DECREF(call_args);
+        if (r != 0) {
+            return NULL;
+        }
+        Py_RETURN_NONE;
+    }
+
+    if (!self->callbacks) {
+        self->callbacks = PyList_New(0);
+        if (!self->callbacks) {
+            return NULL;
+        }
+    }
+    if (PyList_Append(self->callbacks, callback) != 0) {
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+#ifdef PYUV_PYTHON3
+/* Runs on the asyncio loop: copy the outcome to the asyncio future, unless it was cancelled */
+static PyObject *
+future_asyncio_copy(PyObject *aio_future, PyObject *future)
+{
+    int r;
+    Future *self;
+    PyObject *ret;
+
+    ret = PyObject_CallMethod(aio_future, "done", NULL);
+    if (!ret) {
+        return NULL;
+    }
+    r = PyObject_IsTrue(ret);
+    Py_DECREF(ret);
+    if (r < 0) {
+        return NULL;
+    } else if (r) {
+        Py_RETURN_NONE;
+    }
+
+    self = (Future *)future;
+    if (self->error != Py_None) {
+        return PyObject_CallMethod(aio_future, "set_exception", "O", PyTuple_GET_ITEM(self->error, 1));
+    }
+    return PyObject_CallMethod(aio_future, "set_result", "O", self->result);
+}
+
+
+static PyMethodDef future_asyncio_copy_def = {"_asyncio_copy", (PyCFunction)future_asyncio_copy, METH_O, NULL};
+
+
+/* Done callback of the Future, the asyncio loop may be running in another thread */
+static PyObject *
+future_asyncio_done(PyObject *state, PyObject *future)
+{
+    PyObject *copy, *ret;
+
+    copy = PyCFunction_New(&future_asyncio_copy_def, PyTuple_GET_ITEM(state, 1));
+    if (!copy) {
+        return NULL;
+    }
+    ret = PyObject_CallMethod(PyTuple_GET_ITEM(state, 0), "call_soon_threadsafe", "OO", copy, future);
+    Py_DECREF(copy);
+    return ret;
+}
+
+
+static PyMethodDef future_asyncio_done_def = {"_asyncio_done", (PyCFunction)future_asyncio_done, METH_O, NULL};
+
+
+/* asyncio event loop running in this thread, or None. asyncio is not imported if the
+ * application didn't do it, no loop can be running then */
+static PyObject *
+future_running_asyncio_loop(void)
+{
+    PyObject *asyncio;
+
+    asyncio = PyDict_GetItemString(PyImport_GetModuleDict(), "asyncio");
+    if (!asyncio || !PyObject_HasAttrString(asyncio, "_get_running_loop")) {
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+    return PyObject_CallMethod(asyncio, "_get_running_loop", NULL);
+}
+
+
+/* Like asyncio.wrap_future: create an asyncio future on the running loop which gets the
+ * outcome of this one, and await that one instead */
+static PyObject *
+future_asyncio_await(Future *self, PyObject *aio_loop)
+{
+    int r;
+    PyObject *aio_future, *state, *callback, *iter;
+
+    aio_future = PyObject_CallMethod(aio_loop, "create_future", NULL);
+    if (!aio_future) {
+        return NULL;
+    }
+
+    state = PyTuple_Pack(2, aio_loop, aio_future);
+    if (!state) {
+        Py_DECREF(aio_future);
+        return NULL;
+    }
+    callback = PyCFunction_New(&future_asyncio_done_def, state);
+    Py_DECREF(state);
+    if (!callback) {
+        Py_DECREF(aio_future);
+        return NULL;
+    }
+
+    if (!self->callbacks) {
+        self->callbacks = PyList_New(0);
+    }
+    r = self->callbacks ? PyList_Append(self->callbacks, callback) : -1;
+    Py_DECREF(callback);
+    if (r != 0) {
+        Py_DECREF(aio_future);
+        return NULL;
+    }
+
+    iter = PyObject_CallMethod(aio_future, "__await__", NULL);
+    Py_DECREF(aio_future);
+    return iter;
+}
+#endif
+
+
+/* The Future is its own iterator for __await__ (and __iter__, for yield from): it yields
+ * itself until it's done, the driver is expected to resume the coroutine from a done
+ * callback. Then the result is returned through StopIteration, or the error is raised.
+ * Tasks running on an asyncio loop await an asyncio future chained to this one instead */
+static PyObject *
+Future_tp_iter(Future *self)
+{
+#ifdef PYUV_PYTHON3
+    PyObject *aio_loop, *iter;
+
+    if (!self->done) {
+        aio_loop = future_running_asyncio_loop();
+        if (!aio_loop) {
+            return NULL;
+        }
+        if (aio_loop != Py_None) {
+            iter = future_asyncio_await(self, aio_loop);
+            Py_DECREF(aio_loop);
+            return iter;
+        }
+        Py_DECREF(aio_loop);
+    }
+#endif
+    Py_INCREF(self);
+    return (PyObject *)self;
+}
+
+
+static PyObject *
+Future_tp_iternext(Future *self)
+{
+    PyObject *exc;
+
+    if (!self->done) {
+        Py_INCREF(self);
+        return (PyObject *)self;
+    }
+
+    if (self->error != Py_None) {
+        future_raise(self);
+        return NULL;
+    }
+
+    exc = PyObject_CallFunctionObjArgs(PyExc_StopIteration, self->result, NULL);
+    if (exc) {
+        PyErr_SetObject(PyExc_StopIteration, exc);
+        Py_DECREF(exc);
+    }
+    return NULL;
+}
+
+
+static int
+Future_tp_traverse(Future *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->loop);
+    Py_VISIT(self->result);
+    Py_VISIT(self->error);
+    Py_VISIT(self->callbacks);
+    return 0;
+}
+
+
+static int
+Future_tp_clear(Future *self)
+{
+    Py_CLEAR(self->loop);
+    Py_CLEAR(self->result);
+    Py_CLEAR(self->error);
+    Py_CLEAR(self->callbacks);
+    return 0;
+}
+
+
+static void
+Future_tp_dealloc(Future *self)
+{
+    Future_tp_clear(self);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+
+static PyMethodDef
+Future_tp_methods[] = {
+    { "done", (PyCFunction)Future_func_done, METH_NOARGS, "Return True if the work is done." },
+    { "cancel", (PyCFunction)Future_func_cancel, METH_NOARGS, "Cancel the work if it hasn't started yet." },
+    { "cancelled", (PyCFunction)Future_func_cancelled, METH_NOARGS, "Return True if the work was cancelled." },
+    { "result", (PyCFunction)Future_func_result, METH_NOARGS, "Return the result of the work, or raise its exception." },
+    { "exception", (PyCFunction)Future_func_exception, METH_NOARGS, "Return the exception raised by the work, or None." },
+    { "add_done_callback", (PyCFunction)Future_func_add_done_callback, METH_VARARGS, "Add a callback to be called when the work is done." },
+    { NULL }
+};
+
+
+#if PY_VERSION_HEX >= 0x03050000
+static PyAsyncMethods Future_tp_as_async = {
+    (unaryfunc)Future_tp_iter,                                      /*am_await*/
+    0,                                                              /*am_aiter*/
+    0,                                                              /*am_anext*/
+};
+#endif
+
+
+static PyTypeObject FutureType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv.Future",                                                  /*tp_name*/
+    sizeof(Future),                                                 /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    (destructor)Future_tp_dealloc,                                  /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+#if PY_VERSION_HEX >= 0x03050000
+    &Future_tp_as_async,                                            /*tp_as_async*/
+#else
+    0,                                                              /*tp_compare*/
+#endif
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    0,                                                              /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,                        /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)Future_tp_traverse,                               /*tp_traverse*/
+    (inquiry)Future_tp_clear,                                       /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    0,                                                              /*tp_weaklistoffset*/
+    (getiterfunc)Future_tp_iter,                                    /*tp_iter*/
+    (iternextfunc)Future_tp_iternext,                               /*tp_iternext*/
+    Future_tp_methods,                                              /*tp_methods*/
+    0,                                                              /*tp_members*/
+    0,                                                              /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    0,                                                              /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    0,                                                              /*tp_new*/
+};
+
+
+/* Turn the current exception into a (type, value, traceback) tuple */
+static PyObject *
+threadpool_fetch_error(PyObject *work_cb)
+{
+    PyObject *error, *err_type, *err_value, *err_tb;
+
+    err_type = err_value = err_tb = NULL;
+
+    PyErr_Fetch(&err_type, &err_value, &err_tb);
+    PyErr_NormalizeException(&err_type, &err_value, &err_tb);
+    error = PyTuple_New(3);
+    if (!error) {
+        PyErr_WriteUnraisable(work_cb);
+        Py_XDECREF(err_type);
+        Py_XDECREF(err_value);
+        Py_XDECREF(err_tb);
+        Py_RETURN_NONE;
+    }
+    if (!err_type) {
+        err_type = Py_None;
+        Py_INCREF(Py_None);
+    }
+    if (!err_value) {
+        err_value = Py_None;
+        Py_INCREF(Py_None);
+    }
+    if (!err_tb) {
+        err_tb = Py_None;
+        Py_INCREF(Py_None);
+    }
+    PyTuple_SET_ITEM(error, 0, err_type);
+    PyTuple_SET_ITEM(error, 1, err_value);
+    PyTuple_SET_ITEM(error, 2, err_tb);
+    return error;
+}
+
+
+static void
+threadpool_work_cb(uv_work_t *req)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    tpool_req_t *work_req;
+    tpool_req_data_t *data;
+    PyObject *result, *error;
+
+    ASSERT(req);
+
+    work_req = (tpool_req_t *)req->data;
+    if (work_req->pool->pending_count == 0) {
+        /* the item queued with this request was cancelled */
+        PyGILState_Release(gstate);
+        return;
+    }
+    data = work_req->pool->pending[0];
+    threadpool_pending_remove(work_req->pool, data);
+    data->future->work = NULL;
+    work_req->data = data;
+
+    if (PYUV_PROBE_ENABLED(work__start)) {
+        PYUV_PROBE2(work__start, req, data->queued ? uv_hrtime() - data->queued : 0);
+    }
+    data->started = PYUV_PROBE_ENABLED(work__end) ? uv_hrtime() : 0;
+
+    result = pyuv_callback("work", data->work_cb, NULL);
+    if (result == NULL) {
+        error = threadpool_fetch_error(data->work_cb);
+        result = Py_None;
+        Py_INCREF(Py_None);
+    } else {
+        error = Py_None;
+        Py_INCREF(Py_None);
+    }
+    data->result = result;
+    data->error = error;
+
+    if (PYUV_PROBE_ENABLED(work__end)) {
+        PYUV_PROBE2(work__end, req, data->started ? uv_hrtime() - data->started : 0);
+    }
+
+    PyGILState_Release(gstate);
+}
+
+
+static void
+threadpool_after_work_cb(uv_work_t *req)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    tpool_req_t *work_req;
+    tpool_req_data_t *data;
+    PyObject *result;
+
+    ASSERT(req);
+
+    work_req = (tpool_req_t *)req->data;
+    data = work_req->data;
+    if (!data) {
+        goto done;
+    }
+
+    if (data->after_work_cb) {
+        result = pyuv_callback("after_work", data->after_work_cb, data->result, data->error, NULL);
+        if (result == NULL) {
+            PyErr_WriteUnraisable(data->after_work_cb);
+        }
+        Py_XDECREF(result);
+    }
+
+    future_set_result(data->future, data->result, data->error);
+    threadpool_req_data_free(data);
+
+done:
+    Py_DECREF(work_req->pool);
+    PyMem_Free(work_req);
+    PyGILState_Release(gstate);
+}
+
+
+static PyObject *
+ThreadPool_func_queue_work(ThreadPool *self, PyObject *args, PyObject *kwargs)
+{
+    int r, priority;
+    tpool_req_t *work_req;
+    tpool_req_data_t *req_data;
+    Future *future;
+    PyObject *work_cb, *after_work_cb;
+
+    static char *kwlist[] = {"work_cb", "after_work_cb", "priority", NULL};
+
+    work_req = NULL;
+    req_data = NULL;
+    future = NULL;
+    work_cb = after_work_cb = NULL;
+    priority = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|Oi:queue_work", kwlist, &work_cb, &after_work_cb, &priority)) {
+        return NULL;
+    }
+
+    if (!PyCallable_Check(work_cb)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+
+    if (after_work_cb == Py_None) {
+        after_work_cb = NULL;
+    }
+    if (after_work_cb != NULL && !PyCallable_Check(after_work_cb)) {
+        PyErr_SetString(PyExc_TypeError, "after_work_cb must be a callable");
+        return NULL;
+    }
+
+    work_req = PyMem_Malloc(sizeof(tpool_req_t));
+    if (!work_req) {
+        PyErr_NoMemory();
+        goto error;
+    }
+
+    req_data = PyMem_Malloc(sizeof(tpool_req_data_t));
+    if (!req_data) {
+        PyErr_NoMemory();
+        goto error;
+    }
+
+    future = future_new(self->loop);
+    if (!future) {
+        goto error;
+    }
+
+    req_data->pool = self;
+    req_data->priority = priority;
+    if (threadpool_pending_push(self, req_data) != 0) {
+        goto error;
+    }
+
+    Py_INCREF(work_cb);
+    Py_XINCREF(after_work_cb);
+
+    req_data->work_cb = work_cb;
+    req_data->after_work_cb = after_work_cb;
+    /* the request keeps a reference until it's done */
+    Py_INCREF(future);
+    req_data->future = future;
+    req_data->result = NULL;
+    req_data->error = NULL;
+    req_data->queued = PYUV_PROBE_ENABLED(work__start) ? uv_hrtime() : 0;
+    future->work = req_data;
+
+    Py_INCREF(self);
+    work_req->pool = self;
+    work_req->data = NULL;
+    work_req->req.data = (void *)work_req;
+    r = uv_queue_work(UV_LOOP(self), &work_req->req, threadpool_work_cb, threadpool_after_work_cb);
+    if (r != 0) {
+        RAISE_UV_EXCEPTION(UV_LOOP(self), PyExc_ThreadPoolError);
+        threadpool_pending_remove(self, req_data);
+        future->work = NULL;
+        Py_DECREF(self);
+        threadpool_req_data_free(req_data);
+        req_data = NULL;
+        goto error;
+    }
+
+    return (PyObject *)future;
+
+error:
+    if (work_req) {
+        PyMem_Free(work_req);
+    }
+    if (req_data) {
+        PyMem_Free(req_data);
+    }
+    Py_XDECREF(future);
+    return NULL;
+}
+
+
+/* queue_work_batch: the items are split in chunks, one uv_work_t each. The chunks share the
+ * batch, only touched with the GIL held, and write their results straight into its list */
+#define TPOOL_BATCH_DEFAULT_CHUNKS 32
+
+typedef struct {
+    PyObject *work_cb;
+    PyObject *after_work_cb;
+    Future *future;
+    PyObject *items;        /* list */
+    PyObject *results;      /* list, same size */
+    PyObject *error;        /* first error, or NULL */
+    Py_ssize_t pending;     /* chunks not done yet */
+} tpool_batch_t;
+
+typedef struct {
+    uv_work_t req;
+    tpool_batch_t *batch;
+    Py_ssize_t start;
+    Py_ssize_t end;
+    PyObject *errors;       /* list, only created if an item failed */
+} tpool_chunk_t;
+
+
+static void
+threadpool_batch_work_cb(uv_work_t *req)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    tpool_chunk_t *chunk;
+    tpool_batch_t *batch;
+    PyObject *result, *error;
+    Py_ssize_t i, j;
+
+    ASSERT(req);
+
+    chunk = (tpool_chunk_t *)req->data;
+    batch = chunk->batch;
+
+    for (i = chunk->start; i < chunk->end; i++) {
+        result = pyuv_callback("work", batch->work_cb, PyList_GET_ITEM(batch->items, i), NULL);
+        if (result == NULL) {
+            error = threadpool_fetch_error(batch->work_cb);
+            if (!chunk->errors) {
+                chunk->errors = PyList_New(chunk->end - chunk->start);
+                if (!chunk->errors) {
+                    PyErr_WriteUnraisable(batch->work_cb);
+                    Py_DECREF(error);
+                    continue;
+                }
+                /* PyList_New leaves NULL items */
+                for (j = 0; j < chunk->end - chunk->start; j++) {
+                    Py_INCREF(Py_None);
+                    PyList_SET_ITEM(chunk->errors, j, Py_None);
+                }
+            }
+            PyList_SetItem(chunk->errors, i - chunk->start, error);
+        } else {
+            PyList_SetItem(batch->results, i, result);
+        }
+    }
+
+    PyGILState_Release(gstate);
+}
+
+
+static void
+threadpool_batch_after_work_cb(uv_work_t *req)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    tpool_chunk_t *chunk;
+    tpool_batch_t *batch;
+    PyObject *result, *py_start, *results, *errors;
+    Py_ssize_t i;
+
+    ASSERT(req);
+
+    chunk = (tpool_chunk_t *)req->data;
+    batch = chunk->batch;
+
+    if (chunk->errors && !batch->error) {
+        for (i = 0; i < PyList_GET_SIZE(chunk->errors); i++) {
+            if (PyList_GET_ITEM(chunk->errors, i) != Py_None) {
+                batch->error = PyList_GET_ITEM(chunk->errors, i);
+                Py_INCREF(batch->error);
+                break;
+            }
+        }
+    }
+
+    if (batch->after_work_cb) {
+        py_start = PyInt_FromSsize_t(chunk->start);
+        results = PyList_GetSlice(batch->results, chunk->start, chunk->end);
+        errors = chunk->errors ? chunk->errors : Py_None;
+        if (py_start && results) {
+            result = pyuv_callback("after_work", batch->after_work_cb, py_start, results, errors, NULL);
+        } else {
+            result = NULL;
+        }
+        if (result == NULL) {
+            PyErr_WriteUnraisable(batch->after_work_cb);
+        }
+        Py_XDECREF(result);
+        Py_XDECREF(py_start);
+        Py_XDECREF(results);
+    }
+
+    Py_XDECREF(chunk->errors);
+    PyMem_Free(chunk);
+
+    if (--batch->pending == 0) {
+        future_set_result(batch->future, batch->results, batch->error ? batch->error : Py_None);
+        Py_DECREF(batch->future);
+        Py_DECREF(batch->work_cb);
+        Py_XDECREF(batch->after_work_cb);
+        Py_DECREF(batch->items);
+        Py_DECREF(batch->results);
+        Py_XDECREF(batch->error);
+        PyMem_Free(batch);
+    }
+
+    PyGILState_Release(gstate);
+}
+
+
+static PyObject *
+ThreadPool_func_queue_work_batch(ThreadPool *self, PyObject *args, PyObject *kwargs)
+{
+    int r;
+    Py_ssize_t i, count, chunksize, nchunks;
+    tpool_batch_t *batch;
+    tpool_chunk_t *chunk;
+    Future *future;
+    PyObject *work_cb, *iterable, *after_work_cb, *items, *results;
+
+    static char *kwlist[] = {"work_cb", "iterable", "after_work_cb", "chunksize", NULL};
+
+    after_work_cb = Py_None;
+    chunksize = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO|On:queue_work_batch", kwlist, &work_cb, &iterable, &after_work_cb, &chunksize)) {
+        return NULL;
+    }
+
+    if (!PyCallable_Check(work_cb)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+
+    if (after_work_cb != Py_None && !PyCallable_Check(after_work_cb)) {
+        PyErr_SetString(PyExc_TypeError, "after_work_cb must be a callable");
+        return NULL;
+    }
+
+    if (chunksize < 0) {
+        PyErr_SetString(PyExc_ValueError, "chunksize must be a positive number");
+        return NULL;
+    }
+
+    items = PySequence_List(iterable);
+    if (!items) {
+        return NULL;
+    }
+    count = PyList_GET_SIZE(items);
+
+    results = PyList_New(count);
+    if (!results) {
+        Py_DECREF(items);
+        return NULL;
+    }
+    for (i = 0; i < count; i++) {
+        Py_INCREF(Py_None);
+        PyList_SET_ITEM(results, i, Py_None);
+    }
+
+    future = future_new(self->loop);
+    if (!future) {
+        Py_DECREF(items);
+        Py_DECREF(results);
+        return NULL;
+    }
+
+    if (count == 0) {
+        future_set_result(future, results, Py_None);
+        Py_DECREF(items);
+        Py_DECREF(results);
+        return (PyObject *)future;
+    }
+
+    if (chunksize == 0) {
+        chunksize = (count + TPOOL_BATCH_DEFAULT_CHUNKS - 1) / TPOOL_BATCH_DEFAULT_CHUNKS;
+    }
+    nchunks = (count + chunksize - 1) / chunksize;
+
+    batch = PyMem_Malloc(sizeof(tpool_batch_t));
+    if (!batch) {
+        Py_DECREF(items);
+        Py_DECREF(results);
+        Py_DECREF(future);
+        return PyErr_NoMemory();
+    }
+    Py_INCREF(work_cb);
+    Py_INCREF(future);
+    batch->work_cb = work_cb;
+    batch->after_work_cb = NULL;
+    if (after_work_cb != Py_None) {
+        Py_INCREF(after_work_cb);
+        batch->after_work_cb = after_work_cb;
+    }
+    batch->future = future;
+    batch->items = items;
+    batch->results = results;
+    batch->error = NULL;
+    batch->pending = nchunks;
+
+    for (i = 0; i < nchunks; i++) {
+        chunk = PyMem_Malloc(sizeof(tpool_chunk_t));
+        if (chunk) {
+            chunk->batch = batch;
+            chunk->start = i * chunksize;
+            chunk->end = chunk->start + chunksize < count ? chunk->start + chunksize : count;
+            chunk->errors = NULL;
+            chunk->req.data = (void *)chunk;
+            r = uv_queue_work(UV_LOOP(self), &chunk->req, threadpool_batch_work_cb, threadpool_batch_after_work_cb);
+            if (r == 0) {
+                continue;
+            }
+            RAISE_UV_EXCEPTION(UV_LOOP(self), PyExc_ThreadPoolError);
+            PyMem_Free(chunk);
+        } else {
+            PyErr_NoMemory();
+        }
+        /* the chunks already queued still run, the batch is freed by the last one */
+        batch->pending = i;
+        if (i == 0) {
+            Py_DECREF(batch->future);
+            Py_DECREF(batch->work_cb);
+            Py_XDECREF(batch->after_work_cb);
+            Py_DECREF(batch->items);
+            Py_DECREF(batch->results);
+            PyMem_Free(batch);
+        }
+        Py_DECREF(future);
+        return NULL;
+    }
+
+    return (PyObject *)future;
+}
+
+
+/* Native work: the buffers are exported (so they can't be resized) until the work is done and
+ * the work itself runs without the GIL, so it runs in parallel in all the pool threads */
+enum {
+    TPOOL_NATIVE_SHA1 = 0,
+    TPOOL_NATIVE_SHA256,
+    TPOOL_NATIVE_CRC32,
+    TPOOL_NATIVE_COMPRESS,
+    TPOOL_NATIVE_DECOMPRESS,
+    TPOOL_NATIVE_B64ENCODE,
+    TPOOL_NATIVE_B64DECODE,
+    TPOOL_NATIVE_COMPARE,
+    TPOOL_NATIVE_FIND
+};
+
+#define TPOOL_DECOMPRESS_MAX_SIZE   (64 * 1024 * 1024)
+
+/* Read-only buffers are exported for the duration of the work, mutable ones could be modified
+ * by Python code while the work runs without the GIL, so the work gets a copy of them */
 typedef struct {
-    PyObject *work_cb;
+    const unsigned char *data;
+    size_t len;
+    Py_buffer view;
+    Bool exported;
+    unsigned char *copy;
+} tpool_native_buf_t;
+
+typedef struct {
+    uv_work_t req;
+    int kind;
+    int level;
+    size_t max_size;        /* decompress */
+    tpool_native_buf_t in;
+    tpool_native_buf_t in2; /* second operand of compare and find */
     PyObject *after_work_cb;
-    PyObject *result;
-    PyObject *error;
-} tpool_req_data_t;
+    Future *future;
+    /* output, either bytes (out) or an integer (value) */
+    unsigned char *out;
+    size_t out_len;
+    Py_ssize_t value;
+    const char *error;
+} tpool_native_t;
+
+
+static int
+threadpool_native_buf_init(tpool_native_buf_t *buf, PyObject *obj)
+{
+    if (PyObject_GetBuffer(obj, &buf->view, PyBUF_SIMPLE) != 0) {
+        return -1;
+    }
+    buf->len = (size_t)buf->view.len;
+    if (buf->view.readonly) {
+        buf->data = (const unsigned char *)buf->view.buf;
+        buf->exported = True;
+        return 0;
+    }
+
+    buf->copy = PyMem_Malloc(buf->len ? buf->len : 1);
+    if (!buf->copy) {
+        PyBuffer_Release(&buf->view);
+        PyErr_NoMemory();
+        return -1;
+    }
+    memcpy(buf->copy, buf->view.buf, buf->len);
+    buf->data = buf->copy;
+    PyBuffer_Release(&buf->view);
+    return 0;
+}
 
 
 static void
-threadpool_work_cb(uv_work_t *req)
+threadpool_native_buf_release(tpool_native_buf_t *buf)
 {
-    PyGILState_STATE gstate = PyGILState_Ensure();
-    tpool_req_data_t *data;
-    PyObject *result, *error, *err_type, *err_value, *err_tb;
+    if (buf->exported) {
+        PyBuffer_Release(&buf->view);
+        buf->exported = False;
+    }
+    PyMem_Free(buf->copy);
+    buf->copy = NULL;
+}
 
-    err_type = err_value = err_tb = NULL;
 
-    ASSERT(req);
+static void
+threadpool_native_release(tpool_native_t *work)
+{
+    threadpool_native_buf_release(&work->in);
+    threadpool_native_buf_release(&work->in2);
+}
 
-    data = (tpool_req_data_t*)(req->data);
 
-    result = PyObject_CallFunctionObjArgs(data->work_cb, NULL);
-    if (result == NULL) {
-        PyErr_Fetch(&err_type, &err_value, &err_tb);
-        PyErr_NormalizeException(&err_type, &err_value, &err_tb);
-        error = PyTuple_New(3);
-        if (!error) {
-            PyErr_WriteUnraisable(data->work_cb);
-            error = Py_None;
-            Py_INCREF(Py_None);
-        } else {
-            if (!err_type) {
-                err_type = Py_None;
-                Py_INCREF(Py_None);
-            }
-            if (!err_value) {
-                err_value = Py_None;
-                Py_INCREF(Py_None);
+#ifdef PYUV_HAVE_ZLIB
+/* zlib counts in uInt, buffers of 4GB or more are fed and drained in chunks. The output
+ * buffer grows up to max_size bytes, more output than that is an error */
+#define TPOOL_ZLIB_CHUNK ((size_t)(uInt)-1)
+
+static const char *
+threadpool_native_zlib(tpool_native_t *work, const unsigned char *data, size_t len, size_t max_size)
+{
+    int r, flush;
+    z_stream z;
+    size_t size, avail;
+    unsigned char *tmp;
+    Bool deflating = work->kind == TPOOL_NATIVE_COMPRESS;
+
+    memset(&z, 0, sizeof(z));
+    r = deflating ? deflateInit(&z, work->level) : inflateInit(&z);
+    if (r != Z_OK) {
+        return r == Z_MEM_ERROR ? "out of memory" : "error initializing zlib";
+    }
+
+    size = 0;
+    flush = Z_NO_FLUSH;
+    for (;;) {
+        if (z.avail_in == 0 && len > 0) {
+            z.next_in = (Bytef *)data;
+            z.avail_in = (uInt)(len > TPOOL_ZLIB_CHUNK ? TPOOL_ZLIB_CHUNK : len);
+            data += z.avail_in;
+            len -= z.avail_in;
+        }
+        if (deflating && z.avail_in == 0 && len == 0) {
+            flush = Z_FINISH;
+        }
+        if (work->out_len == size) {
+            if (size == max_size) {
+                r = Z_BUF_ERROR;
+                break;
             }
-            if (!err_tb) {
-                err_tb = Py_None;
-                Py_INCREF(Py_None);
+            size = size < max_size / 2 ? (size ? size * 2 : 16384) : max_size;
+            tmp = realloc(work->out, size);
+            if (!tmp) {
+                r = Z_MEM_ERROR;
+                break;
             }
-            PyTuple_SET_ITEM(error, 0, err_type);
-            PyTuple_SET_ITEM(error, 1, err_value);
-            PyTuple_SET_ITEM(error, 2, err_tb);
+            work->out = tmp;
         }
-        result = Py_None;
-        Py_INCREF(Py_None);
+        avail = size - work->out_len;
+        z.next_out = work->out + work->out_len;
+        z.avail_out = (uInt)(avail > TPOOL_ZLIB_CHUNK ? TPOOL_ZLIB_CHUNK : avail);
+        avail = z.avail_out;
+        r = deflating ? deflate(&z, flush) : inflate(&z, Z_NO_FLUSH);
+        work->out_len += avail - z.avail_out;
+        if (r == Z_STREAM_END) {
+            break;
+        }
+        /* no progress possible: all the input was consumed without reaching the end */
+        if ((r == Z_BUF_ERROR && z.avail_out != 0) || (r != Z_OK && r != Z_BUF_ERROR)) {
+            break;
+        }
+    }
+
+    if (deflating) {
+        deflateEnd(&z);
     } else {
-        error = Py_None;
-        Py_INCREF(Py_None);
+        inflateEnd(&z);
     }
-    data->result = result;
-    data->error = error;
 
-    PyGILState_Release(gstate);
+    switch (r) {
+        case Z_STREAM_END:
+            return NULL;
+        case Z_MEM_ERROR:
+            return "out of memory";
+        case Z_BUF_ERROR:
+            return work->out_len == max_size ? "decompressed data is larger than max_size" : "truncated compressed data";
+        default:
+            return deflating ? "compression failed" : "invalid compressed data";
+    }
 }
+#endif
 
 
 static void
-threadpool_after_work_cb(uv_work_t *req)
+threadpool_native_work_cb(uv_work_t *req)
+{
+    tpool_native_t *work = (tpool_native_t *)req->data;
+    const unsigned char *data = work->in.data;
+    size_t len = work->in.len;
+    int r;
+
+    switch (work->kind) {
+        case TPOOL_NATIVE_SHA1:
+        case TPOOL_NATIVE_SHA256:
+        {
+#ifdef PYUV_HAVE_OPENSSL
+            unsigned int digest_len;
+#endif
+            work->out = malloc(KERNEL_SHA256_SIZE);
+            if (!work->out) {
+                break;
+            }
+#ifdef PYUV_HAVE_OPENSSL
+            if (!EVP_Digest(data, len, work->out, &digest_len, work->kind == TPOOL_NATIVE_SHA1 ? EVP_sha1() : EVP_sha256(), NULL)) {
+                work->error = "hashing failed";
+                return;
+            }
+            work->out_len = digest_len;
+#else
+            if (work->kind == TPOOL_NATIVE_SHA1) {
+                kernel_sha1(data, len, work->out);
+                work->out_len = KERNEL_SHA1_SIZE;
+            } else {
+                kernel_sha256(data, len, work->out);
+                work->out_len = KERNEL_SHA256_SIZE;
+            }
+#endif
+            return;
+        }
+        case TPOOL_NATIVE_CRC32:
+        {
+#ifdef PYUV_HAVE_ZLIB
+            uLong crc = crc32(0L, Z_NULL, 0);
+            size_t chunk;
+            for (; len > 0; data += chunk, len -= chunk) {
+                chunk = len > TPOOL_ZLIB_CHUNK ? TPOOL_ZLIB_CHUNK : len;
+                crc = crc32(crc, data, (uInt)chunk);
+            }
+            work->value = (Py_ssize_t)crc;
+#else
+            work->value = (Py_ssize_t)kernel_crc32(0, data, len);
+#endif
+            return;
+        }
+#ifdef PYUV_HAVE_ZLIB
+        case TPOOL_NATIVE_COMPRESS:
+            work->error = threadpool_native_zlib(work, data, len, (size_t)-1);
+            return;
+        case TPOOL_NATIVE_DECOMPRESS:
+            /* one more byte than allowed, to tell a full buffer apart from a too large output */
+            work->error = threadpool_native_zlib(work, data, len, work->max_size + 1);
+            if (work->error == NULL && work->out_len > work->max_size) {
+                work->error = "decompressed data is larger than max_size";
+            }
+            return;
+#endif
+        case TPOOL_NATIVE_B64ENCODE:
+            work->out = malloc((len + 2) / 3 * 4 + 1);
+            if (!work->out) {
+                break;
+            }
+            work->out_len = kernel_b64encode(data, len, (char *)work->out);
+            return;
+        case TPOOL_NATIVE_B64DECODE:
+            work->out = malloc(len / 4 * 3 + 1);
+            if (!work->out) {
+                break;
+            }
+            work->value = kernel_b64decode(data, len, work->out);
+            if (work->value < 0) {
+                work->error = "invalid base64 data";
+            } else {
+                work->out_len = (size_t)work->value;
+            }
+            return;
+        case TPOOL_NATIVE_COMPARE:
+            r = memcmp(data, work->in2.data, len < work->in2.len ? len : work->in2.len);
+            if (r == 0) {
+                r = len < work->in2.len ? -1 : (len > work->in2.len ? 1 : 0);
+            }
+            work->value = r < 0 ? -1 : (r > 0 ? 1 : 0);
+            return;
+        case TPOOL_NATIVE_FIND:
+            work->value = kernel_find(data, len, work->in2.data, work->in2.len);
+            return;
+        default:
+            ASSERT(0);
+    }
+
+    work->error = "out of memory";
+}
+
+
+static void
+threadpool_native_after_work_cb(uv_work_t *req)
 {
     PyGILState_STATE gstate = PyGILState_Ensure();
-    tpool_req_data_t *data;
-    PyObject *result;
+    tpool_native_t *work;
+    PyObject *result, *error, *exc, *ret;
 
     ASSERT(req);
 
-    data = (tpool_req_data_t*)req->data;
+    work = (tpool_native_t *)req->data;
+    result = error = NULL;
 
-    if (data->after_work_cb) {
-        result = PyObject_CallFunctionObjArgs(data->after_work_cb, data->result, data->error, NULL);
-        if (result == NULL) {
-            PyErr_WriteUnraisable(data->after_work_cb);
+    if (work->error) {
+        exc = PyObject_CallFunction(PyExc_ThreadPoolError, "s", work->error);
+        if (exc) {
+            error = Py_BuildValue("(OOO)", PyExc_ThreadPoolError, exc, Py_None);
+            Py_DECREF(exc);
         }
-        Py_XDECREF(result);
+    } else if (work->kind == TPOOL_NATIVE_CRC32) {
+        result = PyLong_FromUnsignedLong((unsigned long)(uint32_t)work->value);
+    } else if (work->kind == TPOOL_NATIVE_COMPARE || work->kind == TPOOL_NATIVE_FIND) {
+        result = PyInt_FromSsize_t(work->value);
+    } else {
+        result = PyString_FromStringAndSize((const char *)work->out, (Py_ssize_t)work->out_len);
+    }
+    if (!result && !error) {
+        error = threadpool_fetch_error(work->after_work_cb ? work->after_work_cb : Py_None);
+    }
+    if (!result) {
+        result = Py_None;
+        Py_INCREF(Py_None);
+    }
+    if (!error) {
+        error = Py_None;
+        Py_INCREF(Py_None);
     }
 
-    Py_DECREF(data->work_cb);
-    Py_XDECREF(data->after_work_cb);
-    Py_DECREF(data->result);
-    Py_DECREF(data->error);
+    threadpool_native_release(work);
+    free(work->out);
+
+    if (work->after_work_cb) {
+        ret = pyuv_callback("after_work", work->after_work_cb, result, error, NULL);
+        if (ret == NULL) {
+            PyErr_WriteUnraisable(work->after_work_cb);
+        }
+        Py_XDECREF(ret);
+        Py_DECREF(work->after_work_cb);
+    }
+
+    future_set_result(work->future, result, error);
+    Py_DECREF(work->future);
+    Py_DECREF(result);
+    Py_DECREF(error);
+    PyMem_Free(work);
 
-    PyMem_Free(req->data);
-    PyMem_Free(req);
     PyGILState_Release(gstate);
 }
 
 
+/* Takes ownership of the buffers, they are released even if queueing fails */
 static PyObject *
-ThreadPool_func_queue_work(ThreadPool *self, PyObject *args)
+threadpool_queue_native(ThreadPool *self, tpool_native_t *work, PyObject *after_work_cb)
 {
     int r;
-    uv_work_t *work_req = NULL;
-    tpool_req_data_t *req_data = NULL;
-    PyObject *work_cb, *after_work_cb;
+    Future *future;
 
-    work_req = NULL;
-    req_data = NULL;
-    work_cb = after_work_cb = NULL;
+    if (after_work_cb == Py_None) {
+        after_work_cb = NULL;
+    }
+    if (after_work_cb && !PyCallable_Check(after_work_cb)) {
+        PyErr_SetString(PyExc_TypeError, "after_work_cb must be a callable");
+        goto error;
+    }
+
+    future = future_new(self->loop);
+    if (!future) {
+        goto error;
+    }
+
+    Py_XINCREF(after_work_cb);
+    work->after_work_cb = after_work_cb;
+    work->future = future;
+    work->out = NULL;
+    work->out_len = 0;
+    work->value = 0;
+    work->error = NULL;
+    work->req.data = (void *)work;
+
+    r = uv_queue_work(UV_LOOP(self), &work->req, threadpool_native_work_cb, threadpool_native_after_work_cb);
+    if (r != 0) {
+        RAISE_UV_EXCEPTION(UV_LOOP(self), PyExc_ThreadPoolError);
+        Py_XDECREF(after_work_cb);
+        Py_DECREF(future);
+        goto error;
+    }
+
+    /* one reference for the request, one for the caller */
+    Py_INCREF(future);
+    return (PyObject *)future;
 
-    if (!PyArg_ParseTuple(args, "O|O:queue_work", &work_cb, &after_work_cb)) {
+error:
+    threadpool_native_release(work);
+    PyMem_Free(work);
+    return NULL;
+}
+
+
+static tpool_native_t *
+threadpool_native_new(int kind, PyObject *data, PyObject *data2)
+{
+    tpool_native_t *work;
+
+    work = PyMem_Malloc(sizeof(tpool_native_t));
+    if (!work) {
+        PyErr_NoMemory();
         return NULL;
     }
+    memset(work, 0, sizeof(tpool_native_t));
+    work->kind = kind;
 
-    if (!PyCallable_Check(work_cb)) {
-        PyErr_SetString(PyExc_TypeError, "a callable is required");
+    if (threadpool_native_buf_init(&work->in, data) != 0) {
+        PyMem_Free(work);
+        return NULL;
+    }
+    if (data2 && threadpool_native_buf_init(&work->in2, data2) != 0) {
+        threadpool_native_release(work);
+        PyMem_Free(work);
         return NULL;
     }
+    return work;
+}
 
-    if (after_work_cb != NULL && !PyCallable_Check(after_work_cb)) {
-        PyErr_SetString(PyExc_TypeError, "after_work_cb must be a callable");
+
+static PyObject *
+ThreadPool_func_hash(ThreadPool *self, PyObject *args, PyObject *kwargs)
+{
+    int kind;
+    const char *algorithm;
+    tpool_native_t *work;
+    PyObject *data, *after_work_cb;
+
+    static char *kwlist[] = {"data", "algorithm", "after_work_cb", NULL};
+
+    after_work_cb = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "Os|O:hash", kwlist, &data, &algorithm, &after_work_cb)) {
         return NULL;
     }
 
-    work_req = PyMem_Malloc(sizeof(uv_work_t));
-    if (!work_req) {
-        PyErr_NoMemory();
-        goto error;
+    if (strcmp(algorithm, "sha1") == 0) {
+        kind = TPOOL_NATIVE_SHA1;
+    } else if (strcmp(algorithm, "sha256") == 0) {
+        kind = TPOOL_NATIVE_SHA256;
+    } else if (strcmp(algorithm, "crc32") == 0) {
+        kind = TPOOL_NATIVE_CRC32;
+#ifndef PYUV_HAVE_ZLIB
+        if (!kernel_crc32_ready) {
+            kernel_crc32_init();
+        }
+#endif
+    } else {
+        PyErr_SetString(PyExc_ValueError, "algorithm must be 'sha1', 'sha256' or 'crc32'");
+        return NULL;
     }
 
-    req_data = PyMem_Malloc(sizeof(tpool_req_data_t));
-    if (!req_data) {
-        PyErr_NoMemory();
-        goto error;
+    work = threadpool_native_new(kind, data, NULL);
+    if (!work) {
+        return NULL;
     }
+    return threadpool_queue_native(self, work, after_work_cb);
+}
 
-    Py_INCREF(work_cb);
-    Py_XINCREF(after_work_cb);
 
-    req_data->work_cb = work_cb;
-    req_data->after_work_cb = after_work_cb;
-    req_data->result = NULL;
-    req_data->error = NULL;
+#ifdef PYUV_HAVE_ZLIB
+static PyObject *
+ThreadPool_func_compress(ThreadPool *self, PyObject *args, PyObject *kwargs)
+{
+    int level;
+    tpool_native_t *work;
+    PyObject *data, *after_work_cb;
 
-    work_req->data = (void *)req_data;
-    r = uv_queue_work(UV_LOOP(self), work_req, threadpool_work_cb, threadpool_after_work_cb);
-    if (r != 0) {
-        RAISE_UV_EXCEPTION(UV_LOOP(self), PyExc_ThreadPoolError);
-        goto error;
+    static char *kwlist[] = {"data", "level", "after_work_cb", NULL};
+
+    level = Z_DEFAULT_COMPRESSION;
+    after_work_cb = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|iO:compress", kwlist, &data, &level, &after_work_cb)) {
+        return NULL;
     }
 
-    Py_RETURN_NONE;
+    if (level < -1 || level > 9) {
+        PyErr_SetString(PyExc_ValueError, "level must be between -1 and 9");
+        return NULL;
+    }
 
-error:
-    if (work_req) {
-        PyMem_Free(work_req);
+    work = threadpool_native_new(TPOOL_NATIVE_COMPRESS, data, NULL);
+    if (!work) {
+        return NULL;
     }
-    if (req_data) {
-        PyMem_Free(req_data);
+    work->level = level;
+    return threadpool_queue_native(self, work, after_work_cb);
+}
+
+
+static PyObject *
+ThreadPool_func_decompress(ThreadPool *self, PyObject *args, PyObject *kwargs)
+{
+    Py_ssize_t max_size;
+    tpool_native_t *work;
+    PyObject *data, *after_work_cb;
+
+    static char *kwlist[] = {"data", "after_work_cb", "max_size", NULL};
+
+    max_size = TPOOL_DECOMPRESS_MAX_SIZE;
+    after_work_cb = Py_None;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|On:decompress", kwlist, &data, &after_work_cb, &max_size)) {
+        return NULL;
     }
-    Py_DECREF(work_cb);
-    Py_XDECREF(after_work_cb);
-    return NULL;
+
+    if (max_size < 0) {
+        PyErr_SetString(PyExc_ValueError, "max_size must be a positive value or zero");
+        return NULL;
+    }
+
+    work = threadpool_native_new(TPOOL_NATIVE_DECOMPRESS, data, NULL);
+    if (!work) {
+        return NULL;
+    }
+    work->max_size = (size_t)max_size;
+    return threadpool_queue_native(self, work, after_work_cb);
 }
+#endif
+
+
+/* Methods taking one or two buffers and an optional callback */
+#define TPOOL_NATIVE_METHOD(name, kind, nbuffers)                                                   \
+    static PyObject *                                                                               \
+    ThreadPool_func_##name(ThreadPool *self, PyObject *args, PyObject *kwargs)                      \
+    {                                                                                               \
+        tpool_native_t *work;                                                                       \
+        PyObject *data, *data2, *after_work_cb;                                                     \
+        static char *kwlist1[] = {"data", "after_work_cb", NULL};                                   \
+        static char *kwlist2[] = {"data", "data2", "after_work_cb", NULL};                          \
+        data2 = NULL;                                                                               \
+        after_work_cb = Py_None;                                                                    \
+        if (nbuffers == 1) {                                                                        \
+            if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|O:" #name, kwlist1, &data, &after_work_cb)) { \
+                return NULL;                                                                        \
+            }                                                                                       \
+        } else {                                                                                    \
+            if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO|O:" #name, kwlist2, &data, &data2, &after_work_cb)) { \
+                return NULL;                                                                        \
+            }                                                                                       \
+        }                                                                                           \
+        work = threadpool_native_new(kind, data, data2);                                            \
+        if (!work) {                                                                                \
+            return NULL;                                                                            \
+        }                                                                                           \
+        return threadpool_queue_native(self, work, after_work_cb);                                  \
+    }
+
+TPOOL_NATIVE_METHOD(b64encode, TPOOL_NATIVE_B64ENCODE, 1)
+TPOOL_NATIVE_METHOD(b64decode, TPOOL_NATIVE_B64DECODE, 1)
+TPOOL_NATIVE_METHOD(compare, TPOOL_NATIVE_COMPARE, 2)
+TPOOL_NATIVE_METHOD(find, TPOOL_NATIVE_FIND, 2)
+
+#undef TPOOL_NATIVE_METHOD
 
 
 static PyObject *
@@ -231,6 +1670,9 @@ ThreadPool_tp_clear(ThreadPool *self)
 static void
 ThreadPool_tp_dealloc(ThreadPool *self)
 {
+    /* the requests keep the pool alive, so nothing can be pending here */
+    ASSERT(self->pending_count == 0);
+    PyMem_Free(self->pending);
     ThreadPool_tp_clear(self);
     Py_TYPE(self)->tp_free((PyObject *)self);
 }
@@ -238,7 +1680,17 @@ ThreadPool_tp_dealloc(ThreadPool *self)
 
 static PyMethodDef
 ThreadPool_tp_methods[] = {
-    { "queue_work", (PyCFunction)ThreadPool_func_queue_work, METH_VARARGS, "Queue the given function to be run in the thread pool." },
+    { "queue_work", (PyCFunction)ThreadPool_func_queue_work, METH_VARARGS|METH_KEYWORDS, "Queue the given function to be run in the thread pool." },
+    { "queue_work_batch", (PyCFunction)ThreadPool_func_queue_work_batch, METH_VARARGS|METH_KEYWORDS, "Run the given function in the thread pool for every item, in chunks." },
+    { "hash", (PyCFunction)ThreadPool_func_hash, METH_VARARGS|METH_KEYWORDS, "Compute the SHA-1, SHA-256 or CRC-32 of the data in the thread pool." },
+#ifdef PYUV_HAVE_ZLIB
+    { "compress", (PyCFunction)ThreadPool_func_compress, METH_VARARGS|METH_KEYWORDS, "Compress the data with zlib in the thread pool." },
+    { "decompress", (PyCFunction)ThreadPool_func_decompress, METH_VARARGS|METH_KEYWORDS, "Decompress zlib data in the thread pool." },
+#endif
+    { "b64encode", (PyCFunction)ThreadPool_func_b64encode, METH_VARARGS|METH_KEYWORDS, "Encode the data with base64 in the thread pool." },
+    { "b64decode", (PyCFunction)ThreadPool_func_b64decode, METH_VARARGS|METH_KEYWORDS, "Decode base64 data in the thread pool." },
+    { "compare", (PyCFunction)ThreadPool_func_compare, METH_VARARGS|METH_KEYWORDS, "Compare two buffers in the thread pool." },
+    { "find", (PyCFunction)ThreadPool_func_find, METH_VARARGS|METH_KEYWORDS, "Find a buffer inside another one in the thread pool." },
     { "set_parallel_threads", (PyCFunction)ThreadPool_func_set_parallel_threads, METH_CLASS|METH_VARARGS, "Set the maximum number of allowed threads in the pool." },
     { NULL }
 };
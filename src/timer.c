@@ -1,3 +1,52 @@
+static void on_timer_callback(uv_timer_t *timer, int status);
+
+
+
+/* Round the deadline up to the next multiple of the slack, in loop time, so all timers
+ * with a deadline in the same window expire in the same uv__run_timers pass */
+static INLINE int64_t
+timer_slack_round(int64_t deadline, int64_t slack)
+{
+    deadline += slack - 1;
+    return deadline - deadline % slack;
+}
+
+
+/* Start the timer so it expires at now + timeout, rounded up when a slack is set */
+static int
+timer_slack_start(Timer *self, int64_t timeout, int64_t repeat)
+{
+    int64_t now;
+    uv_timer_t *timer = (uv_timer_t *)UV_HANDLE(self);
+
+    if (self->slack <= 0) {
+        return uv_timer_start(timer, on_timer_callback, timeout, repeat);
+    }
+
+    now = uv_now(timer->loop);
+    self->deadline = timer_slack_round(now + timeout, self->slack);
+    return uv_timer_start(timer, on_timer_callback, self->deadline - now, repeat);
+}
+
+
+/* Schedule the next expiration of a repeating timer one period after the previous rounded
+ * deadline, not after the time the callback ran, so lateness doesn't add up. Periods which
+ * already went by are skipped. */
+static void
+timer_slack_repeat(Timer *self, int64_t repeat)
+{
+    int64_t now, deadline;
+    uv_timer_t *timer = (uv_timer_t *)UV_HANDLE(self);
+
+    now = uv_now(timer->loop);
+    deadline = self->deadline + repeat;
+    if (deadline <= now) {
+        deadline += ((now - deadline) / repeat + 1) * repeat;
+    }
+    self->deadline = timer_slack_round(deadline, self->slack);
+    uv_timer_start(timer, on_timer_callback, self->deadline - now, repeat);
+}
+
 
 static void
 on_timer_callback(uv_timer_t *timer, int status)
@@ -5,6 +54,7 @@ on_timer_callback(uv_timer_t *timer, int status)
     PyGILState_STATE gstate = PyGILState_Ensure();
     Timer *self;
     PyObject *result;
+    unsigned int restarts;
 
     ASSERT(timer);
     ASSERT(status == 0);
@@ -14,12 +64,25 @@ on_timer_callback(uv_timer_t *timer, int status)
     /* Object could go out of scope in the callback, increase refcount to avoid it */
     Py_INCREF(self);
 
-    result = PyObject_CallFunctionObjArgs(self->callback, self, NULL);
+    PYUV_PROBE2(timer__fire, self, uv_timer_get_repeat(timer));
+
+    restarts = self->restarts;
+
+    result = pyuv_callback("timer", self->callback, self, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(self->callback);
     }
     Py_XDECREF(result);
 
+    /* libuv re-armed a repeating timer relative to the time it ran, unless the callback
+     * restarted or stopped it, reschedule it from the previous rounded deadline */
+    if (self->slack > 0 && self->restarts == restarts && UV_HANDLE(self) && uv_is_active((uv_handle_t *)timer)) {
+        int64_t repeat = uv_timer_get_repeat(timer);
+        if (repeat > 0) {
+            timer_slack_repeat(self, repeat);
+        }
+    }
+
     Py_DECREF(self);
     PyGILState_Release(gstate);
 }
@@ -29,16 +92,18 @@ static PyObject *
 Timer_func_start(Timer *self, PyObject *args, PyObject *kwargs)
 {
     int r;
-    double timeout, repeat;
+    double timeout, repeat, slack;
+    int64_t slack_ms, prev_slack;
     PyObject *tmp, *callback;
 
-    static char *kwlist[] = {"callback", "timeout", "repeat", NULL};
+    static char *kwlist[] = {"callback", "timeout", "repeat", "slack", NULL};
 
     tmp = NULL;
+    slack = 0.0;
 
     RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
 
-    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "Odd:__init__", kwlist, &callback, &timeout, &repeat)) {
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "Odd|d:__init__", kwlist, &callback, &timeout, &repeat, &slack)) {
         return NULL;
     }
 
@@ -57,12 +122,23 @@ Timer_func_start(Timer *self, PyObject *args, PyObject *kwargs)
         return NULL;
     }
 
-    r = uv_timer_start((uv_timer_t *)UV_HANDLE(self), on_timer_callback, (int64_t)(timeout * 1000), (int64_t)(repeat * 1000));
+    if (slack < 0.0) {
+        PyErr_SetString(PyExc_ValueError, "a positive value or zero is required");
+        return NULL;
+    }
+
+    slack_ms = (int64_t)(slack * 1000);
+    prev_slack = self->slack;
+    self->slack = slack_ms;
+    r = timer_slack_start(self, (int64_t)(timeout * 1000), (int64_t)(repeat * 1000));
     if (r != 0) {
+        self->slack = prev_slack;
         RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self), PyExc_TimerError);
         return NULL;
     }
 
+    self->restarts++;
+
     tmp = self->callback;
     Py_INCREF(callback);
     self->callback = callback;
@@ -84,6 +160,7 @@ Timer_func_stop(Timer *self)
         RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self), PyExc_TimerError);
         return NULL;
     }
+    self->restarts++;
 
     Py_RETURN_NONE;
 }
@@ -93,15 +170,25 @@ static PyObject *
 Timer_func_again(Timer *self)
 {
     int r;
+    int64_t repeat;
+    uv_timer_t *timer;
 
     RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
 
-    r = uv_timer_again((uv_timer_t *)UV_HANDLE(self));
+    timer = (uv_timer_t *)UV_HANDLE(self);
+    r = uv_timer_again(timer);
     if (r != 0) {
         RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self), PyExc_TimerError);
         return NULL;
     }
 
+    /* uv_timer_again restarted it at now + repeat, round the deadline like start does */
+    repeat = uv_timer_get_repeat(timer);
+    if (self->slack > 0 && repeat > 0) {
+        timer_slack_start(self, repeat, repeat);
+    }
+    self->restarts++;
+
     Py_RETURN_NONE;
 }
 
@@ -145,6 +232,14 @@ Timer_repeat_set(Timer *self, PyObject *value, void *closure)
 }
 
 
+static PyObject *
+Timer_slack_get(Timer *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    return PyFloat_FromDouble(self->slack/1000.0);
+}
+
+
 static int
 Timer_tp_init(Timer *self, PyObject *args, PyObject *kwargs)
 {
@@ -184,6 +279,7 @@ Timer_tp_init(Timer *self, PyObject *args, PyObject *kwargs)
     }
     uv_timer->data = (void *)self;
     UV_HANDLE(self) = (uv_handle_t *)uv_timer;
+    PYUV_PROBE2(handle__init, self, Py_TYPE(self)->tp_name);
 
     return 0;
 }
@@ -229,6 +325,7 @@ Timer_tp_methods[] = {
 
 static PyGetSetDef Timer_tp_getsets[] = {
     {"repeat", (getter)Timer_repeat_get, (setter)Timer_repeat_set, "Timer repeat value.", NULL},
+    {"slack", (getter)Timer_slack_get, NULL, "Amount of time the Timer may be delayed to share a wakeup with other timers.", NULL},
     {NULL}
 };
 
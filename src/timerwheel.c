@@ -0,0 +1,644 @@
+/* Intrusive circular lists, slot heads are sentinels */
+
+static INLINE void
+timer_wheel_link_init(timer_wheel_link_t *link)
+{
+    link->prev = link->next = link;
+}
+
+
+static INLINE void
+timer_wheel_link_append(timer_wheel_link_t *head, timer_wheel_link_t *link)
+{
+    link->prev = head->prev;
+    link->next = head;
+    head->prev->next = link;
+    head->prev = link;
+}
+
+
+static INLINE void
+timer_wheel_link_remove(timer_wheel_link_t *link)
+{
+    link->prev->next = link->next;
+    link->next->prev = link->prev;
+    timer_wheel_link_init(link);
+}
+
+
+/* Move all the elements of src to the end of dst */
+static INLINE void
+timer_wheel_link_splice(timer_wheel_link_t *src, timer_wheel_link_t *dst)
+{
+    if (src->next == src) {
+        return;
+    }
+    src->next->prev = dst->prev;
+    src->prev->next = dst;
+    dst->prev->next = src->next;
+    dst->prev = src->prev;
+    timer_wheel_link_init(src);
+}
+
+
+#define TIMER_WHEEL_ENTRY(l) ((TimerWheelEntry *)((char *)(l) - offsetof(TimerWheelEntry, link)))
+
+
+/* Put the entry in the slot covering its expiration tick, relative to the current tick */
+static void
+timer_wheel_add(TimerWheel *self, TimerWheelEntry *entry)
+{
+    int level;
+    uint64_t delta, expires;
+    timer_wheel_link_t *slot;
+
+    if (entry->expires < self->current) {
+        entry->expires = self->current;
+    }
+    delta = entry->expires - self->current;
+    if (delta >= TIMER_WHEEL_MAX_TICKS) {
+        entry->expires = self->current + TIMER_WHEEL_MAX_TICKS - 1;
+        delta = TIMER_WHEEL_MAX_TICKS - 1;
+    }
+    expires = entry->expires;
+
+    if (delta < TIMER_WHEEL_ROOT_SIZE) {
+        slot = &self->root[expires & (TIMER_WHEEL_ROOT_SIZE - 1)];
+    } else {
+        for (level = 0; level < TIMER_WHEEL_LEVELS - 1; level++) {
+            if (delta < ((uint64_t)1 << (TIMER_WHEEL_ROOT_BITS + (level + 1) * TIMER_WHEEL_LEVEL_BITS))) {
+                break;
+            }
+        }
+        slot = &self->levels[level][(expires >> (TIMER_WHEEL_ROOT_BITS + level * TIMER_WHEEL_LEVEL_BITS)) & (TIMER_WHEEL_LEVEL_SIZE - 1)];
+    }
+
+    timer_wheel_link_append(slot, &entry->link);
+}
+
+
+/* Redistribute the entries of an upper level slot, returns the slot index */
+static int
+timer_wheel_cascade(TimerWheel *self, int level)
+{
+    int index;
+    timer_wheel_link_t tmp, *link;
+
+    index = (int)((self->current >> (TIMER_WHEEL_ROOT_BITS + level * TIMER_WHEEL_LEVEL_BITS)) & (TIMER_WHEEL_LEVEL_SIZE - 1));
+
+    timer_wheel_link_init(&tmp);
+    timer_wheel_link_splice(&self->levels[level][index], &tmp);
+    while (tmp.next != &tmp) {
+        link = tmp.next;
+        timer_wheel_link_remove(link);
+        timer_wheel_add(self, TIMER_WHEEL_ENTRY(link));
+    }
+
+    return index;
+}
+
+
+/* Expire all ticks up to target (included), moving the entries to the expired list */
+static void
+timer_wheel_advance(TimerWheel *self, uint64_t target, timer_wheel_link_t *expired)
+{
+    int level, index;
+
+    while (self->current <= target) {
+        index = (int)(self->current & (TIMER_WHEEL_ROOT_SIZE - 1));
+        if (index == 0) {
+            for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+                if (timer_wheel_cascade(self, level) != 0) {
+                    break;
+                }
+            }
+        }
+        timer_wheel_link_splice(&self->root[index], expired);
+        self->current++;
+    }
+}
+
+
+static INLINE uint64_t
+timer_wheel_now(TimerWheel *self)
+{
+    return (uint64_t)uv_now(UV_HANDLE_LOOP(self)) - self->base;
+}
+
+
+static void
+on_timer_wheel_timer(uv_timer_t *timer, int status)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    Py_ssize_t i, count;
+    TimerWheel *self;
+    TimerWheelEntry *entry;
+    timer_wheel_link_t expired, *link;
+    PyObject *entries, *result;
+
+    ASSERT(timer);
+    ASSERT(status == 0);
+
+    self = (TimerWheel *)(timer->data);
+    ASSERT(self);
+    /* Object could go out of scope in the callback, increase refcount to avoid it */
+    Py_INCREF(self);
+
+    timer_wheel_link_init(&expired);
+    timer_wheel_advance(self, timer_wheel_now(self) / self->resolution, &expired);
+
+    count = 0;
+    for (link = expired.next; link != &expired; link = link->next) {
+        count++;
+    }
+    if (count == 0) {
+        goto done;
+    }
+
+    /* the references held by the wheel are transferred to the list */
+    entries = PyList_New(count);
+    for (i = 0; i < count; i++) {
+        link = expired.next;
+        timer_wheel_link_remove(link);
+        entry = TIMER_WHEEL_ENTRY(link);
+        entry->wheel = NULL;
+        if (entries) {
+            PyList_SET_ITEM(entries, i, (PyObject *)entry);
+        } else {
+            Py_DECREF(entry);
+        }
+    }
+    self->pending -= count;
+    if (self->pending == 0) {
+        uv_timer_stop(timer);
+    }
+
+    if (!entries) {
+        PyErr_WriteUnraisable(self->callback);
+        goto done;
+    }
+
+    result = pyuv_callback("timer_wheel", self->callback, self, entries, NULL);
+    if (result == NULL) {
+        PyErr_WriteUnraisable(self->callback);
+    }
+    Py_XDECREF(result);
+    Py_DECREF(entries);
+
+done:
+    Py_DECREF(self);
+    PyGILState_Release(gstate);
+}
+
+
+static int
+timer_wheel_schedule(TimerWheel *self, TimerWheelEntry *entry, double timeout)
+{
+    uint64_t now;
+
+    now = timer_wheel_now(self);
+
+    if (self->pending == 0) {
+        /* the wheel is empty, so it can skip the ticks which passed while it was stopped */
+        self->current = now / self->resolution + 1;
+        if (uv_timer_start((uv_timer_t *)UV_HANDLE(self), on_timer_wheel_timer, self->resolution, self->resolution) != 0) {
+            RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self), PyExc_TimerError);
+            return -1;
+        }
+    }
+
+    /* never expire early: the tick must start at or after now + timeout */
+    entry->expires = (uint64_t)ceil((now + timeout * 1000.0) / self->resolution);
+    entry->wheel = self;
+    timer_wheel_add(self, entry);
+    self->pending++;
+    return 0;
+}
+
+
+static void
+timer_wheel_unschedule(TimerWheel *self, TimerWheelEntry *entry)
+{
+    timer_wheel_link_remove(&entry->link);
+    entry->wheel = NULL;
+    self->pending--;
+    if (self->pending == 0) {
+        uv_timer_stop((uv_timer_t *)UV_HANDLE(self));
+    }
+}
+
+
+static PyObject *
+TimerWheel_func_schedule(TimerWheel *self, PyObject *args, PyObject *kwargs)
+{
+    double timeout;
+    TimerWheelEntry *entry;
+    PyObject *data;
+
+    static char *kwlist[] = {"timeout", "data", NULL};
+
+    data = Py_None;
+
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "d|O:schedule", kwlist, &timeout, &data)) {
+        return NULL;
+    }
+
+    if (timeout < 0.0) {
+        PyErr_SetString(PyExc_ValueError, "a positive value or zero is required");
+        return NULL;
+    }
+
+    entry = PyObject_GC_New(TimerWheelEntry, &TimerWheelEntryType);
+    if (!entry) {
+        return NULL;
+    }
+    timer_wheel_link_init(&entry->link);
+    entry->wheel = NULL;
+    entry->expires = 0;
+    Py_INCREF(data);
+    entry->data = data;
+    PyObject_GC_Track(entry);
+
+    if (timer_wheel_schedule(self, entry, timeout) != 0) {
+        Py_DECREF(entry);
+        return NULL;
+    }
+
+    /* one reference for the wheel, one for the caller */
+    Py_INCREF(entry);
+    return (PyObject *)entry;
+}
+
+
+static PyObject *
+TimerWheel_func_reschedule(TimerWheel *self, PyObject *args)
+{
+    double timeout;
+    TimerWheelEntry *entry;
+
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTuple(args, "O!d:reschedule", &TimerWheelEntryType, &entry, &timeout)) {
+        return NULL;
+    }
+
+    if (timeout < 0.0) {
+        PyErr_SetString(PyExc_ValueError, "a positive value or zero is required");
+        return NULL;
+    }
+
+    if (entry->wheel && entry->wheel != self) {
+        PyErr_SetString(PyExc_ValueError, "entry is scheduled on another TimerWheel");
+        return NULL;
+    }
+
+    if (entry->wheel) {
+        /* keep the wheel running, the entry goes right back in */
+        timer_wheel_link_remove(&entry->link);
+        self->pending--;
+    } else {
+        Py_INCREF(entry);
+    }
+
+    if (timer_wheel_schedule(self, entry, timeout) != 0) {
+        entry->wheel = NULL;
+        Py_DECREF(entry);
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+TimerWheel_func_cancel(TimerWheel *self, PyObject *args)
+{
+    TimerWheelEntry *entry;
+
+    RAISE_IF_HANDLE_CLOSED(self, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTuple(args, "O!:cancel", &TimerWheelEntryType, &entry)) {
+        return NULL;
+    }
+
+    if (entry->wheel != self) {
+        Py_RETURN_FALSE;
+    }
+
+    timer_wheel_unschedule(self, entry);
+    Py_DECREF(entry);
+    Py_RETURN_TRUE;
+}
+
+
+static PyObject *
+TimerWheel_resolution_get(TimerWheel *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    return PyFloat_FromDouble(self->resolution / 1000.0);
+}
+
+
+static PyObject *
+TimerWheel_pending_get(TimerWheel *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    return PyInt_FromSsize_t(self->pending);
+}
+
+
+static int
+TimerWheel_tp_init(TimerWheel *self, PyObject *args, PyObject *kwargs)
+{
+    int r;
+    double resolution;
+    uv_timer_t *uv_timer = NULL;
+    Loop *loop;
+    PyObject *tmp, *callback;
+
+    static char *kwlist[] = {"loop", "callback", "resolution", NULL};
+
+    resolution = 0.01;
+
+    if (UV_HANDLE(self)) {
+        PyErr_SetString(PyExc_TimerError, "Object already initialized");
+        return -1;
+    }
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!O|d:__init__", kwlist, &LoopType, &loop, &callback, &resolution)) {
+        return -1;
+    }
+
+    if (!PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return -1;
+    }
+
+    if (resolution < 0.001) {
+        PyErr_SetString(PyExc_ValueError, "resolution must be at least 0.001");
+        return -1;
+    }
+
+    tmp = (PyObject *)((Handle *)self)->loop;
+    Py_INCREF(loop);
+    ((Handle *)self)->loop = loop;
+    Py_XDECREF(tmp);
+
+    uv_timer = PyMem_Malloc(sizeof(uv_timer_t));
+    if (!uv_timer) {
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    r = uv_timer_init(UV_HANDLE_LOOP(self), uv_timer);
+    if (r != 0) {
+        RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self), PyExc_TimerError);
+        PyMem_Free(uv_timer);
+        return -1;
+    }
+    uv_timer->data = (void *)self;
+    UV_HANDLE(self) = (uv_handle_t *)uv_timer;
+    PYUV_PROBE2(handle__init, self, Py_TYPE(self)->tp_name);
+
+    tmp = self->callback;
+    Py_INCREF(callback);
+    self->callback = callback;
+    Py_XDECREF(tmp);
+
+    self->resolution = (uint64_t)(resolution * 1000 + 0.5);
+    self->base = (uint64_t)uv_now(UV_HANDLE_LOOP(self));
+    self->current = 0;
+
+    return 0;
+}
+
+
+static PyObject *
+TimerWheel_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    int i, j;
+    TimerWheel *self = (TimerWheel *)HandleType.tp_new(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+    for (i = 0; i < TIMER_WHEEL_ROOT_SIZE; i++) {
+        timer_wheel_link_init(&self->root[i]);
+    }
+    for (i = 0; i < TIMER_WHEEL_LEVELS; i++) {
+        for (j = 0; j < TIMER_WHEEL_LEVEL_SIZE; j++) {
+            timer_wheel_link_init(&self->levels[i][j]);
+        }
+    }
+    self->pending = 0;
+    return (PyObject *)self;
+}
+
+
+static int
+TimerWheel_tp_traverse(TimerWheel *self, visitproc visit, void *arg)
+{
+    int i, j;
+    timer_wheel_link_t *link;
+
+    for (i = 0; i < TIMER_WHEEL_ROOT_SIZE; i++) {
+        for (link = self->root[i].next; link != &self->root[i]; link = link->next) {
+            Py_VISIT(TIMER_WHEEL_ENTRY(link));
+        }
+    }
+    for (i = 0; i < TIMER_WHEEL_LEVELS; i++) {
+        for (j = 0; j < TIMER_WHEEL_LEVEL_SIZE; j++) {
+            for (link = self->levels[i][j].next; link != &self->levels[i][j]; link = link->next) {
+                Py_VISIT(TIMER_WHEEL_ENTRY(link));
+            }
+        }
+    }
+    Py_VISIT(self->callback);
+    HandleType.tp_traverse((PyObject *)self, visit, arg);
+    return 0;
+}
+
+
+static void
+timer_wheel_clear_slot(TimerWheel *self, timer_wheel_link_t *slot)
+{
+    TimerWheelEntry *entry;
+
+    /* releasing an entry can run arbitrary code, so take them out one by one */
+    while (slot->next != slot) {
+        entry = TIMER_WHEEL_ENTRY(slot->next);
+        timer_wheel_link_remove(&entry->link);
+        entry->wheel = NULL;
+        self->pending--;
+        Py_DECREF(entry);
+    }
+}
+
+
+static int
+TimerWheel_tp_clear(TimerWheel *self)
+{
+    int i, j;
+
+    for (i = 0; i < TIMER_WHEEL_ROOT_SIZE; i++) {
+        timer_wheel_clear_slot(self, &self->root[i]);
+    }
+    for (i = 0; i < TIMER_WHEEL_LEVELS; i++) {
+        for (j = 0; j < TIMER_WHEEL_LEVEL_SIZE; j++) {
+            timer_wheel_clear_slot(self, &self->levels[i][j]);
+        }
+    }
+    Py_CLEAR(self->callback);
+    HandleType.tp_clear((PyObject *)self);
+    return 0;
+}
+
+
+static PyMethodDef
+TimerWheel_tp_methods[] = {
+    { "schedule", (PyCFunction)TimerWheel_func_schedule, METH_VARARGS|METH_KEYWORDS, "Schedule a new timeout entry." },
+    { "reschedule", (PyCFunction)TimerWheel_func_reschedule, METH_VARARGS, "Schedule an entry again, with a new timeout." },
+    { "cancel", (PyCFunction)TimerWheel_func_cancel, METH_VARARGS, "Cancel a scheduled entry." },
+    { NULL }
+};
+
+
+static PyGetSetDef TimerWheel_tp_getsets[] = {
+    {"resolution", (getter)TimerWheel_resolution_get, NULL, "Duration of a tick.", NULL},
+    {"pending", (getter)TimerWheel_pending_get, NULL, "Number of scheduled entries.", NULL},
+    {NULL}
+};
+
+
+static PyTypeObject TimerWheelType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv.TimerWheel",                                              /*tp_name*/
+    sizeof(TimerWheel),                                             /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    0,                                                              /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    0,                                                              /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,                        /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)TimerWheel_tp_traverse,                           /*tp_traverse*/
+    (inquiry)TimerWheel_tp_clear,                                   /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    0,                                                              /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    TimerWheel_tp_methods,                                          /*tp_methods*/
+    0,                                                              /*tp_members*/
+    TimerWheel_tp_getsets,                                          /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    (initproc)TimerWheel_tp_init,                                   /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    TimerWheel_tp_new,                                              /*tp_new*/
+};
+
+
+/* TimerWheelEntry, created by TimerWheel.schedule */
+
+static PyObject *
+TimerWheelEntry_scheduled_get(TimerWheelEntry *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    return PyBool_FromLong((long)(self->wheel != NULL));
+}
+
+
+static int
+TimerWheelEntry_tp_traverse(TimerWheelEntry *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->data);
+    return 0;
+}
+
+
+static int
+TimerWheelEntry_tp_clear(TimerWheelEntry *self)
+{
+    Py_CLEAR(self->data);
+    return 0;
+}
+
+
+static void
+TimerWheelEntry_tp_dealloc(TimerWheelEntry *self)
+{
+    /* scheduled entries are referenced by their wheel */
+    ASSERT(self->wheel == NULL);
+    TimerWheelEntry_tp_clear(self);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+
+static PyMemberDef TimerWheelEntry_tp_members[] = {
+    {"data", T_OBJECT, offsetof(TimerWheelEntry, data), 0, "Object given when the entry was scheduled."},
+    {NULL}
+};
+
+
+static PyGetSetDef TimerWheelEntry_tp_getsets[] = {
+    {"scheduled", (getter)TimerWheelEntry_scheduled_get, NULL, "Indicates if the entry is scheduled.", NULL},
+    {NULL}
+};
+
+
+static PyTypeObject TimerWheelEntryType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv.TimerWheelEntry",                                         /*tp_name*/
+    sizeof(TimerWheelEntry),                                        /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    (destructor)TimerWheelEntry_tp_dealloc,                         /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    0,                                                              /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,                        /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)TimerWheelEntry_tp_traverse,                      /*tp_traverse*/
+    (inquiry)TimerWheelEntry_tp_clear,                              /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    0,                                                              /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    0,                                                              /*tp_methods*/
+    TimerWheelEntry_tp_members,                                     /*tp_members*/
+    TimerWheelEntry_tp_getsets,                                     /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    0,                                                              /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    0,                                                              /*tp_new*/
+};
+
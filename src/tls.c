@@ -0,0 +1,1450 @@
+
+#ifdef PYUV_HAVE_OPENSSL
+
+typedef struct {
+    TLSStream *tls;
+    PyObject *callback;
+    uv_buf_t buf;
+} tls_write_data_t;
+
+/* The request data is the TLSStream, the stream could have another layer by the time it completes */
+typedef struct {
+    uv_shutdown_t req;
+    PyObject *callback;
+} tls_shutdown_req_t;
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+#define ASN1_STRING_get0_data ASN1_STRING_data
+#endif
+
+#define RAISE_IF_TLS_NOT_INITIALIZED(obj, ptr, retval)                      \
+    do {                                                                    \
+        if (!(obj)->ptr) {                                                  \
+            PyErr_SetString(PyExc_TLSError, "Object was not initialized");  \
+            return retval;                                                  \
+        }                                                                   \
+    } while(0)
+
+
+static void
+set_tls_exception(const char *msg)
+{
+    unsigned long e;
+    char buf[256];
+
+    e = ERR_get_error();
+    if (e != 0) {
+        ERR_error_string_n(e, buf, sizeof(buf));
+        PyErr_Format(PyExc_TLSError, "%s: %s", msg, buf);
+    } else {
+        PyErr_SetString(PyExc_TLSError, msg);
+    }
+    ERR_clear_error();
+}
+
+
+/* TLSContext */
+
+static void
+tls_session_capsule_destructor(PyObject *capsule)
+{
+    SSL_SESSION *session = (SSL_SESSION *)PyCapsule_GetPointer(capsule, NULL);
+    if (session) {
+        SSL_SESSION_free(session);
+    }
+}
+
+
+static int
+tls_new_session_cb(SSL *ssl, SSL_SESSION *session)
+{
+    /* Called with the GIL held, from within SSL_do_handshake or SSL_read */
+    TLSStream *self;
+    PyObject *capsule;
+
+    self = (TLSStream *)SSL_get_app_data(ssl);
+    if (!self || self->server_hostname == Py_None) {
+        return 0;
+    }
+
+    capsule = PyCapsule_New((void *)session, NULL, tls_session_capsule_destructor);
+    if (!capsule) {
+        PyErr_WriteUnraisable((PyObject *)self);
+        return 0;
+    }
+    if (PyDict_SetItem(self->context->sessions, self->server_hostname, capsule) < 0) {
+        /* the session will be freed by OpenSSL, make sure the capsule doesn't touch it */
+        PyCapsule_SetDestructor(capsule, NULL);
+        Py_DECREF(capsule);
+        PyErr_WriteUnraisable((PyObject *)self);
+        return 0;
+    }
+    Py_DECREF(capsule);
+
+    /* we keep the reference to the session */
+    return 1;
+}
+
+
+static PyObject *
+TLSContext_func_clear_sessions(TLSContext *self)
+{
+    RAISE_IF_TLS_NOT_INITIALIZED(self, ctx, NULL);
+    PyDict_Clear(self->sessions);
+    Py_RETURN_NONE;
+}
+
+
+static int
+TLSContext_tp_init(TLSContext *self, PyObject *args, PyObject *kwargs)
+{
+    long options;
+    int server_side;
+    char *certfile, *keyfile, *cafile, *ciphers;
+    PyObject *verify;
+    SSL_CTX *ctx;
+
+    static char *kwlist[] = {"server_side", "certfile", "keyfile", "cafile", "verify", "ciphers", NULL};
+
+    server_side = 0;
+    certfile = keyfile = cafile = ciphers = NULL;
+    verify = Py_False;
+
+    if (self->ctx) {
+        PyErr_SetString(PyExc_TLSError, "Object already initialized");
+        return -1;
+    }
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|izzzOz:__init__", kwlist, &server_side, &certfile, &keyfile, &cafile, &verify, &ciphers)) {
+        return -1;
+    }
+
+    ctx = SSL_CTX_new(SSLv23_method());
+    if (!ctx) {
+        set_tls_exception("error creating TLS context");
+        return -1;
+    }
+
+    options = SSL_OP_ALL | SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3;
+#ifdef SSL_OP_NO_COMPRESSION
+    options |= SSL_OP_NO_COMPRESSION;
+#endif
+    SSL_CTX_set_options(ctx, options);
+    SSL_CTX_set_mode(ctx, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER | SSL_MODE_ENABLE_PARTIAL_WRITE);
+#ifdef SSL_MODE_RELEASE_BUFFERS
+    SSL_CTX_set_mode(ctx, SSL_MODE_RELEASE_BUFFERS);
+#endif
+
+    if (certfile) {
+        if (SSL_CTX_use_certificate_chain_file(ctx, certfile) != 1) {
+            set_tls_exception("error loading certificate");
+            goto error;
+        }
+        if (SSL_CTX_use_PrivateKey_file(ctx, keyfile ? keyfile : certfile, SSL_FILETYPE_PEM) != 1) {
+            set_tls_exception("error loading private key");
+            goto error;
+        }
+        if (SSL_CTX_check_private_key(ctx) != 1) {
+            set_tls_exception("private key does not match the certificate");
+            goto error;
+        }
+    }
+
+    if (cafile) {
+        if (SSL_CTX_load_verify_locations(ctx, cafile, NULL) != 1) {
+            set_tls_exception("error loading CA certificates");
+            goto error;
+        }
+    }
+
+    if (PyObject_IsTrue(verify)) {
+        SSL_CTX_set_verify(ctx, server_side ? SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT : SSL_VERIFY_PEER, NULL);
+    } else {
+        SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, NULL);
+    }
+
+    if (ciphers && SSL_CTX_set_cipher_list(ctx, ciphers) != 1) {
+        set_tls_exception("error setting cipher list");
+        goto error;
+    }
+
+    if (server_side) {
+        /* Sessions are cached by OpenSSL itself (session IDs) and tickets are enabled by default */
+        SSL_CTX_set_session_id_context(ctx, (const unsigned char *)"pyuv", 4);
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+    } else {
+        /* Client sessions are cached per server_hostname in the context */
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb(ctx, tls_new_session_cb);
+    }
+
+    self->sessions = PyDict_New();
+    if (!self->sessions) {
+        goto error;
+    }
+
+    self->ctx = ctx;
+    self->server_side = server_side;
+
+    return 0;
+
+error:
+    SSL_CTX_free(ctx);
+    return -1;
+}
+
+
+static PyObject *
+TLSContext_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    TLSContext *self = (TLSContext *)PyType_GenericNew(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+    self->ctx = NULL;
+    return (PyObject *)self;
+}
+
+
+static int
+TLSContext_tp_traverse(TLSContext *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->sessions);
+    return 0;
+}
+
+
+static int
+TLSContext_tp_clear(TLSContext *self)
+{
+    Py_CLEAR(self->sessions);
+    return 0;
+}
+
+
+static void
+TLSContext_tp_dealloc(TLSContext *self)
+{
+    TLSContext_tp_clear(self);
+    if (self->ctx) {
+        SSL_CTX_free(self->ctx);
+        self->ctx = NULL;
+    }
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+
+static PyMethodDef
+TLSContext_tp_methods[] = {
+    { "clear_sessions", (PyCFunction)TLSContext_func_clear_sessions, METH_NOARGS, "Forget all cached client sessions." },
+    { NULL }
+};
+
+
+static PyMemberDef TLSContext_tp_members[] = {
+    {"server_side", T_INT, offsetof(TLSContext, server_side), READONLY, "Indicates if this context is used for the server side."},
+    {NULL}
+};
+
+
+static PyTypeObject TLSContextType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv.TLSContext",                                              /*tp_name*/
+    sizeof(TLSContext),                                             /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    (destructor)TLSContext_tp_dealloc,                              /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    0,                                                              /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,                        /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)TLSContext_tp_traverse,                           /*tp_traverse*/
+    (inquiry)TLSContext_tp_clear,                                   /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    0,                                                              /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    TLSContext_tp_methods,                                          /*tp_methods*/
+    TLSContext_tp_members,                                          /*tp_members*/
+    0,                                                              /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    (initproc)TLSContext_tp_init,                                   /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    TLSContext_tp_new,                                              /*tp_new*/
+};
+
+
+/* TLSStream */
+
+static void
+on_tls_write(uv_write_t* req, int status)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    tls_write_data_t *req_data;
+    TLSStream *self;
+    PyObject *callback, *result, *py_errorno;
+    uv_err_t err;
+
+    ASSERT(req);
+
+    req_data = (tls_write_data_t *)req->data;
+    self = req_data->tls;
+    callback = req_data->callback;
+
+    ASSERT(self);
+
+    if (status < 0) {
+        handle_stats_error((Handle *)self->stream, &self->stream->stats);
+    } else {
+        handle_stats_write((Handle *)self->stream, &self->stream->stats, req_data->buf.len);
+    }
+
+    if (callback != Py_None) {
+        if (status < 0) {
+            err = uv_last_error(UV_HANDLE_LOOP(self->stream));
+            py_errorno = pyuv_error_code(err.code);
+        } else {
+            py_errorno = Py_None;
+            Py_INCREF(Py_None);
+        }
+        result = pyuv_callback("write", callback, self, py_errorno, NULL);
+        if (result == NULL) {
+            PyErr_WriteUnraisable(callback);
+        }
+        Py_XDECREF(result);
+        Py_DECREF(py_errorno);
+    }
+
+    Py_DECREF(callback);
+    PyMem_Free(req_data->buf.base);
+    PyMem_Free(req_data);
+    PyMem_Free(req);
+
+    /* Refcount was increased in tls_flush */
+    Py_DECREF(self);
+    PyGILState_Release(gstate);
+}
+
+
+/* Write all pending ciphertext to the underlying stream. The callback is called once it has been written. */
+static int
+tls_flush(TLSStream *self, PyObject *callback)
+{
+    int r;
+    size_t pending;
+    char *data;
+    uv_write_t *wr = NULL;
+    tls_write_data_t *req_data = NULL;
+
+    pending = BIO_ctrl_pending(self->wbio);
+    if (pending == 0 && callback == Py_None) {
+        return 0;
+    }
+
+    /* If there is nothing to write but a callback was given an empty write is issued */
+    data = PyMem_Malloc(pending > 0 ? pending : 1);
+    if (!data) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    if (pending > 0 && BIO_read(self->wbio, data, (int)pending) != (int)pending) {
+        PyMem_Free(data);
+        set_tls_exception("error reading from memory BIO");
+        return -1;
+    }
+
+    wr = (uv_write_t *)PyMem_Malloc(sizeof(uv_write_t));
+    if (!wr) {
+        PyErr_NoMemory();
+        goto error;
+    }
+
+    req_data = (tls_write_data_t *)PyMem_Malloc(sizeof(tls_write_data_t));
+    if (!req_data) {
+        PyErr_NoMemory();
+        goto error;
+    }
+
+    Py_INCREF(callback);
+    req_data->tls = self;
+    req_data->callback = callback;
+    req_data->buf = uv_buf_init(data, pending);
+    wr->data = (void *)req_data;
+
+    r = uv_write(wr, (uv_stream_t *)UV_HANDLE(self->stream), &req_data->buf, 1, on_tls_write);
+    if (r != 0) {
+        RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self->stream), PyExc_TLSError);
+        Py_DECREF(callback);
+        goto error;
+    }
+
+    handle_stats_queued((Handle *)self->stream, &self->stream->stats, ((uv_stream_t *)UV_HANDLE(self->stream))->write_queue_size);
+
+    /* Keep the object alive until the write is completed */
+    Py_INCREF(self);
+    return 0;
+
+error:
+    PyMem_Free(data);
+    if (req_data) {
+        PyMem_Free(req_data);
+    }
+    if (wr) {
+        PyMem_Free(wr);
+    }
+    return -1;
+}
+
+
+/* Encrypt the given plaintext and write it to the underlying stream */
+static int
+tls_write(TLSStream *self, const char *data, Py_ssize_t len, PyObject *callback)
+{
+    int r;
+    Py_ssize_t offset;
+
+    offset = 0;
+    while (offset < len) {
+        r = SSL_write(self->ssl, data + offset, (int)(len - offset));
+        if (r <= 0) {
+            set_tls_exception("error encrypting data");
+            return -1;
+        }
+        offset += r;
+    }
+
+    return tls_flush(self, callback);
+}
+
+
+static void
+tls_call_handshake_cb(TLSStream *self, PyObject *py_errorno)
+{
+    PyObject *callback, *result;
+
+    callback = self->on_handshake_cb;
+    if (!callback) {
+        return;
+    }
+    self->on_handshake_cb = NULL;
+
+    result = pyuv_callback("handshake", callback, self, py_errorno, NULL);
+    if (result == NULL) {
+        PyErr_WriteUnraisable(callback);
+    }
+    Py_XDECREF(result);
+    Py_DECREF(callback);
+}
+
+
+static void
+tls_call_read_cb(TLSStream *self, PyObject *data, PyObject *py_errorno)
+{
+    PyObject *callback, *result;
+
+    callback = self->on_read_cb;
+    if (!callback) {
+        return;
+    }
+    Py_INCREF(callback);
+
+    result = pyuv_callback("read", callback, self, data, py_errorno, NULL);
+    if (result == NULL) {
+        PyErr_WriteUnraisable(callback);
+    }
+    Py_XDECREF(result);
+    Py_DECREF(callback);
+}
+
+
+/* Flush or fail the writes which were queued while the handshake was in progress */
+static void
+tls_process_pending_writes(TLSStream *self, PyObject *py_errorno)
+{
+    Py_ssize_t i;
+    PyObject *pending, *item, *data, *callback, *result, *write_errorno;
+
+    pending = self->pending_writes;
+    self->pending_writes = PyList_New(0);
+    if (!self->pending_writes) {
+        self->pending_writes = pending;
+        PyErr_WriteUnraisable((PyObject *)self);
+        return;
+    }
+
+    for (i = 0; i < PyList_GET_SIZE(pending); i++) {
+        item = PyList_GET_ITEM(pending, i);
+        data = PyTuple_GET_ITEM(item, 0);
+        callback = PyTuple_GET_ITEM(item, 1);
+        if (py_errorno == Py_None) {
+            if (tls_write(self, PyString_AS_STRING(data), PyString_GET_SIZE(data), callback) == 0) {
+                continue;
+            }
+            PyErr_WriteUnraisable((PyObject *)self);
+        }
+        if (callback != Py_None) {
+            if (py_errorno == Py_None) {
+                write_errorno = pyuv_error_code(UV_EPROTO);
+            } else {
+                write_errorno = py_errorno;
+                Py_INCREF(py_errorno);
+            }
+            result = pyuv_callback("write", callback, self, write_errorno, NULL);
+            if (result == NULL) {
+                PyErr_WriteUnraisable(callback);
+            }
+            Py_XDECREF(result);
+            Py_XDECREF(write_errorno);
+        }
+    }
+
+    Py_DECREF(pending);
+}
+
+
+/* Decrypt all available records and deliver them as a single chunk */
+static void
+tls_read_plaintext(TLSStream *self)
+{
+    int r, err;
+    Py_ssize_t size, offset;
+    PyObject *data, *py_errorno;
+
+    size = 16384;
+    offset = 0;
+    data = PyString_FromStringAndSize(NULL, size);
+    if (!data) {
+        PyErr_WriteUnraisable((PyObject *)self);
+        return;
+    }
+
+    py_errorno = NULL;
+    while (1) {
+        if (offset == size) {
+            size *= 2;
+            if (_PyBytes_Resize(&data, size) < 0) {
+                PyErr_WriteUnraisable((PyObject *)self);
+                return;
+            }
+        }
+        r = SSL_read(self->ssl, PyString_AS_STRING(data) + offset, (int)(size - offset));
+        if (r > 0) {
+            offset += r;
+            continue;
+        }
+        err = SSL_get_error(self->ssl, r);
+        if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+            break;
+        } else if (err == SSL_ERROR_ZERO_RETURN) {
+            py_errorno = pyuv_error_code(UV_EOF);
+        } else {
+            py_errorno = pyuv_error_code(UV_EPROTO);
+        }
+        ERR_clear_error();
+        break;
+    }
+
+    /* SSL_read may have produced records (alerts, key updates) which need to be sent */
+    if (tls_flush(self, Py_None) != 0) {
+        PyErr_WriteUnraisable((PyObject *)self);
+    }
+
+    if (offset > 0) {
+        if (_PyBytes_Resize(&data, offset) < 0) {
+            PyErr_WriteUnraisable((PyObject *)self);
+        } else {
+            tls_call_read_cb(self, data, Py_None);
+        }
+    }
+    Py_XDECREF(data);
+
+    if (py_errorno) {
+        tls_call_read_cb(self, Py_None, py_errorno);
+        Py_DECREF(py_errorno);
+    }
+}
+
+
+static void
+tls_do_handshake(TLSStream *self)
+{
+    int r, err;
+    PyObject *py_errorno;
+
+    r = SSL_do_handshake(self->ssl);
+    if (tls_flush(self, Py_None) != 0) {
+        PyErr_WriteUnraisable((PyObject *)self);
+    }
+
+    if (r == 1) {
+        self->handshake_done = True;
+        tls_call_handshake_cb(self, Py_None);
+        tls_process_pending_writes(self, Py_None);
+        return;
+    }
+
+    err = SSL_get_error(self->ssl, r);
+    if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+        return;
+    }
+
+    ERR_clear_error();
+    py_errorno = pyuv_error_code(UV_EPROTO);
+    tls_call_handshake_cb(self, py_errorno);
+    tls_process_pending_writes(self, py_errorno);
+    Py_DECREF(py_errorno);
+}
+
+
+static uv_buf_t
+on_tls_alloc(uv_stream_t* handle, size_t suggested_size)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    uv_buf_t buf = uv_buf_init(PyMem_Malloc(suggested_size), suggested_size);
+    UNUSED_ARG(handle);
+    PyGILState_Release(gstate);
+    return buf;
+}
+
+
+static void
+on_tls_read(uv_stream_t* handle, int nread, uv_buf_t buf)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    uv_err_t err;
+    Stream *stream;
+    TLSStream *self;
+    PyObject *py_errorno;
+
+    ASSERT(handle);
+
+    stream = (Stream *)handle->data;
+    ASSERT(stream);
+    self = (TLSStream *)stream->layer;
+    ASSERT(self);
+    /* Object could go out of scope in the callback, increase refcount to avoid it */
+    Py_INCREF(self);
+
+    stream_stats_read(stream, nread);
+
+    if (nread > 0) {
+        BIO_write(self->rbio, buf.base, nread);
+    }
+
+    /* In case of error libuv may not call alloc_cb */
+    if (buf.base != NULL) {
+        PyMem_Free(buf.base);
+    }
+
+    if (nread < 0) {
+        err = uv_last_error(UV_HANDLE_LOOP(stream));
+        py_errorno = pyuv_error_code(err.code);
+        if (!self->handshake_done) {
+            tls_call_handshake_cb(self, py_errorno);
+            tls_process_pending_writes(self, py_errorno);
+        } else {
+            tls_call_read_cb(self, Py_None, py_errorno);
+        }
+        Py_DECREF(py_errorno);
+    } else if (nread > 0) {
+        if (!self->handshake_done) {
+            tls_do_handshake(self);
+        }
+        /* the handshake callback may have started reading already */
+        if (self->handshake_done && self->on_read_cb) {
+            tls_read_plaintext(self);
+        }
+    }
+
+    Py_DECREF(self);
+    PyGILState_Release(gstate);
+}
+
+
+static void
+on_tls_shutdown(uv_shutdown_t* req, int status)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    uv_err_t err;
+    TLSStream *self;
+    PyObject *callback, *result, *py_errorno;
+
+    self = (TLSStream *)req->data;
+    callback = ((tls_shutdown_req_t *)req)->callback;
+
+    ASSERT(self);
+    Py_INCREF(self);
+
+    if (callback != Py_None) {
+        if (status < 0) {
+            err = uv_last_error(req->handle->loop);
+            py_errorno = pyuv_error_code(err.code);
+        } else {
+            py_errorno = Py_None;
+            Py_INCREF(Py_None);
+        }
+        result = pyuv_callback("shutdown", callback, self, py_errorno, NULL);
+        if (result == NULL) {
+            PyErr_WriteUnraisable(callback);
+        }
+        Py_XDECREF(result);
+        Py_DECREF(py_errorno);
+    }
+
+    Py_DECREF(callback);
+    PyMem_Free(req);
+
+    /* Refcount was increased in func_shutdown */
+    Py_DECREF(self);
+
+    Py_DECREF(self);
+    PyGILState_Release(gstate);
+}
+
+
+static PyObject *
+TLSStream_func_do_handshake(TLSStream *self, PyObject *args)
+{
+    int r;
+    PyObject *callback;
+
+    RAISE_IF_TLS_NOT_INITIALIZED(self, ssl, NULL);
+    RAISE_IF_HANDLE_CLOSED(self->stream, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTuple(args, "O:do_handshake", &callback)) {
+        return NULL;
+    }
+
+    if (!PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+
+    if (self->handshake_done || self->on_handshake_cb) {
+        PyErr_SetString(PyExc_TLSError, "handshake already started");
+        return NULL;
+    }
+
+    r = uv_read_start((uv_stream_t *)UV_HANDLE(self->stream), (uv_alloc_cb)on_tls_alloc, (uv_read_cb)on_tls_read);
+    if (r != 0) {
+        RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self->stream), PyExc_TLSError);
+        return NULL;
+    }
+
+    Py_INCREF(callback);
+    self->on_handshake_cb = callback;
+
+    /* The client sends the first flight right away, the server just waits for it */
+    if (!self->context->server_side) {
+        tls_do_handshake(self);
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+TLSStream_func_start_read(TLSStream *self, PyObject *args)
+{
+    int r;
+    PyObject *tmp, *callback;
+
+    RAISE_IF_TLS_NOT_INITIALIZED(self, ssl, NULL);
+    RAISE_IF_HANDLE_CLOSED(self->stream, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTuple(args, "O:start_read", &callback)) {
+        return NULL;
+    }
+
+    if (!PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return NULL;
+    }
+
+    r = uv_read_start((uv_stream_t *)UV_HANDLE(self->stream), (uv_alloc_cb)on_tls_alloc, (uv_read_cb)on_tls_read);
+    if (r != 0) {
+        RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self->stream), PyExc_TLSError);
+        return NULL;
+    }
+
+    tmp = self->on_read_cb;
+    Py_INCREF(callback);
+    self->on_read_cb = callback;
+    Py_XDECREF(tmp);
+
+    /* OpenSSL may already have decrypted records (or have the ciphertext for them) buffered,
+     * more data may never arrive to trigger reading them */
+    if (self->handshake_done && (SSL_pending(self->ssl) > 0 || BIO_ctrl_pending(self->rbio) > 0)) {
+        Py_INCREF(self);
+        tls_read_plaintext(self);
+        Py_DECREF(self);
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+TLSStream_func_stop_read(TLSStream *self)
+{
+    int r;
+
+    RAISE_IF_TLS_NOT_INITIALIZED(self, ssl, NULL);
+    RAISE_IF_HANDLE_CLOSED(self->stream, PyExc_HandleClosedError, NULL);
+
+    r = uv_read_stop((uv_stream_t *)UV_HANDLE(self->stream));
+    if (r != 0) {
+        RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self->stream), PyExc_TLSError);
+        return NULL;
+    }
+
+    Py_CLEAR(self->on_read_cb);
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+TLSStream_func_write(TLSStream *self, PyObject *args)
+{
+    int r;
+    Py_buffer pbuf;
+    PyObject *callback, *data, *item;
+
+    callback = Py_None;
+
+    RAISE_IF_TLS_NOT_INITIALIZED(self, ssl, NULL);
+    RAISE_IF_HANDLE_CLOSED(self->stream, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTuple(args, "s*|O:write", &pbuf, &callback)) {
+        return NULL;
+    }
+
+    if (callback != Py_None && !PyCallable_Check(callback)) {
+        PyBuffer_Release(&pbuf);
+        PyErr_SetString(PyExc_TypeError, "a callable or None is required");
+        return NULL;
+    }
+
+    if (!self->handshake_done) {
+        /* Keep a copy of the data until the handshake is completed */
+        data = PyString_FromStringAndSize(pbuf.buf, pbuf.len);
+        PyBuffer_Release(&pbuf);
+        if (!data) {
+            return NULL;
+        }
+        item = PyTuple_Pack(2, data, callback);
+        Py_DECREF(data);
+        if (!item) {
+            return NULL;
+        }
+        r = PyList_Append(self->pending_writes, item);
+        Py_DECREF(item);
+        if (r != 0) {
+            return NULL;
+        }
+        Py_RETURN_NONE;
+    }
+
+    r = tls_write(self, pbuf.buf, pbuf.len, callback);
+    PyBuffer_Release(&pbuf);
+    if (r != 0) {
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+TLSStream_func_shutdown(TLSStream *self, PyObject *args)
+{
+    int r;
+    tls_shutdown_req_t *req = NULL;
+    PyObject *callback = Py_None;
+
+    RAISE_IF_TLS_NOT_INITIALIZED(self, ssl, NULL);
+    RAISE_IF_HANDLE_CLOSED(self->stream, PyExc_HandleClosedError, NULL);
+
+    if (!PyArg_ParseTuple(args, "|O:shutdown", &callback)) {
+        return NULL;
+    }
+
+    if (callback != Py_None && !PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "a callable or None is required");
+        return NULL;
+    }
+
+    /* Send close_notify, we don't wait for the peer's */
+    if (self->handshake_done) {
+        SSL_shutdown(self->ssl);
+        ERR_clear_error();
+        if (tls_flush(self, Py_None) != 0) {
+            return NULL;
+        }
+    }
+
+    req = (tls_shutdown_req_t *)PyMem_Malloc(sizeof(tls_shutdown_req_t));
+    if (!req) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+
+    Py_INCREF(callback);
+    req->callback = callback;
+    req->req.data = (void *)self;
+
+    r = uv_shutdown(&req->req, (uv_stream_t *)UV_HANDLE(self->stream), on_tls_shutdown);
+    if (r != 0) {
+        RAISE_UV_EXCEPTION(UV_HANDLE_LOOP(self->stream), PyExc_TLSError);
+        Py_DECREF(callback);
+        PyMem_Free(req);
+        return NULL;
+    }
+
+    /* Keep the object alive until the shutdown is completed */
+    Py_INCREF(self);
+
+    Py_RETURN_NONE;
+}
+
+
+/* Certificate names as tuples of relative distinguished names, like the ssl module */
+static PyObject *
+tls_name_to_tuple(X509_NAME *name)
+{
+    int i, n, len;
+    char buf[128];
+    unsigned char *value;
+    X509_NAME_ENTRY *entry;
+    ASN1_OBJECT *obj;
+    PyObject *result, *item;
+
+    n = X509_NAME_entry_count(name);
+    result = PyTuple_New(n);
+    if (!result) {
+        return NULL;
+    }
+
+    for (i = 0; i < n; i++) {
+        entry = X509_NAME_get_entry(name, i);
+        obj = X509_NAME_ENTRY_get_object(entry);
+        if (OBJ_obj2nid(obj) != NID_undef) {
+            strncpy(buf, OBJ_nid2ln(OBJ_obj2nid(obj)), sizeof(buf) - 1);
+            buf[sizeof(buf) - 1] = '\0';
+        } else {
+            OBJ_obj2txt(buf, sizeof(buf), obj, 1);
+        }
+        len = ASN1_STRING_to_UTF8(&value, X509_NAME_ENTRY_get_data(entry));
+        if (len < 0) {
+            set_tls_exception("error decoding certificate name");
+            Py_DECREF(result);
+            return NULL;
+        }
+        item = Py_BuildValue("((ss#))", buf, (const char *)value, (Py_ssize_t)len);
+        OPENSSL_free(value);
+        if (!item) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(result, i, item);
+    }
+
+    return result;
+}
+
+
+static PyObject *
+tls_alt_names_to_tuple(X509 *cert)
+{
+    int i, j;
+    char buf[64];
+    const unsigned char *ip;
+    GENERAL_NAME *gn;
+    GENERAL_NAMES *names;
+    PyObject *result, *item;
+
+    result = PyList_New(0);
+    if (!result) {
+        return NULL;
+    }
+
+    names = X509_get_ext_d2i(cert, NID_subject_alt_name, NULL, NULL);
+    for (i = 0; names && i < sk_GENERAL_NAME_num(names); i++) {
+        gn = sk_GENERAL_NAME_value(names, i);
+        switch (gn->type) {
+            case GEN_DNS:
+                item = Py_BuildValue("(ss#)", "DNS", (const char *)ASN1_STRING_get0_data(gn->d.dNSName), (Py_ssize_t)ASN1_STRING_length(gn->d.dNSName));
+                break;
+            case GEN_EMAIL:
+                item = Py_BuildValue("(ss#)", "email", (const char *)ASN1_STRING_get0_data(gn->d.rfc822Name), (Py_ssize_t)ASN1_STRING_length(gn->d.rfc822Name));
+                break;
+            case GEN_URI:
+                item = Py_BuildValue("(ss#)", "URI", (const char *)ASN1_STRING_get0_data(gn->d.uniformResourceIdentifier), (Py_ssize_t)ASN1_STRING_length(gn->d.uniformResourceIdentifier));
+                break;
+            case GEN_IPADD:
+                ip = ASN1_STRING_get0_data(gn->d.iPAddress);
+                if (ASN1_STRING_length(gn->d.iPAddress) == 4) {
+                    PyOS_snprintf(buf, sizeof(buf), "%d.%d.%d.%d", ip[0], ip[1], ip[2], ip[3]);
+                } else if (ASN1_STRING_length(gn->d.iPAddress) == 16) {
+                    buf[0] = '\0';
+                    for (j = 0; j < 16; j += 2) {
+                        PyOS_snprintf(buf + strlen(buf), sizeof(buf) - strlen(buf), j ? ":%X" : "%X", (ip[j] << 8) | ip[j+1]);
+                    }
+                } else {
+                    strcpy(buf, "<invalid>");
+                }
+                item = Py_BuildValue("(ss)", "IP Address", buf);
+                break;
+            default:
+                continue;
+        }
+        if (!item || PyList_Append(result, item) != 0) {
+            Py_XDECREF(item);
+            Py_DECREF(result);
+            result = NULL;
+            break;
+        }
+        Py_DECREF(item);
+    }
+    GENERAL_NAMES_free(names);
+
+    if (!result) {
+        return NULL;
+    }
+    item = PyList_AsTuple(result);
+    Py_DECREF(result);
+    return item;
+}
+
+
+static PyObject *
+tls_bio_to_string(BIO *bio)
+{
+    char *data;
+    long len;
+
+    len = BIO_get_mem_data(bio, &data);
+    return PYUVString_FromStringAndSize(data, (Py_ssize_t)len);
+}
+
+
+static PyObject *
+tls_cert_to_dict(X509 *cert)
+{
+    int r;
+    BIO *bio;
+    PyObject *dict, *value;
+
+    dict = PyDict_New();
+    bio = BIO_new(BIO_s_mem());
+    if (!dict || !bio) {
+        if (!bio) {
+            set_tls_exception("error creating memory BIO");
+        }
+        goto error;
+    }
+
+#define TLS_CERT_SET(key, expr)                                 \
+    value = (expr);                                             \
+    if (!value) {                                               \
+        goto error;                                             \
+    }                                                           \
+    r = PyDict_SetItemString(dict, key, value);                 \
+    Py_DECREF(value);                                           \
+    if (r != 0) {                                               \
+        goto error;                                             \
+    }
+
+    TLS_CERT_SET("subject", tls_name_to_tuple(X509_get_subject_name(cert)));
+    TLS_CERT_SET("issuer", tls_name_to_tuple(X509_get_issuer_name(cert)));
+    TLS_CERT_SET("version", PyInt_FromLong(X509_get_version(cert) + 1));
+    TLS_CERT_SET("subjectAltName", tls_alt_names_to_tuple(cert));
+
+    i2a_ASN1_INTEGER(bio, X509_get_serialNumber(cert));
+    TLS_CERT_SET("serialNumber", tls_bio_to_string(bio));
+    (void)BIO_reset(bio);
+    ASN1_TIME_print(bio, X509_get_notBefore(cert));
+    TLS_CERT_SET("notBefore", tls_bio_to_string(bio));
+    (void)BIO_reset(bio);
+    ASN1_TIME_print(bio, X509_get_notAfter(cert));
+    TLS_CERT_SET("notAfter", tls_bio_to_string(bio));
+
+#undef TLS_CERT_SET
+
+    BIO_free(bio);
+    return dict;
+
+error:
+    if (bio) {
+        BIO_free(bio);
+    }
+    Py_XDECREF(dict);
+    return NULL;
+}
+
+
+static PyObject *
+TLSStream_func_getpeercert(TLSStream *self, PyObject *args)
+{
+    int len;
+    unsigned char *der;
+    X509 *cert;
+    PyObject *binary_form, *result;
+
+    binary_form = Py_False;
+
+    RAISE_IF_TLS_NOT_INITIALIZED(self, ssl, NULL);
+
+    if (!PyArg_ParseTuple(args, "|O:getpeercert", &binary_form)) {
+        return NULL;
+    }
+
+    if (!self->handshake_done) {
+        PyErr_SetString(PyExc_TLSError, "handshake not done yet");
+        return NULL;
+    }
+
+    cert = SSL_get_peer_certificate(self->ssl);
+    if (!cert) {
+        Py_RETURN_NONE;
+    }
+
+    if (PyObject_IsTrue(binary_form)) {
+        der = NULL;
+        len = i2d_X509(cert, &der);
+        if (len < 0) {
+            set_tls_exception("error encoding the certificate");
+            result = NULL;
+        } else {
+            result = PyString_FromStringAndSize((const char *)der, len);
+            OPENSSL_free(der);
+        }
+    } else {
+        result = tls_cert_to_dict(cert);
+    }
+
+    X509_free(cert);
+    return result;
+}
+
+
+static PyObject *
+TLSStream_handshake_done_get(TLSStream *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    return PyBool_FromLong((long)self->handshake_done);
+}
+
+
+static PyObject *
+TLSStream_session_reused_get(TLSStream *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    RAISE_IF_TLS_NOT_INITIALIZED(self, ssl, NULL);
+    return PyBool_FromLong((long)SSL_session_reused(self->ssl));
+}
+
+
+static PyObject *
+TLSStream_cipher_get(TLSStream *self, void *closure)
+{
+    const char *name;
+
+    UNUSED_ARG(closure);
+
+    if (!self->handshake_done) {
+        Py_RETURN_NONE;
+    }
+    name = SSL_get_cipher_name(self->ssl);
+    if (!name) {
+        Py_RETURN_NONE;
+    }
+    return PYUVString_FromString(name);
+}
+
+
+static PyObject *
+TLSStream_version_get(TLSStream *self, void *closure)
+{
+    UNUSED_ARG(closure);
+
+    if (!self->handshake_done) {
+        Py_RETURN_NONE;
+    }
+    return PYUVString_FromString(SSL_get_version(self->ssl));
+}
+
+
+static int
+TLSStream_tp_init(TLSStream *self, PyObject *args, PyObject *kwargs)
+{
+    const char *hostname;
+    Stream *stream;
+    TLSContext *context;
+    X509_VERIFY_PARAM *param;
+    PyObject *server_hostname, *session, *tmp;
+
+    static char *kwlist[] = {"stream", "context", "server_hostname", NULL};
+
+    server_hostname = Py_None;
+
+    if (self->ssl) {
+        PyErr_SetString(PyExc_TLSError, "Object already initialized");
+        return -1;
+    }
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!O!|O:__init__", kwlist, &StreamType, &stream, &TLSContextType, &context, &server_hostname)) {
+        return -1;
+    }
+
+    RAISE_IF_HANDLE_CLOSED(stream, PyExc_HandleClosedError, -1);
+
+    if (!context->ctx) {
+        PyErr_SetString(PyExc_TLSError, "context is not initialized");
+        return -1;
+    }
+
+    if (stream->layer) {
+        PyErr_SetString(PyExc_TLSError, "stream is already in use by another layer");
+        return -1;
+    }
+
+    if (server_hostname == Py_None && !context->server_side && SSL_CTX_get_verify_mode(context->ctx) != SSL_VERIFY_NONE) {
+        PyErr_SetString(PyExc_TLSError, "server_hostname is required to verify the server certificate");
+        return -1;
+    }
+
+    if (server_hostname != Py_None) {
+#ifdef PYUV_PYTHON3
+        if (!PyUnicode_Check(server_hostname)) {
+#else
+        if (!PyString_Check(server_hostname)) {
+#endif
+            PyErr_SetString(PyExc_TypeError, "server_hostname must be a string or None");
+            return -1;
+        }
+    }
+
+    tmp = self->pending_writes;
+    self->pending_writes = PyList_New(0);
+    Py_XDECREF(tmp);
+    if (!self->pending_writes) {
+        return -1;
+    }
+
+    self->ssl = SSL_new(context->ctx);
+    if (!self->ssl) {
+        set_tls_exception("error creating TLS connection");
+        goto error;
+    }
+
+    self->rbio = BIO_new(BIO_s_mem());
+    self->wbio = BIO_new(BIO_s_mem());
+    if (!self->rbio || !self->wbio) {
+        set_tls_exception("error creating memory BIO");
+        goto error;
+    }
+    /* The BIOs are owned by the SSL object after this */
+    SSL_set_bio(self->ssl, self->rbio, self->wbio);
+    SSL_set_app_data(self->ssl, (char *)self);
+
+    if (context->server_side) {
+        SSL_set_accept_state(self->ssl);
+    } else {
+        SSL_set_connect_state(self->ssl);
+        if (server_hostname != Py_None) {
+#ifdef PYUV_PYTHON3
+            hostname = PyUnicode_AsUTF8(server_hostname);
+#else
+            hostname = PyString_AsString(server_hostname);
+#endif
+            if (!hostname) {
+                goto error;
+            }
+            SSL_set_tlsext_host_name(self->ssl, hostname);
+            /* the certificate must be valid for the server we wanted to talk to */
+            param = SSL_get0_param(self->ssl);
+            X509_VERIFY_PARAM_set_hostflags(param, X509_CHECK_FLAG_NO_PARTIAL_WILDCARDS);
+            if (X509_VERIFY_PARAM_set1_ip_asc(param, hostname) != 1 && X509_VERIFY_PARAM_set1_host(param, hostname, 0) != 1) {
+                set_tls_exception("error setting the host name to verify");
+                goto error;
+            }
+            /* Try to resume a previous session with this server */
+            session = PyDict_GetItem(context->sessions, server_hostname);
+            if (session) {
+                SSL_set_session(self->ssl, (SSL_SESSION *)PyCapsule_GetPointer(session, NULL));
+            }
+        }
+    }
+
+    Py_INCREF(stream);
+    self->stream = stream;
+    Py_INCREF(context);
+    self->context = context;
+    Py_INCREF(server_hostname);
+    self->server_hostname = server_hostname;
+
+    /* The stream keeps the TLS layer alive for as long as it exists */
+    Py_INCREF(self);
+    stream->layer = (PyObject *)self;
+
+    return 0;
+
+error:
+    if (self->rbio && !SSL_get_rbio(self->ssl)) {
+        BIO_free(self->rbio);
+    }
+    if (self->wbio && !SSL_get_wbio(self->ssl)) {
+        BIO_free(self->wbio);
+    }
+    self->rbio = self->wbio = NULL;
+    SSL_free(self->ssl);
+    self->ssl = NULL;
+    Py_CLEAR(self->pending_writes);
+    return -1;
+}
+
+
+static PyObject *
+TLSStream_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    TLSStream *self = (TLSStream *)PyType_GenericNew(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+    self->ssl = NULL;
+    self->weakreflist = NULL;
+    self->handshake_done = False;
+    return (PyObject *)self;
+}
+
+
+static int
+TLSStream_tp_traverse(TLSStream *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->stream);
+    Py_VISIT(self->context);
+    Py_VISIT(self->server_hostname);
+    Py_VISIT(self->on_handshake_cb);
+    Py_VISIT(self->on_read_cb);
+    Py_VISIT(self->pending_writes);
+    return 0;
+}
+
+
+static int
+TLSStream_tp_clear(TLSStream *self)
+{
+    Py_CLEAR(self->stream);
+    Py_CLEAR(self->context);
+    Py_CLEAR(self->server_hostname);
+    Py_CLEAR(self->on_handshake_cb);
+    Py_CLEAR(self->on_read_cb);
+    Py_CLEAR(self->pending_writes);
+    return 0;
+}
+
+
+static void
+TLSStream_tp_dealloc(TLSStream *self)
+{
+    if (self->weakreflist != NULL) {
+        PyObject_ClearWeakRefs((PyObject *)self);
+    }
+    TLSStream_tp_clear(self);
+    if (self->ssl) {
+        /* frees the BIOs as well */
+        SSL_free(self->ssl);
+        self->ssl = NULL;
+    }
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+
+static PyMethodDef
+TLSStream_tp_methods[] = {
+    { "do_handshake", (PyCFunction)TLSStream_func_do_handshake, METH_VARARGS, "Perform the TLS handshake." },
+    { "start_read", (PyCFunction)TLSStream_func_start_read, METH_VARARGS, "Start reading decrypted data." },
+    { "stop_read", (PyCFunction)TLSStream_func_stop_read, METH_NOARGS, "Stop reading data." },
+    { "write", (PyCFunction)TLSStream_func_write, METH_VARARGS, "Encrypt and write data on the stream." },
+    { "shutdown", (PyCFunction)TLSStream_func_shutdown, METH_VARARGS, "Send a close notification and shutdown the write side of the stream." },
+    { "getpeercert", (PyCFunction)TLSStream_func_getpeercert, METH_VARARGS, "Return the certificate of the peer." },
+    { NULL }
+};
+
+
+static PyMemberDef TLSStream_tp_members[] = {
+    {"stream", T_OBJECT_EX, offsetof(TLSStream, stream), READONLY, "Stream this TLS connection runs on."},
+    {"context", T_OBJECT_EX, offsetof(TLSStream, context), READONLY, "TLSContext used by this connection."},
+    {"server_hostname", T_OBJECT_EX, offsetof(TLSStream, server_hostname), READONLY, "Host name of the server (client side only)."},
+    {NULL}
+};
+
+
+static PyGetSetDef TLSStream_tp_getsets[] = {
+    {"handshake_done", (getter)TLSStream_handshake_done_get, NULL, "Indicates if the handshake has been completed.", NULL},
+    {"session_reused", (getter)TLSStream_session_reused_get, NULL, "Indicates if a previous session was resumed.", NULL},
+    {"cipher", (getter)TLSStream_cipher_get, NULL, "Name of the negotiated cipher.", NULL},
+    {"version", (getter)TLSStream_version_get, NULL, "Negotiated protocol version.", NULL},
+    {NULL}
+};
+
+
+static PyTypeObject TLSStreamType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv.TLSStream",                                               /*tp_name*/
+    sizeof(TLSStream),                                              /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    (destructor)TLSStream_tp_dealloc,                               /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    0,                                                              /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,                        /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)TLSStream_tp_traverse,                            /*tp_traverse*/
+    (inquiry)TLSStream_tp_clear,                                    /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    offsetof(TLSStream, weakreflist),                               /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    TLSStream_tp_methods,                                           /*tp_methods*/
+    TLSStream_tp_members,                                           /*tp_members*/
+    TLSStream_tp_getsets,                                           /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    (initproc)TLSStream_tp_init,                                    /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    TLSStream_tp_new,                                               /*tp_new*/
+};
+
+#endif
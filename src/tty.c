@@ -109,6 +109,7 @@ TTY_tp_init(TTY *self, PyObject *args, PyObject *kwargs)
     }
     uv_tty->data = (void *)self;
     UV_HANDLE(self) = (uv_handle_t *)uv_tty;
+    PYUV_PROBE2(handle__init, self, Py_TYPE(self)->tp_name);
 
     return 0;
 }
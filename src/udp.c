@@ -4,6 +4,7 @@ typedef struct {
     uv_buf_t *bufs;
     int buf_count;
     Py_buffer view;
+    size_t nbytes;
 } udp_send_data_t;
 
 
@@ -42,6 +43,12 @@ on_udp_read(uv_udp_t* handle, int nread, uv_buf_t buf, struct sockaddr* addr, un
         goto done;
     }
 
+    if (nread > 0) {
+        handle_stats_read((Handle *)self, &self->stats, nread);
+    } else {
+        handle_stats_error((Handle *)self, &self->stats);
+    }
+
     if (nread > 0) {
         ASSERT(addr);
         if (addr->sa_family == AF_INET) {
@@ -62,10 +69,10 @@ on_udp_read(uv_udp_t* handle, int nread, uv_buf_t buf, struct sockaddr* addr, un
         data = Py_None;
         Py_INCREF(Py_None);
         err = uv_last_error(UV_HANDLE_LOOP(self));
-        py_errorno = PyInt_FromLong((long)err.code);
+        py_errorno = pyuv_error_code(err.code);
     }
 
-    result = PyObject_CallFunctionObjArgs(self->on_read_cb, self, address_tuple, data, py_errorno, NULL);
+    result = pyuv_callback("read", self->on_read_cb, self, address_tuple, data, py_errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(self->on_read_cb);
     }
@@ -105,15 +112,22 @@ on_udp_send(uv_udp_send_t* req, int status)
     /* Object could go out of scope in the callback, increase refcount to avoid it */
     Py_INCREF(self);
 
+    self->send_queue_size -= req_data->nbytes;
+    if (status < 0) {
+        handle_stats_error((Handle *)self, &self->stats);
+    } else {
+        handle_stats_write((Handle *)self, &self->stats, req_data->nbytes);
+    }
+
     if (callback != Py_None) {
         if (status < 0) {
             uv_err_t err = uv_last_error(UV_HANDLE_LOOP(self));
-            py_errorno = PyInt_FromLong((long)err.code);
+            py_errorno = pyuv_error_code(err.code);
         } else {
             py_errorno = Py_None;
             Py_INCREF(Py_None);
         }
-        result = PyObject_CallFunctionObjArgs(callback, self, py_errorno, NULL);
+        result = pyuv_callback("send", callback, self, py_errorno, NULL);
         if (result == NULL) {
             PyErr_WriteUnraisable(callback);
         }
@@ -295,6 +309,7 @@ UDP_func_send(UDP *self, PyObject *args)
     req_data->bufs = &buf;
     req_data->buf_count = 1;
     req_data->view = pbuf;
+    req_data->nbytes = pbuf.len;
 
     wr->data = (void *)req_data;
 
@@ -308,6 +323,10 @@ UDP_func_send(UDP *self, PyObject *args)
         goto error;
     }
 
+    /* libuv doesn't track the size of the send queue, so it's done here */
+    self->send_queue_size += req_data->nbytes;
+    handle_stats_queued((Handle *)self, &self->stats, self->send_queue_size);
+
     Py_RETURN_NONE;
 
 error:
@@ -385,6 +404,10 @@ UDP_func_sendlines(UDP *self, PyObject *args)
     req_data->callback = callback;
     req_data->bufs = bufs;
     req_data->buf_count = buf_count;
+    req_data->nbytes = 0;
+    for (i = 0; i < buf_count; i++) {
+        req_data->nbytes += bufs[i].len;
+    }
     wr->data = (void *)req_data;
 
     if (address_type == AF_INET) {
@@ -397,6 +420,10 @@ UDP_func_sendlines(UDP *self, PyObject *args)
         goto error;
     }
 
+    /* libuv doesn't track the size of the send queue, so it's done here */
+    self->send_queue_size += req_data->nbytes;
+    handle_stats_queued((Handle *)self, &self->stats, self->send_queue_size);
+
     Py_RETURN_NONE;
 
 error:
@@ -609,6 +636,7 @@ UDP_tp_init(UDP *self, PyObject *args, PyObject *kwargs)
     }
     uv_udp_handle->data = (void *)self;
     UV_HANDLE(self) = (uv_handle_t *)uv_udp_handle;
+    PYUV_PROBE2(handle__init, self, Py_TYPE(self)->tp_name);
 
     return 0;
 }
@@ -643,6 +671,14 @@ UDP_tp_clear(UDP *self)
 }
 
 
+static PyObject *
+UDP_stats_get(UDP *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    return pyuv_handle_stats_result(&self->stats);
+}
+
+
 static PyMethodDef
 UDP_tp_methods[] = {
     { "bind", (PyCFunction)UDP_func_bind, METH_VARARGS, "Bind to the specified IP and port." },
@@ -660,6 +696,12 @@ UDP_tp_methods[] = {
 };
 
 
+static PyGetSetDef UDP_tp_getsets[] = {
+    {"stats", (getter)UDP_stats_get, 0, "Traffic counters.", NULL},
+    {NULL}
+};
+
+
 static PyTypeObject UDPType = {
     PyVarObject_HEAD_INIT(NULL, 0)
     "pyuv.UDP",                                                     /*tp_name*/
@@ -690,7 +732,7 @@ static PyTypeObject UDPType = {
     0,                                                              /*tp_iternext*/
     UDP_tp_methods,                                                 /*tp_methods*/
     0,                                                              /*tp_members*/
-    0,                                                              /*tp_getsets*/
+    UDP_tp_getsets,                                                 /*tp_getsets*/
     0,                                                              /*tp_base*/
     0,                                                              /*tp_dict*/
     0,                                                              /*tp_descr_get*/
@@ -40,7 +40,6 @@ Util_func_uptime(PyObject *obj)
 {
     double uptime;
     uv_err_t err;
-    PyObject *exc_data;
 
     UNUSED_ARG(obj);
 
@@ -48,11 +47,7 @@ Util_func_uptime(PyObject *obj)
     if (err.code == UV_OK) {
         return PyFloat_FromDouble(uptime);
     } else {
-        exc_data = Py_BuildValue("(is)", err.code, uv_strerror(err));
-        if (exc_data != NULL) {
-            PyErr_SetObject(PyExc_UVError, exc_data);
-            Py_DECREF(exc_data);
-        }
+        pyuv_set_uv_exception(err, PyExc_UVError);
         return NULL;
     }
 }
@@ -63,7 +58,6 @@ Util_func_resident_set_memory(PyObject *obj)
 {
     size_t rss;
     uv_err_t err;
-    PyObject *exc_data;
 
     UNUSED_ARG(obj);
 
@@ -71,11 +65,7 @@ Util_func_resident_set_memory(PyObject *obj)
     if (err.code == UV_OK) {
         return PyInt_FromSsize_t(rss);
     } else {
-        exc_data = Py_BuildValue("(is)", err.code, uv_strerror(err));
-        if (exc_data != NULL) {
-            PyErr_SetObject(PyExc_UVError, exc_data);
-            Py_DECREF(exc_data);
-        }
+        pyuv_set_uv_exception(err, PyExc_UVError);
         return NULL;
     }
 }
@@ -88,7 +78,7 @@ Util_func_interface_addresses(PyObject *obj)
     char ip[INET6_ADDRSTRLEN];
     uv_interface_address_t* interfaces;
     uv_err_t err;
-    PyObject *result, *item, *exc_data;
+    PyObject *result, *item;
 
     UNUSED_ARG(obj);
 
@@ -120,11 +110,7 @@ Util_func_interface_addresses(PyObject *obj)
         uv_free_interface_addresses(interfaces, count);
         return result;
     } else {
-        exc_data = Py_BuildValue("(is)", err.code, uv_strerror(err));
-        if (exc_data != NULL) {
-            PyErr_SetObject(PyExc_UVError, exc_data);
-            Py_DECREF(exc_data);
-        }
+        pyuv_set_uv_exception(err, PyExc_UVError);
         return NULL;
     }
 }
@@ -136,7 +122,7 @@ Util_func_cpu_info(PyObject *obj)
     int i, count;
     uv_cpu_info_t* cpus;
     uv_err_t err;
-    PyObject *result, *item, *times, *exc_data;
+    PyObject *result, *item, *times;
 
     UNUSED_ARG(obj);
 
@@ -168,11 +154,7 @@ Util_func_cpu_info(PyObject *obj)
         uv_free_cpu_info(cpus, count);
         return result;
     } else {
-        exc_data = Py_BuildValue("(is)", err.code, uv_strerror(err));
-        if (exc_data != NULL) {
-            PyErr_SetObject(PyExc_UVError, exc_data);
-            Py_DECREF(exc_data);
-        }
+        pyuv_set_uv_exception(err, PyExc_UVError);
         return NULL;
     }
 }
@@ -227,11 +209,7 @@ Util_func_set_process_title(PyObject *obj, PyObject *args)
     if (err.code == UV_OK) {
         Py_RETURN_NONE;
     } else {
-        PyObject *exc_data = Py_BuildValue("(is)", err.code, uv_strerror(err));
-        if (exc_data != NULL) {
-            PyErr_SetObject(PyExc_UVError, exc_data);
-            Py_DECREF(exc_data);
-        }
+        pyuv_set_uv_exception(err, PyExc_UVError);
         return NULL;
     }
 }
@@ -253,11 +231,7 @@ Util_func_get_process_title(PyObject *obj)
     if (err.code == UV_OK) {
         return PyString_FromString(buffer);
     } else {
-        PyObject *exc_data = Py_BuildValue("(is)", err.code, uv_strerror(err));
-        if (exc_data != NULL) {
-            PyErr_SetObject(PyExc_UVError, exc_data);
-            Py_DECREF(exc_data);
-        }
+        pyuv_set_uv_exception(err, PyExc_UVError);
         return NULL;
     }
 }
@@ -312,7 +286,7 @@ getaddrinfo_cb(uv_getaddrinfo_t* req, int status, struct addrinfo* res)
 
     if (status != 0) {
         err = uv_last_error(loop->uv_loop);
-        errorno = PyInt_FromLong((long)err.code);
+        errorno = pyuv_error_code(err.code);
         dns_result = Py_None;
         Py_INCREF(Py_None);
         goto callback;
@@ -322,7 +296,7 @@ getaddrinfo_cb(uv_getaddrinfo_t* req, int status, struct addrinfo* res)
     if (!dns_result) {
         PyErr_NoMemory();
         PyErr_WriteUnraisable(Py_None);
-        errorno = PyInt_FromLong((long)UV_ENOMEM);
+        errorno = pyuv_error_code(UV_ENOMEM);
         dns_result = Py_None;
         Py_INCREF(Py_None);
         goto callback;
@@ -355,7 +329,7 @@ getaddrinfo_cb(uv_getaddrinfo_t* req, int status, struct addrinfo* res)
     Py_INCREF(Py_None);
 
 callback:
-    result = PyObject_CallFunctionObjArgs(callback, dns_result, errorno, NULL);
+    result = pyuv_callback("getaddrinfo", callback, dns_result, errorno, NULL);
     if (result == NULL) {
         PyErr_WriteUnraisable(callback);
     }
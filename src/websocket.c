@@ -0,0 +1,695 @@
+
+/* WebSocket (RFC 6455) frame decoder, can be attached to a stream with Stream.start_read */
+
+#define PYUV_WS_OPCODE_CONTINUATION     0x0
+#define PYUV_WS_OPCODE_TEXT             0x1
+#define PYUV_WS_OPCODE_BINARY           0x2
+#define PYUV_WS_OPCODE_CLOSE            0x8
+#define PYUV_WS_OPCODE_PING             0x9
+#define PYUV_WS_OPCODE_PONG             0xA
+
+#define WS_MAX_HEADER_SIZE          14
+#define WS_MAX_CONTROL_PAYLOAD      125
+#define WS_DEFAULT_MAX_MESSAGE_SIZE (16 * 1024 * 1024)
+
+enum {
+    WS_STATE_HEADER = 0,
+    WS_STATE_PAYLOAD,
+    WS_STATE_ERROR
+};
+
+
+/* XOR src with the masking key into dst (which may be the same buffer), starting at the given
+ * offset of the key. Works on 8 bytes at a time, which the compiler turns into vector code. */
+static void
+websocket_mask(char *dst, const char *src, size_t len, const unsigned char *key, size_t offset)
+{
+    size_t i;
+    uint64_t mask64, chunk;
+    unsigned char mask[8];
+
+    for (i = 0; i < 8; i++) {
+        mask[i] = key[(offset + i) & 3];
+    }
+    memcpy(&mask64, mask, 8);
+
+    i = 0;
+    for (; i + 8 <= len; i += 8) {
+        memcpy(&chunk, src + i, 8);
+        chunk ^= mask64;
+        memcpy(dst + i, &chunk, 8);
+    }
+    for (; i < len; i++) {
+        dst[i] = src[i] ^ mask[i & 7];
+    }
+}
+
+
+/* Masking keys must not be predictable by scripts or intermediaries (RFC 6455 section 10.3), so
+ * they come from os.urandom, which is fetched in batches to keep the call off the per frame path */
+static int
+websocket_mask_key(WebSocketParser *self, unsigned char *key)
+{
+    PyObject *os, *data;
+
+    if (self->mask_pool_offset + 4 > sizeof(self->mask_pool)) {
+        os = PyImport_ImportModule("os");
+        if (!os) {
+            return -1;
+        }
+        data = PyObject_CallMethod(os, "urandom", "n", (Py_ssize_t)sizeof(self->mask_pool));
+        Py_DECREF(os);
+        if (!data) {
+            return -1;
+        }
+        if (!PyString_Check(data) || PyString_GET_SIZE(data) != (Py_ssize_t)sizeof(self->mask_pool)) {
+            PyErr_SetString(PyExc_RuntimeError, "os.urandom returned an unexpected value");
+            Py_DECREF(data);
+            return -1;
+        }
+        memcpy(self->mask_pool, PyString_AS_STRING(data), sizeof(self->mask_pool));
+        Py_DECREF(data);
+        self->mask_pool_offset = 0;
+    }
+
+    memcpy(key, self->mask_pool + self->mask_pool_offset, 4);
+    self->mask_pool_offset += 4;
+    return 0;
+}
+
+
+/* Check that a whole message can be sent as a single frame with the given opcode, raises
+ * ValueError otherwise */
+static int
+websocket_check_frame(int opcode, Py_ssize_t len)
+{
+    switch (opcode) {
+        case PYUV_WS_OPCODE_TEXT:
+        case PYUV_WS_OPCODE_BINARY:
+            return 0;
+        case PYUV_WS_OPCODE_CLOSE:
+        case PYUV_WS_OPCODE_PING:
+        case PYUV_WS_OPCODE_PONG:
+            if (len > WS_MAX_CONTROL_PAYLOAD) {
+                PyErr_SetString(PyExc_ValueError, "control frame payload is too big");
+                return -1;
+            }
+            return 0;
+        default:
+            PyErr_SetString(PyExc_ValueError, "invalid opcode");
+            return -1;
+    }
+}
+
+
+/* Write a frame header into hdr, which must have room for WS_MAX_HEADER_SIZE bytes */
+static size_t
+websocket_frame_header(char *hdr, int opcode, uint64_t len, const unsigned char *key)
+{
+    size_t n, i;
+    unsigned char *p = (unsigned char *)hdr;
+
+    p[0] = 0x80 | (opcode & 0x0f);
+    if (len < 126) {
+        p[1] = (unsigned char)len;
+        n = 2;
+    } else if (len <= 0xffff) {
+        p[1] = 126;
+        p[2] = (unsigned char)(len >> 8);
+        p[3] = (unsigned char)len;
+        n = 4;
+    } else {
+        p[1] = 127;
+        for (i = 0; i < 8; i++) {
+            p[2+i] = (unsigned char)(len >> (56 - 8*i));
+        }
+        n = 10;
+    }
+    if (key) {
+        p[1] |= 0x80;
+        memcpy(p + n, key, 4);
+        n += 4;
+    }
+    return n;
+}
+
+
+static int
+websocket_buf_append(WebSocketParser *self, const char *data, size_t len)
+{
+    char *tmp;
+    size_t size;
+
+    if (self->msg_len + len > self->msg_size) {
+        size = self->msg_size ? self->msg_size : 4096;
+        while (size < self->msg_len + len) {
+            size *= 2;
+        }
+        tmp = (char *) PyMem_Realloc(self->msg, size);
+        if (!tmp) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        self->msg = tmp;
+        self->msg_size = size;
+    }
+    if (self->masked) {
+        websocket_mask(self->msg + self->msg_len, data, len, self->key, self->key_offset);
+    } else {
+        memcpy(self->msg + self->msg_len, data, len);
+    }
+    self->msg_len += len;
+    return 0;
+}
+
+
+static int
+websocket_deliver(WebSocketParser *self, int opcode, PyObject *data)
+{
+    PyObject *result, *py_opcode;
+
+    if (!data) {
+        if (opcode == PYUV_WS_OPCODE_TEXT && PyErr_ExceptionMatches(PyExc_UnicodeDecodeError)) {
+            /* invalid UTF-8 is a protocol error */
+            PyErr_Clear();
+            return -1;
+        }
+        PyErr_WriteUnraisable(self->on_message_cb);
+        return -1;
+    }
+
+    py_opcode = PyInt_FromLong((long)opcode);
+    if (!py_opcode) {
+        PyErr_WriteUnraisable(self->on_message_cb);
+        Py_DECREF(data);
+        return -1;
+    }
+
+    result = pyuv_callback("websocket", self->on_message_cb, self->handle, py_opcode, data, NULL);
+    if (result == NULL) {
+        PyErr_WriteUnraisable(self->on_message_cb);
+    }
+    Py_XDECREF(result);
+    Py_DECREF(py_opcode);
+    Py_DECREF(data);
+    return 0;
+}
+
+
+static INLINE PyObject *
+websocket_message_object(int opcode, const char *data, size_t len)
+{
+    if (opcode == PYUV_WS_OPCODE_TEXT) {
+        return PyUnicode_DecodeUTF8(data, len, NULL);
+    }
+    return PyString_FromStringAndSize(data, len);
+}
+
+
+/* A whole frame is finished, act on it */
+static int
+websocket_frame_done(WebSocketParser *self)
+{
+    PyObject *data;
+    int opcode;
+
+    if (self->opcode & 0x08) {
+        /* Control frame, its payload is in the control buffer */
+        switch (self->opcode) {
+            case PYUV_WS_OPCODE_PING:
+                memcpy(self->pong, self->ctrl, self->ctrl_len);
+                self->pong_len = self->ctrl_len;
+                self->pong_pending = True;
+                return 0;
+            case PYUV_WS_OPCODE_PONG:
+                return 0;
+            default:
+                data = PyString_FromStringAndSize(self->ctrl, self->ctrl_len);
+                return websocket_deliver(self, self->opcode, data);
+        }
+    }
+
+    if (!self->fin) {
+        return 0;
+    }
+
+    opcode = self->msg_opcode;
+    data = websocket_message_object(opcode, self->msg, self->msg_len);
+    self->msg_len = 0;
+    self->msg_opcode = PYUV_WS_OPCODE_CONTINUATION;
+    return websocket_deliver(self, opcode, data);
+}
+
+
+static int
+websocket_parse_header(WebSocketParser *self)
+{
+    unsigned char *p = self->hdr;
+    uint64_t len;
+    int i;
+
+    self->fin = (p[0] & 0x80) != 0;
+    self->opcode = p[0] & 0x0f;
+    self->masked = (p[1] & 0x80) != 0;
+
+    /* No extensions are negotiated, reserved bits must be clear */
+    if (p[0] & 0x70) {
+        return -1;
+    }
+    /* Clients must mask their frames and servers must not */
+    if (self->masked != self->server_side) {
+        return -1;
+    }
+
+    len = p[1] & 0x7f;
+    i = 2;
+    if (len == 126) {
+        len = ((uint64_t)p[2] << 8) | p[3];
+        i = 4;
+    } else if (len == 127) {
+        len = 0;
+        for (i = 2; i < 10; i++) {
+            len = (len << 8) | p[i];
+        }
+        if (len >> 63) {
+            return -1;
+        }
+    }
+    if (self->masked) {
+        memcpy(self->key, p + i, 4);
+    }
+    self->remaining = len;
+    self->key_offset = 0;
+
+    switch (self->opcode) {
+        case PYUV_WS_OPCODE_CONTINUATION:
+            if (self->msg_opcode == PYUV_WS_OPCODE_CONTINUATION) {
+                return -1;
+            }
+            break;
+        case PYUV_WS_OPCODE_TEXT:
+        case PYUV_WS_OPCODE_BINARY:
+            if (self->msg_opcode != PYUV_WS_OPCODE_CONTINUATION) {
+                /* the previous message isn't finished yet */
+                return -1;
+            }
+            self->msg_opcode = self->opcode;
+            break;
+        case PYUV_WS_OPCODE_CLOSE:
+        case PYUV_WS_OPCODE_PING:
+        case PYUV_WS_OPCODE_PONG:
+            if (!self->fin || len > WS_MAX_CONTROL_PAYLOAD) {
+                return -1;
+            }
+            self->ctrl_len = 0;
+            return 0;
+        default:
+            return -1;
+    }
+
+    if (self->msg_len + len > (uint64_t)self->max_message_size) {
+        return -1;
+    }
+    return 0;
+}
+
+
+/* Size of the frame header, or 0 if not enough bytes are known yet */
+static INLINE size_t
+websocket_header_size(WebSocketParser *self)
+{
+    size_t n;
+
+    if (self->hdr_len < 2) {
+        return 0;
+    }
+    n = 2;
+    if ((self->hdr[1] & 0x7f) == 126) {
+        n += 2;
+    } else if ((self->hdr[1] & 0x7f) == 127) {
+        n += 8;
+    }
+    if (self->hdr[1] & 0x80) {
+        n += 4;
+    }
+    return n;
+}
+
+
+static void
+websocket_parser_reset(WebSocketParser *self)
+{
+    self->state = WS_STATE_HEADER;
+    self->hdr_len = 0;
+    self->msg_len = 0;
+    self->msg_opcode = PYUV_WS_OPCODE_CONTINUATION;
+    self->pong_pending = False;
+}
+
+
+static int
+websocket_parser_feed(WebSocketParser *self, PyObject *handle, const char *data, Py_ssize_t len)
+{
+    size_t n, need;
+    Py_ssize_t pos;
+    int opcode;
+
+    if (self->feeding) {
+        /* the outer call is still parsing the current frame */
+        PyErr_SetString(PyExc_RuntimeError, "WebSocketParser can't be fed from its own callbacks");
+        return -1;
+    }
+
+    if (self->state == WS_STATE_ERROR) {
+        return -1;
+    }
+
+    /* Object could go out of scope in the callbacks, increase refcount to avoid it */
+    Py_INCREF(self);
+    self->handle = handle;
+    self->feeding = True;
+
+    pos = 0;
+    while (pos < len || (self->state == WS_STATE_PAYLOAD && self->remaining == 0)) {
+        if (self->state == WS_STATE_HEADER) {
+            /* Header bytes are few, copy them as they come */
+            self->hdr[self->hdr_len++] = (unsigned char)data[pos++];
+            need = websocket_header_size(self);
+            if (need == 0 || self->hdr_len < need) {
+                continue;
+            }
+            self->hdr_len = 0;
+            if (websocket_parse_header(self) != 0) {
+                goto error;
+            }
+            self->state = WS_STATE_PAYLOAD;
+            continue;
+        }
+
+        n = len - pos;
+        if (n > self->remaining) {
+            n = (size_t)self->remaining;
+        }
+
+        if (self->opcode & 0x08) {
+            if (self->masked) {
+                websocket_mask(self->ctrl + self->ctrl_len, data + pos, n, self->key, self->key_offset);
+            } else {
+                memcpy(self->ctrl + self->ctrl_len, data + pos, n);
+            }
+            self->ctrl_len += n;
+        } else if (self->fin && self->msg_len == 0 && n == self->remaining) {
+            /* Fast path, the whole message is here: unmask straight into the result object */
+            PyObject *obj = PyString_FromStringAndSize(NULL, n);
+            if (!obj) {
+                PyErr_WriteUnraisable(self->on_message_cb);
+                goto error;
+            }
+            if (self->masked) {
+                websocket_mask(PyString_AS_STRING(obj), data + pos, n, self->key, 0);
+            } else {
+                memcpy(PyString_AS_STRING(obj), data + pos, n);
+            }
+            if (self->msg_opcode == PYUV_WS_OPCODE_TEXT) {
+                PyObject *text = PyUnicode_DecodeUTF8(PyString_AS_STRING(obj), n, NULL);
+                Py_DECREF(obj);
+                obj = text;
+            }
+            pos += n;
+            self->remaining = 0;
+            self->state = WS_STATE_HEADER;
+            opcode = self->msg_opcode;
+            self->msg_opcode = PYUV_WS_OPCODE_CONTINUATION;
+            if (websocket_deliver(self, opcode, obj) != 0) {
+                goto error;
+            }
+            continue;
+        } else if (websocket_buf_append(self, data + pos, n) != 0) {
+            PyErr_WriteUnraisable(self->on_message_cb);
+            goto error;
+        }
+
+        pos += n;
+        self->remaining -= n;
+        self->key_offset = (self->key_offset + n) & 3;
+
+        if (self->remaining == 0) {
+            self->state = WS_STATE_HEADER;
+            if (websocket_frame_done(self) != 0) {
+                goto error;
+            }
+        }
+    }
+
+    self->handle = Py_None;
+    self->feeding = False;
+    Py_DECREF(self);
+    return 0;
+
+error:
+    self->state = WS_STATE_ERROR;
+    self->handle = Py_None;
+    self->feeding = False;
+    Py_DECREF(self);
+    return -1;
+}
+
+
+static PyObject *
+WebSocketParser_func_feed(WebSocketParser *self, PyObject *args)
+{
+    int r;
+    Py_buffer pbuf;
+
+    if (self->feeding) {
+        PyErr_SetString(PyExc_RuntimeError, "WebSocketParser can't be fed from its own callbacks");
+        return NULL;
+    }
+
+    if (!PyArg_ParseTuple(args, "s*:feed", &pbuf)) {
+        return NULL;
+    }
+
+    r = websocket_parser_feed(self, Py_None, pbuf.buf, pbuf.len);
+    PyBuffer_Release(&pbuf);
+    /* there is no stream to answer pings on */
+    self->pong_pending = False;
+    if (r != 0) {
+        PyErr_SetString(PyExc_ValueError, "invalid WebSocket frame");
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+WebSocketParser_func_reset(WebSocketParser *self)
+{
+    if (self->feeding) {
+        PyErr_SetString(PyExc_RuntimeError, "WebSocketParser can't be reset from its own callbacks");
+        return NULL;
+    }
+
+    websocket_parser_reset(self);
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+WebSocketParser_func_encode(WebSocketParser *self, PyObject *args)
+{
+    int opcode;
+    size_t hdr_len;
+    unsigned char key[4];
+    char hdr[WS_MAX_HEADER_SIZE];
+    Py_buffer pbuf;
+    PyObject *result;
+    char *ptr;
+
+    if (!PyArg_ParseTuple(args, "s*i:encode", &pbuf, &opcode)) {
+        return NULL;
+    }
+
+    if (websocket_check_frame(opcode, pbuf.len) != 0) {
+        PyBuffer_Release(&pbuf);
+        return NULL;
+    }
+
+    if (self->server_side) {
+        hdr_len = websocket_frame_header(hdr, opcode, pbuf.len, NULL);
+    } else {
+        if (websocket_mask_key(self, key) != 0) {
+            PyBuffer_Release(&pbuf);
+            return NULL;
+        }
+        hdr_len = websocket_frame_header(hdr, opcode, pbuf.len, key);
+    }
+
+    result = PyString_FromStringAndSize(NULL, hdr_len + pbuf.len);
+    if (!result) {
+        PyBuffer_Release(&pbuf);
+        return NULL;
+    }
+    ptr = PyString_AS_STRING(result);
+    memcpy(ptr, hdr, hdr_len);
+
+    if (self->server_side) {
+        memcpy(ptr + hdr_len, pbuf.buf, pbuf.len);
+    } else {
+        websocket_mask(ptr + hdr_len, pbuf.buf, pbuf.len, key, 0);
+    }
+    PyBuffer_Release(&pbuf);
+
+    return result;
+}
+
+
+static PyObject *
+WebSocketParser_server_side_get(WebSocketParser *self, void *closure)
+{
+    UNUSED_ARG(closure);
+    return PyBool_FromLong((long)self->server_side);
+}
+
+
+static int
+WebSocketParser_tp_init(WebSocketParser *self, PyObject *args, PyObject *kwargs)
+{
+    PyObject *on_message_cb, *tmp, *server_side;
+    Py_ssize_t max_message_size;
+
+    static char *kwlist[] = {"on_message", "server_side", "max_message_size", NULL};
+
+    if (self->feeding) {
+        PyErr_SetString(PyExc_RuntimeError, "WebSocketParser can't be initialized from its own callbacks");
+        return -1;
+    }
+
+    server_side = Py_True;
+    max_message_size = WS_DEFAULT_MAX_MESSAGE_SIZE;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|On:__init__", kwlist, &on_message_cb, &server_side, &max_message_size)) {
+        return -1;
+    }
+
+    if (!PyCallable_Check(on_message_cb)) {
+        PyErr_SetString(PyExc_TypeError, "a callable is required");
+        return -1;
+    }
+
+    if (max_message_size <= 0) {
+        PyErr_SetString(PyExc_ValueError, "max_message_size must be positive");
+        return -1;
+    }
+
+    tmp = self->on_message_cb;
+    Py_INCREF(on_message_cb);
+    self->on_message_cb = on_message_cb;
+    Py_XDECREF(tmp);
+
+    self->server_side = PyObject_IsTrue(server_side) ? True : False;
+    self->max_message_size = max_message_size;
+    websocket_parser_reset(self);
+
+    return 0;
+}
+
+
+static PyObject *
+WebSocketParser_tp_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
+{
+    WebSocketParser *self = (WebSocketParser *)PyType_GenericNew(type, args, kwargs);
+    if (!self) {
+        return NULL;
+    }
+    self->handle = Py_None;
+    self->feeding = False;
+    self->msg = NULL;
+    self->msg_len = self->msg_size = 0;
+    self->mask_pool_offset = sizeof(self->mask_pool);
+    return (PyObject *)self;
+}
+
+
+static int
+WebSocketParser_tp_traverse(WebSocketParser *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->on_message_cb);
+    return 0;
+}
+
+
+static int
+WebSocketParser_tp_clear(WebSocketParser *self)
+{
+    Py_CLEAR(self->on_message_cb);
+    return 0;
+}
+
+
+static void
+WebSocketParser_tp_dealloc(WebSocketParser *self)
+{
+    WebSocketParser_tp_clear(self);
+    PyMem_Free(self->msg);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+
+static PyMethodDef
+WebSocketParser_tp_methods[] = {
+    { "feed", (PyCFunction)WebSocketParser_func_feed, METH_VARARGS, "Feed data to the parser." },
+    { "reset", (PyCFunction)WebSocketParser_func_reset, METH_NOARGS, "Reset the parser state, discarding any partial message." },
+    { "encode", (PyCFunction)WebSocketParser_func_encode, METH_VARARGS, "Encode the given data as a single WebSocket frame." },
+    { NULL }
+};
+
+
+static PyGetSetDef WebSocketParser_tp_getsets[] = {
+    {"server_side", (getter)WebSocketParser_server_side_get, NULL, "Indicates if the parser is used on the server side of the connection.", NULL},
+    {NULL}
+};
+
+
+static PyTypeObject WebSocketParserType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "pyuv.WebSocketParser",                                         /*tp_name*/
+    sizeof(WebSocketParser),                                        /*tp_basicsize*/
+    0,                                                              /*tp_itemsize*/
+    (destructor)WebSocketParser_tp_dealloc,                         /*tp_dealloc*/
+    0,                                                              /*tp_print*/
+    0,                                                              /*tp_getattr*/
+    0,                                                              /*tp_setattr*/
+    0,                                                              /*tp_compare*/
+    0,                                                              /*tp_repr*/
+    0,                                                              /*tp_as_number*/
+    0,                                                              /*tp_as_sequence*/
+    0,                                                              /*tp_as_mapping*/
+    0,                                                              /*tp_hash */
+    0,                                                              /*tp_call*/
+    0,                                                              /*tp_str*/
+    0,                                                              /*tp_getattro*/
+    0,                                                              /*tp_setattro*/
+    0,                                                              /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,                        /*tp_flags*/
+    0,                                                              /*tp_doc*/
+    (traverseproc)WebSocketParser_tp_traverse,                      /*tp_traverse*/
+    (inquiry)WebSocketParser_tp_clear,                              /*tp_clear*/
+    0,                                                              /*tp_richcompare*/
+    0,                                                              /*tp_weaklistoffset*/
+    0,                                                              /*tp_iter*/
+    0,                                                              /*tp_iternext*/
+    WebSocketParser_tp_methods,                                     /*tp_methods*/
+    0,                                                              /*tp_members*/
+    WebSocketParser_tp_getsets,                                     /*tp_getsets*/
+    0,                                                              /*tp_base*/
+    0,                                                              /*tp_dict*/
+    0,                                                              /*tp_descr_get*/
+    0,                                                              /*tp_descr_set*/
+    0,                                                              /*tp_dictoffset*/
+    (initproc)WebSocketParser_tp_init,                              /*tp_init*/
+    0,                                                              /*tp_alloc*/
+    WebSocketParser_tp_new,                                         /*tp_new*/
+};
+
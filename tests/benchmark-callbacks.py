@@ -0,0 +1,112 @@
+from __future__ import print_function
+
+import sys
+sys.path.insert(0, '../')
+import time
+import pyuv
+
+# Measures the time spent per callback invocation for each handle type, including the loop
+# iteration which triggered it. Run it against two builds to compare the dispatch overhead.
+
+COUNT = 100000
+
+
+class Counter(object):
+
+    def __init__(self, count, done):
+        self.left = count
+        self.done = done
+
+    def __call__(self, handle, *args):
+        self.left -= 1
+        if self.left == 0:
+            self.done(handle)
+
+
+def bench_timer(loop, count):
+    timer = pyuv.Timer(loop)
+    timer.start(Counter(count, lambda h: h.close()), 0.000001, 0.000001)
+
+
+def bench_idle(loop, count):
+    idle = pyuv.Idle(loop)
+    idle.start(Counter(count, lambda h: h.close()))
+
+
+def bench_prepare_check(loop, count):
+    # the idle handle keeps the loop spinning, both prepare and check run once per iteration
+    idle = pyuv.Idle(loop)
+    idle.start(lambda h: None)
+    prepare = pyuv.Prepare(loop)
+    check = pyuv.Check(loop)
+    def done(h):
+        h.close()
+        if prepare.closed and check.closed:
+            idle.close()
+    prepare.start(Counter(count // 2, done))
+    check.start(Counter(count // 2, done))
+
+
+def bench_async(loop, count):
+    counter = Counter(count, lambda h: h.close())
+    def cb(handle):
+        counter(handle)
+        if not handle.closed:
+            handle.send()
+    async_h = pyuv.Async(loop, cb)
+    async_h.send()
+
+
+def bench_poll(loop, count):
+    sock = pyuv.UDP(loop)
+    sock.bind(("127.0.0.1", 0))
+    # an UDP socket is always writable
+    poll = pyuv.Poll(loop, sock.fileno())
+    def done(h):
+        h.close()
+        sock.close()
+    poll.start(pyuv.UV_WRITABLE, Counter(count, done))
+
+
+def bench_udp(loop, count):
+    server = pyuv.UDP(loop)
+    server.bind(("127.0.0.1", 0))
+    client = pyuv.UDP(loop)
+    address = server.getsockname()
+    def done(h):
+        server.close()
+        client.close()
+    counter = Counter(count, done)
+    # keep a window of datagrams in flight, one is sent for every one received
+    def on_recv(handle, address_, data, error):
+        counter(handle)
+        if not handle.closed:
+            client.send(address, b"x")
+    server.start_recv(on_recv)
+    for i in range(64):
+        client.send(address, b"x")
+
+
+def bench_fs(loop, count):
+    counter = Counter(count, lambda h: None)
+    def cb(loop_, path, stat_data, error):
+        counter(loop_)
+        if counter.left > 0:
+            pyuv.fs.stat(loop, ".", cb)
+    pyuv.fs.stat(loop, ".", cb)
+
+
+BENCHMARKS = [("Timer", bench_timer), ("Idle", bench_idle), ("Prepare/Check", bench_prepare_check),
+              ("Async", bench_async), ("Poll", bench_poll), ("UDP", bench_udp), ("fs", bench_fs)]
+
+
+print("PyUV version %s" % pyuv.__version__)
+
+loop = pyuv.Loop.default_loop()
+for name, bench in BENCHMARKS:
+    count = COUNT if name != "fs" else COUNT // 10
+    bench(loop, count)
+    t0 = time.time()
+    loop.run()
+    elapsed = time.time() - t0
+    print("%-15s %8.3f usec/callback" % (name, elapsed * 1000000 / count))
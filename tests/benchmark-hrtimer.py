@@ -0,0 +1,68 @@
+from __future__ import print_function
+
+import sys
+sys.path.insert(0, '../')
+import pyuv
+
+# Measures how late periodic timers fire (jitter), comparing Timer, which works in
+# milliseconds, with the timerfd backed HRTimer. Lateness is measured against the ideal
+# schedule, so errors don't accumulate. Run it on an idle machine for meaningful numbers.
+
+COUNT = 5000
+PERIODS = [100000, 250000, 1000000]     # nanoseconds
+
+
+def report(name, period, lateness):
+    lateness.sort()
+    n = len(lateness)
+    print("%-8s %8.1f usec period: min %7.1f  avg %7.1f  p50 %7.1f  p99 %7.1f  max %8.1f usec" % (
+          name, period / 1000.0, lateness[0] / 1000.0, sum(lateness) / n / 1000.0,
+          lateness[n // 2] / 1000.0, lateness[n * 99 // 100] / 1000.0, lateness[-1] / 1000.0))
+
+
+def bench_timer(loop, period):
+    lateness = []
+    start = pyuv.util.hrtime()
+    def cb(timer):
+        now = pyuv.util.hrtime()
+        expected = start + period * (len(lateness) + 1)
+        lateness.append(now - expected)
+        if len(lateness) == COUNT:
+            timer.close()
+    timer = pyuv.Timer(loop)
+    timer.start(cb, period / 1e9, period / 1e9)
+    loop.run()
+    return lateness
+
+
+def bench_hrtimer(loop, period):
+    lateness = []
+    start = pyuv.util.hrtime()
+    state = {'ticks': 0}
+    def cb(timer, expirations, error):
+        if error is not None:
+            print("HRTimer error: %s" % pyuv.errno.strerror(error))
+            timer.close()
+            return
+        now = pyuv.util.hrtime()
+        state['ticks'] += expirations
+        expected = start + period * state['ticks']
+        lateness.append(now - expected)
+        if len(lateness) == COUNT:
+            timer.close()
+    timer = pyuv.HRTimer(loop)
+    timer.start(cb, start + period, period)
+    loop.run()
+    return lateness
+
+
+print("PyUV version %s" % pyuv.__version__)
+
+loop = pyuv.Loop.default_loop()
+for period in PERIODS:
+    if period >= 1000000:
+        report("Timer", period, bench_timer(loop, period))
+    else:
+        print("%-8s %8.1f usec period: not possible, Timer has millisecond resolution" % ("Timer", period / 1000.0))
+    if hasattr(pyuv, "HRTimer"):
+        report("HRTimer", period, bench_hrtimer(loop, period))
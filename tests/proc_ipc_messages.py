@@ -0,0 +1,27 @@
+#!/usr/bin/env python
+
+import sys
+sys.path.insert(0, '../')
+
+import pyuv
+
+
+def on_channel_message(handle, data, recv_handle, error):
+    global channel
+    if data is None:
+        channel.close()
+        return
+    # echo every message back, along with its handle if there was one
+    if recv_handle is not None:
+        channel.write_message(data, recv_handle, lambda h, e: recv_handle.close())
+    else:
+        channel.write_message(data)
+
+
+loop = pyuv.Loop.default_loop()
+
+channel = pyuv.Pipe(loop, True)
+channel.open(sys.stdin.fileno())
+channel.start_read_messages(on_channel_message)
+
+loop.run()
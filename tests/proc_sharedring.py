@@ -0,0 +1,35 @@
+#!/usr/bin/env python
+
+import os
+import sys
+sys.path.insert(0, '../')
+
+import pyuv
+
+
+def on_channel_message(handle, data, fd, error):
+    global channel, fds
+    if data is None:
+        channel.close()
+        return
+    fds.append(fd)
+    if len(fds) == 2:
+        # both ends of the ring arrived, produce into it and exit
+        ring = pyuv.SharedRing(loop, fds=tuple(fds))
+        for fd in fds:
+            os.close(fd)
+        for i in range(1000):
+            while not ring.put(("message %d" % i).encode()):
+                pass
+        ring.close()
+        channel.close()
+
+
+loop = pyuv.Loop.default_loop()
+fds = []
+
+channel = pyuv.Pipe(loop, True)
+channel.open(sys.stdin.fileno())
+channel.start_read_messages(on_channel_message)
+
+loop.run()
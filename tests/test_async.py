@@ -39,6 +39,57 @@ class AsyncTest(unittest2.TestCase):
         self.assertEqual(self.async_cb_called, 3)
         self.assertEqual(self.prepare_cb_called, 1)
 
+    def test_async_payloads(self):
+        self.received = []
+        self.batches = 0
+        def async_cb(async_h, payloads):
+            self.batches += 1
+            self.received.extend(payloads)
+            if len(self.received) == 4 * 1000:
+                async_h.close()
+        def thread_cb(thread_id):
+            for i in range(1000):
+                async_h.send((thread_id, i))
+        loop = pyuv.Loop()
+        async_h = pyuv.Async(loop, async_cb, payloads=True)
+        threads = [threading.Thread(target=thread_cb, args=(n,)) for n in range(4)]
+        for t in threads:
+            t.start()
+        # everything is sent before the loop runs, so all the sends coalesce into a single wakeup
+        for t in threads:
+            t.join()
+        loop.run()
+        # nothing is lost when wakeups are coalesced, and each thread's payloads keep their order
+        self.assertEqual(len(self.received), 4 * 1000)
+        self.assertEqual(self.batches, 1)
+        for n in range(4):
+            self.assertEqual([i for thread_id, i in self.received if thread_id == n], list(range(1000)))
+
+    def test_async_payloads_batch(self):
+        self.batches = []
+        def async_cb(async_h, payloads):
+            self.batches.append(payloads)
+            if len(self.batches) == 2:
+                async_h.close()
+        loop = pyuv.Loop()
+        async_h = pyuv.Async(loop, async_cb, payloads=True)
+        async_h.send(1)
+        async_h.send('two')
+        async_h.send(None)
+        loop.run(pyuv.UV_RUN_ONCE)
+        # a wakeup without payloads still gets the (empty) list
+        async_h.send()
+        loop.run()
+        self.assertEqual(self.batches, [[1, 'two', None], []])
+
+    def test_async_payloads_disabled(self):
+        loop = pyuv.Loop()
+        async_h = pyuv.Async(loop, lambda h: h.close())
+        self.assertRaises(pyuv.error.AsyncError, async_h.send, 1)
+        async_h.send()
+        loop.run()
+        self.assertTrue(async_h.closed)
+
 
 if __name__ == '__main__':
     unittest2.main(verbosity=2)
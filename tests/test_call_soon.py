@@ -0,0 +1,94 @@
+
+from common import unittest2
+import threading
+import pyuv
+
+
+class CallSoonTest(unittest2.TestCase):
+
+    def test_call_soon(self):
+        self.calls = []
+        def cb(*args):
+            self.calls.append(args)
+        loop = pyuv.Loop()
+        loop.call_soon(cb)
+        loop.call_soon(cb, 1)
+        loop.call_soon(cb, 1, 'two', None)
+        loop.run()
+        self.assertEqual(self.calls, [(), (1,), (1, 'two', None)])
+
+    def test_call_soon_order(self):
+        # enough calls to make the queue grow while it wraps around
+        self.calls = []
+        def cb(i):
+            self.calls.append(i)
+            if i < 100:
+                loop.call_soon(cb, i + 100)
+        loop = pyuv.Loop()
+        for i in range(100):
+            loop.call_soon(cb, i)
+        loop.run()
+        self.assertEqual(self.calls, list(range(200)))
+
+    def test_call_soon_next_iteration(self):
+        self.iterations = []
+        def cb(n):
+            self.iterations.append(self.check_count)
+            if n > 0:
+                loop.call_soon(cb, n - 1)
+        def check_cb(handle):
+            self.check_count += 1
+        self.check_count = 0
+        loop = pyuv.Loop()
+        check = pyuv.Check(loop)
+        check.start(check_cb)
+        check.unref()
+        loop.call_soon(cb, 2)
+        loop.run()
+        # calls queued from a callback run on the following iteration
+        self.assertEqual(self.iterations, [0, 1, 2])
+
+    def test_call_soon_errors(self):
+        self.called = False
+        def cb():
+            self.called = True
+        loop = pyuv.Loop()
+        self.assertRaises(TypeError, loop.call_soon)
+        self.assertRaises(TypeError, loop.call_soon, None)
+        loop.call_soon(lambda: 1 / 0)
+        loop.call_soon(cb)
+        loop.run()
+        self.assertTrue(self.called)
+
+    def test_call_soon_threadsafe(self):
+        self.calls = []
+        def cb(thread_id, i):
+            self.calls.append((thread_id, i))
+            if len(self.calls) == 4 * 500:
+                timer.close()
+        def producer(thread_id):
+            for i in range(500):
+                loop.call_soon_threadsafe(cb, thread_id, i)
+        loop = pyuv.Loop()
+        # call_soon_threadsafe doesn't keep the loop alive
+        timer = pyuv.Timer(loop)
+        timer.start(lambda t: None, 10, 0)
+        threads = [threading.Thread(target=producer, args=(n,)) for n in range(4)]
+        for t in threads:
+            t.start()
+        loop.run()
+        for t in threads:
+            t.join()
+        self.assertEqual(len(self.calls), 4 * 500)
+        # calls from the same thread keep their order
+        for n in range(4):
+            self.assertEqual([i for thread_id, i in self.calls if thread_id == n], list(range(500)))
+
+    def test_call_soon_threadsafe_errors(self):
+        loop = pyuv.Loop()
+        self.assertRaises(TypeError, loop.call_soon_threadsafe)
+        self.assertRaises(TypeError, loop.call_soon_threadsafe, None)
+
+
+if __name__ == '__main__':
+    unittest2.main(verbosity=2)
@@ -0,0 +1,89 @@
+
+import os
+
+from common import unittest2
+import pyuv
+
+
+@unittest2.skipUnless(hasattr(pyuv, "HRTimer"), "HRTimer is not available in the current platform")
+class HRTimerTest(unittest2.TestCase):
+
+    def test_hrtimer1(self):
+        self.fired = []
+        def timer_cb(timer, expirations, error):
+            self.assertEqual(error, None)
+            self.fired.append((pyuv.util.hrtime(), expirations))
+            timer.close()
+        loop = pyuv.Loop()
+        timer = pyuv.HRTimer(loop)
+        deadline = pyuv.util.hrtime() + 500000
+        timer.start(timer_cb, deadline)
+        self.assertTrue(timer.active)
+        self.assertTrue(timer.deadline >= deadline - 1000)
+        self.assertEqual(timer.interval, 0)
+        loop.run()
+        self.assertEqual(len(self.fired), 1)
+        now, expirations = self.fired[0]
+        self.assertTrue(now >= deadline)
+        self.assertEqual(expirations, 1)
+
+    def test_hrtimer_oneshot_inactive(self):
+        self.fired = 0
+        def timer_cb(timer, expirations, error):
+            self.fired += 1
+        loop = pyuv.Loop()
+        timer = pyuv.HRTimer(loop)
+        # a deadline in the past fires right away, and the loop exits afterwards
+        timer.start(timer_cb, 0)
+        loop.run()
+        self.assertEqual(self.fired, 1)
+        self.assertFalse(timer.active)
+        self.assertEqual(timer.deadline, None)
+        timer.close()
+        loop.run()
+
+    def test_hrtimer_interval(self):
+        self.expirations = 0
+        def timer_cb(timer, expirations, error):
+            self.expirations += expirations
+            if self.expirations >= 10:
+                timer.stop()
+                timer.close()
+        loop = pyuv.Loop()
+        timer = pyuv.HRTimer(loop)
+        start = pyuv.util.hrtime()
+        timer.start(timer_cb, start + 200000, 200000)
+        self.assertEqual(timer.interval, 200000)
+        loop.run()
+        self.assertTrue(self.expirations >= 10)
+        self.assertTrue(pyuv.util.hrtime() - start >= 10 * 200000)
+
+    def test_hrtimer_stop(self):
+        self.fired = 0
+        def timer_cb(timer, expirations, error):
+            self.fired += 1
+        loop = pyuv.Loop()
+        timer = pyuv.HRTimer(loop)
+        timer.start(timer_cb, pyuv.util.hrtime() + 1000000, 1000000)
+        timer.stop()
+        self.assertFalse(timer.active)
+        loop.run()
+        self.assertEqual(self.fired, 0)
+        timer.close()
+        self.assertRaises(pyuv.error.HandleClosedError, timer.start, timer_cb, 0)
+        self.assertRaises(TypeError, pyuv.HRTimer(loop).start, None, 0)
+        loop.run()
+
+    def test_hrtimer_close_fd(self):
+        loop = pyuv.Loop()
+        timer = pyuv.HRTimer(loop)
+        fds = set(os.listdir("/proc/self/fd"))
+        timer.close()
+        # the timerfd is released once the handle is closed
+        self.assertEqual(set(os.listdir("/proc/self/fd")), fds)
+        loop.run()
+        self.assertTrue(len(set(os.listdir("/proc/self/fd"))) < len(fds))
+
+
+if __name__ == '__main__':
+    unittest2.main(verbosity=2)
@@ -0,0 +1,152 @@
+
+from common import unittest2
+import pyuv
+
+
+TEST_PORT = 1234
+
+REQUESTS = (b"GET /a HTTP/1.1\r\nHost: localhost\r\n\r\n"
+            b"POST /b HTTP/1.1\r\nContent-Length: 5\r\n\r\nhello"
+            b"PUT /c HTTP/1.0\r\nTransfer-Encoding: chunked\r\n\r\n3;ext\r\nabc\r\n2\r\nde\r\n0\r\nX-Trailer: x\r\n\r\n")
+
+
+class HTTPTestMixin(object):
+
+    def setUp(self):
+        self.events = []
+        self.parser = pyuv.HTTPParser(self.on_headers, self.on_body, self.on_complete)
+
+    def on_headers(self, handle, method, path, version, headers, keep_alive):
+        self.events.append((method, path, version, headers, keep_alive))
+
+    def on_body(self, handle, data):
+        if self.events and isinstance(self.events[-1], bytes):
+            self.events[-1] += data
+        else:
+            self.events.append(data)
+
+    def on_complete(self, handle):
+        self.events.append(None)
+
+    def check_events(self):
+        self.assertEqual(self.events, [("GET", "/a", (1, 1), [("Host", "localhost")], True), None,
+                                       ("POST", "/b", (1, 1), [("Content-Length", "5")], True), b"hello", None,
+                                       ("PUT", "/c", (1, 0), [("Transfer-Encoding", "chunked")], False), b"abcde", None])
+
+
+class HTTPParserTest(HTTPTestMixin, unittest2.TestCase):
+
+    def test_http_parse(self):
+        self.parser.feed(REQUESTS)
+        self.check_events()
+
+    def test_http_parse_bytewise(self):
+        for i in range(len(REQUESTS)):
+            self.parser.feed(REQUESTS[i:i+1])
+        self.check_events()
+
+    def test_http_invalid(self):
+        self.assertRaises(ValueError, self.parser.feed, b"POST / HTTP/1.1\r\nContent-Length: 1\r\nTransfer-Encoding: chunked\r\n\r\n")
+        self.assertRaises(ValueError, self.parser.feed, b"GET / HTTP/1.1\r\n\r\n")
+        self.parser.reset()
+        self.parser.feed(b"GET / HTTP/1.1\r\nConnection: close\r\n\r\n")
+        self.assertFalse(self.parser.keep_alive)
+
+    def test_http_transfer_encoding(self):
+        self.parser.feed(b"POST / HTTP/1.1\r\nTransfer-Encoding: gzip, chunked\r\n\r\n1\r\nx\r\n0\r\n\r\n")
+        self.assertEqual(self.events[1:], [b"x", None])
+        for te in (b"chunked, gzip", b"chunked, chunked", b"gzip", b"chunked\r\nTransfer-Encoding: chunked"):
+            self.parser.reset()
+            self.assertRaises(ValueError, self.parser.feed, b"POST / HTTP/1.1\r\nTransfer-Encoding: " + te + b"\r\n\r\n")
+
+    def test_http_feed_from_callback(self):
+        self.errors = []
+        def on_headers(handle, method, path, version, headers, keep_alive):
+            self.events.append(path)
+            for func in (lambda: self.parser.feed(b"GET /x HTTP/1.1\r\n\r\n"), self.parser.reset):
+                try:
+                    func()
+                except RuntimeError:
+                    self.errors.append(path)
+        self.parser = pyuv.HTTPParser(on_headers, self.on_body, self.on_complete)
+        self.parser.feed(b"GET /a HTTP/1.1\r\n\r\nGET /b HTTP/1.1\r\n\r\nGET /c")
+        self.parser.feed(b" HTTP/1.1\r\n\r\n")
+        self.assertEqual(self.events, ["/a", None, "/b", None, "/c", None])
+        self.assertEqual(self.errors, ["/a", "/a", "/b", "/b", "/c", "/c"])
+
+
+class HTTPStreamTest(HTTPTestMixin, unittest2.TestCase):
+
+    def on_connection(self, server, error):
+        self.assertEqual(error, None)
+        client = pyuv.TCP(server.loop)
+        server.accept(client)
+        client.start_read(self.on_client_connection_read, self.parser)
+
+    def on_client_connection_read(self, client, data, error):
+        self.assertEqual(data, None)
+        self.assertEqual(error, pyuv.errno.UV_EOF)
+        client.close()
+        self.server.close()
+
+    def on_client_connection(self, client, error):
+        self.assertEqual(error, None)
+        client.write(REQUESTS[:10])
+        client.write(REQUESTS[10:])
+        client.shutdown(lambda c, e: c.close())
+
+    def on_headers(self, handle, method, path, version, headers, keep_alive):
+        self.assertTrue(isinstance(handle, pyuv.TCP))
+        super(HTTPStreamTest, self).on_headers(handle, method, path, version, headers, keep_alive)
+
+    def test_http_stream(self):
+        loop = pyuv.Loop.default_loop()
+        self.server = pyuv.TCP(loop)
+        self.server.bind(("0.0.0.0", TEST_PORT))
+        self.server.listen(self.on_connection)
+        client = pyuv.TCP(loop)
+        client.connect(("127.0.0.1", TEST_PORT), self.on_client_connection)
+        loop.run()
+        self.check_events()
+
+
+class HTTPStreamStopTest(HTTPTestMixin, unittest2.TestCase):
+
+    def on_connection(self, server, error):
+        self.assertEqual(error, None)
+        client = pyuv.TCP(server.loop)
+        server.accept(client)
+        client.start_read(self.on_client_connection_read, self.parser)
+
+    def on_client_connection_read(self, client, data, error):
+        self.fail("read callback called after stop_read")
+
+    def on_complete(self, handle):
+        super(HTTPStreamStopTest, self).on_complete(handle)
+        # the pipelined request and the garbage after it must not be parsed
+        handle.stop_read()
+        handle.loop.call_soon(self.close_all, handle)
+
+    def close_all(self, handle):
+        handle.close()
+        self.server.close()
+
+    def on_client_connection(self, client, error):
+        self.assertEqual(error, None)
+        client.write(b"GET /a HTTP/1.1\r\n\r\nGET /b HTTP/1.1\r\n\r\n\x00garbage\r\n\r\n")
+        client.shutdown(lambda c, e: c.close())
+
+    def test_http_stream_stop_read(self):
+        loop = pyuv.Loop.default_loop()
+        self.server = pyuv.TCP(loop)
+        self.server.bind(("0.0.0.0", TEST_PORT))
+        self.server.listen(self.on_connection)
+        client = pyuv.TCP(loop)
+        client.connect(("127.0.0.1", TEST_PORT), self.on_client_connection)
+        loop.run()
+        self.assertEqual(self.events, [("GET", "/a", (1, 1), [], True), None])
+
+
+if __name__ == '__main__':
+    unittest2.main(verbosity=2)
+
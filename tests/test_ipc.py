@@ -121,5 +121,46 @@ class IPCSendRecvTest(unittest2.TestCase):
         self.loop.run()
 
 
+@platform_skip(["win32"])
+class IPCMessagesTest(unittest2.TestCase):
+
+    def setUp(self):
+        self.loop = pyuv.Loop.default_loop()
+
+    def proc_exit_cb(self, proc, exit_status, term_signal):
+        proc.close()
+
+    def on_channel_message(self, handle, data, recv_handle, error):
+        self.assertEqual(error, None)
+        self.messages.append(data)
+        if data == b"handle":
+            self.assertTrue(isinstance(recv_handle, pyuv.Pipe))
+            recv_handle.close()
+        else:
+            self.assertEqual(recv_handle, None)
+        if len(self.messages) == len(self.expected):
+            self.channel.close()
+            self.send_pipe.close()
+
+    def test_ipc_messages(self):
+        self.messages = []
+        self.expected = [("message %d" % i).encode() for i in range(100)] + [b"handle", b"", b"x" * 100000]
+        self.send_pipe = pyuv.Pipe(self.loop, True)
+        self.send_pipe.bind(TEST_PIPE)
+        self.channel = pyuv.Pipe(self.loop, True)
+        stdio = [pyuv.StdIO(stream=self.channel, flags=pyuv.UV_CREATE_PIPE|pyuv.UV_READABLE_PIPE|pyuv.UV_WRITABLE_PIPE)]
+        proc = pyuv.Process(self.loop)
+        proc.spawn(file=sys.executable, args=[b"proc_ipc_messages.py"], exit_callback=self.proc_exit_cb, stdio=stdio)
+        for data in self.expected:
+            # all but the first message are batched until the first write completes
+            if data == b"handle":
+                self.channel.write_message(data, self.send_pipe)
+            else:
+                self.channel.write_message(data)
+        self.channel.start_read_messages(self.on_channel_message)
+        self.loop.run()
+        self.assertEqual(self.messages, self.expected)
+
+
 if __name__ == '__main__':
     unittest2.main(verbosity=2)
@@ -0,0 +1,77 @@
+
+import functools
+import time
+
+from common import unittest2
+import pyuv
+
+
+class LoopMonitorTest(unittest2.TestCase):
+
+    def test_monitor(self):
+        self.cb_called = 0
+        def timer_cb(handle):
+            self.cb_called += 1
+            # block the loop for a while
+            time.sleep(0.02)
+            if self.cb_called == 10:
+                handle.close()
+        loop = pyuv.Loop()
+        self.assertEqual(loop.monitor_stats(), None)
+        loop.start_monitor(0.005)
+        timer = pyuv.Timer(loop)
+        timer.start(timer_cb, 0.001, 0.001)
+        loop.run()
+        loop.stop_monitor()
+        stats = loop.monitor_stats(reset=True)
+        self.assertEqual(sorted(stats.keys()), ["callbacks", "iteration", "poll", "timer_delay"])
+        self.assertTrue(stats["iteration"].count >= 10)
+        self.assertTrue(stats["callbacks"].max >= 0.02)
+        self.assertTrue(stats["callbacks"].p50 <= stats["callbacks"].p99 <= stats["callbacks"].max)
+        self.assertTrue(stats["iteration"].max >= stats["callbacks"].max)
+        self.assertTrue(stats["timer_delay"].count > 0)
+        self.assertTrue(stats["timer_delay"].max >= 0.01)
+        self.assertEqual(loop.monitor_stats()["iteration"].count, 0)
+
+    def test_profiler(self):
+        self.cb_called = 0
+        def timer_cb(handle):
+            self.cb_called += 1
+            if self.cb_called == 5:
+                handle.close()
+        def stat_cb(loop, path, stat_result, errorno):
+            self.assertEqual(errorno, None)
+        loop = pyuv.Loop()
+        self.assertEqual(loop.profile_stats(), {})
+        loop.start_profiler()
+        timer = pyuv.Timer(loop)
+        timer.start(timer_cb, 0.001, 0.001)
+        pyuv.fs.stat(loop, ".", stat_cb)
+        loop.run()
+        loop.stop_profiler()
+        stats = loop.profile_stats(reset=True)
+        self.assertEqual(stats[(pyuv.Timer, "timer", timer_cb.__code__)].count, 5)
+        self.assertEqual(stats[(pyuv.Loop, "fs.stat", stat_cb.__code__)].count, 1)
+        result = stats[(pyuv.Timer, "timer", timer_cb.__code__)]
+        self.assertTrue(0 <= result.max <= result.total)
+        self.assertEqual(loop.profile_stats(), {})
+
+    def test_profiler_bounded(self):
+        loop = pyuv.Loop()
+        loop.start_profiler()
+        # lambdas created for every call share their code
+        for i in range(100):
+            loop.call_soon(lambda: None)
+        # distinct callables past the limit are accounted together
+        for i in range(1100):
+            loop.call_soon(functools.partial(int, i))
+        loop.run()
+        stats = loop.profile_stats()
+        self.assertEqual(len(stats), 1024 + 1)
+        lambdas = [v for k, v in stats.items() if hasattr(k[2], "co_name")]
+        self.assertEqual([v.count for v in lambdas], [100])
+        self.assertEqual(stats[(None, "call_soon", None)].count, 1100 - 1023)
+
+
+if __name__ == '__main__':
+    unittest2.main(verbosity=2)
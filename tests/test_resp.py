@@ -0,0 +1,113 @@
+
+from common import unittest2
+import pyuv
+
+
+TEST_PORT = 1234
+
+REPLIES = b"+OK\r\n-ERR unknown command\r\n:42\r\n$5\r\nhello\r\n$-1\r\n*3\r\n:1\r\n*2\r\n$1\r\na\r\n$0\r\n\r\n*0\r\n"
+
+
+class RESPParserTest(unittest2.TestCase):
+
+    def setUp(self):
+        self.batches = []
+        self.parser = pyuv.RESPParser(self.on_replies)
+
+    def on_replies(self, handle, replies):
+        self.batches.append(replies)
+
+    def check_replies(self, replies):
+        self.assertEqual(len(replies), 6)
+        self.assertEqual(replies[0], b"OK")
+        self.assertTrue(isinstance(replies[1], pyuv.error.RESPError))
+        self.assertEqual(replies[1].args, ("ERR unknown command",))
+        self.assertEqual(replies[2:], [42, b"hello", None, [1, [b"a", b""], []]])
+
+    def test_resp_batch(self):
+        self.parser.feed(REPLIES)
+        self.assertEqual(len(self.batches), 1)
+        self.check_replies(self.batches[0])
+
+    def test_resp_bytewise(self):
+        for i in range(len(REPLIES)):
+            self.parser.feed(REPLIES[i:i+1])
+        self.check_replies([reply for batch in self.batches for reply in batch])
+
+    def test_resp_invalid(self):
+        self.assertRaises(ValueError, self.parser.feed, b"$3\r\nabcde\r\n")
+        self.parser.reset()
+        self.parser.feed(b":1\r\n")
+        self.assertEqual(self.batches, [[1]])
+
+    def test_resp_limits(self):
+        self.assertRaises(ValueError, self.parser.feed, b"$536870913\r\n")
+        self.parser.reset()
+        self.assertRaises(ValueError, self.parser.feed, b"*1000000000\r\n")
+        self.parser.reset()
+        # the declared sizes are not allocated up front
+        self.parser.feed(b"*100000000\r\n:1\r\n$536870912\r\nabc")
+        self.assertEqual(self.batches, [])
+        self.parser.reset()
+        data = b"x" * 300000
+        self.parser.feed(b"*2\r\n$300000\r\n" + data[:1000])
+        self.parser.feed(data[1000:] + b"\r\n:1\r\n")
+        self.assertEqual(self.batches, [[[data, 1]]])
+
+    def test_resp_encode(self):
+        data = pyuv.RESPParser.encode_commands([(b"SET", u"key", 1), [b"GET", b"key"]])
+        self.assertEqual(data, b"*3\r\n$3\r\nSET\r\n$3\r\nkey\r\n$1\r\n1\r\n*2\r\n$3\r\nGET\r\n$3\r\nkey\r\n")
+        self.assertRaises(TypeError, pyuv.RESPParser.encode_commands, [(b"GET", None)])
+
+
+class RESPStreamTest(unittest2.TestCase):
+
+    def on_connection(self, server, error):
+        self.assertEqual(error, None)
+        client = pyuv.TCP(server.loop)
+        server.accept(client)
+        client.start_read(self.on_server_read)
+
+    def on_server_read(self, handle, data, error):
+        if data is None:
+            handle.close()
+            self.server.close()
+            return
+        self.received += data
+        if len(self.received) == len(self.commands):
+            self.assertEqual(self.received, self.commands)
+            # send the replies in two pieces, the second one cutting a bulk string
+            handle.write(REPLIES[:30])
+            handle.write(REPLIES[30:])
+
+    def on_client_connection(self, client, error):
+        self.assertEqual(error, None)
+        client.start_read(self.on_client_read, pyuv.RESPParser(self.on_replies))
+        client.writelines([self.commands])
+
+    def on_client_read(self, handle, data, error):
+        handle.close()
+
+    def on_replies(self, handle, replies):
+        self.replies.extend(replies)
+        if len(self.replies) == 6:
+            handle.close()
+
+    def test_resp_stream(self):
+        self.received = b""
+        self.replies = []
+        self.commands = pyuv.RESPParser.encode_commands([(b"PING",), (b"GET", b"key")] * 3)
+        loop = pyuv.Loop.default_loop()
+        self.server = pyuv.TCP(loop)
+        self.server.bind(("0.0.0.0", TEST_PORT))
+        self.server.listen(self.on_connection)
+        client = pyuv.TCP(loop)
+        client.connect(("127.0.0.1", TEST_PORT), self.on_client_connection)
+        loop.run()
+        self.assertEqual(len(self.replies), 6)
+        self.assertEqual(self.replies[2:], [42, b"hello", None, [1, [b"a", b""], []]])
+
+
+if __name__ == '__main__':
+    unittest2.main(verbosity=2)
+
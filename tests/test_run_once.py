@@ -1,4 +1,6 @@
 
+import time
+
 from common import unittest2
 import pyuv
 
@@ -18,6 +20,52 @@ class RunOnceTest(unittest2.TestCase):
         self.assertEqual(self.cb_called, 500)
 
 
+class RunModesTest(unittest2.TestCase):
+
+    def test_run_nowait(self):
+        self.cb_called = 0
+        def timer_cb(handle):
+            self.cb_called += 1
+        loop = pyuv.Loop.default_loop()
+        timer = pyuv.Timer(loop)
+        timer.start(timer_cb, 10, 0)
+        t0 = time.time()
+        self.assertTrue(loop.run(pyuv.UV_RUN_NOWAIT))
+        self.assertTrue(time.time() - t0 < 1)
+        self.assertEqual(self.cb_called, 0)
+        timer.close()
+        self.assertFalse(loop.run(mode=pyuv.UV_RUN_NOWAIT))
+        self.assertRaises(ValueError, loop.run, 42)
+
+    def test_run_for(self):
+        self.cb_called = 0
+        def timer_cb(handle):
+            self.cb_called += 1
+        loop = pyuv.Loop.default_loop()
+        timer = pyuv.Timer(loop)
+        timer.start(timer_cb, 0.01, 0.01)
+        t0 = time.time()
+        self.assertTrue(loop.run_for(0.2))
+        self.assertTrue(0.15 < time.time() - t0 < 1)
+        self.assertTrue(self.cb_called > 0)
+        timer.close()
+        # nothing keeps the loop alive, it returns right away
+        t0 = time.time()
+        self.assertFalse(loop.run_for(10))
+        self.assertTrue(time.time() - t0 < 1)
+
+    def test_loop_dealloc(self):
+        # the internal handles of a loop are closed when it's deallocated, so many loops
+        # using them can be created without running out of file descriptors
+        for i in range(500):
+            loop = pyuv.Loop()
+            loop.start_monitor(0.005)
+            loop.call_soon(lambda: None)
+            loop.run(pyuv.UV_RUN_NOWAIT)
+            loop.run_for(0.001)
+            del loop
+
+
 if __name__ == '__main__':
     unittest2.main(verbosity=2)
 
@@ -0,0 +1,100 @@
+
+import mmap
+import os
+import struct
+import sys
+
+from common import unittest2
+import pyuv
+
+
+@unittest2.skipUnless(hasattr(pyuv, "SharedRing"), "SharedRing is not available in the current platform")
+class SharedRingTest(unittest2.TestCase):
+
+    def on_messages(self, ring, messages, error):
+        self.assertEqual(error, None)
+        self.messages.extend(messages)
+        if len(self.messages) == len(self.expected):
+            ring.close()
+
+    def test_sharedring(self):
+        self.messages = []
+        self.expected = [("message %d" % i).encode() for i in range(1000)] + [b"", b"x" * 60000]
+        loop = pyuv.Loop.default_loop()
+        ring = pyuv.SharedRing(loop, size=100000)
+        self.assertEqual(ring.size, 131072)
+        # a second mapping of the same ring, as another process would have
+        producer = pyuv.SharedRing(loop, fds=ring.fds)
+        self.assertEqual(producer.size, ring.size)
+        self.assertRaises(ValueError, producer.put, b"x" * 70000)
+        ring.start(self.on_messages)
+        for data in self.expected:
+            self.assertTrue(producer.put(data))
+        producer.close()
+        loop.run()
+        self.assertEqual(self.messages, self.expected)
+
+    def test_sharedring_full(self):
+        loop = pyuv.Loop.default_loop()
+        ring = pyuv.SharedRing(loop, size=4096)
+        count = 0
+        while ring.put(b"x" * 100):
+            count += 1
+        self.assertEqual(count, 4096 // 128)
+        ring.close()
+        loop.run()
+
+    def test_sharedring_corrupted(self):
+        self.messages = []
+        loop = pyuv.Loop.default_loop()
+        ring = pyuv.SharedRing(loop, size=4096)
+        memfd, eventfd = ring.fds
+        # a committed record which claims to be larger than the ring, right after the header
+        m = mmap.mmap(memfd, 0)
+        struct.pack_into("=IIQ", m, 256, 0x7fffffff, 0, 1)
+        m.close()
+        os.write(eventfd, struct.pack("=Q", 1))
+        ring.start(lambda h, messages, error: self.messages.append(messages))
+        timer = pyuv.Timer(loop)
+        timer.start(lambda t: (ring.close(), t.close()), 0.1, 0)
+        loop.run()
+        self.assertEqual(self.messages, [])
+        self.assertRaises(pyuv.error.HandleClosedError, getattr, ring, "fds")
+
+
+@unittest2.skipUnless(hasattr(pyuv, "SharedRing"), "SharedRing is not available in the current platform")
+class SharedRingIPCTest(unittest2.TestCase):
+
+    def proc_exit_cb(self, proc, exit_status, term_signal):
+        proc.close()
+
+    def on_messages(self, ring, messages, error):
+        self.assertEqual(error, None)
+        self.messages.extend(messages)
+        if len(self.messages) == 1000:
+            ring.close()
+
+    def on_channel_message(self, handle, data, fd, error):
+        # the child closes the channel once it's done
+        self.assertEqual(data, None)
+        self.channel.close()
+
+    def test_sharedring_ipc(self):
+        self.messages = []
+        loop = pyuv.Loop.default_loop()
+        ring = pyuv.SharedRing(loop, size=16384)
+        ring.start(self.on_messages)
+        self.channel = pyuv.Pipe(loop, True)
+        stdio = [pyuv.StdIO(stream=self.channel, flags=pyuv.UV_CREATE_PIPE|pyuv.UV_READABLE_PIPE|pyuv.UV_WRITABLE_PIPE)]
+        proc = pyuv.Process(loop)
+        proc.spawn(file=sys.executable, args=[b"proc_sharedring.py"], exit_callback=self.proc_exit_cb, stdio=stdio)
+        memfd, eventfd = ring.fds
+        self.channel.write_message(b"memfd", memfd)
+        self.channel.write_message(b"eventfd", eventfd)
+        self.channel.start_read_messages(self.on_channel_message)
+        loop.run()
+        self.assertEqual(self.messages, [("message %d" % i).encode() for i in range(1000)])
+
+
+if __name__ == '__main__':
+    unittest2.main(verbosity=2)
@@ -35,6 +35,51 @@ class TCPErrorTest(unittest2.TestCase):
         loop.run()
 
 
+class TCPStatsTest(unittest2.TestCase):
+
+    def on_connection(self, server, error):
+        self.assertEqual(error, None)
+        client = pyuv.TCP(server.loop)
+        server.accept(client)
+        client.start_read(self.on_server_read)
+        self.server_client = client
+
+    def on_server_read(self, client, data, error):
+        if data is None:
+            client.close()
+            self.server.close()
+            return
+        self.received += len(data)
+
+    def on_client_connection(self, client, error):
+        self.assertEqual(error, None)
+        client.write(b"PING")
+        client.writelines([b"PI", b"NG"])
+        client.shutdown(self.on_client_shutdown)
+
+    def on_client_shutdown(self, client, error):
+        client.close()
+
+    def test_tcp_stats(self):
+        self.received = 0
+        loop = pyuv.Loop()
+        self.server = pyuv.TCP(loop)
+        self.server.bind(("0.0.0.0", TEST_PORT))
+        self.server.listen(self.on_connection)
+        client = pyuv.TCP(loop)
+        self.assertEqual(client.stats, (0, 0, 0, 0, 0, 0))
+        client.connect(("127.0.0.1", TEST_PORT), self.on_client_connection)
+        loop.run()
+        self.assertEqual(client.stats.writes, 2)
+        self.assertEqual(client.stats.bytes_written, 8)
+        self.assertEqual(client.stats.errors, 0)
+        self.assertEqual(self.server_client.stats.bytes_read, 8)
+        self.assertEqual(self.received, 8)
+        self.assertTrue(self.server_client.stats.reads >= 1)
+        self.assertEqual(loop.handle_stats.bytes_read, 8)
+        self.assertEqual(loop.handle_stats.bytes_written, 8)
+
+
 class TCPTest(unittest2.TestCase):
 
     def setUp(self):
@@ -427,6 +472,119 @@ class TCPShutdownTest(unittest2.TestCase):
         self.assertEqual(self.close_cb_called, 3)
 
 
+@unittest2.skipUnless(hasattr(pyuv, 'COMPRESS_DEFLATE'), "deflate compression not compiled in")
+class TCPCompressionTest(unittest2.TestCase):
+
+    def setUp(self):
+        self.loop = pyuv.Loop.default_loop()
+        self.server = None
+        self.client = None
+        self.client_connections = []
+        self.received = []
+
+    def on_connection(self, server, error):
+        client = pyuv.TCP(pyuv.Loop.default_loop())
+        server.accept(client)
+        client.set_compression(pyuv.COMPRESS_DEFLATE, flush_threshold=1024)
+        self.assertEqual(client.compression, pyuv.COMPRESS_DEFLATE)
+        self.client_connections.append(client)
+        client.start_read(self.on_client_connection_read)
+        client.write(b"PING"*100)
+        client.writelines([b"PING1", b"PING2"])
+        client.flush()
+
+    def on_client_connection_read(self, client, data, error):
+        if data is None:
+            client.close()
+            self.client_connections.remove(client)
+            self.server.close()
+            return
+
+    def on_client_connection(self, client, error):
+        self.assertEquals(error, None)
+        client.set_compression(pyuv.COMPRESS_DEFLATE)
+        client.start_read(self.on_client_read)
+
+    def on_client_read(self, client, data, error):
+        self.assertEqual(error, None)
+        self.received.append(data)
+        if b"".join(self.received) == b"PING"*100 + b"PING1PING2":
+            client.close()
+
+    def test_tcp_compression(self):
+        self.server = pyuv.TCP(self.loop)
+        self.server.bind(("0.0.0.0", TEST_PORT))
+        self.server.listen(self.on_connection)
+        self.client = pyuv.TCP(self.loop)
+        self.client.connect(("127.0.0.1", TEST_PORT), self.on_client_connection)
+        self.loop.run()
+        self.assertEqual(b"".join(self.received), b"PING"*100 + b"PING1PING2")
+
+    def test_tcp_compression_held_callbacks(self):
+        calls = []
+        received = []
+        def on_flush_timer(timer):
+            timer.close()
+            # the data is still buffered by the compressor, so is the write callback
+            self.assertEqual(calls, [])
+            connection = state[0]
+            connection.flush(lambda c, e: calls.append(("flush", e)))
+            connection.shutdown(lambda c, e: c.close())
+            self.server.close()
+        def on_connection(server, error):
+            connection = pyuv.TCP(self.loop)
+            server.accept(connection)
+            connection.set_compression(pyuv.COMPRESS_DEFLATE, flush_threshold=1024)
+            connection.write(b"PING", lambda c, e: calls.append(("write", e)))
+            state.append(connection)
+            pyuv.Timer(self.loop).start(on_flush_timer, 0.05, 0)
+        def on_client_read(client, data, error):
+            if data is None:
+                client.close()
+                return
+            received.append(data)
+        def on_client_connection(client, error):
+            self.assertEqual(error, None)
+            client.set_compression(pyuv.COMPRESS_DEFLATE)
+            client.start_read(on_client_read)
+        state = []
+        self.server = pyuv.TCP(self.loop)
+        self.server.bind(("0.0.0.0", TEST_PORT))
+        self.server.listen(on_connection)
+        self.client = pyuv.TCP(self.loop)
+        self.client.connect(("127.0.0.1", TEST_PORT), on_client_connection)
+        self.loop.run()
+        self.assertEqual(calls, [("write", None), ("flush", None)])
+        self.assertEqual(b"".join(received), b"PING")
+
+    def test_tcp_compression_max_size(self):
+        errors = []
+        def on_connection(server, error):
+            client = pyuv.TCP(self.loop)
+            server.accept(client)
+            client.set_compression(pyuv.COMPRESS_DEFLATE)
+            client.write(b"\0" * 65536)
+            client.close()
+            server.close()
+        def on_client_read(client, data, error):
+            if error is not None:
+                errors.append(error)
+                client.close()
+        def on_client_connection(client, error):
+            self.assertEqual(error, None)
+            # the payload compresses to a single read, which expands beyond the limit
+            client.set_compression(pyuv.COMPRESS_DEFLATE, max_size=1024)
+            client.start_read(on_client_read)
+        self.server = pyuv.TCP(self.loop)
+        self.server.bind(("0.0.0.0", TEST_PORT))
+        self.server.listen(on_connection)
+        self.client = pyuv.TCP(self.loop)
+        self.assertRaises(ValueError, self.client.set_compression, pyuv.COMPRESS_DEFLATE, max_size=-1)
+        self.client.connect(("127.0.0.1", TEST_PORT), on_client_connection)
+        self.loop.run()
+        self.assertEqual(errors, [pyuv.errno.UV_EPROTO])
+
+
 class TCPFlagsTest(unittest2.TestCase):
 
     def test_tcp_flags(self):
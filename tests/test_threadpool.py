@@ -1,5 +1,8 @@
 
+import base64
 import functools
+import hashlib
+import sys
 import threading
 import time
 
@@ -46,6 +49,301 @@ class ThreadPoolTest(unittest2.TestCase):
         self.loop.run()
 
 
+class ThreadPoolFutureTest(unittest2.TestCase):
+
+    def test_future(self):
+        self.done = []
+        def done_cb(future):
+            self.done.append(future.result())
+        loop = pyuv.Loop()
+        pool = pyuv.ThreadPool(loop)
+        futures = [pool.queue_work(functools.partial(pow, i, 2)) for i in range(100)]
+        for future in futures:
+            self.assertFalse(future.done())
+            self.assertRaises(pyuv.error.ThreadPoolError, future.result)
+            future.add_done_callback(done_cb)
+        loop.run()
+        self.assertEqual([f.result() for f in futures], [i * i for i in range(100)])
+        self.assertEqual(sorted(self.done), [i * i for i in range(100)])
+        self.assertTrue(all(f.done() and f.exception() is None for f in futures))
+
+    def test_future_exception(self):
+        def raise_in_pool():
+            1/0
+        loop = pyuv.Loop()
+        pool = pyuv.ThreadPool(loop)
+        future = pool.queue_work(raise_in_pool)
+        loop.run()
+        self.assertTrue(future.done())
+        self.assertTrue(isinstance(future.exception(), ZeroDivisionError))
+        self.assertRaises(ZeroDivisionError, future.result)
+
+    def test_future_done_callback_after_done(self):
+        self.done = []
+        loop = pyuv.Loop()
+        pool = pyuv.ThreadPool(loop)
+        future = pool.queue_work(lambda: 42)
+        loop.run()
+        # callbacks added to a done future are called on the next loop iteration
+        future.add_done_callback(self.done.append)
+        self.assertEqual(self.done, [])
+        loop.run()
+        self.assertEqual(self.done, [future])
+
+    def test_future_iter(self):
+        loop = pyuv.Loop()
+        pool = pyuv.ThreadPool(loop)
+        future = pool.queue_work(lambda: 42)
+        it = iter(future)
+        # a pending future yields itself, a done one returns its result through StopIteration
+        self.assertTrue(next(it) is future)
+        loop.run()
+        try:
+            next(it)
+        except StopIteration as e:
+            self.assertEqual(e.args[0], 42)
+        else:
+            self.fail("StopIteration not raised")
+
+    @unittest2.skipUnless(sys.version_info >= (3, 5), "await requires Python 3.5")
+    def test_future_await(self):
+        # minimal coroutine driver: resume the coroutine when the future it waits on is done
+        self.results = []
+        ns = {}
+        exec("async def coro(pool):\n"
+             "    a = await pool.queue_work(lambda: 2)\n"
+             "    b = await pool.queue_work(lambda: 3)\n"
+             "    return a * b\n", ns)
+        loop = pyuv.Loop()
+        pool = pyuv.ThreadPool(loop)
+        def step(coro):
+            try:
+                future = coro.send(None)
+            except StopIteration as e:
+                self.results.append(e.value)
+                return
+            future.add_done_callback(lambda f: step(coro))
+        step(ns['coro'](pool))
+        loop.run()
+        self.assertEqual(self.results, [6])
+
+    @unittest2.skipUnless(sys.version_info >= (3, 7), "asyncio.run requires Python 3.7")
+    def test_future_asyncio(self):
+        # futures awaited by asyncio tasks, with the pyuv loop pumped from the asyncio loop
+        import asyncio
+        ns = {'asyncio': asyncio, 'pyuv': pyuv}
+        exec("async def failing(pool):\n"
+             "    try:\n"
+             "        await pool.queue_work(lambda: 1/0)\n"
+             "    except ZeroDivisionError:\n"
+             "        return 'error'\n"
+             "async def pump(loop):\n"
+             "    while True:\n"
+             "        loop.run(pyuv.UV_RUN_NOWAIT)\n"
+             "        await asyncio.sleep(0.001)\n"
+             "async def main(loop, pool):\n"
+             "    pumping = asyncio.ensure_future(pump(loop))\n"
+             "    try:\n"
+             "        works = [pool.queue_work(lambda i=i: i * i) for i in range(10)]\n"
+             "        return await asyncio.gather(failing(pool), *works)\n"
+             "    finally:\n"
+             "        pumping.cancel()\n", ns)
+        loop = pyuv.Loop()
+        pool = pyuv.ThreadPool(loop)
+        results = asyncio.run(ns['main'](loop, pool))
+        self.assertEqual(results, ['error'] + [i * i for i in range(10)])
+
+
+class ThreadPoolPriorityTest(unittest2.TestCase):
+
+    def setUp(self):
+        # keep the pool threads from picking work while it's being queued
+        if hasattr(sys, 'getswitchinterval'):
+            self.interval = sys.getswitchinterval()
+            sys.setswitchinterval(100)
+
+    def tearDown(self):
+        if hasattr(sys, 'getswitchinterval'):
+            sys.setswitchinterval(self.interval)
+
+    def test_priority(self):
+        self.started = []
+        loop = pyuv.Loop()
+        pool = pyuv.ThreadPool(loop)
+        for i in range(10):
+            pool.queue_work(functools.partial(self.started.append, ('background', i)))
+        for i in range(3):
+            pool.queue_work(functools.partial(self.started.append, ('interactive', i)), priority=10)
+        pool.queue_work(functools.partial(self.started.append, ('idle', 0)), None, -1)
+        loop.run()
+        expected = [('interactive', i) for i in range(3)] + [('background', i) for i in range(10)] + [('idle', 0)]
+        if hasattr(sys, 'getswitchinterval'):
+            self.assertEqual(self.started, expected)
+        else:
+            self.assertEqual(sorted(self.started), sorted(expected))
+
+    def test_cancel(self):
+        self.after_work = []
+        self.done = []
+        def after_work_cb(result, error):
+            self.after_work.append((result, error))
+        loop = pyuv.Loop()
+        pool = pyuv.ThreadPool(loop)
+        futures = [pool.queue_work(functools.partial(pow, i, 2), after_work_cb) for i in range(10)]
+        futures[5].add_done_callback(self.done.append)
+        self.assertTrue(futures[5].cancel())
+        self.assertTrue(futures[5].done())
+        self.assertTrue(futures[5].cancelled())
+        self.assertEqual(self.done, [futures[5]])
+        self.assertEqual(len(self.after_work), 1)
+        self.assertEqual(self.after_work[0][0], None)
+        self.assertEqual(self.after_work[0][1][0], pyuv.error.ThreadPoolError)
+        self.assertFalse(futures[5].cancel())
+        self.assertRaises(pyuv.error.ThreadPoolError, futures[5].result)
+        self.assertTrue(isinstance(futures[5].exception(), pyuv.error.ThreadPoolError))
+        loop.run()
+        self.assertEqual(len(self.after_work), 10)
+        self.assertEqual([f.result() for f in futures if not f.cancelled()], [i * i for i in range(10) if i != 5])
+        self.assertFalse(futures[0].cancel())
+        self.assertFalse(futures[0].cancelled())
+
+
+class ThreadPoolBatchTest(unittest2.TestCase):
+
+    def test_batch(self):
+        self.batches = []
+        def after_work_cb(start, results, errors):
+            self.assertEqual(errors, None)
+            self.batches.append((start, results))
+        loop = pyuv.Loop()
+        pool = pyuv.ThreadPool(loop)
+        future = pool.queue_work_batch(lambda x: x * 2, range(1000), after_work_cb, chunksize=100)
+        loop.run()
+        self.assertEqual(len(self.batches), 10)
+        self.assertEqual(sorted(start for start, results in self.batches), list(range(0, 1000, 100)))
+        for start, results in self.batches:
+            self.assertEqual(results, [x * 2 for x in range(start, start + 100)])
+        self.assertEqual(future.result(), [x * 2 for x in range(1000)])
+
+    def test_batch_errors(self):
+        self.errors = []
+        def work(x):
+            if x % 10 == 3:
+                raise ValueError(x)
+            return x
+        def after_work_cb(start, results, errors):
+            if errors is not None:
+                self.errors.extend(start + i for i, e in enumerate(errors) if e is not None)
+        loop = pyuv.Loop()
+        pool = pyuv.ThreadPool(loop)
+        future = pool.queue_work_batch(work, range(50), after_work_cb, chunksize=7)
+        loop.run()
+        self.assertEqual(sorted(self.errors), list(range(3, 50, 10)))
+        self.assertTrue(isinstance(future.exception(), ValueError))
+
+    def test_batch_default_chunksize(self):
+        loop = pyuv.Loop()
+        pool = pyuv.ThreadPool(loop)
+        future = pool.queue_work_batch(str, (i for i in range(100)))
+        empty = pool.queue_work_batch(str, [])
+        self.assertTrue(empty.done())
+        self.assertEqual(empty.result(), [])
+        loop.run()
+        self.assertEqual(future.result(), [str(i) for i in range(100)])
+        self.assertRaises(ValueError, pool.queue_work_batch, str, [1], None, -1)
+        self.assertRaises(TypeError, pool.queue_work_batch, None, [1])
+
+
+class ThreadPoolNativeTest(unittest2.TestCase):
+
+    def setUp(self):
+        self.loop = pyuv.Loop()
+        self.pool = pyuv.ThreadPool(self.loop)
+        self.data = b''.join(str(i).encode() for i in range(20000))
+
+    def test_hash(self):
+        import zlib
+        self.results = []
+        def after_work_cb(result, error):
+            self.assertEqual(error, None)
+            self.results.append(result)
+        sha1 = self.pool.hash(self.data, 'sha1', after_work_cb)
+        sha256 = self.pool.hash(memoryview(self.data), 'sha256')
+        crc32 = self.pool.hash(bytearray(self.data), 'crc32')
+        empty = self.pool.hash(b'', 'sha256')
+        self.loop.run()
+        self.assertEqual(self.results, [hashlib.sha1(self.data).digest()])
+        self.assertEqual(sha1.result(), hashlib.sha1(self.data).digest())
+        self.assertEqual(sha256.result(), hashlib.sha256(self.data).digest())
+        self.assertEqual(crc32.result(), zlib.crc32(self.data) & 0xffffffff)
+        self.assertEqual(empty.result(), hashlib.sha256(b'').digest())
+        self.assertRaises(ValueError, self.pool.hash, self.data, 'md5')
+        self.assertRaises(TypeError, self.pool.hash, 42, 'sha1')
+
+    def test_hash_block_boundaries(self):
+        import zlib
+        # lengths around the 64 bytes SHA block, where the padding needs one or two blocks
+        data = [bytes(bytearray(range(n))) for n in (0, 1, 55, 56, 63, 64, 65, 119, 120, 128)]
+        sha1 = [self.pool.hash(d, 'sha1') for d in data]
+        sha256 = [self.pool.hash(d, 'sha256') for d in data]
+        crc32 = [self.pool.hash(d, 'crc32') for d in data]
+        self.loop.run()
+        self.assertEqual([f.result() for f in sha1], [hashlib.sha1(d).digest() for d in data])
+        self.assertEqual([f.result() for f in sha256], [hashlib.sha256(d).digest() for d in data])
+        self.assertEqual([f.result() for f in crc32], [zlib.crc32(d) & 0xffffffff for d in data])
+
+    def test_mutable_buffer(self):
+        # mutable buffers are copied, so they can be modified (and resized) while the work runs
+        data = bytearray(self.data)
+        future = self.pool.hash(data, 'sha256')
+        data[:] = b'x'
+        self.loop.run()
+        self.assertEqual(future.result(), hashlib.sha256(self.data).digest())
+
+    def test_base64(self):
+        encoded = self.pool.b64encode(self.data)
+        decoded = self.pool.b64decode(base64.b64encode(self.data))
+        invalid = self.pool.b64decode(b'QQ=A')
+        self.loop.run()
+        self.assertEqual(encoded.result(), base64.b64encode(self.data))
+        self.assertEqual(decoded.result(), self.data)
+        self.assertTrue(isinstance(invalid.exception(), pyuv.error.ThreadPoolError))
+
+    def test_compare_find(self):
+        futures = [self.pool.compare(self.data, self.data),
+                   self.pool.compare(self.data, self.data[:-1]),
+                   self.pool.compare(b'abc', b'abd'),
+                   self.pool.find(self.data, b'19999'),
+                   self.pool.find(self.data, b'xyz')]
+        self.loop.run()
+        self.assertEqual([f.result() for f in futures], [0, 1, -1, self.data.find(b'19999'), -1])
+
+    @unittest2.skipUnless(hasattr(pyuv.ThreadPool, 'compress'), 'zlib support not available')
+    def test_compress(self):
+        import zlib
+        compressed = self.pool.compress(self.data, 9)
+        decompressed = self.pool.decompress(zlib.compress(self.data))
+        invalid = self.pool.decompress(b'not zlib data')
+        self.loop.run()
+        self.assertEqual(zlib.decompress(compressed.result()), self.data)
+        self.assertEqual(decompressed.result(), self.data)
+        self.assertTrue(isinstance(invalid.exception(), pyuv.error.ThreadPoolError))
+        self.assertRaises(ValueError, self.pool.compress, self.data, 10)
+
+    @unittest2.skipUnless(hasattr(pyuv.ThreadPool, 'compress'), 'zlib support not available')
+    def test_decompress_max_size(self):
+        import zlib
+        bomb = zlib.compress(b'\0' * (1024 * 1024))
+        exact = self.pool.decompress(bomb, max_size=1024 * 1024)
+        too_large = self.pool.decompress(bomb, max_size=1024 * 1024 - 1)
+        truncated = self.pool.decompress(bomb[:-10])
+        self.loop.run()
+        self.assertEqual(exact.result(), b'\0' * (1024 * 1024))
+        self.assertTrue(isinstance(too_large.exception(), pyuv.error.ThreadPoolError))
+        self.assertTrue(isinstance(truncated.exception(), pyuv.error.ThreadPoolError))
+        self.assertRaises(ValueError, self.pool.decompress, bomb, max_size=-1)
+
+
 class ThreadPoolMultiLoopTest(unittest2.TestCase):
 
     def setUp(self):
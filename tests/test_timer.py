@@ -1,3 +1,4 @@
+import time
 
 from common import unittest2
 import pyuv
@@ -57,6 +58,76 @@ class TimerTest(unittest2.TestCase):
         loop.run()
         self.assertEqual(self.timer_cb_called, 1)
 
+    def test_timer_slack(self):
+        self.fired = []
+        def timer_cb(timer):
+            self.fired.append(loop.now())
+            timer.close()
+        loop = pyuv.Loop()
+        timers = []
+        # pick deadlines which all fall in the same 100ms window, relative to the loop time the
+        # timers are started with, at least 40ms from now
+        now = loop.now()
+        boundary = (now // 100 + 2) * 100
+        for offset in (1, 20, 40, 60):
+            timer = pyuv.Timer(loop)
+            timer.start(timer_cb, (boundary - now - offset + 0.5) / 1000.0, 0, slack=0.1)
+            self.assertEqual(timer.slack, 0.1)
+            timers.append(timer)
+        loop.run()
+        self.assertEqual(len(self.fired), 4)
+        # all deadlines were rounded up to the same 100ms boundary, so they fired in one pass
+        self.assertEqual(len(set(self.fired)), 1)
+        self.assertTrue(self.fired[0] >= boundary)
+        self.assertRaises(ValueError, pyuv.Timer(loop).start, timer_cb, 0.1, 0, -1)
+
+    def test_timer_slack_repeat(self):
+        self.fired = []
+        def timer_cb(timer):
+            self.fired.append(loop.now())
+            if len(self.fired) == 3:
+                timer.close()
+        loop = pyuv.Loop()
+        timer = pyuv.Timer(loop)
+        timer.start(timer_cb, 0.01, 0.03, slack=0.02)
+        loop.run()
+        self.assertEqual(len(self.fired), 3)
+        self.assertTrue(self.fired[0] < self.fired[1] < self.fired[2])
+
+    def test_timer_slack_repeat_drift(self):
+        self.fired = []
+        def timer_cb(timer):
+            self.fired.append(loop.now())
+            # run late, the next deadline must still be one period after the previous one
+            time.sleep(0.005)
+            if len(self.fired) == 5:
+                timer.close()
+        loop = pyuv.Loop()
+        timer = pyuv.Timer(loop)
+        timer.start(timer_cb, 0.1, 0.1, slack=0.05)
+        loop.run()
+        self.assertEqual(len(self.fired), 5)
+        # rescheduling from the time the callback ran would add up to a slack window per period
+        self.assertTrue(self.fired[4] - self.fired[0] < 500)
+
+    def test_timer_slack_again(self):
+        self.fired = []
+        def timer_cb(timer):
+            self.fired.append(loop.now())
+            timer.close()
+        def restart_cb(timer):
+            self.started = loop.now()
+            timers[0].again()
+            timer.close()
+        loop = pyuv.Loop()
+        timers = [pyuv.Timer(loop), pyuv.Timer(loop)]
+        timers[0].start(timer_cb, 10, 0.05, slack=0.1)
+        timers[1].start(restart_cb, 0.01, 0)
+        loop.run()
+        self.assertEqual(len(self.fired), 1)
+        # restarted with the 50ms repeat, rounded up to the next 100ms boundary
+        self.assertTrue(self.fired[0] >= (self.started + 50 + 99) // 100 * 100)
+
 
 if __name__ == '__main__':
     unittest2.main(verbosity=2)
@@ -0,0 +1,81 @@
+
+from common import unittest2
+import pyuv
+
+
+class TimerWheelTest(unittest2.TestCase):
+
+    def test_timerwheel1(self):
+        self.fired = []
+        def wheel_cb(wheel, entries):
+            self.fired.extend(entry.data for entry in entries)
+            for entry in entries:
+                self.assertFalse(entry.scheduled)
+            if wheel.pending == 0:
+                wheel.close()
+        loop = pyuv.Loop()
+        wheel = pyuv.TimerWheel(loop, wheel_cb, 0.01)
+        self.assertEqual(wheel.resolution, 0.01)
+        for i, timeout in enumerate((0.05, 0.01, 0.2, 0.1)):
+            entry = wheel.schedule(timeout, i)
+            self.assertTrue(entry.scheduled)
+        self.assertEqual(wheel.pending, 4)
+        loop.run()
+        self.assertEqual(self.fired, [1, 0, 3, 2])
+
+    def test_timerwheel_cancel(self):
+        self.fired = []
+        def wheel_cb(wheel, entries):
+            self.fired.extend(entry.data for entry in entries)
+            if wheel.pending == 0:
+                wheel.close()
+        loop = pyuv.Loop()
+        wheel = pyuv.TimerWheel(loop, wheel_cb)
+        entry1 = wheel.schedule(0.05, 'a')
+        entry2 = wheel.schedule(0.1, 'b')
+        self.assertTrue(wheel.cancel(entry1))
+        self.assertFalse(wheel.cancel(entry1))
+        self.assertFalse(entry1.scheduled)
+        self.assertEqual(wheel.pending, 1)
+        loop.run()
+        self.assertEqual(self.fired, ['b'])
+        self.assertFalse(wheel.cancel(entry2))
+
+    def test_timerwheel_reschedule(self):
+        self.fired = []
+        def wheel_cb(wheel, entries):
+            self.fired.extend(entry.data for entry in entries)
+            if wheel.pending == 0:
+                wheel.close()
+        loop = pyuv.Loop()
+        wheel = pyuv.TimerWheel(loop, wheel_cb)
+        entry1 = wheel.schedule(0.02, 'a')
+        wheel.schedule(0.1, 'b')
+        wheel.reschedule(entry1, 0.3)
+        self.assertEqual(wheel.pending, 2)
+        loop.run()
+        self.assertEqual(self.fired, ['b', 'a'])
+        # a fired entry can be scheduled again
+        self.fired = []
+        wheel = pyuv.TimerWheel(loop, wheel_cb)
+        wheel.reschedule(entry1, 0.01)
+        loop.run()
+        self.assertEqual(self.fired, ['a'])
+
+    def test_timerwheel_errors(self):
+        loop = pyuv.Loop()
+        self.assertRaises(ValueError, pyuv.TimerWheel, loop, lambda *args: None, 0.0001)
+        self.assertRaises(TypeError, pyuv.TimerWheel, loop, None)
+        wheel1 = pyuv.TimerWheel(loop, lambda *args: None)
+        wheel2 = pyuv.TimerWheel(loop, lambda *args: None)
+        self.assertRaises(ValueError, wheel1.schedule, -1)
+        self.assertRaises(TypeError, wheel1.cancel, None)
+        entry = wheel1.schedule(1.0)
+        self.assertRaises(ValueError, wheel2.reschedule, entry, 1.0)
+        wheel1.close()
+        wheel2.close()
+        loop.run()
+
+
+if __name__ == '__main__':
+    unittest2.main(verbosity=2)
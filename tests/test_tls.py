@@ -0,0 +1,150 @@
+
+import os
+
+from common import unittest2
+import pyuv
+
+
+TEST_PORT = 1234
+CERTFILE = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'tls_cert.pem')
+
+
+@unittest2.skipUnless(hasattr(pyuv, 'TLSStream'), "TLS support not compiled in")
+class TLSTest(unittest2.TestCase):
+
+    def setUp(self):
+        self.loop = pyuv.Loop.default_loop()
+        self.server_ctx = pyuv.TLSContext(server_side=True, certfile=CERTFILE)
+        self.client_ctx = pyuv.TLSContext()
+        self.server = None
+        self.connections = []
+        self.received = []
+        self.reused = []
+
+    def on_connection(self, server, error):
+        self.assertEqual(error, None)
+        client = pyuv.TCP(self.loop)
+        server.accept(client)
+        tls = pyuv.TLSStream(client, self.server_ctx)
+        self.connections.append(tls)
+        tls.do_handshake(self.on_server_handshake)
+
+    def on_server_handshake(self, tls, error):
+        self.assertEqual(error, None)
+        tls.start_read(self.on_server_read)
+
+    def on_server_read(self, tls, data, error):
+        if data is None:
+            tls.stream.close()
+            self.connections.remove(tls)
+            return
+        tls.write(data)
+
+    def on_client_connection(self, client, error):
+        self.assertEqual(error, None)
+        tls = pyuv.TLSStream(client, self.client_ctx, server_hostname="localhost")
+        # data written before the handshake completes is queued
+        tls.write(b"PING")
+        tls.do_handshake(self.on_client_handshake)
+
+    def on_client_handshake(self, tls, error):
+        self.assertEqual(error, None)
+        self.assertTrue(tls.handshake_done)
+        self.reused.append(tls.session_reused)
+        tls.start_read(self.on_client_read)
+
+    def on_client_read(self, tls, data, error):
+        self.assertEqual(error, None)
+        self.received.append(data)
+        tls.stream.close()
+
+    def test_tls_echo(self):
+        self.server = pyuv.TCP(self.loop)
+        self.server.bind(("0.0.0.0", TEST_PORT))
+        self.server.listen(self.on_connection)
+        client = pyuv.TCP(self.loop)
+        client.connect(("127.0.0.1", TEST_PORT), self.on_client_connection)
+        def check(timer):
+            if self.received and not self.connections:
+                timer.close()
+                self.server.close()
+        timer = pyuv.Timer(self.loop)
+        timer.start(check, 0.05, 0.05)
+        self.loop.run()
+        self.assertEqual(self.received, [b"PING"])
+        self.assertEqual(self.reused, [False])
+
+    def test_tls_session_resumption(self):
+        self.server = pyuv.TCP(self.loop)
+        self.server.bind(("0.0.0.0", TEST_PORT))
+        self.server.listen(self.on_connection)
+        def check(timer):
+            if self.connections or len(self.received) < len(self.reused):
+                return
+            if len(self.reused) == 1:
+                client = pyuv.TCP(self.loop)
+                client.connect(("127.0.0.1", TEST_PORT), self.on_client_connection)
+            elif len(self.reused) == 2:
+                timer.close()
+                self.server.close()
+        client = pyuv.TCP(self.loop)
+        client.connect(("127.0.0.1", TEST_PORT), self.on_client_connection)
+        timer = pyuv.Timer(self.loop)
+        timer.start(check, 0.05, 0.05)
+        self.loop.run()
+        self.assertEqual(self.received, [b"PING", b"PING"])
+        self.assertEqual(self.reused, [False, True])
+
+    def test_tls_verify_hostname(self):
+        self.client_ctx = pyuv.TLSContext(cafile=CERTFILE, verify=True)
+        errors = []
+        certs = []
+        def on_handshake(tls, error):
+            errors.append(error)
+            if error is None:
+                certs.append(tls.getpeercert())
+                self.assertTrue(tls.getpeercert(True))
+            tls.stream.close()
+        def on_client_connection(hostname):
+            def cb(client, error):
+                self.assertEqual(error, None)
+                tls = pyuv.TLSStream(client, self.client_ctx, server_hostname=hostname)
+                tls.do_handshake(on_handshake)
+            return cb
+        def on_connection(server, error):
+            client = pyuv.TCP(self.loop)
+            server.accept(client)
+            tls = pyuv.TLSStream(client, self.server_ctx)
+            tls.do_handshake(lambda tls, error: tls.stream.close())
+        self.server = pyuv.TCP(self.loop)
+        self.server.bind(("0.0.0.0", TEST_PORT))
+        self.server.listen(on_connection)
+        for hostname in ("localhost", "example.com"):
+            client = pyuv.TCP(self.loop)
+            client.connect(("127.0.0.1", TEST_PORT), on_client_connection(hostname))
+        def check(timer):
+            if len(errors) == 2:
+                timer.close()
+                self.server.close()
+        timer = pyuv.Timer(self.loop)
+        timer.start(check, 0.05, 0.05)
+        self.loop.run()
+        self.assertEqual(len([e for e in errors if e is None]), 1)
+        self.assertEqual(len(certs), 1)
+        self.assertTrue((('commonName', 'localhost'),) in certs[0]['subject'])
+        self.assertRaises(pyuv.error.TLSError, pyuv.TLSStream, pyuv.TCP(self.loop), self.client_ctx)
+
+    def test_tls_uninitialized(self):
+        tls = pyuv.TLSStream.__new__(pyuv.TLSStream)
+        self.assertRaises(pyuv.error.TLSError, tls.start_read, lambda *args: None)
+        self.assertRaises(pyuv.error.TLSError, tls.getpeercert)
+        self.assertRaises(pyuv.error.TLSError, getattr, tls, 'session_reused')
+        ctx = pyuv.TLSContext.__new__(pyuv.TLSContext)
+        self.assertRaises(pyuv.error.TLSError, ctx.clear_sessions)
+
+    def test_tls_bad_context(self):
+        self.assertRaises(pyuv.error.TLSError, pyuv.TLSContext, certfile="/nonexistent")
+
+
+if __name__ == '__main__':
+    unittest2.main(verbosity=2)
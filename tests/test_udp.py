@@ -53,6 +53,10 @@ class UDPTest(unittest2.TestCase):
         timer.start(self.timer_cb, 0.1, 0)
         self.loop.run()
         self.assertEqual(self.on_close_called, 3)
+        self.assertEqual(self.client.stats.writes, 1)
+        self.assertEqual(self.client.stats.bytes_written, len(b"PING"+common.linesep))
+        self.assertEqual(self.client.stats.reads, 1)
+        self.assertEqual(self.server.stats.bytes_read, len(b"PING"+common.linesep))
 
 
 class UDPTestNull(unittest2.TestCase):
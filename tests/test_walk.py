@@ -32,6 +32,25 @@ class WalkTest(unittest2.TestCase):
         self.assertEqual(w_timer(), None)
 
 
+    def test_handles(self):
+        loop = pyuv.Loop()
+        timers = [pyuv.Timer(loop) for i in range(3)]
+        idle = pyuv.Idle(loop)
+        tcp = pyuv.TCP(loop)
+        handles = loop.handles()
+        self.assertEqual(len(handles), 5)
+        self.assertTrue(idle in handles and tcp in handles)
+        self.assertEqual(loop.handles(pyuv.Timer), timers)
+        self.assertEqual(len(loop.handles((pyuv.Idle, pyuv.TCP))), 2)
+        self.assertEqual(loop.handles(type=pyuv.UDP), [])
+        self.assertRaises(TypeError, loop.handles, 42)
+        self.assertEqual(loop.handle_counts(), {pyuv.Timer: 3, pyuv.Idle: 1, pyuv.TCP: 1})
+        for handle in handles:
+            handle.close()
+        loop.run()
+        self.assertEqual(loop.handles(), [])
+        self.assertEqual(loop.handle_counts(), {})
+
 
 if __name__ == '__main__':
     unittest2.main(verbosity=2)
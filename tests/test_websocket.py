@@ -0,0 +1,127 @@
+
+import os
+
+from common import unittest2
+import pyuv
+
+
+TEST_PORT = 1234
+
+
+class WebSocketParserTest(unittest2.TestCase):
+
+    def setUp(self):
+        self.messages = []
+        self.server = pyuv.WebSocketParser(self.on_message)
+        self.client = pyuv.WebSocketParser(self.on_message, server_side=False)
+
+    def on_message(self, handle, opcode, data):
+        self.messages.append((opcode, data))
+
+    def test_websocket_roundtrip(self):
+        payload = os.urandom(70000)
+        data = self.client.encode(b"hello", pyuv.WS_OPCODE_TEXT) + self.client.encode(payload, pyuv.WS_OPCODE_BINARY)
+        for i in range(0, len(data), 1000):
+            self.server.feed(data[i:i+1000])
+        self.assertEqual(self.messages, [(pyuv.WS_OPCODE_TEXT, u"hello"), (pyuv.WS_OPCODE_BINARY, payload)])
+
+    def test_websocket_mask_keys(self):
+        # more frames than keys fetched at once from os.urandom, all of them decode
+        frames = [self.client.encode(b"x", pyuv.WS_OPCODE_BINARY) for i in range(200)]
+        keys = set(frame[2:6] for frame in frames)
+        self.assertTrue(len(keys) > 190)
+        self.server.feed(b"".join(frames))
+        self.assertEqual(self.messages, [(pyuv.WS_OPCODE_BINARY, b"x")] * 200)
+
+    def test_websocket_fragmented(self):
+        # text message split in 2 frames with a ping in between, sent unmasked by a server
+        data = b"\x01\x04frag" + b"\x89\x01p" + b"\x80\x04ment"
+        for i in range(len(data)):
+            self.client.feed(data[i:i+1])
+        self.assertEqual(self.messages, [(pyuv.WS_OPCODE_TEXT, u"fragment")])
+
+    def test_websocket_invalid(self):
+        # servers only accept masked frames
+        self.assertRaises(ValueError, self.server.feed, self.server.encode(b"hello", pyuv.WS_OPCODE_BINARY))
+        self.assertRaises(ValueError, self.server.feed, b"")
+        self.server.reset()
+        self.server.feed(self.client.encode(b"hello", pyuv.WS_OPCODE_BINARY))
+        self.assertEqual(self.messages, [(pyuv.WS_OPCODE_BINARY, b"hello")])
+
+    def test_websocket_encode_invalid(self):
+        self.assertRaises(ValueError, self.client.encode, b"x", pyuv.WS_OPCODE_CONTINUATION)
+        self.assertRaises(ValueError, self.client.encode, b"x", 3)
+        self.assertRaises(ValueError, self.client.encode, b"x", 0x10)
+        self.assertRaises(ValueError, self.client.encode, b"x" * 126, pyuv.WS_OPCODE_PING)
+        self.server.feed(self.client.encode(b"x" * 125, pyuv.WS_OPCODE_CLOSE))
+        self.assertEqual(self.messages, [(pyuv.WS_OPCODE_CLOSE, b"x" * 125)])
+
+    def test_websocket_feed_from_callback(self):
+        errors = []
+        def on_message(handle, opcode, data):
+            self.messages.append(data)
+            for func in (lambda: self.server.feed(self.client.encode(b"x", pyuv.WS_OPCODE_BINARY)), self.server.reset, lambda: self.server.__init__(on_message)):
+                try:
+                    func()
+                except RuntimeError:
+                    errors.append(data)
+        self.server = pyuv.WebSocketParser(on_message)
+        self.server.feed(self.client.encode(b"a", pyuv.WS_OPCODE_BINARY) + self.client.encode(b"b", pyuv.WS_OPCODE_BINARY))
+        self.assertEqual(self.messages, [b"a", b"b"])
+        self.assertEqual(errors, [b"a"] * 3 + [b"b"] * 3)
+
+
+class WebSocketStreamTest(unittest2.TestCase):
+
+    def on_connection(self, server, error):
+        self.assertEqual(error, None)
+        client = pyuv.TCP(server.loop)
+        server.accept(client)
+        client.start_read(self.on_read, pyuv.WebSocketParser(self.on_server_message))
+
+    def on_server_message(self, handle, opcode, data):
+        if opcode == pyuv.WS_OPCODE_CLOSE:
+            handle.send_message(data, pyuv.WS_OPCODE_CLOSE, self.on_close_sent)
+            self.server.close()
+        else:
+            handle.send_message(data, opcode)
+
+    def on_close_sent(self, handle, error):
+        if not handle.closed:
+            handle.close()
+
+    def on_read(self, handle, data, error):
+        self.assertEqual(data, None)
+        if not handle.closed:
+            handle.close()
+
+    def on_client_connection(self, client, error):
+        self.assertEqual(error, None)
+        client.start_read(self.on_read, pyuv.WebSocketParser(self.on_client_message, server_side=False))
+        # the server answers the ping before echoing the message
+        client.write(self.encoder.encode(b"ping", pyuv.WS_OPCODE_PING))
+        client.send_message(b"hello", pyuv.WS_OPCODE_BINARY)
+
+    def on_client_message(self, handle, opcode, data):
+        self.messages.append((opcode, data))
+        if opcode == pyuv.WS_OPCODE_CLOSE:
+            handle.close()
+        else:
+            handle.send_message(b"\x03\xe8", pyuv.WS_OPCODE_CLOSE)
+
+    def test_websocket_stream(self):
+        self.messages = []
+        self.encoder = pyuv.WebSocketParser(self.on_client_message, server_side=False)
+        loop = pyuv.Loop.default_loop()
+        self.server = pyuv.TCP(loop)
+        self.server.bind(("0.0.0.0", TEST_PORT))
+        self.server.listen(self.on_connection)
+        client = pyuv.TCP(loop)
+        client.connect(("127.0.0.1", TEST_PORT), self.on_client_connection)
+        loop.run()
+        self.assertEqual(self.messages, [(pyuv.WS_OPCODE_BINARY, b"hello"), (pyuv.WS_OPCODE_CLOSE, b"\x03\xe8")])
+
+
+if __name__ == '__main__':
+    unittest2.main(verbosity=2)
+